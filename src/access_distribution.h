@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "fast_random.h"
+#include "utils.h"
+
+enum class AccessType {
+  UniformAccessType = 0,
+  ZipfianAccessType,
+  HotspotAccessType,
+  LatestAccessType,
+};
+
+static const double DEFAULT_ZIPF_THETA = 0.99;
+static const double DEFAULT_HOT_OP_FRACTION = 0.9;
+static const double DEFAULT_HOT_KEY_FRACTION = 0.1;
+
+static void validate_access_params(const AccessType access_type, const double zipf_theta, const double hot_op_fraction, const double hot_key_fraction) {
+  if (access_type == AccessType::ZipfianAccessType || access_type == AccessType::LatestAccessType) {
+    ASSERT(zipf_theta > 0 && zipf_theta < 1, "zipf theta must be in (0, 1): " << zipf_theta);
+  } else if (access_type == AccessType::HotspotAccessType) {
+    ASSERT(hot_op_fraction >= 0 && hot_op_fraction <= 1, "hot op fraction must be in [0, 1]: " << hot_op_fraction);
+    ASSERT(hot_key_fraction > 0 && hot_key_fraction < 1, "hot key fraction must be in (0, 1): " << hot_key_fraction);
+  } else {
+    ASSERT(access_type == AccessType::UniformAccessType, "unsupported access type: " << int(access_type));
+  }
+}
+
+// picks which of item_count items an operation accesses. everything a draw needs is computed
+// at construction, so that threads share one instance and a draw costs a few multiplications
+// and at most one pow.
+//  - uniform: every item alike.
+//  - zipfian: item popularity follows a zipf law with exponent theta. the ranks are scrambled
+//    by a hash, so that hot items are spread over the key space rather than clustered.
+//  - hotspot: hot_op_fraction of the draws go to the first hot_key_fraction of the items.
+//  - latest: zipfian over recency. next() returns how many items back from the newest one.
+class AccessDistribution {
+
+public:
+  AccessDistribution(const AccessType access_type, const uint64_t item_count, const double zipf_theta = DEFAULT_ZIPF_THETA, const double hot_op_fraction = DEFAULT_HOT_OP_FRACTION, const double hot_key_fraction = DEFAULT_HOT_KEY_FRACTION) :
+    access_type_(access_type), item_count_(item_count), theta_(zipf_theta),
+    zeta_n_(0), alpha_(0), eta_(0), half_pow_theta_(0),
+    hot_op_fraction_(hot_op_fraction), hot_count_(0) {
+
+    ASSERT(item_count_ != 0, "access distribution needs at least one item");
+    validate_access_params(access_type_, theta_, hot_op_fraction_, hot_key_fraction);
+
+    if (access_type_ == AccessType::ZipfianAccessType || access_type_ == AccessType::LatestAccessType) {
+      // gray et al., "quickly generating billion-record synthetic databases".
+      for (uint64_t i = 1; i <= item_count_; ++i) {
+        zeta_n_ += 1.0 / std::pow(i, theta_);
+      }
+      half_pow_theta_ = std::pow(0.5, theta_);
+      double zeta_2 = 1 + half_pow_theta_;
+      alpha_ = 1.0 / (1 - theta_);
+      eta_ = (1 - std::pow(2.0 / item_count_, 1 - theta_)) / (1 - zeta_2 / zeta_n_);
+
+    } else if (access_type_ == AccessType::HotspotAccessType) {
+      hot_count_ = std::max<uint64_t>(1, uint64_t(item_count_ * hot_key_fraction));
+      if (hot_count_ == item_count_) {
+        hot_op_fraction_ = 1;
+      }
+    }
+  }
+
+  inline AccessType access_type() const { return access_type_; }
+
+  inline uint64_t item_count() const { return item_count_; }
+
+  // an item in [0, item_count).
+  inline uint64_t next(FastRandom &rand_gen) const {
+    switch (access_type_) {
+      case AccessType::ZipfianAccessType:
+        return scramble(next_zipf_rank(rand_gen)) % item_count_;
+      case AccessType::HotspotAccessType:
+        if (rand_gen.next_uniform() < hot_op_fraction_) {
+          return rand_gen.next<uint64_t>() % hot_count_;
+        }
+        return hot_count_ + rand_gen.next<uint64_t>() % (item_count_ - hot_count_);
+      case AccessType::LatestAccessType:
+        return next_zipf_rank(rand_gen);
+      default:
+        return rand_gen.next<uint64_t>() % item_count_;
+    }
+  }
+
+private:
+  // rank 0 is the most popular item.
+  inline uint64_t next_zipf_rank(FastRandom &rand_gen) const {
+    double u = rand_gen.next_uniform();
+    double uz = u * zeta_n_;
+    if (uz < 1) {
+      return 0;
+    }
+    if (uz < 1 + half_pow_theta_) {
+      return 1;
+    }
+    uint64_t rank = uint64_t(item_count_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+    return rank < item_count_ ? rank : item_count_ - 1;
+  }
+
+  // murmur3 finalizer.
+  static inline uint64_t scramble(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+  }
+
+private:
+  AccessType access_type_;
+  uint64_t item_count_;
+
+  // zipfian and latest
+  double theta_;
+  double zeta_n_;
+  double alpha_;
+  double eta_;
+  double half_pow_theta_;
+
+  // hotspot
+  double hot_op_fraction_;
+  uint64_t hot_count_;
+};
+
+// chooses the keys of a thread's reads from the initial keys. for the latest distribution, the
+// keys the thread inserted itself are newer than the initial keys, and the most recent
+// RECENT_KEY_COUNT of them are kept.
+template<typename KeyT>
+class AccessKeyPicker {
+
+  static const size_t RECENT_KEY_COUNT = 1ull << 16;
+
+public:
+  AccessKeyPicker(const AccessDistribution *distribution, const KeyT *keys, const uint64_t seed) :
+    distribution_(distribution), keys_(keys), rand_gen_(seed), recent_count_(0) {
+
+    if (distribution_->access_type() == AccessType::LatestAccessType) {
+      recent_keys_.resize(RECENT_KEY_COUNT);
+    }
+  }
+
+  inline const KeyT& next() {
+    uint64_t item = distribution_->next(rand_gen_);
+    if (distribution_->access_type() != AccessType::LatestAccessType) {
+      return keys_[item];
+    }
+
+    // item counts back from the newest key.
+    uint64_t recent_size = std::min<uint64_t>(recent_count_, RECENT_KEY_COUNT);
+    if (item < recent_size) {
+      return recent_keys_[(recent_count_ - 1 - item) % RECENT_KEY_COUNT];
+    }
+    return keys_[distribution_->item_count() - 1 - (item - recent_size)];
+  }
+
+  inline void inserted(const KeyT &key) {
+    if (distribution_->access_type() == AccessType::LatestAccessType) {
+      recent_keys_[recent_count_ % RECENT_KEY_COUNT] = key;
+      ++recent_count_;
+    }
+  }
+
+private:
+  const AccessDistribution *distribution_;
+  const KeyT *keys_;
+  FastRandom rand_gen_;
+
+  std::vector<KeyT> recent_keys_;
+  uint64_t recent_count_;
+};
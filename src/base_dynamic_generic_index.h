@@ -16,6 +16,8 @@ public:
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) override {}
 
+  virtual void scan_full(ResultSink &sink, const size_t count) override {}
+
   virtual void prepare_threads(const size_t thread_count) override {}
 
   virtual void register_thread(const size_t thread_id) override {}
@@ -17,11 +17,13 @@ public:
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) override {}
 
+  virtual void scan_full(ResultSink &sink, const size_t count) override {}
+
   virtual void prepare_threads(const size_t thread_count) override {}
 
   virtual void register_thread(const size_t thread_id) override {}
 
-  virtual void reorganize() final {}
+  virtual void reorganize(const size_t thread_count = 1) final {}
 
   virtual void print() const override {}
 
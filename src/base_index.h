@@ -1,12 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "data_table.h"
+#include "index_memory_stats.h"
 #include "offset.h"
+#include "result_sink.h"
 
 template<typename KeyT, typename ValueT>
 class BaseIndex {
@@ -19,21 +23,80 @@ public:
 
   virtual void insert(const KeyT &key, const Uint64 &offset) = 0;
 
+  // load entries into an empty index. the entries must be sorted by key.
+  // indexes that can build their structure from sorted input override this.
+  virtual void bulk_load(const std::pair<KeyT, Uint64> *entries, const size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      insert(entries[i].first, entries[i].second);
+    }
+  }
+
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) = 0;
 
+  // look up a batch of keys. offsets[i] receives the matches of keys[i].
+  // indexes that can overlap the memory accesses of several probes override this.
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) {
+    for (size_t i = 0; i < count; ++i) {
+      find(keys[i], offsets[i]);
+    }
+  }
+
   virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) = 0;
 
+  // find() and find_range() with the offsets streamed into a sink.
+  // indexes that produce offsets in place override these, so that lookups do not allocate.
+  // the defaults go through a per-thread vector, which stops allocating once it has grown.
+  virtual void find(const KeyT &key, ResultSink &sink) {
+    lookup_into_sink(sink, [&](std::vector<Uint64> &offsets) { find(key, offsets); });
+  }
+
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) {
+    lookup_into_sink(sink, [&](std::vector<Uint64> &offsets) { find_range(lhs_key, rhs_key, offsets); });
+  }
+
   virtual void scan(const KeyT &key, std::vector<Uint64> &offsets) = 0;
 
   virtual void scan_reverse(const KeyT &key, std::vector<Uint64> &offsets) = 0;
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count = std::numeric_limits<std::size_t>::max()) = 0;
 
+  virtual void scan_full(ResultSink &sink, const size_t count = std::numeric_limits<std::size_t>::max()) {
+    lookup_into_sink(sink, [&](std::vector<Uint64> &offsets) { scan_full(offsets, count); });
+  }
+
+  // remove every entry of a key.
   virtual void erase(const KeyT &key) = 0;
 
+  // remove the entry of a key that points to offset, and keep the other entries of the key.
+  // indexes that can remove a single entry override this. the default erases the key and
+  // inserts its other entries again.
+  virtual void erase(const KeyT &key, const Uint64 &offset) {
+    std::vector<Uint64> offsets;
+    find(key, offsets);
+    if (std::find(offsets.begin(), offsets.end(), offset) == offsets.end()) { return; }
+
+    erase(key);
+    for (auto other : offsets) {
+      if (other != offset) {
+        insert(key, other);
+      }
+    }
+  }
+
   virtual size_t size() const = 0;
 
-  virtual void reorganize() = 0;
+  // the memory that the index holds, by structure. indexes that can walk their structure
+  // override this, the default only reports the entry count. must not be called while
+  // other threads modify the index.
+  virtual IndexMemoryStats memory_usage() const {
+    IndexMemoryStats stats;
+    stats.entry_count_ = size();
+    return stats;
+  }
+
+  // prepare the index for reads after a bulk insertion.
+  // indexes that build a separate structure may use up to thread_count threads.
+  virtual void reorganize(const size_t thread_count = 1) = 0;
   
   virtual void prepare_threads(const size_t thread_count) = 0;
 
@@ -43,6 +106,22 @@ public:
 
 protected:
 
+  // runs a vector-based lookup on a per-thread buffer and forwards its offsets to the sink.
+  // the buffer is borrowed for the call, so a sink that looks up again gets a buffer of its own.
+  template<typename LookupFunc>
+  static void lookup_into_sink(ResultSink &sink, LookupFunc lookup) {
+    static thread_local std::vector<Uint64> scratch_offsets;
+
+    std::vector<Uint64> offsets;
+    offsets.swap(scratch_offsets);
+    lookup(offsets);
+    for (auto offset : offsets) {
+      sink.push_back(offset);
+    }
+    offsets.clear();
+    offsets.swap(scratch_offsets);
+  }
+
   DataTable<KeyT, ValueT> *table_ptr_;
 
 };
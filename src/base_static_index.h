@@ -1,6 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include <immintrin.h>
+
 #include "base_index.h"
+#include "index_file.h"
+#include "time_measurer.h"
+
+// how a static index lays out its sorted entries.
+//  AoS: one array of (key, offset) pairs.
+//  SoA: a dense key array plus a parallel offset array, so that searches only touch keys.
+enum class StorageLayout {
+  AoS = 0,
+  SoA,
+};
 
 template<typename KeyT, typename ValueT>
 class BaseStaticIndex : public BaseIndex<KeyT, ValueT> {
@@ -19,12 +36,24 @@ protected:
   }
 
 public:
-  BaseStaticIndex(DataTable<KeyT, ValueT> *table_ptr) : 
-    BaseIndex<KeyT, ValueT>(table_ptr), container_(nullptr), size_(0) {}
+  BaseStaticIndex(DataTable<KeyT, ValueT> *table_ptr, const StorageLayout layout = StorageLayout::AoS) : 
+    BaseIndex<KeyT, ValueT>(table_ptr), 
+    layout_(layout), container_(nullptr), keys_(nullptr), offsets_(nullptr), 
+    key_base_(nullptr), offset_base_(nullptr), key_stride_(0), offset_stride_(0), size_(0), 
+    mapped_file_(nullptr) {}
   
   virtual ~BaseStaticIndex() {
+    delete mapped_file_;
+    mapped_file_ = nullptr;
+
     delete[] container_;
     container_ = nullptr;
+
+    delete[] keys_;
+    keys_ = nullptr;
+
+    delete[] offsets_;
+    offsets_ = nullptr;
   }
 
   virtual void insert(const KeyT &key, const Uint64 &offset) final {}
@@ -33,10 +62,10 @@ public:
 
   virtual void scan(const KeyT &key, std::vector<Uint64> &offsets) final {
     for (size_t i = 0; i < this->size_; ++i) {
-      if (this->container_[i].key_ == key) {
-        offsets.push_back(this->container_[i].offset_);
+      if (this->key_at(i) == key) {
+        offsets.push_back(this->offset_at(i));
       }
-      if (this->container_[i].key_ > key) {
+      if (this->key_at(i) > key) {
         return;
       }
     }
@@ -44,20 +73,21 @@ public:
 
   virtual void scan_reverse(const KeyT &key, std::vector<Uint64> &offsets) final {
     for (int i = this->size_ - 1; i >= 0; --i) {
-      if (this->container_[i].key_ == key) {
-        offsets.push_back(this->container_[i].offset_);
+      if (this->key_at(i) == key) {
+        offsets.push_back(this->offset_at(i));
       }
-      if (this->container_[i].key_ < key) {
+      if (this->key_at(i) < key) {
         return;
       }
     }
   }
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
-    size_t bound = std::min(count, this->size_);
-    for (size_t i = 0; i < bound; ++i) {
-      offsets.push_back(this->container_[i].offset_);
-    }
+    scan_full_into(offsets, count);
+  }
+
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    scan_full_into(sink, count);
   }
   
   virtual void prepare_threads(const size_t thread_count) final {}
@@ -66,31 +96,553 @@ public:
 
   virtual size_t size() const final { return size_; }
 
+  // the sorted entries are the leaves, and the structure built on top of them is inner.
+  // a mapped index is counted alike, although its pages belong to the page cache.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = size_;
+    stats.leaf_bytes_ = size_ * (layout_ == StorageLayout::AoS ? sizeof(KeyOffsetPair) : sizeof(KeyT) + sizeof(Uint64));
+    stats.inner_bytes_ = inner_bytes();
+    return stats;
+  }
+
+  // sort all entries of the table, then build the inner structure.
+  // both phases use thread_count threads.
+  virtual void reorganize(const size_t thread_count = 1) final {
+
+    TimeMeasurer timer;
+
+    timer.tic();
+    base_reorganize(thread_count);
+    timer.toc();
+    timings_.sort_ms_ = timer.time_us() / 1000.0 - timings_.gather_ms_;
+
+    timer.tic();
+    reorganize_inner(thread_count);
+    timer.toc();
+    timings_.build_ms_ = timer.time_us() / 1000.0;
+  }
+
+  // wall-clock time of each phase of the last reorganize().
+  struct ReorganizeTimings {
+    double gather_ms_ = 0; // copy keys and offsets out of the table
+    double sort_ms_ = 0; // sort entries, and split them if the layout is SoA
+    double build_ms_ = 0; // build the inner structure
+  };
+
+  const ReorganizeTimings& reorganize_timings() const { return timings_; }
+
+  // write the sorted entries and the inner structure to a file. keys and offsets are
+  // stored as separate arrays, whatever the layout is.
+  void save(const std::string &path) const {
+    IndexFileWriter writer(path);
+    writer.write_value(uint64_t(sizeof(KeyT)));
+    writer.write_value(uint64_t(size_));
+
+    writer.begin_array();
+    for (size_t i = 0; i < size_; ++i) {
+      writer.write_value(key_at(i));
+    }
+    writer.begin_array();
+    for (size_t i = 0; i < size_; ++i) {
+      writer.write_value(offset_at(i));
+    }
+
+    save_inner(writer);
+  }
+
+  // map a file written by save() instead of calling reorganize(). lookups are served from
+  // the mapping in SoA layout, so startup costs a few page faults rather than a sort.
+  // the index must be constructed with the same parameters as the saved one.
+  void load(const std::string &path) {
+    ASSERT(container_ == nullptr && keys_ == nullptr && size_ == 0, "index is already built");
+
+    mapped_file_ = new IndexFileReader(path);
+    ASSERT(mapped_file_->read_value<uint64_t>() == sizeof(KeyT), "mismatched key size: " << path);
+    size_ = mapped_file_->read_value<uint64_t>();
+
+    layout_ = StorageLayout::SoA;
+    key_base_ = reinterpret_cast<const char*>(mapped_file_->read_array<KeyT>(size_));
+    offset_base_ = reinterpret_cast<const char*>(mapped_file_->read_array<Uint64>(size_));
+    key_stride_ = sizeof(KeyT);
+    offset_stride_ = sizeof(Uint64);
+
+    load_inner(*mapped_file_);
+  }
+
+  // whether the index is served from a mapped file.
+  bool is_mapped() const { return mapped_file_ != nullptr; }
+
+  // build from the entries of another static index (may be nullptr) merged with a sorted run of
+  // new entries, instead of gathering the table. both inputs are sorted, so a linear merge replaces
+  // the sort. entries of base whose key satisfies drop(key) are left out.
+  template<typename DropFunc>
+  void reorganize_merged(const BaseStaticIndex *base, const std::vector<std::pair<KeyT, Uint64>> &run, DropFunc drop, const size_t thread_count = 1) {
+
+    ASSERT(container_ == nullptr && keys_ == nullptr && size_ == 0, "invalid container");
+
+    size_t base_size = (base == nullptr) ? 0 : base->size_;
+    container_ = new KeyOffsetPair[base_size + run.size()];
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < base_size || j < run.size()) {
+      if (j == run.size() || (i < base_size && !(run[j].first < base->key_at(i)))) {
+        if (!drop(base->key_at(i))) {
+          container_[size_++] = KeyOffsetPair(base->key_at(i), base->offset_at(i));
+        }
+        ++i;
+      } else {
+        container_[size_++] = KeyOffsetPair(run[j].first, run[j].second);
+        ++j;
+      }
+    }
+
+    apply_layout(thread_count);
+
+    if (size_ != 0) {
+      reorganize_inner(thread_count);
+    }
+  }
+
 protected:
-  void base_reorganize() {
+  // build the inner structure on top of the sorted entries.
+  virtual void reorganize_inner(const size_t thread_count) = 0;
+
+  // write the inner structure, after the sorted entries.
+  virtual void save_inner(IndexFileWriter &writer) const = 0;
+
+  // restore the inner structure written by save_inner(). large arrays should point
+  // into the mapping rather than being copied.
+  virtual void load_inner(IndexFileReader &reader) = 0;
+
+  // bytes in the inner structure.
+  virtual size_t inner_bytes() const = 0;
+
+  void base_reorganize(const size_t thread_count) {
 
-    ASSERT(container_ == nullptr && size_ == 0, "invalid container");
+    ASSERT(container_ == nullptr && keys_ == nullptr && size_ == 0, "invalid container");
+    ASSERT(thread_count != 0, "thread count cannot be 0");
 
-    size_t capacity = 0;
-    capacity = this->table_ptr_->size();
+    TimeMeasurer timer;
+    timer.tic();
+
+    // blocks may be partially filled, so every block starts at the prefix sum of the sizes before it.
+    size_t block_count = this->table_ptr_->block_count();
+    std::vector<size_t> block_sizes(block_count);
+    std::vector<size_t> block_starts(block_count + 1, 0);
+    for (size_t block_id = 0; block_id < block_count; ++block_id) {
+      block_sizes[block_id] = this->table_ptr_->block_size(block_id);
+      block_starts[block_id + 1] = block_starts[block_id] + block_sizes[block_id];
+    }
+    size_t capacity = block_starts[block_count];
+
+    ASSERT(capacity != 0, "table must contain at least one tuple!");
     
     container_ = new KeyOffsetPair[capacity];
 
-    DataTableIterator<KeyT, ValueT> iterator(this->table_ptr_);
-    while (iterator.has_next()) {
-      auto entry = iterator.next();
-      container_[size_].key_ = *(entry.key_);
-      container_[size_].offset_ = entry.offset_;
-      ++size_;
+    // every thread copies a contiguous range of blocks.
+    run_in_parallel(thread_count, [&](const size_t thread_id) {
+      size_t block_begin = block_count * thread_id / thread_count;
+      size_t block_end = block_count * (thread_id + 1) / thread_count;
+
+      for (size_t block_id = block_begin; block_id < block_end; ++block_id) {
+        size_t tuple_count = block_sizes[block_id];
+        KeyOffsetPair *dst = container_ + block_starts[block_id];
+
+        for (size_t rel_offset = 0; rel_offset < tuple_count; ++rel_offset) {
+          dst[rel_offset].key_ = *(this->table_ptr_->get_tuple_key(block_id, rel_offset));
+          dst[rel_offset].offset_ = OffsetT::construct_raw_data(block_id, rel_offset);
+        }
+      }
+    });
+    size_ = capacity;
+
+    timer.toc();
+    timings_.gather_ms_ = timer.time_us() / 1000.0;
+
+    if (size_ < RADIX_SORT_THRESHOLD) {
+      std::sort(container_, container_ + size_, compare_func);
+    } else {
+      radix_sort(thread_count);
+    }
+
+    apply_layout(thread_count);
+  }
+
+  // point key_at() and offset_at() to the sorted container_. in SoA layout, the
+  // container is split into a key array and an offset array first.
+  void apply_layout(const size_t thread_count) {
+
+    if (layout_ == StorageLayout::AoS) {
+      key_base_ = reinterpret_cast<const char*>(&container_[0].key_);
+      offset_base_ = reinterpret_cast<const char*>(&container_[0].offset_);
+      key_stride_ = sizeof(KeyOffsetPair);
+      offset_stride_ = sizeof(KeyOffsetPair);
+      return;
+    }
+
+    // split the sorted pairs into two dense arrays.
+    keys_ = new KeyT[size_];
+    offsets_ = new Uint64[size_];
+    run_in_parallel(thread_count, [&](const size_t thread_id) {
+      size_t begin = size_ * thread_id / thread_count;
+      size_t end = size_ * (thread_id + 1) / thread_count;
+      for (size_t i = begin; i < end; ++i) {
+        keys_[i] = container_[i].key_;
+        offsets_[i] = container_[i].offset_;
+      }
+    });
+    delete[] container_;
+    container_ = nullptr;
+
+    key_base_ = reinterpret_cast<const char*>(keys_);
+    offset_base_ = reinterpret_cast<const char*>(offsets_);
+    key_stride_ = sizeof(KeyT);
+    offset_stride_ = sizeof(Uint64);
+  }
+
+  // parallel LSD radix sort of container_, one byte per pass.
+  // every thread owns a contiguous range of the input and keeps its own histogram,
+  // so the scatter of each pass is stable. passes in which all keys share the same
+  // byte are skipped.
+  void radix_sort(const size_t thread_count) {
+    typedef typename std::make_unsigned<KeyT>::type UnsignedKeyT;
+
+    const size_t RADIX = 256;
+
+    KeyOffsetPair *src = container_;
+    KeyOffsetPair *dst = new KeyOffsetPair[size_];
+
+    std::vector<size_t> histograms(thread_count * RADIX);
+
+    for (size_t pass = 0; pass < sizeof(KeyT); ++pass) {
+
+      const size_t shift = pass * 8;
+      // the sign bit of signed keys flips the order of the most significant byte.
+      const size_t sign_flip = (std::is_signed<KeyT>::value && pass == sizeof(KeyT) - 1) ? 0x80 : 0;
+
+      run_in_parallel(thread_count, [&](const size_t thread_id) {
+        size_t *histogram = histograms.data() + thread_id * RADIX;
+        memset(histogram, 0, sizeof(size_t) * RADIX);
+
+        size_t begin = size_ * thread_id / thread_count;
+        size_t end = size_ * (thread_id + 1) / thread_count;
+        for (size_t i = begin; i < end; ++i) {
+          ++histogram[((UnsignedKeyT(src[i].key_) >> shift) & 0xff) ^ sign_flip];
+        }
+      });
+
+      // turn the histograms into scatter positions: digit-major, thread-minor.
+      bool is_trivial = false;
+      size_t position = 0;
+      for (size_t digit = 0; digit < RADIX; ++digit) {
+        size_t digit_count = 0;
+        for (size_t thread_id = 0; thread_id < thread_count; ++thread_id) {
+          size_t count = histograms[thread_id * RADIX + digit];
+          histograms[thread_id * RADIX + digit] = position;
+          position += count;
+          digit_count += count;
+        }
+        if (digit_count == size_) {
+          is_trivial = true;
+        }
+      }
+      if (is_trivial) { continue; }
+
+      run_in_parallel(thread_count, [&](const size_t thread_id) {
+        size_t *positions = histograms.data() + thread_id * RADIX;
+
+        size_t begin = size_ * thread_id / thread_count;
+        size_t end = size_ * (thread_id + 1) / thread_count;
+        for (size_t i = begin; i < end; ++i) {
+          dst[positions[((UnsignedKeyT(src[i].key_) >> shift) & 0xff) ^ sign_flip]++] = src[i];
+        }
+      });
+
+      std::swap(src, dst);
     }
 
-    std::sort(container_, container_ + size_, compare_func);
+    container_ = src;
+    delete[] dst;
+    dst = nullptr;
+  }
+
+  // i-th smallest key. in SoA layout, consecutive keys are adjacent in memory.
+  inline const KeyT& key_at(const size_t i) const {
+    return *reinterpret_cast<const KeyT*>(key_base_ + i * key_stride_);
+  }
 
+  // offset of the i-th smallest key.
+  inline const Uint64& offset_at(const size_t i) const {
+    return *reinterpret_cast<const Uint64*>(offset_base_ + i * offset_stride_);
+  }
+
+  // batched find for indexes whose inner layers narrow a key down to an inclusive range
+  // of the container. range_func maps a key to that range.
+  template<typename RangeFunc>
+  void find_batch_in_ranges(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets, const KeyT &key_min, const KeyT &key_max, RangeFunc range_func) {
+
+    if (size_ == 0) {
+      return;
+    }
+    if (key_min == key_max) {
+      for (size_t i = 0; i < count; ++i) {
+        this->find(keys[i], offsets[i]);
+      }
+      return;
+    }
+
+    size_t firsts[FIND_BATCH_GROUP_SIZE];
+    size_t begins[FIND_BATCH_GROUP_SIZE];
+    size_t ends[FIND_BATCH_GROUP_SIZE];
+
+    for (size_t base = 0; base < count; base += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(FIND_BATCH_GROUP_SIZE, count - base);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        const KeyT &key = keys[base + i];
+        begins[i] = 0;
+        ends[i] = 0;
+        if (key > key_max || key < key_min) { continue; }
+
+        std::pair<int, int> range = range_func(key);
+        if (range.first > range.second) { continue; }
+
+        begins[i] = range.first;
+        ends[i] = std::min(size_t(range.second) + 1, size_);
+      }
+      std::copy(begins, begins + group_size, firsts);
+
+      lower_bound_group(keys + base, group_size, begins, ends);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        scan_matches(keys[base + i], settle_lower_bound(keys[base + i], begins[i], firsts[i]), offsets[base + i]);
+      }
+    }
+  }
+
+  // lower bound search of a group of keys, each within its own candidate range [begins[i], ends[i]).
+  // the searches advance in lockstep and prefetch the probe of the next round, so that
+  // their cache misses overlap. on return, begins[i] holds the lower bound of keys[i].
+  void lower_bound_group(const KeyT *keys, const size_t group_size, size_t *begins, const size_t *ends) const {
+    ASSERT(group_size <= FIND_BATCH_GROUP_SIZE, "group is too large: " << group_size);
+
+    size_t lens[FIND_BATCH_GROUP_SIZE];
+    size_t max_len = 0;
+
+    for (size_t i = 0; i < group_size; ++i) {
+      lens[i] = ends[i] - begins[i];
+      if (lens[i] > max_len) {
+        max_len = lens[i];
+      }
+      if (lens[i] != 0) {
+        PREFETCH(&key_at(begins[i] + lens[i] / 2));
+      }
+    }
+
+    while (max_len > 1) {
+      max_len = 0;
+      for (size_t i = 0; i < group_size; ++i) {
+        if (lens[i] <= 1) { continue; }
+
+        size_t half = lens[i] / 2;
+        begins[i] = (key_at(begins[i] + half) < keys[i]) ? begins[i] + half : begins[i];
+        lens[i] -= half;
+
+        PREFETCH(&key_at(begins[i] + lens[i] / 2));
+
+        if (lens[i] > max_len) {
+          max_len = lens[i];
+        }
+      }
+    }
+
+    for (size_t i = 0; i < group_size; ++i) {
+      if (lens[i] == 1) {
+        begins[i] += (key_at(begins[i]) < keys[i]);
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////
+  // last-mile search
+  /////////////////////////////////////////////////////////////////////
+
+  // lower bound of the key within [begin, end). returns end if all keys in the range are smaller.
+  // the range is narrowed by a branch-free binary search, and the last few entries are
+  // counted by a linear scan, which is vectorized when keys are dense (SoA layout).
+  size_t lower_bound_in(const KeyT &key, size_t begin, const size_t end) const {
+    size_t len = end - begin;
+    while (len > LINEAR_SEARCH_SIZE) {
+      size_t half = len / 2;
+      // both candidates of the next round, so the branch-free select does not stall on them.
+      PREFETCH(&key_at(begin + half / 2));
+      PREFETCH(&key_at(begin + half + half / 2));
+      begin = (key_at(begin + half) < key) ? begin + half : begin;
+      len -= half;
+    }
+    return begin + count_less(key, begin, len);
+  }
+
+  // lower bound of the key in the whole container, by exponential search around a
+  // predicted position. the cost grows with the distance to the lower bound.
+  size_t lower_bound_around(const KeyT &key, const size_t hint) const {
+    if (hint < size_ && key_at(hint) < key) {
+      // move right. the lower bound is larger than hint.
+      size_t lo = hint + 1;
+      size_t step = 1;
+      while (true) {
+        size_t probe = lo + step - 1;
+        if (probe >= size_) {
+          return lower_bound_in(key, lo, size_);
+        }
+        if (!(key_at(probe) < key)) {
+          return lower_bound_in(key, lo, probe);
+        }
+        lo = probe + 1;
+        step *= 2;
+      }
+    }
+    // move left. the lower bound is not larger than hint.
+    size_t hi = hint;
+    size_t step = 1;
+    while (true) {
+      if (hi < step) {
+        return lower_bound_in(key, 0, hi);
+      }
+      size_t probe = hi - step;
+      if (key_at(probe) < key) {
+        return lower_bound_in(key, probe + 1, hi);
+      }
+      hi = probe;
+      step *= 2;
+    }
+  }
+
+  // lower bound of a key that inner layers narrowed down to the inclusive range [first, second].
+  // the lower bound of any key within [key_min, key_max] lies in [first, second + 1], except
+  // when inner layers stop at a separator equal to the key: duplicates of the separator may
+  // extend to the left of the range.
+  size_t lower_bound_in_range(const KeyT &key, const std::pair<int, int> &range) const {
+    size_t first = range.first;
+    size_t end = std::max(first, std::min(size_t(range.second + 1), size_));
+    return settle_lower_bound(key, lower_bound_in(key, first, end), first);
+  }
+
+  // a lower bound found at the first position of a range may still have equal keys on its left.
+  size_t settle_lower_bound(const KeyT &key, const size_t pos, const size_t first) const {
+    if (pos == first && pos > 0 && !(key_at(pos - 1) < key)) {
+      return lower_bound_around(key, pos - 1);
+    }
+    return pos;
+  }
+
+  template<typename OutputT>
+  void scan_full_into(OutputT &offsets, const size_t count) const {
+    size_t bound = std::min(count, this->size_);
+    for (size_t i = 0; i < bound; ++i) {
+      offsets.push_back(this->offset_at(i));
+    }
+  }
+
+  // collect all entries that are equal to key, starting from its lower bound.
+  // OutputT is a std::vector<Uint64> or a ResultSink.
+  template<typename OutputT>
+  void scan_matches(const KeyT &key, size_t pos, OutputT &offsets) const {
+    for (; pos < size_ && key_at(pos) == key; ++pos) {
+      offsets.push_back(offset_at(pos));
+    }
+  }
+
+private:
+
+  // number of keys in [begin, begin + len) that are smaller than the key. keys are sorted,
+  // so the comparison mask of a SIMD block is a run of ones starting at bit 0.
+  size_t count_less(const KeyT &key, const size_t begin, const size_t len) const {
+    if (std::is_integral<KeyT>::value && key_stride_ == sizeof(KeyT)) {
+      const KeyT *keys = reinterpret_cast<const KeyT*>(key_base_) + begin;
+      if (sizeof(KeyT) == 4) {
+        return count_less_32(keys, key, len);
+      }
+      if (sizeof(KeyT) == 8 && has_sse42()) {
+        return count_less_64(keys, key, len);
+      }
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < len; ++i) {
+      count += (key_at(begin + i) < key);
+    }
+    return count;
+  }
+
+  // unsigned keys have their sign bit flipped, so that signed comparisons can be used.
+  static size_t count_less_32(const KeyT *keys, const KeyT &key, const size_t len) {
+    __m128i xmm_flip = _mm_set1_epi32(std::is_signed<KeyT>::value ? 0 : std::numeric_limits<int32_t>::min());
+    __m128i xmm_key = _mm_xor_si128(_mm_set1_epi32(int32_t(key)), xmm_flip);
+
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+      __m128i xmm_keys = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), xmm_flip);
+      count += __builtin_ctz(~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(xmm_key, xmm_keys))));
+    }
+    for (; i < len; ++i) {
+      count += (keys[i] < key);
+    }
+    return count;
+  }
+
+  __attribute__((target("sse4.2")))
+  static size_t count_less_64(const KeyT *keys, const KeyT &key, const size_t len) {
+    __m128i xmm_flip = _mm_set1_epi64x(std::is_signed<KeyT>::value ? 0 : std::numeric_limits<int64_t>::min());
+    __m128i xmm_key = _mm_xor_si128(_mm_set1_epi64x(int64_t(key)), xmm_flip);
+
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 2 <= len; i += 2) {
+      __m128i xmm_keys = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), xmm_flip);
+      count += __builtin_ctz(~_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(xmm_key, xmm_keys))));
+    }
+    for (; i < len; ++i) {
+      count += (keys[i] < key);
+    }
+    return count;
+  }
+
+  static bool has_sse42() {
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
   }
 
 protected:
 
+  StorageLayout layout_;
+
+  // AoS storage
   KeyOffsetPair *container_;
+
+  // SoA storage
+  KeyT *keys_;
+  Uint64 *offsets_;
+
+  // where key_at() and offset_at() read from, and the distance in bytes between two consecutive entries.
+  const char *key_base_;
+  const char *offset_base_;
+  size_t key_stride_;
+  size_t offset_stride_;
+
   size_t size_;
 
+  ReorganizeTimings timings_;
+
+  // set if the index is loaded from a file. owns the mapping.
+  IndexFileReader *mapped_file_;
+
+  // below this size, std::sort beats the fixed cost of the radix passes.
+  static const size_t RADIX_SORT_THRESHOLD = 1ull << 16;
+
+  // the last-mile search switches from binary search to a linear scan at this range size.
+  static const size_t LINEAR_SEARCH_SIZE = 16;
+
 };
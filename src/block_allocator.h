@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+// provides the tuple storage of data blocks. the returned memory must be zeroed.
+class BlockAllocator {
+public:
+  virtual ~BlockAllocator() {}
+
+  virtual char* allocate(const size_t size) = 0;
+
+  virtual void deallocate(char *ptr, const size_t size) = 0;
+};
+
+
+// one heap allocation per block.
+class HeapBlockAllocator : public BlockAllocator {
+public:
+  virtual char* allocate(const size_t size) final {
+    char *ptr = new char[size];
+    memset(ptr, 0, size);
+    return ptr;
+  }
+
+  virtual void deallocate(char *ptr, const size_t size) final {
+    delete[] ptr;
+  }
+
+  // shared by all tables that do not bring their own allocator.
+  static HeapBlockAllocator* get_instance() {
+    static HeapBlockAllocator allocator;
+    return &allocator;
+  }
+};
+
+
+// carves blocks out of large anonymous mappings backed by 2MB pages, so that key loads
+// from the table miss the TLB less often. the kernel hands out zeroed pages, so blocks are
+// not touched at allocation time.
+// explicit huge pages (MAP_HUGETLB) are used if the system has reserved them; otherwise
+// the arena asks for transparent huge pages. with numa_local set, every numa node has its
+// own arena, and a block comes from the node of the thread that allocates it. blocks are
+// released together with the allocator.
+class ArenaBlockAllocator : public BlockAllocator {
+
+  static const size_t HUGE_PAGE_SIZE = 2ull << 20; // unit: byte (2 MB)
+  static const size_t ARENA_SIZE = 64ull << 20; // unit: byte (64 MB)
+
+  static const int MPOL_PREFERRED_MODE = 1; // MPOL_PREFERRED in numaif.h
+  static const size_t MAX_NUMA_NODES = 64;
+
+  struct Arena {
+    Arena(char *data, const size_t size) : data_(data), size_(size), used_(0) {}
+
+    char *data_;
+    size_t size_;
+    size_t used_;
+  };
+
+public:
+  ArenaBlockAllocator(const bool numa_local = false) : numa_local_(numa_local), current_arenas_(MAX_NUMA_NODES, nullptr) {}
+
+  virtual ~ArenaBlockAllocator() {
+    for (auto arena : arenas_) {
+      munmap(arena->data_, arena->size_);
+      delete arena;
+      arena = nullptr;
+    }
+  }
+
+  virtual char* allocate(const size_t size) final {
+    size_t node = numa_local_ ? current_numa_node() : 0;
+
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    Arena *arena = current_arenas_[node];
+    if (arena == nullptr || arena->size_ - arena->used_ < size) {
+      arena = create_arena(size, node);
+      current_arenas_[node] = arena;
+    }
+
+    char *ptr = arena->data_ + arena->used_;
+    // keep blocks cache line aligned.
+    arena->used_ += (size + 63) & ~size_t(63);
+    return ptr;
+  }
+
+  // blocks are never reused, so that every block is zeroed by the kernel.
+  virtual void deallocate(char *ptr, const size_t size) final {}
+
+  inline bool uses_explicit_huge_pages() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return explicit_huge_pages_;
+  }
+
+private:
+  Arena* create_arena(const size_t size, const size_t node) {
+    size_t arena_size = std::max(ARENA_SIZE, (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+
+    void *ptr = mmap(nullptr, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      explicit_huge_pages_ = true;
+    } else {
+      ptr = mmap(nullptr, arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      ASSERT(ptr != MAP_FAILED, "failed to map arena of " << arena_size << " bytes");
+      // best effort. the mapping falls back to small pages without transparent huge pages.
+      madvise(ptr, arena_size, MADV_HUGEPAGE);
+    }
+
+    if (numa_local_) {
+      // pages are placed when first touched, so the policy applies to the whole arena.
+      unsigned long node_mask = 1ul << node;
+      syscall(SYS_mbind, ptr, arena_size, MPOL_PREFERRED_MODE, &node_mask, MAX_NUMA_NODES, 0);
+    }
+
+    Arena *arena = new Arena(static_cast<char*>(ptr), arena_size);
+    arenas_.push_back(arena);
+    return arena;
+  }
+
+  static size_t current_numa_node() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= MAX_NUMA_NODES) {
+      return 0;
+    }
+    return node;
+  }
+
+private:
+  ArenaBlockAllocator(const ArenaBlockAllocator &);
+  ArenaBlockAllocator& operator=(const ArenaBlockAllocator &);
+
+private:
+  bool numa_local_;
+  bool explicit_huge_pages_ = false;
+
+  mutable std::mutex mutex_;
+  std::vector<Arena*> arenas_;
+  std::vector<Arena*> current_arenas_;
+};
+
+
+enum class BlockAllocatorType {
+  HeapType = 0,
+  ArenaType,
+  NumaArenaType,
+};
+
+static inline BlockAllocator* create_block_allocator(const BlockAllocatorType type) {
+  switch (type) {
+    case BlockAllocatorType::HeapType:
+      return new HeapBlockAllocator();
+    case BlockAllocatorType::ArenaType:
+      return new ArenaBlockAllocator(false);
+    case BlockAllocatorType::NumaArenaType:
+      return new ArenaBlockAllocator(true);
+    default:
+      ASSERT(false, "unsupported block allocator type: " << int(type));
+      return nullptr;
+  }
+}
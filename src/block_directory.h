@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "data_block.h"
+
+// the data blocks of a table, indexed by block id.
+// blocks live in a fixed two-level array: the top level is allocated upfront, and a segment
+// of BLOCK_SEGMENT_SIZE block pointers is allocated on first use. both levels are published
+// by compare-and-swap, and a published pointer never moves. readers therefore look up
+// blocks without locks while writers add blocks.
+//
+// tuples are appended through insertion slots. each slot fills a block of its own, so
+// threads inserting through different slots do not share the fetch_add cache line. block
+// ids come from a shared counter, hence blocks may be partially filled and ids interleave
+// across slots.
+class BlockDirectory {
+
+  static const size_t BLOCK_SEGMENT_BITS = 12;
+  static const size_t BLOCK_SEGMENT_SIZE = 1ull << BLOCK_SEGMENT_BITS;
+  static const size_t BLOCK_SEGMENT_COUNT = 1ull << 14;
+
+  static const size_t CACHELINE_SIZE = 64;
+
+  typedef std::atomic<DataBlock*> BlockSlot;
+
+  struct InsertionSlot {
+    std::atomic<DataBlock*> active_block_;
+    // the successor of the active block, or the active block itself if none is prepared.
+    std::atomic<DataBlock*> next_block_;
+    char padding_[CACHELINE_SIZE - 2 * sizeof(std::atomic<DataBlock*>)];
+  };
+
+public:
+  BlockDirectory(const size_t tuple_size, const uint64_t max_block_capacity, BlockAllocator *allocator) :
+    tuple_size_(tuple_size), max_block_capacity_(max_block_capacity), allocator_(allocator),
+    next_block_id_(0), block_count_(0), slots_(nullptr), slot_count_(0) {
+
+    segments_ = new std::atomic<BlockSlot*>[BLOCK_SEGMENT_COUNT];
+    for (size_t i = 0; i < BLOCK_SEGMENT_COUNT; ++i) {
+      segments_[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    prepare_slots(1);
+  }
+
+  ~BlockDirectory() {
+    free(slots_);
+    slots_ = nullptr;
+
+    for (size_t i = 0; i < BLOCK_SEGMENT_COUNT; ++i) {
+      BlockSlot *segment = segments_[i].load(std::memory_order_relaxed);
+      if (segment == nullptr) { continue; }
+
+      for (size_t j = 0; j < BLOCK_SEGMENT_SIZE; ++j) {
+        delete segment[j].load(std::memory_order_relaxed);
+      }
+      delete[] segment;
+    }
+    delete[] segments_;
+    segments_ = nullptr;
+  }
+
+  // the block must have been created.
+  inline DataBlock* get(const BlockIDT block_id) const {
+    BlockSlot *segment = segments_[block_id >> BLOCK_SEGMENT_BITS].load(std::memory_order_acquire);
+    return segment[block_id & (BLOCK_SEGMENT_SIZE - 1)].load(std::memory_order_acquire);
+  }
+
+  // nullptr if the block has not been created yet.
+  inline DataBlock* try_get(const BlockIDT block_id) const {
+    BlockSlot *segment = segments_[block_id >> BLOCK_SEGMENT_BITS].load(std::memory_order_acquire);
+    if (segment == nullptr) { return nullptr; }
+    return segment[block_id & (BLOCK_SEGMENT_SIZE - 1)].load(std::memory_order_acquire);
+  }
+
+  // return the block with the given id, and create it if it does not exist yet.
+  // concurrent callers agree on one block. the losers of the race free their copies.
+  DataBlock* get_or_create(const BlockIDT block_id) {
+    ASSERT((block_id >> BLOCK_SEGMENT_BITS) < BLOCK_SEGMENT_COUNT, "exceed maximum number of blocks");
+
+    BlockSlot &slot = get_segment(block_id >> BLOCK_SEGMENT_BITS)[block_id & (BLOCK_SEGMENT_SIZE - 1)];
+
+    DataBlock *block = slot.load(std::memory_order_acquire);
+    if (block != nullptr) {
+      return block;
+    }
+
+    DataBlock *new_block = new DataBlock(block_id, tuple_size_, max_block_capacity_, allocator_);
+    if (!slot.compare_exchange_strong(block, new_block, std::memory_order_acq_rel)) {
+      delete new_block;
+      return block;
+    }
+
+    // block_count_ = max(block_count_, block_id + 1)
+    size_t count = block_count_.load(std::memory_order_relaxed);
+    while (count < block_id + 1 && !block_count_.compare_exchange_weak(count, block_id + 1, std::memory_order_acq_rel)) {}
+
+    return new_block;
+  }
+
+  // one past the largest id of the created blocks.
+  inline size_t block_count() const {
+    return block_count_.load(std::memory_order_acquire);
+  }
+
+  inline size_t block_size(const BlockIDT block_id) const {
+    DataBlock *block = try_get(block_id);
+    return block == nullptr ? 0 : block->size();
+  }
+
+  size_t tuple_count() const {
+    size_t count = 0;
+    size_t block_count = this->block_count();
+    for (size_t block_id = 0; block_id < block_count; ++block_id) {
+      count += block_size(block_id);
+    }
+    return count;
+  }
+
+  // make sure there are at least slot_count insertion slots. 
+  // must not run concurrently with allocate_tuple().
+  void prepare_slots(const size_t slot_count) {
+    if (slot_count <= slot_count_) { return; }
+
+    void *ptr = nullptr;
+    int rt = posix_memalign(&ptr, CACHELINE_SIZE, slot_count * sizeof(InsertionSlot));
+    ASSERT(rt == 0, "memory allocation failed");
+
+    InsertionSlot *slots = static_cast<InsertionSlot*>(ptr);
+    for (size_t i = 0; i < slot_count; ++i) {
+      DataBlock *block = nullptr;
+      if (i < slot_count_) {
+        block = slots_[i].active_block_.load(std::memory_order_relaxed);
+      } else {
+        block = get_or_create(next_block_id_.fetch_add(1));
+      }
+      new (&slots[i].active_block_) std::atomic<DataBlock*>(block);
+      new (&slots[i].next_block_) std::atomic<DataBlock*>(i < slot_count_ ? slots_[i].next_block_.load(std::memory_order_relaxed) : block);
+    }
+    free(slots_);
+    slots_ = slots;
+    slot_count_ = slot_count;
+  }
+
+  inline size_t slot_count() const {
+    return slot_count_;
+  }
+
+  // reserve count consecutive tuples through the given slot. returns the block, and the
+  // position of the first tuple in rel_offset.
+  DataBlock* allocate_tuple(const size_t slot_id, RelOffsetT &rel_offset, const size_t count = 1) {
+    ASSERT(slot_id < slot_count_, "slot id out of range: " << slot_id << " " << slot_count_);
+
+    InsertionSlot &slot = slots_[slot_id];
+
+    while (true) {
+      DataBlock *block = slot.active_block_.load(std::memory_order_acquire);
+
+      rel_offset = block->get_next_rel_offset(count);
+
+      if (rel_offset == INVALID_OFFSET) {
+        // the block is full, or too full for count tuples. help to switch to the next one instead of waiting.
+        advance_slot(slot, block);
+        continue;
+      }
+
+      // the first writer of a block prepares the next one, so that no writer
+      // allocates a block when the active one fills up.
+      if (rel_offset == 0) {
+        prepare_next_block(slot, block);
+      }
+
+      if (rel_offset + count == block->get_max_rel_offset()) {
+        advance_slot(slot, block);
+      }
+
+      return block;
+    }
+  }
+
+private:
+  DataBlock* prepare_next_block(InsertionSlot &slot, DataBlock *block) {
+    DataBlock *next_block = slot.next_block_.load(std::memory_order_acquire);
+    if (next_block != block) {
+      return next_block;
+    }
+
+    DataBlock *new_block = get_or_create(next_block_id_.fetch_add(1));
+    if (slot.next_block_.compare_exchange_strong(next_block, new_block, std::memory_order_acq_rel)) {
+      return new_block;
+    }
+    // lost the race to another writer. new_block stays empty, which readers skip.
+    return next_block;
+  }
+
+  // move the slot past a full block. only the first caller succeeds.
+  void advance_slot(InsertionSlot &slot, DataBlock *full_block) {
+    DataBlock *next_block = prepare_next_block(slot, full_block);
+    slot.active_block_.compare_exchange_strong(full_block, next_block, std::memory_order_acq_rel);
+  }
+
+  BlockSlot* get_segment(const size_t segment_id) {
+    BlockSlot *segment = segments_[segment_id].load(std::memory_order_acquire);
+    if (segment != nullptr) {
+      return segment;
+    }
+
+    BlockSlot *new_segment = new BlockSlot[BLOCK_SEGMENT_SIZE];
+    for (size_t i = 0; i < BLOCK_SEGMENT_SIZE; ++i) {
+      new_segment[i].store(nullptr, std::memory_order_relaxed);
+    }
+    if (!segments_[segment_id].compare_exchange_strong(segment, new_segment, std::memory_order_acq_rel)) {
+      delete[] new_segment;
+      return segment;
+    }
+    return new_segment;
+  }
+
+private:
+  BlockDirectory(const BlockDirectory &);
+  BlockDirectory& operator=(const BlockDirectory &);
+
+private:
+  size_t tuple_size_;
+  uint64_t max_block_capacity_;
+  BlockAllocator *allocator_;
+
+  std::atomic<BlockSlot*> *segments_;
+  std::atomic<BlockIDT> next_block_id_;
+  std::atomic<size_t> block_count_;
+
+  InsertionSlot *slots_;
+  size_t slot_count_;
+};
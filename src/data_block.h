@@ -3,6 +3,7 @@
 #include <atomic>
 #include <cstring>
 
+#include "block_allocator.h"
 #include "offset.h"
 
 const uint64_t MaxBlockCapacity = 1000;
@@ -10,25 +11,26 @@ const uint64_t MaxBlockCapacity = 1000;
 class DataBlock {
 
   public:
-    DataBlock(const BlockIDT block_id, const size_t tuple_size, const uint64_t max_block_capacity) : 
+    DataBlock(const BlockIDT block_id, const size_t tuple_size, const uint64_t max_block_capacity, BlockAllocator *allocator = HeapBlockAllocator::get_instance()) : 
       block_id_(block_id),
       tuple_size_(tuple_size), 
-      max_rel_offset_(max_block_capacity) {
+      max_rel_offset_(max_block_capacity),
+      allocator_(allocator) {
       
       next_rel_offset_ = 0;
 
-      tuples_ = new char[tuple_size_ * max_rel_offset_];
-      memset(tuples_, 0, tuple_size_ * max_rel_offset_);
+      tuples_ = allocator_->allocate(tuple_size_ * max_rel_offset_);
     }
 
     ~DataBlock() {
-      delete[] tuples_;
+      allocator_->deallocate(tuples_, tuple_size_ * max_rel_offset_);
       tuples_ = nullptr;
     }
 
-    RelOffsetT get_next_rel_offset() {
-      RelOffsetT rel_offset = next_rel_offset_.fetch_add(1);
-      if (rel_offset < max_rel_offset_) {
+    // reserve count consecutive tuples, and return the first one.
+    RelOffsetT get_next_rel_offset(const size_t count = 1) {
+      RelOffsetT rel_offset = next_rel_offset_.fetch_add(count);
+      if (rel_offset + count <= max_rel_offset_) {
         return rel_offset;
       } else {
         return INVALID_OFFSET;
@@ -48,8 +50,10 @@ class DataBlock {
       return max_rel_offset_;
     }
 
+    // threads that overshoot the last slot leave next_rel_offset_ beyond the capacity.
     size_t size() const {
-      return next_rel_offset_;
+      RelOffsetT next_rel_offset = next_rel_offset_.load();
+      return next_rel_offset < max_rel_offset_ ? next_rel_offset : max_rel_offset_;
     }
 
   private:
@@ -64,5 +68,6 @@ class DataBlock {
     std::atomic<RelOffsetT> next_rel_offset_;
 
     size_t tuple_size_;
+    BlockAllocator *allocator_;
     char *tuples_;
 };
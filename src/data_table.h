@@ -3,7 +3,7 @@
 #include <cassert>
 #include <vector>
 
-#include "data_block.h"
+#include "block_directory.h"
 
 template<typename KeyT, typename ValueT>
 class DataTableIterator;
@@ -14,94 +14,83 @@ class DataTable {
   friend DataTableIterator<KeyT, ValueT>;
 
 public:
-  DataTable(const uint64_t max_block_capacity = MaxBlockCapacity) {
-
-    max_block_capacity_ = max_block_capacity;
-
-    data_blocks_.emplace_back(new DataBlock(0, sizeof(KeyT) + sizeof(ValueT), max_block_capacity_));
-    active_data_block_ = data_blocks_.at(0);
-  }
+  // the allocator provides the block storage. it must outlive the table.
+  DataTable(const uint64_t max_block_capacity = MaxBlockCapacity, BlockAllocator *allocator = HeapBlockAllocator::get_instance()) :
+    max_block_capacity_(max_block_capacity),
+    data_blocks_(sizeof(KeyT) + sizeof(ValueT), max_block_capacity, allocator) {}
   
-  ~DataTable() {
-    for (auto entry : data_blocks_) {
-      delete entry;
-      entry = nullptr;
-    }
-  }
-
-  OffsetT insert_tuple(const KeyT &key, const ValueT &value) {
-
-    while (true) {
-      DataBlock* tmp_block = active_data_block_;
-
-      RelOffsetT rel_offset = tmp_block->get_next_rel_offset();
+  ~DataTable() {}
 
-      if (rel_offset != INVALID_OFFSET) {
-        
-        OffsetT tuple_offset(tmp_block->get_block_id(), rel_offset);
-
-        // copy data.
-        char* data = tmp_block->get_tuple(rel_offset);
-        memcpy(data, &key, sizeof(key));
-        memcpy(data + sizeof(key), &value, sizeof(ValueT));
+  // give every inserting thread its own block, so that threads do not contend on one block.
+  // must be called before the threads start inserting.
+  void prepare_threads(const size_t thread_count) {
+    data_blocks_.prepare_slots(thread_count);
+  }
 
-        if (rel_offset == tmp_block->get_max_rel_offset() - 1) {
-          auto new_block = new DataBlock(tmp_block->get_block_id() + 1, sizeof(KeyT) + sizeof(ValueT), max_block_capacity_);
-          data_blocks_.emplace_back(new_block);
+  // thread_id selects the block to append to. threads may share an id, at the cost of contention.
+  OffsetT insert_tuple(const KeyT &key, const ValueT &value, const size_t thread_id = 0) {
 
-          COMPILER_MEMORY_FENCE;
+    RelOffsetT rel_offset = INVALID_OFFSET;
+    DataBlock *block = data_blocks_.allocate_tuple(thread_id, rel_offset);
 
-          active_data_block_ = new_block;
-        }
+    // copy data.
+    char* data = block->get_tuple(rel_offset);
+    memcpy(data, &key, sizeof(key));
+    memcpy(data + sizeof(key), &value, sizeof(ValueT));
 
-        return tuple_offset;
-      }
-    }
+    return OffsetT(block->get_block_id(), rel_offset);
   }
 
   KeyT* get_tuple_key(const BlockIDT block_id, const RelOffsetT rel_offset) const {
 
-    char *data = data_blocks_.at(block_id)->get_tuple(rel_offset);
+    char *data = data_blocks_.get(block_id)->get_tuple(rel_offset);
     return (KeyT*)(data);
   }
 
   ValueT* get_tuple_value(const BlockIDT block_id, const RelOffsetT rel_offset) const {
 
-    char *data = data_blocks_.at(block_id)->get_tuple(rel_offset);
+    char *data = data_blocks_.get(block_id)->get_tuple(rel_offset);
     return (ValueT*)(data + sizeof(KeyT));
   }
 
   KeyT* get_tuple_key(const OffsetT offset) const {
 
-    char *data = data_blocks_.at(offset.block_id())->get_tuple(offset.rel_offset());
+    char *data = data_blocks_.get(offset.block_id())->get_tuple(offset.rel_offset());
     return (KeyT*)(data);
   }
 
   ValueT* get_tuple_value(const OffsetT offset) const {
 
-    char *data = data_blocks_.at(offset.block_id())->get_tuple(offset.rel_offset());
+    char *data = data_blocks_.get(offset.block_id())->get_tuple(offset.rel_offset());
     return (ValueT*)(data + sizeof(KeyT));
   }
 
+  // blocks may be partially filled, so the size sums up all blocks.
   size_t size() const {
-    ASSERT(data_blocks_.size() != 0, "must have at least one data block");
-    if (data_blocks_.size() == 1) {
-      return data_blocks_.at(0)->size();
-    } else {
-      return (data_blocks_.size() - 1) * max_block_capacity_ + data_blocks_.at(data_blocks_.size() - 1)->size();
-    }
+    return data_blocks_.tuple_count();
+  }
+
+  // one past the largest block id.
+  size_t block_count() const {
+    return data_blocks_.block_count();
+  }
+
+  size_t block_size(const BlockIDT block_id) const {
+    return data_blocks_.block_size(block_id);
+  }
+
+  uint64_t max_block_capacity() const {
+    return max_block_capacity_;
   }
 
   // approximate data table size
   size_t size_approx() const {
-    assert(data_blocks_.size() != 0);
-    return data_blocks_.size() * max_block_capacity_;
+    return data_blocks_.block_count() * max_block_capacity_;
   }
 
 private:
   uint64_t max_block_capacity_;
-  std::vector<DataBlock*> data_blocks_;
-  DataBlock* active_data_block_;
+  BlockDirectory data_blocks_;
 
 };
 
@@ -122,51 +111,45 @@ public:
   DataTableIterator(DataTable<KeyT, ValueT> *table_ptr) : 
     table_ptr_(table_ptr), curr_block_id_(0), curr_rel_offset_(0) {
     
-    ASSERT(table_ptr_->data_blocks_.size() != 0, "table must contain at least one data block!");
-    ASSERT(!(table_ptr_->data_blocks_.size() == 1 && table_ptr_->data_blocks_.at(0)->size() == 0), "table must contain at least one tuple!");
-
-    max_rel_offset_ = table_ptr_->max_block_capacity_ - 1; 
+    ASSERT(table_ptr_->size() != 0, "table must contain at least one tuple!");
 
-    last_block_id_ = table_ptr_->data_blocks_.size() - 1;
+    last_block_id_ = table_ptr_->block_count() - 1;
+    curr_block_size_ = table_ptr_->block_size(0);
 
-    size_t last_block_size = table_ptr_->data_blocks_.at(last_block_id_)->size();
-    if (last_block_size == 0) {
-      last_rel_offset_ = max_rel_offset_;
-      last_block_id_ = last_block_id_ - 1;
-    } else {
-      last_rel_offset_ = last_block_size - 1;
-    }
+    skip_empty_blocks();
   }
 
   bool has_next() const {
-    if (curr_block_id_ > last_block_id_ || (curr_block_id_ == last_block_id_ && curr_rel_offset_ > last_rel_offset_)) {
-      return false;
-    } else {
-      return true;
-    }
+    return curr_block_id_ <= last_block_id_;
   }
 
   IteratorEntry next() {
     BlockIDT ret_block_id = curr_block_id_;
     RelOffsetT ret_rel_offset = curr_rel_offset_;
 
-    if (curr_rel_offset_ != max_rel_offset_) {
-      curr_rel_offset_++;
-    } else {
+    curr_rel_offset_++;
+    skip_empty_blocks();
+
+    return IteratorEntry(ret_block_id, ret_rel_offset, table_ptr_->get_tuple_key(ret_block_id, ret_rel_offset), table_ptr_->get_tuple_value(ret_block_id, ret_rel_offset));
+  }
+
+private:
+  // blocks are partially filled, and blocks that lost a creation race are empty.
+  void skip_empty_blocks() {
+    while (curr_rel_offset_ >= curr_block_size_ && curr_block_id_ <= last_block_id_) {
       curr_block_id_++;
       curr_rel_offset_ = 0;
+      curr_block_size_ = curr_block_id_ <= last_block_id_ ? table_ptr_->block_size(curr_block_id_) : 0;
     }
-    return IteratorEntry(ret_block_id, ret_rel_offset, table_ptr_->get_tuple_key(ret_block_id, ret_rel_offset), table_ptr_->get_tuple_value(ret_block_id, ret_rel_offset));
   }
 
-
 private:
   DataTable<KeyT, ValueT> *table_ptr_;
 
   BlockIDT curr_block_id_;
   RelOffsetT curr_rel_offset_;
 
+  size_t curr_block_size_;
+
   BlockIDT last_block_id_;
-  RelOffsetT last_rel_offset_;
-  RelOffsetT max_rel_offset_;
 };
@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <array>
+#include <functional>
 
 #include "../libcuckoo/cuckoohash_map.hh"
 
@@ -104,6 +105,10 @@ class Epoch {
 
   void showDeleteRatio();
 
+  // Calls func on every node that awaits deletion. Must not run concurrently
+  // with writers
+  void forEachGarbage(const std::function<void(const Garbage &)> &func);
+
   DeletionList &getDeletionList();
 };
 
@@ -127,6 +127,18 @@ void Epoch::exitEpochAndCleanup(ThreadInfo &threadInfo) {
   }
 }
 
+void Epoch::forEachGarbage(const std::function<void(const Garbage &)> &func) {
+  auto locked_table = deletionLists.lock_table();
+  for (auto &iter : locked_table) {
+    for (LabelDelete *cur = iter.second->head(); cur != nullptr;
+         cur = cur->next) {
+      for (std::size_t i = 0; i < cur->nodesCount; ++i) {
+        func(cur->nodes[i]);
+      }
+    }
+  }
+}
+
 Epoch::~Epoch() {
   uint64_t oldestEpoch = std::numeric_limits<uint64_t>::max();
   auto locked_table = deletionLists.lock_table();
@@ -100,6 +100,14 @@ void LeafNode::deleteLeaf(Node *n) {
   }
 }
 
+std::size_t LeafNode::leafSize(const Node *n) {
+  return isExternal(n) ? leafSize(getExternal(n)) : 0;
+}
+
+std::size_t LeafNode::leafSize(const LeafNode *leaf) {
+  return sizeof(LeafNode) + (sizeof(TID) * leaf->capacity);
+}
+
 //===----------------------------------------------------------------------===//
 //
 // LEAF ACCESS
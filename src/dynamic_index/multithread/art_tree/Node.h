@@ -133,6 +133,18 @@ class Node {
 
   static void deleteNode(Node *node);
 
+  //===--------------------------------------------------------------------===//
+  // MEMORY USAGE
+  //===--------------------------------------------------------------------===//
+
+  // Adds the bytes of the node and its subtree. Must not run concurrently
+  // with writers.
+  static void memoryUsage(const Node *node, uint64_t &innerBytes,
+                          uint64_t &leafBytes);
+
+  // The bytes of an inner node, by its type
+  static std::size_t nodeSize(const Node *node);
+
   //===--------------------------------------------------------------------===//
   // NODE ACCESS
   //===--------------------------------------------------------------------===//
@@ -227,6 +239,8 @@ class Node4 : public Node {
 
   void deleteChildren();
 
+  void memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const;
+
   uint64_t getChildren(uint8_t start, uint8_t end,
                        std::tuple<uint8_t, Node *> *&children,
                        uint32_t &childrenCount, bool &needRestart) const;
@@ -296,6 +310,8 @@ class Node16 : public Node {
 
   void deleteChildren();
 
+  void memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const;
+
   uint64_t getChildren(uint8_t start, uint8_t end,
                        std::tuple<uint8_t, Node *> *&children,
                        uint32_t &childrenCount, bool &needRestart) const;
@@ -336,6 +352,8 @@ class Node48 : public Node {
 
   void deleteChildren();
 
+  void memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const;
+
   uint64_t getChildren(uint8_t start, uint8_t end,
                        std::tuple<uint8_t, Node *> *&children,
                        uint32_t &childrenCount, bool &needRestart) const;
@@ -372,6 +390,8 @@ class Node256 : public Node {
 
   void deleteChildren();
 
+  void memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const;
+
   uint64_t getChildren(uint8_t start, uint8_t end,
                        std::tuple<uint8_t, Node *> *&children,
                        uint32_t &childrenCount, bool &needRestart) const;
@@ -398,6 +418,10 @@ class LeafNode {
 
   static void deleteLeaf(Node *n);
 
+  // The bytes of an external leaf. Inlined leaves take no memory
+  static std::size_t leafSize(const Node *n);
+  static std::size_t leafSize(const LeafNode *leaf);
+
   static TID getLeaf(const Node *n);
   static void readLeaf(const Node *n, std::vector<TID> &results,
                        bool &needRestart);
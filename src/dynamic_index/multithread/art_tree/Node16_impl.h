@@ -80,6 +80,12 @@ void Node16::deleteChildren() {
   }
 }
 
+void Node16::memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const {
+  for (std::size_t i = 0; i < count; ++i) {
+    Node::memoryUsage(children[i], innerBytes, leafBytes);
+  }
+}
+
 uint64_t Node16::getChildren(uint8_t start, uint8_t end,
                              std::tuple<uint8_t, Node *> *&children,
                              uint32_t &childrenCount, bool &needRestart) const {
@@ -17,6 +17,14 @@ void Node256::deleteChildren() {
   }
 }
 
+void Node256::memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const {
+  for (uint64_t i = 0; i < 256; ++i) {
+    if (children[i] != nullptr) {
+      Node::memoryUsage(children[i], innerBytes, leafBytes);
+    }
+  }
+}
+
 void Node256::insert(uint8_t key, Node *val) {
   children[key] = val;
   count++;
@@ -64,6 +64,14 @@ void Node48::deleteChildren() {
   }
 }
 
+void Node48::memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const {
+  for (unsigned i = 0; i < 256; i++) {
+    if (childIndex[i] != emptyMarker) {
+      Node::memoryUsage(children[childIndex[i]], innerBytes, leafBytes);
+    }
+  }
+}
+
 uint64_t Node48::getChildren(uint8_t start, uint8_t end,
                              std::tuple<uint8_t, Node *> *&children,
                              uint32_t &childrenCount, bool &needRestart) const {
@@ -12,6 +12,12 @@ void Node4::deleteChildren() {
   }
 }
 
+void Node4::memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes) const {
+  for (uint32_t i = 0; i < count; ++i) {
+    Node::memoryUsage(children[i], innerBytes, leafBytes);
+  }
+}
+
 bool Node4::isFull() const { return count == 4; }
 
 bool Node4::isUnderfull() const { return false; }
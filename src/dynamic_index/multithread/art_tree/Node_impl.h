@@ -163,6 +163,48 @@ void Node::deleteChildren(Node *node) {
   __builtin_unreachable();
 }
 
+void Node::memoryUsage(const Node *node, uint64_t &innerBytes,
+                       uint64_t &leafBytes) {
+  if (Node::isLeaf(node)) {
+    leafBytes += LeafNode::leafSize(node);
+    return;
+  }
+  innerBytes += nodeSize(node);
+  switch (node->getType()) {
+    case NodeType::N4: {
+      static_cast<const Node4 *>(node)->memoryUsage(innerBytes, leafBytes);
+      return;
+    }
+    case NodeType::N16: {
+      static_cast<const Node16 *>(node)->memoryUsage(innerBytes, leafBytes);
+      return;
+    }
+    case NodeType::N48: {
+      static_cast<const Node48 *>(node)->memoryUsage(innerBytes, leafBytes);
+      return;
+    }
+    case NodeType::N256: {
+      static_cast<const Node256 *>(node)->memoryUsage(innerBytes, leafBytes);
+      return;
+    }
+  }
+  __builtin_unreachable();
+}
+
+std::size_t Node::nodeSize(const Node *node) {
+  switch (node->getType()) {
+    case NodeType::N4:
+      return sizeof(Node4);
+    case NodeType::N16:
+      return sizeof(Node16);
+    case NodeType::N48:
+      return sizeof(Node48);
+    case NodeType::N256:
+      return sizeof(Node256);
+  }
+  __builtin_unreachable();
+}
+
 void Node::deleteNode(Node *node) {
   if (Node::isLeaf(node)) {
     LeafNode::deleteLeaf(node);
@@ -18,6 +18,23 @@ Tree::~Tree() {
 
 ThreadInfo Tree::getThreadInfo() { return ThreadInfo(epoch); }
 
+void Tree::memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes,
+                       uint64_t &garbageBytes) {
+  innerBytes = 0;
+  leafBytes = 0;
+  garbageBytes = 0;
+  Node::memoryUsage(root, innerBytes, leafBytes);
+
+  // Unlinked leaves are deleted by doDeleteLeaf, inner nodes by operator delete
+  epoch.forEachGarbage([&](const Garbage &garbage) {
+    if (garbage.deleter_func == doDeleteLeaf) {
+      garbageBytes += LeafNode::leafSize(static_cast<const LeafNode *>(garbage.n));
+    } else {
+      garbageBytes += Node::nodeSize(static_cast<const Node *>(garbage.n));
+    }
+  });
+}
+
 void yield(int count) {
   if (count > 3) {
     sched_yield();
@@ -104,6 +121,112 @@ restart:
   }
 }
 
+void Tree::lookupBatch(const Key *keys, uint32_t count,
+                       std::vector<TID> *results,
+                       ThreadInfo &threadEpochInfo) const {
+  EpochGuardReadonly epochGuard(threadEpochInfo);
+
+  struct LookupState {
+    Node *node;
+    Node *parentNode;
+    uint64_t parentVersion;
+    uint32_t level;
+    bool optimisticPrefixMatch;
+    bool active;
+  };
+
+  static constexpr uint32_t groupSize = 16;
+  LookupState states[groupSize];
+
+  for (uint32_t begin = 0; begin < count; begin += groupSize) {
+    uint32_t group = std::min(count - begin, groupSize);
+    uint32_t remaining = group;
+
+    for (uint32_t i = 0; i < group; ++i) {
+      states[i].node = root;
+      states[i].parentNode = nullptr;
+      states[i].parentVersion = 0;
+      states[i].level = 0;
+      states[i].optimisticPrefixMatch = false;
+      states[i].active = true;
+    }
+
+    while (remaining > 0) {
+      for (uint32_t i = 0; i < group; ++i) {
+        LookupState &st = states[i];
+        if (!st.active) continue;
+
+        const Key &k = keys[begin + i];
+        std::vector<TID> &result = results[begin + i];
+        bool needRestart = false;
+        bool done = false;
+
+        // the node has been prefetched in the previous round
+        Node *node = st.node;
+        uint64_t v = node->readLockOrRestart(needRestart);
+        if (!needRestart && st.parentNode != nullptr) {
+          st.parentNode->readUnlockOrRestart(st.parentVersion, needRestart);
+        }
+
+        if (!needRestart) {
+          switch (checkPrefix(node, k, st.level)) {  // Increases level
+            case CheckPrefixResult::NoMatch:
+              node->readUnlockOrRestart(v, needRestart);
+              done = true;
+              break;
+            case CheckPrefixResult::OptimisticMatch:
+              st.optimisticPrefixMatch = true;
+            // Fallthrough
+            case CheckPrefixResult::Match: {
+              if (k.getKeyLen() <= st.level) {
+                done = true;
+                break;
+              }
+              Node *child = Node::getChild(k[st.level], node);
+              node->checkOrRestart(v, needRestart);
+              if (needRestart) break;
+
+              if (child == nullptr) {
+                done = true;
+              } else if (Node::isLeaf(child)) {
+                node->readUnlockOrRestart(v, needRestart);
+                if (needRestart) break;
+
+                LeafNode::readLeaf(child, result, needRestart);
+                if (needRestart) break;
+
+                if (st.level < k.getKeyLen() - 1 || st.optimisticPrefixMatch) {
+                  if (checkKey(result[0], k) == TID(-1)) {
+                    result.clear();
+                  }
+                }
+                done = true;
+              } else {
+                st.level++;
+                st.parentNode = node;
+                st.parentVersion = v;
+                st.node = child;
+                __builtin_prefetch(child, 0, 3);
+              }
+              break;
+            }
+          }
+        }
+
+        if (needRestart) {
+          // a concurrent writer interfered: fall back to a single lookup.
+          lookup(k, result, threadEpochInfo);
+          done = true;
+        }
+        if (done) {
+          st.active = false;
+          --remaining;
+        }
+      }
+    }
+  }
+}
+
 bool Tree::lookupRange(const Key &start, const Key &end, Key &continueKey,
                        std::vector<TID> &results, uint32_t softMaxResults,
                        ThreadInfo &threadEpochInfo) const {
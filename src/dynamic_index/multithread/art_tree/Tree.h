@@ -30,6 +30,12 @@ class Tree {
   bool lookup(const Key &k, std::vector<TID> &results,
               ThreadInfo &threadEpochInfo) const;
 
+  /// Lookup a batch of keys. The descents of a group of keys advance one node
+  /// per round and prefetch the node of the next round, so that the cache
+  /// misses of the group overlap. results[i] receives the TIDs of keys[i].
+  void lookupBatch(const Key *keys, uint32_t count, std::vector<TID> *results,
+                   ThreadInfo &threadEpochInfo) const;
+
   /// Looks up all key-value pairs between the provided start and end keys.
   /// Results are placed in the provided result vector (of the provided size).
   /// The actual number of results that were inserted is in the output parameter
@@ -53,6 +59,12 @@ class Tree {
 
   void setLoadKeyFunc(LoadKeyFunction loadKey, void *ctx);
 
+  /// Counts the bytes of the inner nodes and the leaves of the tree, and of
+  /// the nodes that await deletion by the epoch. Must not run concurrently
+  /// with writers.
+  void memoryUsage(uint64_t &innerBytes, uint64_t &leafBytes,
+                   uint64_t &garbageBytes);
+
  private:
   // Class to help loading the key for a given TID
   class KeyLoader {
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <memory>
+
 #include "art_tree/Tree.h"
+#include "art_tree_thread_infos.h"
 
 #include "base_dynamic_generic_index.h"
 #include "data_table.h"
+#include "entry_counter.h"
 #include "utils.h"
 
 
@@ -17,56 +21,147 @@ static void load_key_internal(void *ctx, TID tid, art::Key &tree_key) {
 
   auto data_table_ptr = reinterpret_cast<GenericDataTable*>(ctx);  
 
-  char *key_ptr = data_table_ptr->get_tuple_key(OffsetT(tid - 1));
+  OffsetT offset(tid - 1);
+  char *key_ptr = data_table_ptr->get_tuple_key(offset);
 
-  size_t key_len = strlen(key_ptr);
-  size_t max_key_size = data_table_ptr->get_max_key_size();
-  if (key_len > max_key_size) {
-    key_len = max_key_size;
-  }
+  // the table keeps the key length with the record.
+  size_t key_len = data_table_ptr->get_tuple_key_size(offset);
 
-  tree_key.setKeyLen(key_len);
+  encode_key(key_ptr, key_len, tree_key);
+}
 
-  uint8_t *tree_key_data = &(tree_key[0]);
-  memcpy(tree_key_data, key_ptr, key_len);
+// the tree needs prefix-free keys, and compares the keys it loads from the table with the
+// keys it is given, so both are encoded the same way.
+static void encode_key(const char *key_ptr, const size_t key_len, art::Key &tree_key) {
+  tree_key.setKeyLen(prefix_free_key_size(key_ptr, key_len));
+  encode_prefix_free_key(key_ptr, key_len, &(tree_key[0]));
 }
 
 public:
 
   ArtTreeGenericIndex(GenericDataTable *table_ptr) : 
     BaseDynamicGenericIndex(table_ptr), 
-    container_(load_key_internal, table_ptr), 
-    ti_(container_.getThreadInfo()) {}
+    container_(load_key_internal, table_ptr),
+    thread_infos_(container_) {}
   
   virtual ~ArtTreeGenericIndex() {}
 
+  virtual void prepare_threads(const size_t thread_count) final {}
+
+  // threads that do not register get their thread info on their first operation.
+  virtual void register_thread(const size_t thread_id) final {
+    thread_infos_.get();
+    EntryCounter::register_thread(thread_id);
+  }
+
   virtual void insert(const GenericKey &key, const Uint64 &offset) final {
 
     art::Key tree_key;
     load_key(key, tree_key);
 
-    bool rt = container_.insert(tree_key, offset + 1, ti_);
+    if (container_.insert(tree_key, offset + 1, thread_infos_.get())) {
+      entry_counter_.add(1);
+    }
   }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
 
     art::Key tree_key;
     load_key(key, tree_key);
 
-    bool rt = container_.lookup(tree_key, offsets, ti_);
+    bool rt = container_.lookup(tree_key, offsets, thread_infos_.get());
     for (size_t i = 0; i < offsets.size(); ++i) {
       offsets[i] -= 1;
     }
   }
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {
+  virtual void find_batch(const GenericKey *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    art::Key tree_keys[FIND_BATCH_GROUP_SIZE];
+
+    for (size_t begin = 0; begin < count; begin += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(count - begin, FIND_BATCH_GROUP_SIZE);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        load_key(keys[begin + i], tree_keys[i]);
+      }
+
+      container_.lookupBatch(tree_keys, group_size, offsets + begin, thread_infos_.get());
+
+      for (size_t i = 0; i < group_size; ++i) {
+        for (size_t j = 0; j < offsets[begin + i].size(); ++j) {
+          offsets[begin + i][j] -= 1;
+        }
+      }
+    }
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  // results are streamed one batch of the tree scan at a time.
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
+  // the tree removes one (key, tid) pair at a time.
+  virtual void erase(const GenericKey &key) final {
+
+    art::Key tree_key;
+    load_key(key, tree_key);
+
+    std::vector<TID> tids;
+    container_.lookup(tree_key, tids, thread_infos_.get());
+    for (auto tid : tids) {
+      if (container_.remove(tree_key, tid, thread_infos_.get())) {
+        entry_counter_.add(-1);
+      }
+    }
+  }
+
+  virtual void erase(const GenericKey &key, const Uint64 &offset) final {
+
+    art::Key tree_key;
+    load_key(key, tree_key);
+
+    if (container_.remove(tree_key, offset + 1, thread_infos_.get())) {
+      entry_counter_.add(-1);
+    }
+  }
+
+  virtual size_t size() const final {
+    return entry_counter_.get();
+  }
+
+  // the tree walk takes the lock table of the epoch, hence the cast.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = entry_counter_.get();
+
+    uint64_t inner_bytes = 0;
+    uint64_t leaf_bytes = 0;
+    uint64_t garbage_bytes = 0;
+    const_cast<art::Tree&>(container_).memoryUsage(inner_bytes, leaf_bytes, garbage_bytes);
+    stats.inner_bytes_ = inner_bytes;
+    stats.leaf_bytes_ = leaf_bytes;
+    stats.garbage_bytes_ = garbage_bytes;
+    return stats;
+  }
+
+private:
+  template<typename OutputT>
+  void find_range_into(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, OutputT &offsets) {
     art::Key start_key, end_key;
     load_key(lhs_key, start_key);
     load_key(rhs_key, end_key);
 
-    // Perform scan
+    // the tree restarts a batch that races a writer, so the offsets go through a buffer one
+    // batch at a time. the buffer is borrowed per thread, so that a scan does not allocate,
+    // and a sink that scans again gets a buffer of its own.
     const uint32_t batch_size = 1000;
-    std::vector<Uint64> tmp_result;
+    static thread_local std::vector<Uint64> scratch_batch;
+    std::vector<Uint64> batch;
+    batch.swap(scratch_batch);
 
     art::Key curr_key;
     curr_key.setFrom(start_key);
@@ -74,42 +169,31 @@ public:
     bool has_more = true;
     while (has_more) {
       art::Key next_key;
+      batch.clear();
       has_more = container_.lookupRange(curr_key, end_key, next_key,
-                                        tmp_result, batch_size, ti_);
+                                        batch, batch_size, thread_infos_.get());
 
-      // Copy the results to the vector
-      for (const auto &tid : tmp_result) {
+      // stream the batch to the output
+      for (const auto &tid : batch) {
         offsets.push_back(tid - 1);
       }
 
       // Set the next key
       curr_key.setFrom(next_key);
     }
-
+    batch.clear();
+    batch.swap(scratch_batch);
   }
 
-  virtual void erase(const GenericKey &key) final {
-    // container_.erase(key);
-  }
-
-  virtual size_t size() const final {
-
-    // return art_size(&container_);
-    return 0;
-  }
-
-private:
-  void load_key(const GenericKey &key, art::Key &tree_key) {
-    tree_key.setKeyLen(key.size());
-
-    uint8_t *tree_key_data = &(tree_key[0]);
-    memcpy(tree_key_data, key.raw(), key.size());
-
+  void load_key(const GenericKeyView &key, art::Key &tree_key) {
+    encode_key(key.raw(), key.size(), tree_key);
   }
 
 private:
   art::Tree container_;
-  art::ThreadInfo ti_;
+  // declared after the tree, as thread infos refer to its epoch.
+  ArtThreadInfos thread_infos_;
+  EntryCounter entry_counter_;
 };
 
 }
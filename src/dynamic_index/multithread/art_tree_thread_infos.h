@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "art_tree/Tree.h"
+
+
+namespace dynamic_index {
+namespace multithread {
+
+// the thread infos of one art tree. a thread info binds to the garbage list of the thread
+// that creates it, so every thread makes its own, on its first operation on the tree. the
+// thread info of the calling thread is cached in a thread local, tagged by the id of the
+// tree, so that a thread may work on several trees.
+class ArtThreadInfos {
+
+  struct CachedThreadInfo {
+    uint64_t tree_id_ = 0;
+    art::ThreadInfo *info_ = nullptr;
+  };
+
+public:
+  explicit ArtThreadInfos(art::Tree &tree) : tree_(tree), tree_id_(next_tree_id().fetch_add(1) + 1) {}
+
+  inline art::ThreadInfo& get() {
+    CachedThreadInfo &cached = cached_thread_info();
+    if (cached.tree_id_ != tree_id_) {
+      cached.info_ = lookup();
+      cached.tree_id_ = tree_id_;
+    }
+    return *cached.info_;
+  }
+
+private:
+  ArtThreadInfos(const ArtThreadInfos&);
+  ArtThreadInfos& operator=(const ArtThreadInfos&);
+
+  art::ThreadInfo* lookup() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::unique_ptr<art::ThreadInfo> &info = infos_[std::this_thread::get_id()];
+    if (!info) {
+      info.reset(new art::ThreadInfo(tree_.getThreadInfo()));
+    }
+    return info.get();
+  }
+
+  // ids are not reused, unlike the addresses of trees.
+  static std::atomic<uint64_t>& next_tree_id() {
+    static std::atomic<uint64_t> id(0);
+    return id;
+  }
+
+  static CachedThreadInfo& cached_thread_info() {
+    static thread_local CachedThreadInfo cached;
+    return cached;
+  }
+
+private:
+  art::Tree &tree_;
+  const uint64_t tree_id_;
+  std::mutex mutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<art::ThreadInfo>> infos_;
+};
+
+}
+}
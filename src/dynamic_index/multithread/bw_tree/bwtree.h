@@ -2033,6 +2033,21 @@ class BwTree : public BwTreeBase {
       return nullptr;
     }
     
+    /*
+     * GetChunkCount() - Returns the number of chunks in the linked list,
+     *                   including this one
+     */
+    size_t GetChunkCount() const {
+      size_t chunk_count = 0;
+      for(const AllocationMeta *meta_p = this;
+          meta_p != nullptr;
+          meta_p = meta_p->next.load()) {
+        chunk_count++;
+      }
+
+      return chunk_count;
+    }
+
     /*
      * Destroy() - Frees all chunks in the linked list
      *
@@ -2757,6 +2772,55 @@ class BwTree : public BwTreeBase {
     return;
   }
   
+  /*
+   * GetMemoryUsage() - Counts the bytes held by the tree
+   *
+   * Nodes are found through the mapping table, and garbage through the
+   * thread-local GC lists. Base nodes count their header and items as inner
+   * or leaf bytes, and the chunks that hold their delta records as delta
+   * bytes. A chain in a garbage list counts all its bytes as garbage.
+   * key_bytes_func returns the bytes that a key holds outside the node,
+   * which are added to the items of base nodes
+   *
+   * This must be called under single threaded environment
+   */
+  template <typename KeyBytesFunc>
+  void GetMemoryUsage(size_t *inner_bytes_p,
+                      size_t *leaf_bytes_p,
+                      size_t *delta_bytes_p,
+                      size_t *garbage_bytes_p,
+                      KeyBytesFunc key_bytes_func) {
+    // Delta chains may share nodes, e.g. the removed node under a merge
+    // delta, so every separately allocated node is counted once
+    std::unordered_set<const BaseNode *> visited_set{};
+
+    *inner_bytes_p = 0;
+    *leaf_bytes_p = 0;
+    *delta_bytes_p = 0;
+    for(NodeID node_id = 1;node_id < next_unused_node_id.load();node_id++) {
+      const BaseNode *node_p = mapping_table[node_id].load();
+      if(node_p != nullptr) {
+        CountDeltaChainBytes(node_p, visited_set, key_bytes_func,
+                             inner_bytes_p, leaf_bytes_p, delta_bytes_p);
+      }
+    }
+
+    *garbage_bytes_p = 0;
+    for(size_t i = 0;i < GetThreadNum();i++) {
+      for(const auto *garbage_node_p = GetGCMetaData(i)->header.next_p;
+          garbage_node_p != nullptr;
+          garbage_node_p = garbage_node_p->next_p) {
+        size_t chain_bytes = sizeof(*garbage_node_p);
+        CountDeltaChainBytes((const BaseNode *)garbage_node_p->node_p,
+                             visited_set, key_bytes_func,
+                             &chain_bytes, &chain_bytes, &chain_bytes);
+        *garbage_bytes_p += chain_bytes;
+      }
+    }
+
+    return;
+  }
+
   /*
    * UpdateThreadLocal() - Frees all memorys currently existing and then 
    *                       reallocate a chunk of memory to represent the 
@@ -2803,6 +2867,112 @@ class BwTree : public BwTreeBase {
     return FreeNodeByPointer(node_p);
   }
 
+  /*
+   * CountDeltaChainBytes() - Adds the bytes of a delta chain down to its
+   *                          base node
+   *
+   * This follows the chain the same way as FreeEpochDeltaChain() in
+   * EpochManager. Delta records are allocated inside the chunks of their
+   * base node, except remove and abort nodes, which are allocated with
+   * operator new
+   */
+  template <typename KeyBytesFunc>
+  void CountDeltaChainBytes(const BaseNode *node_p,
+                            std::unordered_set<const BaseNode *> &visited_set,
+                            KeyBytesFunc key_bytes_func,
+                            size_t *inner_bytes_p,
+                            size_t *leaf_bytes_p,
+                            size_t *delta_bytes_p) {
+    while(1) {
+      assert(node_p != nullptr);
+
+      switch(node_p->GetType()) {
+        case NodeType::LeafInsertType:
+        case NodeType::LeafDeleteType:
+        case NodeType::LeafSplitType:
+        case NodeType::InnerInsertType:
+        case NodeType::InnerDeleteType:
+        case NodeType::InnerSplitType:
+          node_p = ((const DeltaNode *)node_p)->child_node_p;
+
+          break;
+        case NodeType::LeafMergeType:
+          CountDeltaChainBytes(((const LeafMergeNode *)node_p)->child_node_p,
+                               visited_set, key_bytes_func,
+                               inner_bytes_p, leaf_bytes_p, delta_bytes_p);
+          CountDeltaChainBytes(((const LeafMergeNode *)node_p)->right_merge_p,
+                               visited_set, key_bytes_func,
+                               inner_bytes_p, leaf_bytes_p, delta_bytes_p);
+
+          return;
+        case NodeType::InnerMergeType:
+          CountDeltaChainBytes(((const InnerMergeNode *)node_p)->child_node_p,
+                               visited_set, key_bytes_func,
+                               inner_bytes_p, leaf_bytes_p, delta_bytes_p);
+          CountDeltaChainBytes(((const InnerMergeNode *)node_p)->right_merge_p,
+                               visited_set, key_bytes_func,
+                               inner_bytes_p, leaf_bytes_p, delta_bytes_p);
+
+          return;
+        case NodeType::LeafRemoveType:
+          if(visited_set.insert(node_p).second == true) {
+            *delta_bytes_p += sizeof(LeafRemoveNode);
+          }
+
+          return;
+        case NodeType::InnerRemoveType:
+          if(visited_set.insert(node_p).second == true) {
+            *delta_bytes_p += sizeof(InnerRemoveNode);
+          }
+
+          return;
+        case NodeType::InnerAbortType:
+          if(visited_set.insert(node_p).second == true) {
+            *delta_bytes_p += sizeof(InnerAbortNode);
+          }
+
+          return;
+        case NodeType::LeafType: {
+          const LeafNode *leaf_node_p = static_cast<const LeafNode *>(node_p);
+          if(visited_set.insert(node_p).second == true) {
+            *leaf_bytes_p += sizeof(LeafNode) + \
+                             leaf_node_p->GetSize() * sizeof(KeyValuePair);
+            for(auto it = leaf_node_p->Begin();
+                it != leaf_node_p->End();
+                it++) {
+              *leaf_bytes_p += key_bytes_func(it->first);
+            }
+            *delta_bytes_p += AllocationMeta::CHUNK_SIZE * \
+              LeafNode::GetAllocationHeader(leaf_node_p)->GetChunkCount();
+          }
+
+          return;
+        }
+        case NodeType::InnerType: {
+          const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
+          if(visited_set.insert(node_p).second == true) {
+            *inner_bytes_p += sizeof(InnerNode) + \
+                              inner_node_p->GetSize() * sizeof(KeyNodeIDPair);
+            for(auto it = inner_node_p->Begin();
+                it != inner_node_p->End();
+                it++) {
+              *inner_bytes_p += key_bytes_func(it->first);
+            }
+            *delta_bytes_p += AllocationMeta::CHUNK_SIZE * \
+              InnerNode::GetAllocationHeader(inner_node_p)->GetChunkCount();
+          }
+
+          return;
+        }
+        default:
+          bwt_printf("Unknown node type: %d\n", (int)node_p->GetType());
+
+          assert(false);
+          return;
+      } // switch
+    } // while 1
+  }
+
   /*
    * InvalidateNodeID() - Recycle NodeID
    *
@@ -7354,12 +7524,52 @@ before_switch:
   bool Insert(const KeyType &key, const ValueType &value) {
     bwt_printf("Insert called\n");
 
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+
+    bool ret = InsertInEpoch(key, value);
+
+    epoch_manager.LeaveEpoch(epoch_node_p);
+
+    return ret;
+  }
+
+  /*
+   * InsertBatch() - Insert a batch of key-value pairs
+   *
+   * The epoch is joined only once for the whole batch. If the pairs are
+   * sorted by key, consecutive inserts go to the same leaf, and find the
+   * inner nodes and the delta chain in the cache
+   *
+   * This function returns the number of pairs that were inserted
+   */
+  size_t InsertBatch(const std::pair<KeyType, ValueType> *items,
+                     size_t count) {
+    bwt_printf("InsertBatch()\n");
+
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+
+    size_t inserted_count = 0;
+    for(size_t i = 0; i < count; i++) {
+      if(InsertInEpoch(items[i].first, items[i].second) == true) {
+        inserted_count++;
+      }
+    }
+
+    epoch_manager.LeaveEpoch(epoch_node_p);
+
+    return inserted_count;
+  }
+
+  /*
+   * InsertInEpoch() - Insert a key-value pair. The caller has joined the epoch
+   *
+   * This function returns false if value already exists
+   */
+  bool InsertInEpoch(const KeyType &key, const ValueType &value) {
     #ifdef BWTREE_DEBUG
     insert_op_count.fetch_add(1);
     #endif
 
-    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
-
     while(1) {
       Context context{key};
       std::pair<int, bool> index_pair;
@@ -7372,8 +7582,6 @@ before_switch:
 
       // If the key-value pair already exists then return false
       if(item_p != nullptr) {
-        epoch_manager.LeaveEpoch(epoch_node_p);
-
         return false;
       }
 
@@ -7428,8 +7636,6 @@ before_switch:
       bwt_printf("Retry installing leaf insert delta from the root\n");
     }
 
-    epoch_manager.LeaveEpoch(epoch_node_p);
-
     return true;
   }
 
@@ -7651,6 +7857,49 @@ before_switch:
     return;
   }
 
+  /*
+   * GetValueBatch() - Fill value lists for a batch of keys
+   *
+   * The epoch is joined only once for the whole batch. Keys of each group
+   * are visited in sorted order, such that consecutive traversals reuse the
+   * inner nodes and delta chains that the previous traversal has just
+   * brought into the cache
+   *
+   * value_lists[i] receives the values of search_keys[i]
+   */
+  void GetValueBatch(const KeyType *search_keys,
+                     size_t count,
+                     std::vector<ValueType> *value_lists) {
+    bwt_printf("GetValueBatch()\n");
+
+    static constexpr size_t group_size = 32;
+    size_t order[group_size];
+
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+
+    for(size_t begin = 0; begin < count; begin += group_size) {
+      size_t group = std::min(count - begin, group_size);
+
+      for(size_t i = 0; i < group; i++) {
+        order[i] = begin + i;
+      }
+
+      std::sort(order, order + group, [this, search_keys](size_t lhs, size_t rhs) {
+        return KeyCmpLess(search_keys[lhs], search_keys[rhs]);
+      });
+
+      for(size_t i = 0; i < group; i++) {
+        Context context{search_keys[order[i]]};
+
+        TraverseReadOptimized(&context, &value_lists[order[i]]);
+      }
+    }
+
+    epoch_manager.LeaveEpoch(epoch_node_p);
+
+    return;
+  }
+
   /*
    * GetValue() - Return value in a ValueSet object
    *
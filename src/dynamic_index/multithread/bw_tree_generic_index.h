@@ -3,6 +3,7 @@
 #include "bw_tree/bwtree.h"
 
 #include "base_dynamic_generic_index.h"
+#include "entry_counter.h"
 
 
 namespace dynamic_index {
@@ -14,7 +15,7 @@ class BwTreeGenericIndex : public BaseDynamicGenericIndex {
 
 public:
   BwTreeGenericIndex(GenericDataTable *table_ptr) : BaseDynamicGenericIndex(table_ptr) {
-    container_ = new BwTree<GenericKey, Uint64, GenericKeyComparator, GenericKeyEqualityChecker, GenericKeyHasher>{true};
+    container_ = new ContainerT{true};
   }
 
   virtual ~BwTreeGenericIndex() {
@@ -30,17 +31,92 @@ public:
   virtual void register_thread(const size_t thread_id) final {
     assert(thread_id < thread_count_);
     container_->AssignGCID(thread_id);
+    EntryCounter::register_thread(thread_id);
   }
 
   virtual void insert(const GenericKey &key, const Uint64 &offset) final {
-    container_->Insert(key, offset);
+    if (container_->Insert(PrefixGenericKey(key), offset)) {
+      entry_counter_.add(1);
+    }
+  }
+
+  // each group is inserted within one epoch. the groups keep the epochs short,
+  // so that garbage collection goes on during a long load.
+  virtual void bulk_load(const std::pair<GenericKey, Uint64> *entries, const size_t count) final {
+    std::vector<std::pair<PrefixGenericKey, Uint64>> group(BULK_LOAD_GROUP_SIZE);
+
+    for (size_t begin = 0; begin < count; begin += BULK_LOAD_GROUP_SIZE) {
+      size_t group_size = std::min(count - begin, BULK_LOAD_GROUP_SIZE);
+      for (size_t i = 0; i < group_size; ++i) {
+        group[i].first.assign(entries[begin + i].first);
+        group[i].second = entries[begin + i].second;
+      }
+      entry_counter_.add(container_->InsertBatch(group.data(), group_size));
+    }
+  }
+
+  using BaseDynamicGenericIndex::find;
+
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    container_->GetValue(make_probe(key, 0), offsets);
+  }
+
+  virtual void find_batch(const GenericKey *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    static thread_local std::vector<PrefixGenericKey> probes;
+    if (probes.size() < count) {
+      probes.resize(count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      probes[i].assign(keys[i]);
+    }
+    container_->GetValueBatch(probes.data(), count, offsets);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
   }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {
-    container_->GetValue(key, offsets);
+  // streams the offsets from the tree iterator. the upper bound is a per-thread probe, so
+  // the sink must not run range scans on this index.
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
   }
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {
+  // the tree deletes one key-value pair at a time.
+  virtual void erase(const GenericKey &key) final {
+    const PrefixGenericKey &probe = make_probe(key, 0);
+
+    std::vector<Uint64> offsets;
+    container_->GetValue(probe, offsets);
+    for (auto offset : offsets) {
+      if (container_->Delete(probe, offset)) {
+        entry_counter_.add(-1);
+      }
+    }
+  }
+
+  virtual void erase(const GenericKey &key, const Uint64 &offset) final {
+    if (container_->Delete(make_probe(key, 0), offset)) {
+      entry_counter_.add(-1);
+    }
+  }
+
+  virtual size_t size() const final {
+    return entry_counter_.get();
+  }
+
+  // keys longer than the inline buffer of a key add their heap bytes to the nodes.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = entry_counter_.get();
+    container_->GetMemoryUsage(&stats.inner_bytes_, &stats.leaf_bytes_, &stats.delta_bytes_, &stats.garbage_bytes_,
+      [](const PrefixGenericKey &key) { return key.heap_bytes(); });
+    return stats;
+  }
+
+private:
+  template<typename OutputT>
+  void find_range_into(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, OutputT &offsets) {
 
     if (lhs_key > rhs_key) { return; }
 
@@ -48,24 +124,27 @@ public:
       find(lhs_key, offsets);
       return;
     }
-    for (auto scan_itr = container_->Begin(lhs_key); (scan_itr.IsEnd() == false) && (container_->KeyCmpLessEqual(scan_itr->first, rhs_key)); scan_itr++) {
+    const PrefixGenericKey &rhs_bound = make_probe(rhs_key, 1);
+    for (auto scan_itr = container_->Begin(make_probe(lhs_key, 0)); (scan_itr.IsEnd() == false) && (container_->KeyCmpLessEqual(scan_itr->first, rhs_bound)); scan_itr++) {
 
       offsets.push_back(scan_itr->second);
     }
   }
 
-  virtual void erase(const GenericKey &key) final {
-    // container_.erase(key);
-  }
-
-  virtual size_t size() const final {
-    // return container_.size();
-    return 0;
+  // a per-thread key that a lookup probes with. its buffer is reused, so lookups do not allocate.
+  static const PrefixGenericKey& make_probe(const GenericKeyView &key, const size_t probe_id) {
+    static thread_local PrefixGenericKey probes[2];
+    probes[probe_id].assign(key);
+    return probes[probe_id];
   }
 
 private:
-  BwTree<GenericKey, Uint64, GenericKeyComparator, GenericKeyEqualityChecker, GenericKeyHasher> *container_;
+  // keys carry their 8-byte prefix, so that most comparisons are one integer compare.
+  typedef BwTree<PrefixGenericKey, Uint64, PrefixGenericKeyComparator, PrefixGenericKeyEqualityChecker, PrefixGenericKeyHasher> ContainerT;
+
+  ContainerT *container_;
   size_t thread_count_;
+  EntryCounter entry_counter_;
 };
 
 }
@@ -3,6 +3,7 @@
 #include "bw_tree/bwtree.h"
 
 #include "base_dynamic_index.h"
+#include "entry_counter.h"
 
 
 namespace dynamic_index {
@@ -31,17 +32,74 @@ public:
   virtual void register_thread(const size_t thread_id) final {
     assert(thread_id < thread_count_);
     container_->AssignGCID(thread_id);
+    EntryCounter::register_thread(thread_id);
   }
 
   virtual void insert(const KeyT &key, const Uint64 &offset) final {
-    container_->Insert(key, offset);
+    if (container_->Insert(key, offset)) {
+      entry_counter_.add(1);
+    }
+  }
+
+  // each group is inserted within one epoch. the groups keep the epochs short,
+  // so that garbage collection goes on during a long load.
+  virtual void bulk_load(const std::pair<KeyT, Uint64> *entries, const size_t count) final {
+    for (size_t begin = 0; begin < count; begin += BULK_LOAD_GROUP_SIZE) {
+      entry_counter_.add(container_->InsertBatch(entries + begin, std::min(count - begin, BULK_LOAD_GROUP_SIZE)));
+    }
   }
 
+  using BaseDynamicIndex<KeyT, ValueT>::find;
+
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
     container_->GetValue(key, offsets);
   }
 
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    container_->GetValueBatch(keys, count, offsets);
+  }
+
   virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  // streams the offsets from the tree iterator.
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
+  // the tree deletes one key-value pair at a time.
+  virtual void erase(const KeyT &key) final {
+    std::vector<Uint64> offsets;
+    container_->GetValue(key, offsets);
+    for (auto offset : offsets) {
+      if (container_->Delete(key, offset)) {
+        entry_counter_.add(-1);
+      }
+    }
+  }
+
+  virtual void erase(const KeyT &key, const Uint64 &offset) final {
+    if (container_->Delete(key, offset)) {
+      entry_counter_.add(-1);
+    }
+  }
+
+  virtual size_t size() const final {
+    return entry_counter_.get();
+  }
+
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = entry_counter_.get();
+    container_->GetMemoryUsage(&stats.inner_bytes_, &stats.leaf_bytes_, &stats.delta_bytes_, &stats.garbage_bytes_,
+      [](const KeyT &) { return size_t(0); });
+    return stats;
+  }
+
+private:
+  template<typename OutputT>
+  void find_range_into(const KeyT &lhs_key, const KeyT &rhs_key, OutputT &offsets) {
 
     if (lhs_key > rhs_key) { return; }
 
@@ -55,18 +113,10 @@ public:
     }
   }
 
-  virtual void erase(const KeyT &key) final {
-    // container_.erase(key);
-  }
-
-  virtual size_t size() const final {
-    // return container_.size();
-    return 0;
-  }
-
 private:
   BwTree<KeyT, Uint64> *container_;
   size_t thread_count_;
+  EntryCounter entry_counter_;
 };
 
 }
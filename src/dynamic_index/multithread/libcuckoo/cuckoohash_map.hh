@@ -320,6 +320,14 @@ public:
    */
   size_type bucket_count() const { return buckets_.size(); }
 
+  /**
+   * Returns the number of bytes taken by the buckets of the table, not counting
+   * memory that the keys and values own.
+   *
+   * @return the size of the bucket array in bytes
+   */
+  size_type bucket_bytes() const { return bucket_count() * sizeof(bucket); }
+
   /**
    * Returns whether the table is empty or not.
    *
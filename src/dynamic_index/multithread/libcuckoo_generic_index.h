@@ -3,6 +3,7 @@
 #include "libcuckoo/cuckoohash_map.hh"
 
 #include "base_dynamic_generic_index.h"
+#include "entry_counter.h"
 
 namespace dynamic_index {
 namespace multithread {
@@ -13,29 +14,85 @@ public:
   LibcuckooGenericIndex(GenericDataTable *table_ptr) : BaseDynamicGenericIndex(table_ptr) {}
   virtual ~LibcuckooGenericIndex() {}
 
+  virtual void register_thread(const size_t thread_id) final {
+    EntryCounter::register_thread(thread_id);
+  }
+
   virtual void insert(const GenericKey &key, const Uint64 &offset) final {
 
     container_.upsert(key, [&offset](std::vector<Uint64>& vec) { vec.push_back(offset); }, 1, offset);
+    entry_counter_.add(1);
+  }
+
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    container_.find(GenericKey(key), offsets);
+  }
+
+  // the offsets are pushed under the bucket lock, so the sink must not modify this index.
+  virtual void find(const GenericKeyView &key, ResultSink &sink) final {
+    container_.find_fn(GenericKey(key), [&sink](const std::vector<Uint64> &vec) {
+      for (auto offset : vec) {
+        sink.push_back(offset);
+      }
+    });
   }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {
-    container_.find(key, offsets);
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    assert(false);
   }
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
     assert(false);
   }
 
   virtual void erase(const GenericKey &key) final {
-    container_.erase(key);
+    size_t count = 0;
+    container_.erase_fn(key, [&count](std::vector<Uint64> &vec) {
+      count = vec.size();
+      return true;
+    });
+    entry_counter_.add(-int64_t(count));
+  }
+
+  // the key goes with its last offset.
+  virtual void erase(const GenericKey &key, const Uint64 &offset) final {
+    bool found = false;
+    container_.erase_fn(key, [&offset, &found](std::vector<Uint64> &vec) {
+      auto iter = std::find(vec.begin(), vec.end(), offset);
+      if (iter != vec.end()) {
+        vec.erase(iter);
+        found = true;
+      }
+      return vec.empty();
+    });
+    if (found) {
+      entry_counter_.add(-1);
+    }
   }
 
+  // the number of entries, rather than of keys.
   virtual size_t size() const final {
-    return container_.size();
+    return entry_counter_.get();
+  }
+
+  // the buckets route a lookup, and the offset vectors hold the entries. walking the
+  // entries takes all the locks of the table, hence the cast.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = entry_counter_.get();
+    stats.inner_bytes_ = container_.bucket_bytes();
+
+    auto locked_container = const_cast<cuckoohash_map<GenericKey, std::vector<Uint64>, GenericKeyHasher>&>(container_).lock_table();
+    for (const auto &entry : locked_container) {
+      stats.leaf_bytes_ += entry.second.capacity() * sizeof(Uint64);
+      stats.leaf_bytes_ += entry.first.heap_bytes();
+    }
+    return stats;
   }
 
 private:
   cuckoohash_map<GenericKey, std::vector<Uint64>, GenericKeyHasher> container_;
+  EntryCounter entry_counter_;
 };
 
 }
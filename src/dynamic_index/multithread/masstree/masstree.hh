@@ -114,6 +114,9 @@ class basic_table {
     inline int modify_insert(Str key, F& f, threadinfo& ti);
 
     inline void print(FILE* f = 0, int indent = 0) const;
+    // bytes in internodes, and in leaves with their key suffixes and values.
+    // not safe against concurrent modification.
+    inline void memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const;
 
   private:
     node_type* root_;
@@ -156,5 +156,48 @@ void basic_table<P>::print(FILE *f, int indent) const {
     root_->print(f ? f : stdout, "", indent, 0);
 }
 
+template <typename P>
+void node_base<P>::memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const
+{
+    if (this->isleaf())
+        static_cast<const leaf<P> *>(this)->memory_usage(inner_bytes, leaf_bytes);
+    else
+        static_cast<const internode<P> *>(this)->memory_usage(inner_bytes, leaf_bytes);
+}
+
+template <typename P>
+void leaf<P>::memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const
+{
+    leaf_bytes += allocated_size();
+    if (ksuf_)
+        leaf_bytes += ksuf_->capacity();
+
+    permuter_type perm = permutation_;
+    for (int idx = 0; idx < perm.size(); ++idx) {
+        int p = perm[idx];
+        leafvalue_type lv = lv_[p];
+        if (!lv)
+            continue;
+        else if (is_layer(p))
+            lv.layer()->unsplit_ancestor()->memory_usage(inner_bytes, leaf_bytes);
+        else
+            leaf_bytes += lv.value()->size();
+    }
+}
+
+template <typename P>
+void internode<P>::memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const
+{
+    inner_bytes += sizeof(*this);
+    for (int p = 0; p <= this->size(); ++p)
+        if (child_[p])
+            child_[p]->memory_usage(inner_bytes, leaf_bytes);
+}
+
+template <typename P>
+inline void basic_table<P>::memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const {
+    root_->unsplit_ancestor()->memory_usage(inner_bytes, leaf_bytes);
+}
+
 } // namespace Masstree
 #endif
@@ -117,6 +117,7 @@ class node_base : public make_nodeversion<P>::type {
     }
 
     void print(FILE* f, const char* prefix, int indent, int kdepth);
+    void memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const;
 };
 
 template <typename P>
@@ -168,6 +169,7 @@ class internode : public node_base<P> {
     }
 
     void print(FILE* f, const char* prefix, int indent, int kdepth);
+    void memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const;
 
     void deallocate(threadinfo& ti) {
         ti.pool_deallocate(this, sizeof(*this), memtag_masstree_internode);
@@ -470,6 +472,7 @@ class leaf : public node_base<P> {
     }
 
     void print(FILE* f, const char* prefix, int indent, int kdepth);
+    void memory_usage(size_t& inner_bytes, size_t& leaf_bytes) const;
 
     leaf<P>* safe_next() const {
         return reinterpret_cast<leaf<P>*>(next_.x & ~(uintptr_t) 1);
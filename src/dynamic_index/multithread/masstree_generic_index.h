@@ -15,6 +15,7 @@
 #include "masstree/kvthread.hh"
 
 #include "base_dynamic_generic_index.h"
+#include "entry_counter.h"
 
 extern volatile uint64_t globalepoch;
 extern volatile bool recovering;
@@ -48,6 +49,7 @@ public:
     if (ti_ == nullptr) {
       ti_ = threadinfo::make(threadinfo::TI_PROCESS, idx++);
     }
+    EntryCounter::register_thread(thread_id);
   }
 
   virtual void insert(const GenericKey &key, const Uint64 &offset) final {
@@ -58,6 +60,7 @@ public:
       ti_->advance_timestamp(lp.node_timestamp());
       qtimes_.ts = ti_->update_timestamp();
       qtimes_.prev_ts = 0;
+      entry_counter_.add(1);
     }
     else {
       qtimes_.ts = ti_->update_timestamp(lp.value()->timestamp());
@@ -70,34 +73,100 @@ public:
 
   }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
+
+  virtual void find(const GenericKeyView &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  // streams the offsets from the scan callback of the tree.
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
+  virtual void erase(const GenericKey &key) final {
+    remove(key, nullptr);
+  }
+
+  virtual void erase(const GenericKey &key, const Uint64 &offset) final {
+    remove(key, &offset);
+  }
+
+  virtual size_t size() const final {
+    return entry_counter_.get();
+  }
 
-    Str value;
+  // values are freed at once on update, and retired nodes sit in limbo lists that the
+  // threadinfos share among all trees, so no garbage is attributed to this tree.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = entry_counter_.get();
+    container_->table().memory_usage(stats.inner_bytes_, stats.leaf_bytes_);
+    return stats;
+  }
+
+private:
+  // visits the keys from the lower bound on, and stops at the first key past the upper bound.
+  template<typename OutputT>
+  struct RangeScanner {
+    RangeScanner(const GenericKeyView &rhs_key, OutputT &offsets) : rhs_key_(rhs_key), offsets_(offsets) {}
+
+    template<typename StackT, typename KeyT>
+    void visit_leaf(const StackT&, const KeyT&, threadinfo&) {}
+
+    bool visit_value(Str key, const row_type *value, threadinfo&) {
+      if (compare_generic_key(key.s, key.len, rhs_key_.raw(), rhs_key_.size()) > 0) { return false; }
+      offsets_.push_back(*(Uint64*)(value->col(0).s));
+      return true;
+    }
+
+    const GenericKeyView &rhs_key_;
+    OutputT &offsets_;
+  };
+
+  template<typename OutputT>
+  void find_into(const GenericKeyView &key, OutputT &offsets) {
     typename Masstree::default_table::unlocked_cursor_type lp(container_->table(), key.raw(), key.size());
     bool found = lp.find_unlocked(*ti_);
     if (found) {
-      value = lp.value()->col(0);
-      offsets.push_back(*(Uint64*)(value.s));
+      offsets.push_back(*(Uint64*)(lp.value()->col(0).s));
     }
   }
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {
-    // assert(false);
-  }
+  template<typename OutputT>
+  void find_range_into(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, OutputT &offsets) {
+    if (lhs_key > rhs_key) { return; }
 
-  virtual void erase(const GenericKey &key) final {
-    // container_.erase(key);
+    RangeScanner<OutputT> scanner(rhs_key, offsets);
+    container_->table().scan(Str(lhs_key.raw(), lhs_key.size()), true, scanner, *ti_);
   }
 
-  virtual size_t size() const final {
-    // return container_.size();
-    return 0;
+  // removes the key, or only its entry for *offset if offset is given.
+  void remove(const GenericKey &key, const Uint64 *offset) {
+
+    typename Masstree::default_table::cursor_type lp(container_->table(), key.raw(), key.size());
+    bool found = lp.find_locked(*ti_);
+    if (found && offset != nullptr) {
+      found = (*(Uint64*)(lp.value()->col(0).s) == *offset);
+    }
+    if (found) {
+      lp.value()->deallocate_rcu(*ti_);
+      entry_counter_.add(-1);
+    }
+    lp.finish(found ? -1 : 0, *ti_);
   }
 
 private:
     Masstree::default_table *container_;
     std::mutex mutex_;
     loginfo::query_times qtimes_;
+    EntryCounter entry_counter_;
 };
 
 }
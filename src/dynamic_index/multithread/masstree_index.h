@@ -15,6 +15,7 @@
 #include "masstree/kvthread.hh"
 
 #include "base_dynamic_index.h"
+#include "entry_counter.h"
 
 extern volatile uint64_t globalepoch;
 extern volatile bool recovering;
@@ -48,6 +49,7 @@ public:
     if (ti_ == nullptr) {
       ti_ = threadinfo::make(threadinfo::TI_PROCESS, idx++);
     }
+    EntryCounter::register_thread(thread_id);
   }
 
   virtual void insert(const KeyT &key, const Uint64 &offset) final {
@@ -58,6 +60,7 @@ public:
       ti_->advance_timestamp(lp.node_timestamp());
       qtimes_.ts = ti_->update_timestamp();
       qtimes_.prev_ts = 0;
+      entry_counter_.add(1);
     }
     else {
       qtimes_.ts = ti_->update_timestamp(lp.value()->timestamp());
@@ -71,33 +74,73 @@ public:
   }
 
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
 
-    Str value;
-    typename Masstree::default_table::unlocked_cursor_type lp(container_->table(), (char*)(&key), sizeof(key));
-    bool found = lp.find_unlocked(*ti_);
-    if (found) {
-      value = lp.value()->col(0);
-      offsets.push_back(*(Uint64*)(value.s));
-    }
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
   }
 
+  // keys are stored in native byte order, so the tree does not scan them in key order.
   virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
     // assert(false);
   }
 
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    // assert(false);
+  }
+
   virtual void erase(const KeyT &key) final {
-    // container_.erase(key);
+    remove(key, nullptr);
+  }
+
+  virtual void erase(const KeyT &key, const Uint64 &offset) final {
+    remove(key, &offset);
   }
 
   virtual size_t size() const final {
-    // return container_.size();
-    return 0;
+    return entry_counter_.get();
+  }
+
+  // values are freed at once on update, and retired nodes sit in limbo lists that the
+  // threadinfos share among all trees, so no garbage is attributed to this tree.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = entry_counter_.get();
+    container_->table().memory_usage(stats.inner_bytes_, stats.leaf_bytes_);
+    return stats;
+  }
+
+private:
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
+    typename Masstree::default_table::unlocked_cursor_type lp(container_->table(), (char*)(&key), sizeof(key));
+    bool found = lp.find_unlocked(*ti_);
+    if (found) {
+      offsets.push_back(*(Uint64*)(lp.value()->col(0).s));
+    }
+  }
+
+  // removes the key, or only its entry for *offset if offset is given.
+  void remove(const KeyT &key, const Uint64 *offset) {
+
+    typename Masstree::default_table::cursor_type lp(container_->table(), (char*)(&key), sizeof(key));
+    bool found = lp.find_locked(*ti_);
+    if (found && offset != nullptr) {
+      found = (*(Uint64*)(lp.value()->col(0).s) == *offset);
+    }
+    if (found) {
+      lp.value()->deallocate_rcu(*ti_);
+      entry_counter_.add(-1);
+    }
+    lp.finish(found ? -1 : 0, *ti_);
   }
 
 private:
     Masstree::default_table *container_;
     std::mutex mutex_;
     loginfo::query_times qtimes_;
+    EntryCounter entry_counter_;
 };
 
 }
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include "art.h"
+#include "result_sink.h"
 
 #ifdef __i386__
     #include <emmintrin.h>
@@ -53,6 +54,7 @@ static art_node* alloc_node(uint8_t type) {
 int art_tree_init(art_tree *t) {
     t->root = NULL;
     t->size = 0;
+    t->value_count = 0;
     return 0;
 }
 
@@ -115,6 +117,62 @@ static void destroy_node(art_node *n) {
     free(n);
 }
 
+// Recursively counts the bytes of a subtree
+static void recursive_memory_usage(const art_node *n, uint64_t *inner_bytes, uint64_t *leaf_bytes) {
+    if (!n) return;
+
+    if (IS_LEAF(n)) {
+        const art_leaf *l = LEAF_RAW(n);
+        *leaf_bytes += sizeof(art_leaf)+l->key_len+l->val_capacity*sizeof(ValueT);
+        return;
+    }
+
+    int i, idx;
+    switch (n->type) {
+        case NODE4:
+            *inner_bytes += sizeof(art_node4);
+            for (i=0;i<n->num_children;i++) {
+                recursive_memory_usage(((const art_node4*)n)->children[i], inner_bytes, leaf_bytes);
+            }
+            break;
+
+        case NODE16:
+            *inner_bytes += sizeof(art_node16);
+            for (i=0;i<n->num_children;i++) {
+                recursive_memory_usage(((const art_node16*)n)->children[i], inner_bytes, leaf_bytes);
+            }
+            break;
+
+        case NODE48:
+            *inner_bytes += sizeof(art_node48);
+            for (i=0;i<256;i++) {
+                idx = ((const art_node48*)n)->keys[i];
+                if (!idx) continue;
+                recursive_memory_usage(((const art_node48*)n)->children[idx-1], inner_bytes, leaf_bytes);
+            }
+            break;
+
+        case NODE256:
+            *inner_bytes += sizeof(art_node256);
+            for (i=0;i<256;i++) {
+                recursive_memory_usage(((const art_node256*)n)->children[i], inner_bytes, leaf_bytes);
+            }
+            break;
+
+        default:
+            abort();
+    }
+}
+
+/**
+ * Counts the bytes held by the nodes of the ART tree
+ */
+void art_memory_usage(const art_tree *t, uint64_t *inner_bytes, uint64_t *leaf_bytes) {
+    *inner_bytes = 0;
+    *leaf_bytes = 0;
+    recursive_memory_usage(t->root, inner_bytes, leaf_bytes);
+}
+
 /**
  * Destroys an ART tree
  * @return 0 on success.
@@ -259,6 +317,22 @@ static int leaf_matches(const art_leaf *n, const unsigned char *key, int key_len
  * @arg rets The vector of matched results
  */
 void art_search(const art_tree *t, const unsigned char *key, int key_len, std::vector<ValueT> &rets) {
+    const art_leaf *l = art_search_leaf(t, key, key_len);
+    if (l == NULL) return;
+
+    for (size_t i = 0; i < l->val_count; ++i) {
+        rets.push_back(art_leaf_value(l, i));
+    }
+}
+
+/**
+ * Searches for the leaf of a key in the ART tree
+ * @arg t The tree
+ * @arg key The key
+ * @arg key_len The length of the key
+ * @return The leaf that holds the values of the key, or NULL
+ */
+const art_leaf* art_search_leaf(const art_tree *t, const unsigned char *key, int key_len) {
     art_node **child;
     art_node *n = t->root;
     int prefix_len, depth = 0;
@@ -269,20 +343,16 @@ void art_search(const art_tree *t, const unsigned char *key, int key_len, std::v
             art_leaf *l = (art_leaf*)n;
             // Check if the expanded path matches
             if (!leaf_matches(l, key, key_len)) {
-
-                for (size_t i = 0; i < l->val_count; ++i) {
-                    ValueT ret = *(ValueT*)(l->kvs+key_len+(i*sizeof(ValueT)));
-                    rets.push_back(ret);
-                }
+                return l;
             }
-            return;
+            return NULL;
         }
 
         // Bail if the prefix does not match
         if (n->partial_len) {
             prefix_len = node_prefix_matches(n, key, key_len, depth);
             if (prefix_len != min(MAX_PREFIX_LEN, n->partial_len)) {
-                return;
+                return NULL;
             }
             depth = depth + n->partial_len;
         }
@@ -292,10 +362,104 @@ void art_search(const art_tree *t, const unsigned char *key, int key_len, std::v
         n = (child) ? *child : NULL;
         depth++;
     }
-    return;
+    return NULL;
 }
 
 
+/**
+ * State of one in-flight lookup of art_search_batch().
+ */
+typedef struct {
+    art_node *n;
+    int depth;
+    size_t idx;
+} art_search_state;
+
+#define ART_SEARCH_BATCH_GROUP 16
+
+/**
+ * Searches for a batch of keys in the ART tree.
+ * Up to ART_SEARCH_BATCH_GROUP lookups are in flight at once. Every lookup
+ * advances by a single node per round and prefetches the node that it
+ * visits in the next round, so the cache misses of different lookups
+ * overlap (asynchronous memory access chaining). A finished lookup hands
+ * its slot to the next key of the batch.
+ * @arg t The tree
+ * @arg keys The keys
+ * @arg key_lens The lengths of the keys
+ * @arg count The number of keys
+ * @arg rets rets[i] receives the matched results of keys[i]
+ */
+void art_search_batch(const art_tree *t, const unsigned char **keys, const int *key_lens, const size_t count, std::vector<ValueT> *rets) {
+    art_search_state states[ART_SEARCH_BATCH_GROUP];
+    size_t next_idx = 0;
+    int active = 0;
+
+    for (int s = 0; s < ART_SEARCH_BATCH_GROUP; ++s) {
+        if (next_idx < count) {
+            states[s].n = t->root;
+            states[s].depth = 0;
+            states[s].idx = next_idx++;
+            ++active;
+        } else {
+            states[s].idx = count;
+        }
+    }
+
+    while (active > 0) {
+        for (int s = 0; s < ART_SEARCH_BATCH_GROUP; ++s) {
+            art_search_state *st = &states[s];
+            if (st->idx == count) continue;
+
+            const unsigned char *key = keys[st->idx];
+            int key_len = key_lens[st->idx];
+            art_node *n = st->n;
+            bool done = false;
+
+            if (!n) {
+                done = true;
+            } else if (IS_LEAF(n)) {
+                art_leaf *l = LEAF_RAW(n);
+                if (!leaf_matches(l, key, key_len)) {
+                    for (size_t i = 0; i < l->val_count; ++i) {
+                        ValueT ret = *(ValueT*)(l->kvs+key_len+(i*sizeof(ValueT)));
+                        rets[st->idx].push_back(ret);
+                    }
+                }
+                done = true;
+            } else {
+                int depth = st->depth;
+                if (n->partial_len) {
+                    int prefix_len = node_prefix_matches(n, key, key_len, depth);
+                    if (prefix_len != min(MAX_PREFIX_LEN, n->partial_len)) {
+                        done = true;
+                    }
+                    depth = depth + n->partial_len;
+                }
+                if (!done) {
+                    art_node **child = find_child(n, key[depth]);
+                    st->n = (child) ? *child : NULL;
+                    st->depth = depth + 1;
+                    if (st->n) {
+                        __builtin_prefetch(LEAF_RAW(st->n), 0, 3);
+                    }
+                }
+            }
+
+            if (done) {
+                if (next_idx < count) {
+                    st->n = t->root;
+                    st->depth = 0;
+                    st->idx = next_idx++;
+                } else {
+                    st->idx = count;
+                    --active;
+                }
+            }
+        }
+    }
+}
+
 // Find the minimum leaf under a node
 static art_leaf* minimum(const art_node *n) {
     // Handle base cases
@@ -670,9 +834,95 @@ bool art_insert(art_tree *t, const unsigned char *key, int key_len, ValueT value
     if (is_new == true) {
         t->size++;
     }
+    t->value_count++;
     return is_new;
 }
 
+/**
+ * Returns the length of the common prefix of two keys, starting at depth
+ */
+static int key_common_prefix(const unsigned char *k1, int k1_len, const unsigned char *k2, int k2_len, int depth) {
+    int max_cmp = min(k1_len, k2_len) - depth;
+    int idx;
+    for (idx=0; idx < max_cmp; idx++) {
+        if (k1[depth+idx] != k2[depth+idx])
+            return idx;
+    }
+    return idx;
+}
+
+/**
+ * Builds the subtree of the sorted keys [begin, end), which share their
+ * first depth bytes. A run of equal keys becomes one leaf.
+ */
+static art_node* build_subtree(const unsigned char **keys, const int *key_lens, const ValueT *values, size_t begin, size_t end, int depth, uint64_t *leaf_count) {
+    const unsigned char *first = keys[begin];
+    const unsigned char *last = keys[end-1];
+    int first_len = key_lens[begin];
+    int last_len = key_lens[end-1];
+
+    if (first_len == last_len && !memcmp(first, last, first_len)) {
+        size_t count = end - begin;
+        art_leaf *l = (art_leaf*)calloc(1, sizeof(art_leaf)+first_len+count*sizeof(ValueT));
+        l->key_len = first_len;
+        l->val_count = count;
+        l->val_capacity = count;
+        memcpy(l->kvs, first, first_len);
+        memcpy(l->kvs+first_len, values+begin, count*sizeof(ValueT));
+        (*leaf_count)++;
+        return (art_node*)SET_LEAF(l);
+    }
+
+    // The keys are sorted, so the first and the last key bound the common prefix
+    int prefix_len = key_common_prefix(first, first_len, last, last_len, depth);
+    int child_depth = depth + prefix_len;
+
+    // As with inserts, no key may be a prefix of another one
+    int num_children = 0;
+    for (size_t i = begin; i < end; i++) {
+        assert(key_lens[i] > child_depth);
+        if (i == begin || keys[i][child_depth] != keys[i-1][child_depth]) {
+            num_children++;
+        }
+    }
+
+    uint8_t type = NODE256;
+    if (num_children <= 4) {
+        type = NODE4;
+    } else if (num_children <= 16) {
+        type = NODE16;
+    } else if (num_children <= 48) {
+        type = NODE48;
+    }
+    art_node *n = alloc_node(type);
+    n->partial_len = prefix_len;
+    memcpy(n->partial, first+depth, min(MAX_PREFIX_LEN, prefix_len));
+
+    // Children come in key order, and the node is large enough for all of them
+    size_t child_begin = begin;
+    while (child_begin < end) {
+        unsigned char c = keys[child_begin][child_depth];
+        size_t child_end = child_begin + 1;
+        while (child_end < end && keys[child_end][child_depth] == c) {
+            child_end++;
+        }
+        art_node *child = build_subtree(keys, key_lens, values, child_begin, child_end, child_depth+1, leaf_count);
+        add_child(n, &n, c, child);
+        child_begin = child_end;
+    }
+    return n;
+}
+
+/**
+ * Builds an empty ART tree bottom-up from sorted keys
+ */
+void art_bulk_load(art_tree *t, const unsigned char **keys, const int *key_lens, const ValueT *values, size_t count) {
+    assert(t->root == NULL);
+    if (count == 0) return;
+    t->root = build_subtree(keys, key_lens, values, 0, count, 0, &t->size);
+    t->value_count = count;
+}
+
 static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
     n->children[c] = NULL;
     n->n.num_children--;
@@ -836,10 +1086,41 @@ void art_delete(art_tree *t, const unsigned char *key, int key_len) {
     art_leaf *l = recursive_delete(t->root, &t->root, key, key_len, 0);
     if (l) {
         t->size--;
+        t->value_count -= l->val_count;
         free(l);
     }
 }
 
+/**
+ * Deletes one value of a key from the ART tree. The other values
+ * keep their order
+ * @arg t The tree
+ * @arg key The key
+ * @arg key_len The length of the key
+ * @arg value The value to delete
+ * @return True if the value was found, otherwise return False.
+ */
+bool art_delete_value(art_tree *t, const unsigned char *key, int key_len, ValueT value) {
+    art_leaf *l = (art_leaf*)art_search_leaf(t, key, key_len);
+    if (!l) return false;
+
+    ValueT *values = (ValueT*)(l->kvs+l->key_len);
+    for (uint32_t i = 0; i < l->val_count; i++) {
+        if (values[i] != value) continue;
+
+        // The last value takes the leaf with it
+        if (l->val_count == 1) {
+            art_delete(t, key, key_len);
+        } else {
+            memmove(values+i, values+i+1, (l->val_count-i-1)*sizeof(ValueT));
+            l->val_count--;
+            t->value_count--;
+        }
+        return true;
+    }
+    return false;
+}
+
 // Retrieve all the leaves given a node
 static void recursive_scan(art_node *n, std::vector<ValueT> &rets) {
     // Handle base cases
@@ -891,6 +1172,68 @@ static void recursive_scan(art_node *n, std::vector<ValueT> &rets) {
     return;
 }
 
+// Compares a leaf key with a bound, in the order of the tree
+static int compare_leaf_key(const art_leaf *l, const unsigned char *key, int key_len) {
+    int res = memcmp(l->kvs, key, std::min((int)l->key_len, key_len));
+    if (res != 0) return res;
+    return (int)l->key_len - key_len;
+}
+
+// Retrieve the leaves in [lhs_key, rhs_key] given a node
+template<typename OutputT>
+static void recursive_range_scan(art_node *n, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, OutputT &rets) {
+    // Handle base cases
+    if (!n) return;
+    if (IS_LEAF(n)) {
+        art_leaf *l = LEAF_RAW(n);
+
+        if (compare_leaf_key(l, lhs_key, lhs_key_len) < 0 || compare_leaf_key(l, rhs_key, rhs_key_len) > 0) {
+            return;
+        }
+        for (size_t i = 0; i < l->val_count; ++i) {
+            ValueT ret = *(ValueT*)(l->kvs+l->key_len+(i*sizeof(ValueT)));
+            rets.push_back(ret);
+        }
+        return;
+    }
+
+    int idx;
+    switch (n->type) {
+        case NODE4:
+            for (int i=0; i < n->num_children; i++) {
+                recursive_range_scan(((art_node4*)n)->children[i], lhs_key, lhs_key_len, rhs_key, rhs_key_len, rets);
+            }
+            break;
+
+        case NODE16:
+            for (int i=0; i < n->num_children; i++) {
+                recursive_range_scan(((art_node16*)n)->children[i], lhs_key, lhs_key_len, rhs_key, rhs_key_len, rets);
+            }
+            break;
+
+        case NODE48:
+            for (int i=0; i < 256; i++) {
+                idx = ((art_node48*)n)->keys[i];
+                if (!idx) continue;
+
+                recursive_range_scan(((art_node48*)n)->children[idx-1], lhs_key, lhs_key_len, rhs_key, rhs_key_len, rets);
+            }
+            break;
+
+        case NODE256:
+            for (int i=0; i < 256; i++) {
+                if (!((art_node256*)n)->children[i]) continue;
+
+                recursive_range_scan(((art_node256*)n)->children[i], lhs_key, lhs_key_len, rhs_key, rhs_key_len, rets);
+            }
+            break;
+
+        default:
+            abort();
+    }
+    return;
+}
+
 /**
  * Scan the entire tree.
  * @arg t The tree to iterate over
@@ -900,37 +1243,36 @@ void art_scan(art_tree *t, std::vector<ValueT> &rets) {
     recursive_scan(t->root, rets);
 }
 
-// Retrieve all the leaves given a node
-static void recursive_scan_limit(art_node *n, std::vector<ValueT> &rets, const size_t count) {
+// Retrieve the leaves given a node, until remaining values have been taken
+template<typename OutputT>
+static void recursive_scan_limit(art_node *n, OutputT &rets, size_t &remaining) {
     // Handle base cases
     if (!n) return;
     if (IS_LEAF(n)) {
         art_leaf *l = LEAF_RAW(n);
 
         for (size_t i = 0; i < l->val_count; ++i) {
+            if (remaining == 0) { return; }
             ValueT ret = *(ValueT*)(l->kvs+l->key_len+(i*sizeof(ValueT)));
-            if (rets.size() < count) {
-                rets.push_back(ret);
-            } else {
-                return;
-            }
+            rets.push_back(ret);
+            --remaining;
         }
         return;
     }
 
-    int idx, res;
+    int idx;
     switch (n->type) {
         case NODE4:
             for (int i=0; i < n->num_children; i++) {
-                recursive_scan_limit(((art_node4*)n)->children[i], rets, count);
-                if (rets.size() >= count) { return; }
+                recursive_scan_limit(((art_node4*)n)->children[i], rets, remaining);
+                if (remaining == 0) { return; }
             }
             break;
 
         case NODE16:
             for (int i=0; i < n->num_children; i++) {
-                recursive_scan_limit(((art_node16*)n)->children[i], rets, count);
-                if (rets.size() >= count) { return; }
+                recursive_scan_limit(((art_node16*)n)->children[i], rets, remaining);
+                if (remaining == 0) { return; }
             }
             break;
 
@@ -939,8 +1281,8 @@ static void recursive_scan_limit(art_node *n, std::vector<ValueT> &rets, const s
                 idx = ((art_node48*)n)->keys[i];
                 if (!idx) continue;
 
-                recursive_scan_limit(((art_node48*)n)->children[idx-1], rets, count);
-                if (rets.size() >= count) { return; }
+                recursive_scan_limit(((art_node48*)n)->children[idx-1], rets, remaining);
+                if (remaining == 0) { return; }
             }
             break;
 
@@ -948,8 +1290,8 @@ static void recursive_scan_limit(art_node *n, std::vector<ValueT> &rets, const s
             for (int i=0; i < 256; i++) {
                 if (!((art_node256*)n)->children[i]) continue;
 
-                recursive_scan_limit(((art_node256*)n)->children[i], rets, count);
-                if (rets.size() >= count) { return; }
+                recursive_scan_limit(((art_node256*)n)->children[i], rets, remaining);
+                if (remaining == 0) { return; }
             }
             break;
 
@@ -960,12 +1302,23 @@ static void recursive_scan_limit(art_node *n, std::vector<ValueT> &rets, const s
 }
 
 /**
- * Scan the entire tree.
+ * Scan the tree until rets holds count values.
  * @arg t The tree to iterate over
  * @arg rets The vector that holds all the results
  */
 void art_scan_limit(art_tree *t, std::vector<ValueT> &rets, const size_t count) {
-    recursive_scan_limit(t->root, rets, count);
+    size_t remaining = count > rets.size() ? count - rets.size() : 0;
+    recursive_scan_limit(t->root, rets, remaining);
+}
+
+/**
+ * Scan the tree, streaming up to count values into the sink.
+ * @arg t The tree to iterate over
+ * @arg sink The sink that receives the results
+ */
+void art_scan_limit(art_tree *t, ResultSink &sink, const size_t count) {
+    size_t remaining = count;
+    recursive_scan_limit(t->root, sink, remaining);
 }
 
 /**
@@ -977,7 +1330,8 @@ void art_scan_limit(art_tree *t, std::vector<ValueT> &rets, const size_t count)
  * @arg rhs_key_len The length of the right-hand-side key
  * @arg rets The vector of matched results
  */
-void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, std::vector<ValueT> &rets) {
+template<typename OutputT>
+static void range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, OutputT &rets) {
 
     // compute common prefix between lhs_key and rhs_key
     int prefix_key_len = 0;
@@ -994,21 +1348,7 @@ void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key
     while (n) {
         // if it is a leaf
         if (IS_LEAF(n)) {
-            n = (art_node*)LEAF_RAW(n);
-            art_leaf *l = (art_leaf*)n;
-            // check if the expanded path matches
-            if (!leaf_matches(l, lhs_key, prefix_key_len)) {
-                // if matches the prefix, 
-                // then include this leaf only if prefix_len is equal to lhs_key_len or rhs_key_len
-                if (prefix_key_len == lhs_key_len || prefix_key_len == rhs_key_len) {
-
-                    for (size_t i = 0; i < l->val_count; ++i) {
-                        ValueT ret = *(ValueT*)(l->kvs+l->key_len+(i*sizeof(ValueT)));
-                        rets.push_back(ret);
-                    }
-                }
-                return;
-            }
+            break;
         }
 
         // if nothing to match, then break.
@@ -1045,7 +1385,16 @@ void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key
 
     if (n == nullptr) { return; }
 
-    recursive_scan(n, rets);
+    // the subtree shares the common prefix. leaves outside the bounds are skipped.
+    recursive_range_scan(n, lhs_key, lhs_key_len, rhs_key, rhs_key_len, rets);
+}
+
+void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, std::vector<ValueT> &rets) {
+    range_scan(t, lhs_key, lhs_key_len, rhs_key, rhs_key_len, rets);
+}
+
+void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, ResultSink &sink) {
+    range_scan(t, lhs_key, lhs_key_len, rhs_key, rhs_key_len, sink);
 }
 
 
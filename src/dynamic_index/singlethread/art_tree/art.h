@@ -32,6 +32,8 @@
 
 typedef uint64_t ValueT;
 
+class ResultSink;
+
 typedef int(*art_callback)(void *data, const unsigned char *key, uint32_t key_len, ValueT value);
 
 /**
@@ -93,12 +95,20 @@ typedef struct {
     unsigned char kvs[];
 } art_leaf;
 
+/**
+ * Returns the i-th value of a leaf. The values follow the key.
+ */
+inline ValueT art_leaf_value(const art_leaf *l, size_t i) {
+    return *(const ValueT*)(l->kvs+l->key_len+(i*sizeof(ValueT)));
+}
+
 /**
  * Main struct, points to root.
  */
 typedef struct {
     art_node *root;
     uint64_t size;
+    uint64_t value_count;
 } art_tree;
 
 /**
@@ -138,6 +148,22 @@ inline uint64_t art_size(const art_tree *t) {
 }
 #endif
 
+/**
+ * Returns the number of values in the ART tree. A key
+ * with several values counts once in art_size()
+ */
+inline uint64_t art_value_count(const art_tree *t) {
+    return t->value_count;
+}
+
+/**
+ * Counts the bytes held by the nodes of the ART tree
+ * @arg t The tree
+ * @arg inner_bytes Receives the bytes of the inner nodes
+ * @arg leaf_bytes Receives the bytes of the leaves
+ */
+void art_memory_usage(const art_tree *t, uint64_t *inner_bytes, uint64_t *leaf_bytes);
+
 /**
  * Inserts a new value into the ART tree
  * @arg t The tree
@@ -148,6 +174,16 @@ inline uint64_t art_size(const art_tree *t) {
  */
 bool art_insert(art_tree *t, const unsigned char *key, int key_len, ValueT value);
 
+/**
+ * Builds an empty ART tree bottom-up, without the node growth of inserts
+ * @arg t The tree, which must be empty
+ * @arg keys The keys in byte order. Equal keys are adjacent and share a leaf
+ * @arg key_lens The lengths of the keys
+ * @arg values values[i] belongs to keys[i]
+ * @arg count The number of keys
+ */
+void art_bulk_load(art_tree *t, const unsigned char **keys, const int *key_lens, const ValueT *values, size_t count);
+
 /**
  * Deletes a value from the ART tree
  * @arg t The tree
@@ -156,6 +192,17 @@ bool art_insert(art_tree *t, const unsigned char *key, int key_len, ValueT value
  */
 void art_delete(art_tree *t, const unsigned char *key, int key_len);
 
+/**
+ * Deletes one value of a key from the ART tree. The key is
+ * deleted with its last value
+ * @arg t The tree
+ * @arg key The key
+ * @arg key_len The length of the key
+ * @arg value The value to delete
+ * @return True if the value was found, otherwise return False.
+ */
+bool art_delete_value(art_tree *t, const unsigned char *key, int key_len, ValueT value);
+
 /**
  * Searches for a value in the ART tree
  * @arg t The tree
@@ -165,6 +212,25 @@ void art_delete(art_tree *t, const unsigned char *key, int key_len);
  */
 void art_search(const art_tree *t, const unsigned char *key, int key_len, std::vector<ValueT> &rets);
 
+/**
+ * Searches for the leaf of a key in the ART tree
+ * @arg t The tree
+ * @arg key The key
+ * @arg key_len The length of the key
+ * @return The leaf that holds the values of the key, or NULL
+ */
+const art_leaf* art_search_leaf(const art_tree *t, const unsigned char *key, int key_len);
+
+/**
+ * Searches for a batch of keys, interleaving the lookups
+ * @arg t The tree
+ * @arg keys The keys
+ * @arg key_lens The lengths of the keys
+ * @arg count The number of keys
+ * @arg rets rets[i] receives the matched results of keys[i]
+ */
+void art_search_batch(const art_tree *t, const unsigned char **keys, const int *key_lens, const size_t count, std::vector<ValueT> *rets);
+
 /**
  * Searches for a value in the ART tree
  * @arg t The tree
@@ -176,6 +242,12 @@ void art_search(const art_tree *t, const unsigned char *key, int key_len, std::v
  */
 void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, std::vector<ValueT> &rets);
 
+/**
+ * Streams the values in [lhs_key, rhs_key] into a sink, without storing them
+ * @arg sink The sink that receives the matched results
+ */
+void art_range_scan(const art_tree *t, const unsigned char *lhs_key, int lhs_key_len, const unsigned char *rhs_key, int rhs_key_len, ResultSink &sink);
+
 /**
  * Returns the minimum valued leaf
  * @return The minimum leaf or NULL
@@ -197,6 +269,8 @@ void art_scan(art_tree *t, std::vector<ValueT> &rets);
 
 void art_scan_limit(art_tree *t, std::vector<ValueT> &rets, const size_t count);
 
+void art_scan_limit(art_tree *t, ResultSink &sink, const size_t count);
+
 /**
  * Iterates through the entries pairs in the map,
  * invoking a callback for each. The call back gets a
@@ -19,28 +19,139 @@ public:
   }
 
   virtual void insert(const GenericKey &key, const Uint64 &offset) final {
-    art_insert(&container_, (unsigned char*)(key.raw()), key.size(), offset);
+    GenericKeyView tree_key = load_key(key, 0);
+    art_insert(&container_, (unsigned char*)(tree_key.raw()), tree_key.size(), offset);
   }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {
-    art_search(&container_, (unsigned char*)(key.raw()), key.size(), offsets);
+  // the tree is built bottom-up, so that nodes are allocated at their final size.
+  virtual void bulk_load(const std::pair<GenericKey, Uint64> *entries, const size_t count) final {
+    std::vector<const unsigned char*> key_ptrs(count);
+    std::vector<int> key_lens(count);
+    std::vector<Uint64> values(count);
+
+    // the encoded keys are packed into one buffer.
+    size_t buffer_size = 0;
+    for (size_t i = 0; i < count; ++i) {
+      key_lens[i] = prefix_free_key_size(entries[i].first.raw(), entries[i].first.size());
+      buffer_size += key_lens[i];
+    }
+    std::vector<char> key_buffer(buffer_size);
+
+    char *key_ptr = key_buffer.data();
+    for (size_t i = 0; i < count; ++i) {
+      encode_prefix_free_key(entries[i].first.raw(), entries[i].first.size(), (uint8_t*)key_ptr);
+      key_ptrs[i] = (unsigned char*)key_ptr;
+      key_ptr += key_lens[i];
+      values[i] = entries[i].second;
+    }
+    art_bulk_load(&container_, key_ptrs.data(), key_lens.data(), values.data(), count);
+  }
+
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    GenericKeyView tree_key = load_key(key, 0);
+    art_search(&container_, (unsigned char*)(tree_key.raw()), tree_key.size(), offsets);
+  }
+
+  virtual void find(const GenericKeyView &key, ResultSink &sink) final {
+    GenericKeyView tree_key = load_key(key, 0);
+    const art_leaf *leaf = art_search_leaf(&container_, (unsigned char*)(tree_key.raw()), tree_key.size());
+    if (leaf == nullptr) { return; }
+    for (size_t i = 0; i < leaf->val_count; ++i) {
+      sink.push_back(art_leaf_value(leaf, i));
+    }
+  }
+
+  virtual void find_batch(const GenericKey *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    static thread_local std::vector<char> key_buffer;
+    const unsigned char *key_ptrs[FIND_BATCH_GROUP_SIZE];
+    int key_lens[FIND_BATCH_GROUP_SIZE];
+
+    for (size_t begin = 0; begin < count; begin += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(count - begin, FIND_BATCH_GROUP_SIZE);
+
+      // the encoded keys of a group are packed into one per-thread buffer.
+      size_t buffer_size = 0;
+      for (size_t i = 0; i < group_size; ++i) {
+        key_lens[i] = prefix_free_key_size(keys[begin + i].raw(), keys[begin + i].size());
+        buffer_size += key_lens[i];
+      }
+      if (key_buffer.size() < buffer_size) {
+        key_buffer.resize(buffer_size);
+      }
+
+      char *key_ptr = key_buffer.data();
+      for (size_t i = 0; i < group_size; ++i) {
+        encode_prefix_free_key(keys[begin + i].raw(), keys[begin + i].size(), (uint8_t*)key_ptr);
+        key_ptrs[i] = (unsigned char*)key_ptr;
+        key_ptr += key_lens[i];
+      }
+      art_search_batch(&container_, key_ptrs, key_lens, group_size, offsets + begin);
+    }
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    GenericKeyView lhs_tree_key = load_key(lhs_key, 0);
+    GenericKeyView rhs_tree_key = load_key(rhs_key, 1);
+    art_range_scan(&container_, (unsigned char*)(lhs_tree_key.raw()), lhs_tree_key.size(), (unsigned char*)(rhs_tree_key.raw()), rhs_tree_key.size(), offsets);
   }
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {
-    art_range_scan(&container_, (unsigned char*)(lhs_key.raw()), lhs_key.size(), (unsigned char*)(rhs_key.raw()), rhs_key.size(), offsets);
+  // the bounds sit in the per-thread buffers during the scan, so the sink must not run range
+  // scans on this index.
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    GenericKeyView lhs_tree_key = load_key(lhs_key, 0);
+    GenericKeyView rhs_tree_key = load_key(rhs_key, 1);
+    art_range_scan(&container_, (unsigned char*)(lhs_tree_key.raw()), lhs_tree_key.size(), (unsigned char*)(rhs_tree_key.raw()), rhs_tree_key.size(), sink);
   }
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
     art_scan_limit(&container_, offsets, count);
   }
 
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    art_scan_limit(&container_, sink, count);
+  }
+
   virtual void erase(const GenericKey &key) final {
-    // container_.erase(key);
+    GenericKeyView tree_key = load_key(key, 0);
+    art_delete(&container_, (unsigned char*)(tree_key.raw()), tree_key.size());
+  }
+
+  virtual void erase(const GenericKey &key, const Uint64 &offset) final {
+    GenericKeyView tree_key = load_key(key, 0);
+    art_delete_value(&container_, (unsigned char*)(tree_key.raw()), tree_key.size(), offset);
   }
 
   virtual size_t size() const final {
 
-    return art_size(&container_);
+    return art_value_count(&container_);
+  }
+
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = art_value_count(&container_);
+
+    uint64_t inner_bytes = 0;
+    uint64_t leaf_bytes = 0;
+    art_memory_usage(&container_, &inner_bytes, &leaf_bytes);
+    stats.inner_bytes_ = inner_bytes;
+    stats.leaf_bytes_ = leaf_bytes;
+    return stats;
+  }
+
+private:
+  // the tree needs prefix-free keys. a key is encoded into one of two per-thread buffers, so
+  // that lookups do not allocate once the buffers have grown. range scans encode their upper
+  // bound into the second buffer.
+  static GenericKeyView load_key(const GenericKeyView &key, const size_t buffer_id) {
+    static thread_local std::vector<char> key_buffers[2];
+    std::vector<char> &key_buffer = key_buffers[buffer_id];
+
+    size_t tree_key_size = prefix_free_key_size(key.raw(), key.size());
+    if (key_buffer.size() < tree_key_size) {
+      key_buffer.resize(tree_key_size);
+    }
+    encode_prefix_free_key(key.raw(), key.size(), (uint8_t*)(key_buffer.data()));
+    return GenericKeyView(key_buffer.data(), tree_key_size);
   }
 
 private:
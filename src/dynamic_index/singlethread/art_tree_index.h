@@ -24,28 +24,97 @@ public:
     art_insert(&container_, (unsigned char*)(&bs_key), sizeof(KeyT), offset);
   }
 
+  // the tree is built bottom-up, so that nodes are allocated at their final size.
+  virtual void bulk_load(const std::pair<KeyT, Uint64> *entries, const size_t count) final {
+    std::vector<KeyT> bs_keys(count);
+    std::vector<const unsigned char*> key_ptrs(count);
+    std::vector<int> key_lens(count, sizeof(KeyT));
+    std::vector<Uint64> values(count);
+
+    for (size_t i = 0; i < count; ++i) {
+      bs_keys[i] = byte_swap<KeyT>(entries[i].first);
+      key_ptrs[i] = (unsigned char*)(&bs_keys[i]);
+      values[i] = entries[i].second;
+    }
+    art_bulk_load(&container_, key_ptrs.data(), key_lens.data(), values.data(), count);
+  }
+
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
     KeyT bs_key = byte_swap<KeyT>(key);
     art_search(&container_, (unsigned char*)(&bs_key), sizeof(KeyT), offsets);
   }
 
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    KeyT bs_key = byte_swap<KeyT>(key);
+    const art_leaf *leaf = art_search_leaf(&container_, (unsigned char*)(&bs_key), sizeof(KeyT));
+    if (leaf == nullptr) { return; }
+    for (size_t i = 0; i < leaf->val_count; ++i) {
+      sink.push_back(art_leaf_value(leaf, i));
+    }
+  }
+
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    KeyT bs_keys[FIND_BATCH_GROUP_SIZE];
+    const unsigned char *key_ptrs[FIND_BATCH_GROUP_SIZE];
+    int key_lens[FIND_BATCH_GROUP_SIZE];
+
+    for (size_t begin = 0; begin < count; begin += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(count - begin, FIND_BATCH_GROUP_SIZE);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        bs_keys[i] = byte_swap<KeyT>(keys[begin + i]);
+        key_ptrs[i] = (unsigned char*)(&bs_keys[i]);
+        key_lens[i] = sizeof(KeyT);
+      }
+      art_search_batch(&container_, key_ptrs, key_lens, group_size, offsets + begin);
+    }
+  }
+
   virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
     KeyT bs_lhs_key = byte_swap<KeyT>(lhs_key);
     KeyT bs_rhs_key = byte_swap<KeyT>(rhs_key);
     art_range_scan(&container_, (unsigned char*)(&bs_lhs_key), sizeof(KeyT), (unsigned char*)(&bs_rhs_key), sizeof(KeyT), offsets);
   }
 
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    KeyT bs_lhs_key = byte_swap<KeyT>(lhs_key);
+    KeyT bs_rhs_key = byte_swap<KeyT>(rhs_key);
+    art_range_scan(&container_, (unsigned char*)(&bs_lhs_key), sizeof(KeyT), (unsigned char*)(&bs_rhs_key), sizeof(KeyT), sink);
+  }
+
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
     art_scan_limit(&container_, offsets, count);
   }
 
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    art_scan_limit(&container_, sink, count);
+  }
+
   virtual void erase(const KeyT &key) final {
-    // container_.erase(key);
+    KeyT bs_key = byte_swap<KeyT>(key);
+    art_delete(&container_, (unsigned char*)(&bs_key), sizeof(KeyT));
+  }
+
+  virtual void erase(const KeyT &key, const Uint64 &offset) final {
+    KeyT bs_key = byte_swap<KeyT>(key);
+    art_delete_value(&container_, (unsigned char*)(&bs_key), sizeof(KeyT), offset);
   }
 
   virtual size_t size() const final {
 
-    return art_size(&container_);
+    return art_value_count(&container_);
+  }
+
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = art_value_count(&container_);
+
+    uint64_t inner_bytes = 0;
+    uint64_t leaf_bytes = 0;
+    art_memory_usage(&container_, &inner_bytes, &leaf_bytes);
+    stats.inner_bytes_ = inner_bytes;
+    stats.leaf_bytes_ = leaf_bytes;
+    return stats;
   }
 
 private:
@@ -0,0 +1,613 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base_dynamic_generic_index.h"
+
+namespace dynamic_index {
+namespace singlethread {
+
+// prefix-btree: a b+tree that stores variable-length keys inside its nodes. the stx index
+// instead keeps a fixed-size PrefixGenericKey per entry, whose bytes live on the heap for keys
+// longer than GenericKey::INLINE_SIZE.
+//  - a leaf packs the bytes of its keys into one buffer, next to slot arrays that hold the
+//    position, the size and the first 4 bytes of every key. the bytes that all keys of a leaf
+//    share are stored once, at the start of the buffer, and stripped from the keys.
+//  - the shared prefix is the common prefix of the fences of the leaf, i.e. the separators
+//    that bound it in the inner nodes. every key between two fences starts with their common
+//    prefix, so the prefix also holds for keys inserted later. it grows when the leaf splits.
+//  - a separator is the shortest prefix of the first key of the right leaf that is not smaller
+//    than the last key of the left leaf (suffix truncation).
+//    keys of child i <= separator i <= keys of child i + 1.
+//  - erased entries leave garbage in the key buffer, which is compacted when the buffer has
+//    to grow. leaves are not merged.
+class PrefixBtreeGenericIndex : public BaseDynamicGenericIndex {
+
+  static const size_t LEAF_CAPACITY = 64;
+  static const size_t INNER_CAPACITY = 64;
+
+  static const size_t MIN_KEY_BUFFER_SIZE = 64; // unit: byte
+
+  struct LeafNode {
+    uint16_t count_;
+    uint16_t prefix_size_;
+    uint32_t keys_size_; // used bytes of keys_, including the prefix and garbage.
+    uint32_t keys_capacity_;
+    char *keys_;
+    LeafNode *next_;
+
+    uint32_t heads_[LEAF_CAPACITY]; // first 4 bytes of the suffix in big-endian order, padded with zeros.
+    uint32_t key_offsets_[LEAF_CAPACITY];
+    uint16_t key_sizes_[LEAF_CAPACITY];
+    Uint64 offsets_[LEAF_CAPACITY];
+  };
+
+  struct InnerNode {
+    uint16_t count_; // number of separators.
+    uint16_t level_; // 1 if the children are leaves.
+
+    uint64_t heads_[INNER_CAPACITY]; // see load_generic_key_prefix.
+    uint32_t key_offsets_[INNER_CAPACITY];
+    uint16_t key_sizes_[INNER_CAPACITY];
+    void *children_[INNER_CAPACITY + 1];
+
+    std::vector<char> keys_;
+  };
+
+  struct Probe {
+    const char *data_;
+    size_t size_;
+    uint64_t head_;
+  };
+
+  // a separator that bounds the leaf on the way down, if there is one.
+  struct Fence {
+    Fence() : data_(nullptr), size_(0), valid_(false) {}
+
+    const char *data_;
+    size_t size_;
+    bool valid_;
+  };
+
+public:
+  PrefixBtreeGenericIndex(GenericDataTable *table_ptr) : BaseDynamicGenericIndex(table_ptr), height_(0), size_(0) {
+    first_leaf_ = new_leaf();
+    root_ = first_leaf_;
+  }
+
+  virtual ~PrefixBtreeGenericIndex() {
+    free_node(root_, height_);
+    root_ = nullptr;
+    first_leaf_ = nullptr;
+  }
+
+  virtual void insert(const GenericKey &key, const Uint64 &offset) final {
+    Probe probe = make_probe(key);
+
+    while (true) {
+      // descend and remember the path and the fences of the leaf.
+      path_.clear();
+      Fence lower_fence;
+      Fence upper_fence;
+
+      void *node = root_;
+      for (size_t level = height_; level > 0; --level) {
+        InnerNode *inner = static_cast<InnerNode*>(node);
+        size_t pos = search_inner(inner, probe);
+        if (pos > 0) {
+          set_fence(inner, pos - 1, lower_fence);
+        }
+        if (pos < inner->count_) {
+          set_fence(inner, pos, upper_fence);
+        }
+        path_.push_back(std::make_pair(inner, pos));
+        node = inner->children_[pos];
+      }
+
+      LeafNode *leaf = static_cast<LeafNode*>(node);
+      if (leaf->count_ < LEAF_CAPACITY) {
+        insert_into_leaf(leaf, probe, offset);
+        ++size_;
+        return;
+      }
+
+      // make room and descend again.
+      split_leaf(leaf, lower_fence, upper_fence);
+    }
+  }
+
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    find_range_into(key, key, offsets);
+  }
+
+  virtual void find(const GenericKeyView &key, ResultSink &sink) final {
+    find_range_into(key, key, sink);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
+  virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
+    scan_full_into(offsets, count);
+  }
+
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    scan_full_into(sink, count);
+  }
+
+  // remove all entries of the key. equal keys may span several leaves.
+  virtual void erase(const GenericKey &key) final {
+    Probe probe = make_probe(key);
+
+    LeafNode *leaf = locate_leaf(probe);
+    size_t pos = search_leaf(leaf, probe, false);
+
+    while (leaf != nullptr) {
+      size_t end = search_leaf(leaf, probe, true);
+      bool reached_end = (end == leaf->count_);
+
+      if (end > pos) {
+        remove_from_leaf(leaf, pos, end);
+        size_ -= end - pos;
+      }
+
+      if (!reached_end) { return; }
+      leaf = leaf->next_;
+      pos = 0;
+    }
+  }
+
+  virtual size_t size() const final {
+    return size_;
+  }
+
+  // leaves are counted with the buffers that pack their keys.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = size_;
+    stats.inner_bytes_ = inner_memory_size(root_, height_);
+    for (LeafNode *leaf = first_leaf_; leaf != nullptr; leaf = leaf->next_) {
+      stats.leaf_bytes_ += sizeof(LeafNode) + leaf->keys_capacity_;
+    }
+    return stats;
+  }
+
+  virtual void print() const final {
+    size_t leaf_count = 0;
+    size_t key_bytes = 0;
+    for (LeafNode *leaf = first_leaf_; leaf != nullptr; leaf = leaf->next_) {
+      ++leaf_count;
+      key_bytes += leaf->keys_capacity_;
+    }
+    size_t memory_size = memory_usage().total_bytes();
+
+    std::cout << "tree height: " << height_ << std::endl;
+    std::cout << "number of leaves: " << leaf_count << std::endl;
+    std::cout << "average leaf fill: " << (double)size_ / leaf_count / LEAF_CAPACITY << std::endl;
+    std::cout << "leaf key bytes: " << key_bytes << std::endl;
+    std::cout << "memory size: " << memory_size << " bytes" << std::endl;
+    std::cout << "memory per key: " << (size_ == 0 ? 0 : (double)memory_size / size_) << " bytes" << std::endl;
+  }
+
+private:
+
+  template<typename OutputT>
+  void find_range_into(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, OutputT &offsets) const {
+    if (lhs_key > rhs_key) { return; }
+
+    Probe lhs_probe = make_probe(lhs_key);
+    Probe rhs_probe = make_probe(rhs_key);
+
+    LeafNode *leaf = locate_leaf(lhs_probe);
+    size_t pos = search_leaf(leaf, lhs_probe, false);
+
+    while (leaf != nullptr) {
+      size_t end = search_leaf(leaf, rhs_probe, true);
+      for (; pos < end; ++pos) {
+        offsets.push_back(leaf->offsets_[pos]);
+      }
+      if (end < leaf->count_) { return; }
+      leaf = leaf->next_;
+      pos = 0;
+    }
+  }
+
+  template<typename OutputT>
+  void scan_full_into(OutputT &offsets, const size_t count) const {
+    size_t i = 0;
+    for (LeafNode *leaf = first_leaf_; leaf != nullptr; leaf = leaf->next_) {
+      for (size_t pos = 0; pos < leaf->count_; ++pos) {
+        if (i == count) { return; }
+        offsets.push_back(leaf->offsets_[pos]);
+        ++i;
+      }
+    }
+  }
+
+  static Probe make_probe(const GenericKeyView &key) {
+    Probe probe;
+    probe.data_ = key.raw();
+    probe.size_ = key.size();
+    probe.head_ = load_generic_key_prefix(key.raw(), key.size());
+    return probe;
+  }
+
+  static uint32_t load_leaf_head(const char *data, const size_t size) {
+    return load_generic_key_prefix(data, size) >> 32;
+  }
+
+  // compares the cached heads first, which settles most comparisons.
+  template<typename HeadT>
+  static int compare_keys(const HeadT lhs_head, const char *lhs, const size_t lhs_size, const HeadT rhs_head, const char *rhs, const size_t rhs_size) {
+    if (lhs_head != rhs_head) {
+      return lhs_head < rhs_head ? -1 : 1;
+    }
+    if (lhs_size > sizeof(HeadT) && rhs_size > sizeof(HeadT)) {
+      return compare_generic_key(lhs + sizeof(HeadT), lhs_size - sizeof(HeadT), rhs + sizeof(HeadT), rhs_size - sizeof(HeadT));
+    }
+    if (lhs_size == rhs_size) { return 0; }
+    return lhs_size < rhs_size ? -1 : 1;
+  }
+
+  static size_t common_prefix_size(const char *lhs, const size_t lhs_size, const char *rhs, const size_t rhs_size) {
+    size_t size = std::min(lhs_size, rhs_size);
+    size_t i = 0;
+    while (i < size && lhs[i] == rhs[i]) { ++i; }
+    return i;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // inner nodes
+  //////////////////////////////////////////////////////////////////////
+
+  // number of separators that are smaller than the probe, i.e. the child to descend into.
+  static size_t search_inner(const InnerNode *node, const Probe &probe) {
+    size_t begin = 0;
+    size_t end = node->count_;
+    while (begin < end) {
+      size_t mid = (begin + end) / 2;
+      if (compare_keys(node->heads_[mid], node->keys_.data() + node->key_offsets_[mid], node->key_sizes_[mid], probe.head_, probe.data_, probe.size_) < 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+
+  static void set_fence(const InnerNode *node, const size_t pos, Fence &fence) {
+    fence.data_ = node->keys_.data() + node->key_offsets_[pos];
+    fence.size_ = node->key_sizes_[pos];
+    fence.valid_ = true;
+  }
+
+  static std::string get_separator(const InnerNode *node, const size_t pos) {
+    return std::string(node->keys_.data() + node->key_offsets_[pos], node->key_sizes_[pos]);
+  }
+
+  static InnerNode* new_inner(const uint16_t level) {
+    InnerNode *node = new InnerNode();
+    node->count_ = 0;
+    node->level_ = level;
+    return node;
+  }
+
+  // place a separator and its right child at pos. the node must not be full.
+  static void insert_into_inner(InnerNode *node, const size_t pos, const std::string &separator, void *right_child) {
+    size_t move_count = node->count_ - pos;
+    memmove(node->heads_ + pos + 1, node->heads_ + pos, move_count * sizeof(uint64_t));
+    memmove(node->key_offsets_ + pos + 1, node->key_offsets_ + pos, move_count * sizeof(uint32_t));
+    memmove(node->key_sizes_ + pos + 1, node->key_sizes_ + pos, move_count * sizeof(uint16_t));
+    memmove(node->children_ + pos + 2, node->children_ + pos + 1, move_count * sizeof(void*));
+
+    node->heads_[pos] = load_generic_key_prefix(separator.data(), separator.size());
+    node->key_offsets_[pos] = node->keys_.size();
+    node->key_sizes_[pos] = separator.size();
+    node->children_[pos + 1] = right_child;
+    node->keys_.insert(node->keys_.end(), separator.begin(), separator.end());
+    ++node->count_;
+  }
+
+  // hand the separator of a split to the parent at the given depth of the path.
+  // full parents split in turn, and a new root is grown at the top.
+  void insert_separator(size_t depth, std::string separator, void *right_child) {
+    while (depth > 0) {
+      InnerNode *node = path_[depth - 1].first;
+      insert_into_inner(node, path_[depth - 1].second, separator, right_child);
+      if (node->count_ < INNER_CAPACITY) { return; }
+
+      // the middle separator moves up. the left half keeps the node.
+      std::vector<std::string> separators;
+      for (size_t i = 0; i < node->count_; ++i) {
+        separators.push_back(get_separator(node, i));
+      }
+      std::vector<void*> children(node->children_, node->children_ + node->count_ + 1);
+      size_t mid = node->count_ / 2;
+
+      InnerNode *right = new_inner(node->level_);
+      right->children_[0] = children[mid + 1];
+      for (size_t i = mid + 1; i < separators.size(); ++i) {
+        insert_into_inner(right, right->count_, separators[i], children[i + 1]);
+      }
+
+      node->count_ = 0;
+      node->keys_.clear();
+      for (size_t i = 0; i < mid; ++i) {
+        insert_into_inner(node, node->count_, separators[i], children[i + 1]);
+      }
+
+      separator = separators[mid];
+      right_child = right;
+      --depth;
+    }
+
+    InnerNode *root = new_inner(height_ + 1);
+    root->children_[0] = root_;
+    insert_into_inner(root, 0, separator, right_child);
+    root_ = root;
+    ++height_;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // leaves
+  //////////////////////////////////////////////////////////////////////
+
+  LeafNode* locate_leaf(const Probe &probe) const {
+    void *node = root_;
+    for (size_t level = height_; level > 0; --level) {
+      InnerNode *inner = static_cast<InnerNode*>(node);
+      node = inner->children_[search_inner(inner, probe)];
+    }
+    return static_cast<LeafNode*>(node);
+  }
+
+  static LeafNode* new_leaf() {
+    LeafNode *leaf = new LeafNode();
+    leaf->count_ = 0;
+    leaf->prefix_size_ = 0;
+    leaf->keys_size_ = 0;
+    leaf->keys_capacity_ = 0;
+    leaf->keys_ = nullptr;
+    leaf->next_ = nullptr;
+    return leaf;
+  }
+
+  static void delete_leaf(LeafNode *leaf) {
+    delete[] leaf->keys_;
+    delete leaf;
+  }
+
+  inline static const char* get_suffix(const LeafNode *leaf, const size_t pos) {
+    return leaf->keys_ + leaf->key_offsets_[pos];
+  }
+
+  // how the keys of the leaf compare to the probe, as far as the leaf prefix tells:
+  // -1 or 1 if all keys are smaller or greater, 0 if the probe starts with the prefix.
+  static int compare_leaf_prefix(const LeafNode *leaf, const Probe &probe) {
+    if (leaf->prefix_size_ == 0) { return 0; }
+    int rt = memcmp(leaf->keys_, probe.data_, std::min<size_t>(leaf->prefix_size_, probe.size_));
+    if (rt != 0) {
+      return rt < 0 ? -1 : 1;
+    }
+    return probe.size_ < leaf->prefix_size_ ? 1 : 0;
+  }
+
+  // position of the first key that is not smaller than the probe, or greater than the probe if upper is set.
+  static size_t search_leaf(const LeafNode *leaf, const Probe &probe, const bool upper) {
+    int rt = compare_leaf_prefix(leaf, probe);
+    if (rt != 0) {
+      return rt > 0 ? 0 : leaf->count_;
+    }
+
+    const char *suffix = probe.data_ + leaf->prefix_size_;
+    size_t suffix_size = probe.size_ - leaf->prefix_size_;
+    uint32_t head = load_leaf_head(suffix, suffix_size);
+
+    size_t begin = 0;
+    size_t end = leaf->count_;
+    while (begin < end) {
+      size_t mid = (begin + end) / 2;
+      int cmp = compare_keys(leaf->heads_[mid], get_suffix(leaf, mid), leaf->key_sizes_[mid], head, suffix, suffix_size);
+      if (cmp < 0 || (upper && cmp == 0)) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+
+  // make room for extra bytes at the end of the key buffer. garbage is dropped on the way.
+  static void reserve_leaf_keys(LeafNode *leaf, const size_t extra) {
+    if (leaf->keys_size_ + extra <= leaf->keys_capacity_) { return; }
+
+    size_t live_size = leaf->prefix_size_;
+    for (size_t pos = 0; pos < leaf->count_; ++pos) {
+      live_size += leaf->key_sizes_[pos];
+    }
+    size_t capacity = std::max(MIN_KEY_BUFFER_SIZE, (live_size + extra) * 5 / 4);
+
+    char *keys = new char[capacity];
+    memcpy(keys, leaf->keys_, leaf->prefix_size_);
+    uint32_t keys_size = leaf->prefix_size_;
+    for (size_t pos = 0; pos < leaf->count_; ++pos) {
+      memcpy(keys + keys_size, get_suffix(leaf, pos), leaf->key_sizes_[pos]);
+      leaf->key_offsets_[pos] = keys_size;
+      keys_size += leaf->key_sizes_[pos];
+    }
+
+    delete[] leaf->keys_;
+    leaf->keys_ = keys;
+    leaf->keys_size_ = keys_size;
+    leaf->keys_capacity_ = capacity;
+  }
+
+  // append a key at pos. the key must start with the leaf prefix, and the leaf must not be full.
+  static void insert_into_leaf(LeafNode *leaf, const Probe &probe, const Uint64 offset) {
+    ASSERT(compare_leaf_prefix(leaf, probe) == 0, "key does not share the leaf prefix");
+
+    size_t pos = search_leaf(leaf, probe, true);
+    const char *suffix = probe.data_ + leaf->prefix_size_;
+    size_t suffix_size = probe.size_ - leaf->prefix_size_;
+
+    reserve_leaf_keys(leaf, suffix_size);
+
+    size_t move_count = leaf->count_ - pos;
+    memmove(leaf->heads_ + pos + 1, leaf->heads_ + pos, move_count * sizeof(uint32_t));
+    memmove(leaf->key_offsets_ + pos + 1, leaf->key_offsets_ + pos, move_count * sizeof(uint32_t));
+    memmove(leaf->key_sizes_ + pos + 1, leaf->key_sizes_ + pos, move_count * sizeof(uint16_t));
+    memmove(leaf->offsets_ + pos + 1, leaf->offsets_ + pos, move_count * sizeof(Uint64));
+
+    memcpy(leaf->keys_ + leaf->keys_size_, suffix, suffix_size);
+    leaf->heads_[pos] = load_leaf_head(suffix, suffix_size);
+    leaf->key_offsets_[pos] = leaf->keys_size_;
+    leaf->key_sizes_[pos] = suffix_size;
+    leaf->offsets_[pos] = offset;
+
+    leaf->keys_size_ += suffix_size;
+    ++leaf->count_;
+  }
+
+  static void remove_from_leaf(LeafNode *leaf, const size_t begin, const size_t end) {
+    size_t move_count = leaf->count_ - end;
+    memmove(leaf->heads_ + begin, leaf->heads_ + end, move_count * sizeof(uint32_t));
+    memmove(leaf->key_offsets_ + begin, leaf->key_offsets_ + end, move_count * sizeof(uint32_t));
+    memmove(leaf->key_sizes_ + begin, leaf->key_sizes_ + end, move_count * sizeof(uint16_t));
+    memmove(leaf->offsets_ + begin, leaf->offsets_ + end, move_count * sizeof(Uint64));
+    leaf->count_ -= end - begin;
+  }
+
+  // copy the entries [begin, end) of the source to an empty leaf with a longer (or equal) prefix.
+  static void fill_leaf(LeafNode *target, const LeafNode *source, const size_t begin, const size_t end, const std::string &prefix) {
+    ASSERT(prefix.size() >= source->prefix_size_, "leaf prefix must not shrink");
+
+    size_t strip_size = prefix.size() - source->prefix_size_;
+
+    size_t keys_size = prefix.size();
+    for (size_t pos = begin; pos < end; ++pos) {
+      keys_size += source->key_sizes_[pos] - strip_size;
+    }
+    target->keys_capacity_ = std::max(MIN_KEY_BUFFER_SIZE, keys_size * 5 / 4);
+    target->keys_ = new char[target->keys_capacity_];
+    memcpy(target->keys_, prefix.data(), prefix.size());
+    target->prefix_size_ = prefix.size();
+    target->keys_size_ = prefix.size();
+
+    for (size_t pos = begin; pos < end; ++pos) {
+      const char *suffix = get_suffix(source, pos) + strip_size;
+      size_t suffix_size = source->key_sizes_[pos] - strip_size;
+      size_t i = target->count_;
+
+      memcpy(target->keys_ + target->keys_size_, suffix, suffix_size);
+      target->heads_[i] = load_leaf_head(suffix, suffix_size);
+      target->key_offsets_[i] = target->keys_size_;
+      target->key_sizes_[i] = suffix_size;
+      target->offsets_[i] = source->offsets_[pos];
+
+      target->keys_size_ += suffix_size;
+      ++target->count_;
+    }
+  }
+
+  // split a full leaf in halves. the left half stays in place, since its predecessor links to it.
+  void split_leaf(LeafNode *leaf, const Fence &lower_fence, const Fence &upper_fence) {
+    // avoid a split point between equal keys if possible, so that separators stay short.
+    size_t count = leaf->count_;
+    size_t mid = count / 2;
+    for (size_t distance = 0; distance < count / 2; ++distance) {
+      if (mid + distance < count && !equal_suffixes(leaf, mid + distance - 1, mid + distance)) {
+        mid += distance;
+        break;
+      }
+      if (mid - distance > 0 && !equal_suffixes(leaf, mid - distance - 1, mid - distance)) {
+        mid -= distance;
+        break;
+      }
+    }
+
+    // the shortest prefix of the first right key that is not smaller than the last left key.
+    const char *last = get_suffix(leaf, mid - 1);
+    const char *first = get_suffix(leaf, mid);
+    size_t first_size = leaf->key_sizes_[mid];
+    size_t separator_size = std::min(first_size, common_prefix_size(last, leaf->key_sizes_[mid - 1], first, first_size) + 1);
+
+    std::string separator(leaf->keys_, leaf->prefix_size_);
+    separator.append(first, separator_size);
+
+    // the fences point into inner nodes, so read them before the separator is inserted.
+    std::string lower_prefix;
+    if (lower_fence.valid_) {
+      lower_prefix.assign(separator, 0, common_prefix_size(lower_fence.data_, lower_fence.size_, separator.data(), separator.size()));
+    }
+    std::string upper_prefix;
+    if (upper_fence.valid_) {
+      upper_prefix.assign(separator, 0, common_prefix_size(separator.data(), separator.size(), upper_fence.data_, upper_fence.size_));
+    }
+
+    LeafNode *right = new_leaf();
+    fill_leaf(right, leaf, mid, count, upper_prefix);
+
+    LeafNode *left = new_leaf();
+    fill_leaf(left, leaf, 0, mid, lower_prefix);
+
+    right->next_ = leaf->next_;
+    left->next_ = right;
+
+    delete[] leaf->keys_;
+    *leaf = *left;
+    delete left;
+
+    insert_separator(path_.size(), separator, right);
+  }
+
+  static bool equal_suffixes(const LeafNode *leaf, const size_t lhs, const size_t rhs) {
+    return compare_keys(leaf->heads_[lhs], get_suffix(leaf, lhs), leaf->key_sizes_[lhs], leaf->heads_[rhs], get_suffix(leaf, rhs), leaf->key_sizes_[rhs]) == 0;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // memory
+  //////////////////////////////////////////////////////////////////////
+
+  static void free_node(void *node, const size_t level) {
+    if (level == 0) {
+      delete_leaf(static_cast<LeafNode*>(node));
+      return;
+    }
+    InnerNode *inner = static_cast<InnerNode*>(node);
+    for (size_t i = 0; i <= inner->count_; ++i) {
+      free_node(inner->children_[i], level - 1);
+    }
+    delete inner;
+  }
+
+  static size_t inner_memory_size(const void *node, const size_t level) {
+    if (level == 0) { return 0; }
+    const InnerNode *inner = static_cast<const InnerNode*>(node);
+    size_t memory_size = sizeof(InnerNode) + inner->keys_.capacity();
+    for (size_t i = 0; i <= inner->count_; ++i) {
+      memory_size += inner_memory_size(inner->children_[i], level - 1);
+    }
+    return memory_size;
+  }
+
+private:
+  void *root_;
+  size_t height_; // number of inner levels.
+  LeafNode *first_leaf_;
+  size_t size_;
+
+  // inner nodes and child positions on the way to the leaf of the last insert.
+  std::vector<std::pair<InnerNode*, size_t>> path_;
+};
+
+}
+}
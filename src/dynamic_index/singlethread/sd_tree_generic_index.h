@@ -1,42 +1,422 @@
 #pragma once
 
-#include <map>
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
 
 #include "base_dynamic_generic_index.h"
 
 namespace dynamic_index {
 namespace singlethread {
 
+// approx-tree: a learned index for variable-length keys.
+//  - entries are kept in key order in a sequence of leaves. a leaf is a sorted array that
+//    is reserved to LEAF_CAPACITY entries, so inserts land in its gap and do not reallocate.
+//    a full leaf is split in halves.
+//  - leaves are separated by fence keys. fence i sits between leaf i and leaf i + 1:
+//    keys of leaf i <= fence i <= keys of leaf i + 1.
+//  - a piecewise linear model over the key bytes that follow the common prefix of the fences
+//    predicts the position of a key among the fences, within MODEL_ERROR positions.
+//    fences added or removed since the last training widen the search window, and the
+//    model is retrained once they reach a fraction of the fences.
 class SdTreeGenericIndex : public BaseDynamicGenericIndex {
 
+  static const size_t LEAF_CAPACITY = 256;
+  static const size_t MODEL_ERROR = 8;
+
+  // a key owned by the index. it is trivially copyable, so that sorted arrays shift by memmove.
+  struct ApproxKey {
+    uint64_t prefix_; // first 8 bytes in big-endian order, padded with zeros.
+    char *data_;
+    size_t size_;
+  };
+
+  struct ApproxEntry {
+    ApproxKey key_;
+    Uint64 offset_;
+  };
+
+  struct ApproxLeaf {
+    ApproxLeaf() { entries_.reserve(LEAF_CAPACITY); }
+
+    std::vector<ApproxEntry> entries_;
+  };
+
+  // maps a key to the position of its lower bound among the fences.
+  struct Segment {
+    uint64_t x_;
+    double y_;
+    double slope_;
+  };
+
 public:
-  SdTreeGenericIndex(GenericDataTable *table_ptr) : BaseDynamicGenericIndex(table_ptr) {}
+  SdTreeGenericIndex(GenericDataTable *table_ptr) : BaseDynamicGenericIndex(table_ptr), size_(0), stale_count_(0) {
+    leaves_.push_back(new ApproxLeaf());
+  }
+
+  virtual ~SdTreeGenericIndex() {
+    for (auto leaf : leaves_) {
+      for (auto &entry : leaf->entries_) {
+        delete[] entry.key_.data_;
+      }
+      delete leaf;
+    }
+    leaves_.clear();
 
-  virtual ~SdTreeGenericIndex() {}
-  
-  virtual void insert(const GenericKey &key, const Uint64 &offset) final {}
+    for (auto &fence : fences_) {
+      delete[] fence.data_;
+    }
+    fences_.clear();
+  }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {}
+  virtual void insert(const GenericKey &key, const Uint64 &offset) final {
+    ApproxKey probe = make_probe(key);
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {}
+    size_t leaf_id = locate_leaf(probe);
+    std::vector<ApproxEntry> &entries = leaves_[leaf_id]->entries_;
+
+    ApproxEntry entry;
+    entry.key_ = copy_key(probe);
+    entry.offset_ = offset;
+    entries.insert(entries.begin() + lower_bound_in_leaf(entries, probe), entry);
+    ++size_;
+
+    if (entries.size() >= LEAF_CAPACITY) {
+      split_leaf(leaf_id);
+    }
+  }
+
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
+
+  virtual void find(const GenericKeyView &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
+    scan_full_into(offsets, count);
   }
 
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    scan_full_into(sink, count);
+  }
+
+  // remove all entries of the key. empty leaves are merged away.
   virtual void erase(const GenericKey &key) final {
+    ApproxKey probe = make_probe(key);
+
+    size_t leaf_id = locate_leaf(probe);
+    size_t pos = lower_bound_in_leaf(leaves_[leaf_id]->entries_, probe);
+
+    while (leaf_id < leaves_.size()) {
+      std::vector<ApproxEntry> &entries = leaves_[leaf_id]->entries_;
+
+      size_t end = pos;
+      while (end < entries.size() && compare_keys(entries[end].key_, probe) == 0) {
+        delete[] entries[end].key_.data_;
+        ++end;
+      }
+      entries.erase(entries.begin() + pos, entries.begin() + end);
+      size_ -= end - pos;
+
+      bool reached_end = (pos == entries.size());
+
+      if (entries.empty() && leaves_.size() > 1) {
+        remove_leaf(leaf_id);
+      } else {
+        ++leaf_id;
+      }
+
+      if (!reached_end) { return; }
+      pos = 0;
+    }
   }
 
   virtual size_t size() const final {
-    return 0;
+    return size_;
+  }
+
+  // leaves hold their reserved entry arrays and the key bytes. the fences and the model
+  // route a lookup.
+  virtual IndexMemoryStats memory_usage() const final {
+    IndexMemoryStats stats;
+    stats.entry_count_ = size_;
+    for (auto leaf : leaves_) {
+      stats.leaf_bytes_ += sizeof(ApproxLeaf) + leaf->entries_.capacity() * sizeof(ApproxEntry);
+      for (auto &entry : leaf->entries_) {
+        stats.leaf_bytes_ += entry.key_.size_;
+      }
+    }
+    stats.inner_bytes_ = leaves_.capacity() * sizeof(ApproxLeaf*) + fences_.capacity() * sizeof(ApproxKey);
+    for (auto &fence : fences_) {
+      stats.inner_bytes_ += fence.size_;
+    }
+    stats.inner_bytes_ += segments_.capacity() * sizeof(Segment) + segment_xs_.capacity() * sizeof(uint64_t) + model_prefix_.capacity();
+    return stats;
   }
 
   virtual void print() const final {
+    std::cout << "number of leaves: " << leaves_.size() << std::endl;
+    std::cout << "average leaf fill: " << (double)size_ / leaves_.size() / LEAF_CAPACITY << std::endl;
+    std::cout << "number of segments: " << segments_.size() << std::endl;
+    std::cout << "model prefix size: " << model_prefix_.size() << std::endl;
+  }
+
+private:
+
+  template<typename OutputT>
+  void find_into(const GenericKeyView &key, OutputT &offsets) const {
+    ApproxKey probe = make_probe(key);
+
+    size_t leaf_id = locate_leaf(probe);
+    size_t pos = lower_bound_in_leaf(leaves_[leaf_id]->entries_, probe);
+
+    // equal keys may continue in the following leaves.
+    for (; leaf_id < leaves_.size(); ++leaf_id, pos = 0) {
+      const std::vector<ApproxEntry> &entries = leaves_[leaf_id]->entries_;
+      for (; pos < entries.size(); ++pos) {
+        if (compare_keys(entries[pos].key_, probe) != 0) { return; }
+        offsets.push_back(entries[pos].offset_);
+      }
+    }
+  }
+
+  template<typename OutputT>
+  void find_range_into(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, OutputT &offsets) const {
+    if (lhs_key > rhs_key) { return; }
+
+    ApproxKey lhs_probe = make_probe(lhs_key);
+    ApproxKey rhs_probe = make_probe(rhs_key);
+
+    size_t leaf_id = locate_leaf(lhs_probe);
+    size_t pos = lower_bound_in_leaf(leaves_[leaf_id]->entries_, lhs_probe);
+
+    for (; leaf_id < leaves_.size(); ++leaf_id, pos = 0) {
+      const std::vector<ApproxEntry> &entries = leaves_[leaf_id]->entries_;
+      for (; pos < entries.size(); ++pos) {
+        if (compare_keys(entries[pos].key_, rhs_probe) > 0) { return; }
+        offsets.push_back(entries[pos].offset_);
+      }
+    }
+  }
+
+  template<typename OutputT>
+  void scan_full_into(OutputT &offsets, const size_t count) const {
+    size_t i = 0;
+    for (auto leaf : leaves_) {
+      for (auto &entry : leaf->entries_) {
+        if (i == count) { return; }
+        offsets.push_back(entry.offset_);
+        ++i;
+      }
+    }
+  }
+
+  // refers to the bytes of the key. the probe does not own them.
+  static ApproxKey make_probe(const GenericKeyView &key) {
+    ApproxKey probe;
+    probe.prefix_ = load_generic_key_prefix(key.raw(), key.size());
+    probe.data_ = const_cast<char*>(key.raw());
+    probe.size_ = key.size();
+    return probe;
+  }
+
+  static ApproxKey copy_key(const ApproxKey &key) {
+    ApproxKey copy = key;
+    if (key.size_ == 0) {
+      copy.data_ = nullptr;
+    } else {
+      copy.data_ = new char[key.size_];
+      memcpy(copy.data_, key.data_, key.size_);
+    }
+    return copy;
+  }
+
+  // compares the cached prefixes first, which settles most comparisons.
+  static int compare_keys(const ApproxKey &lhs, const ApproxKey &rhs) {
+    if (lhs.prefix_ != rhs.prefix_) {
+      return lhs.prefix_ < rhs.prefix_ ? -1 : 1;
+    }
+    size_t cmp_len = std::min(lhs.size_, rhs.size_);
+    if (cmp_len > 8) {
+      int rt = memcmp(lhs.data_ + 8, rhs.data_ + 8, cmp_len - 8);
+      if (rt != 0) { return rt; }
+    }
+    if (lhs.size_ == rhs.size_) { return 0; }
+    return lhs.size_ < rhs.size_ ? -1 : 1;
+  }
+
+  static size_t lower_bound_in_leaf(const std::vector<ApproxEntry> &entries, const ApproxKey &key) {
+    size_t begin = 0;
+    size_t end = entries.size();
+    while (begin < end) {
+      size_t mid = (begin + end) / 2;
+      if (compare_keys(entries[mid].key_, key) < 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+
+  // model input: the 8 bytes that follow the common prefix of the fences.
+  uint64_t model_input(const ApproxKey &key) const {
+    if (key.size_ <= model_prefix_.size()) { return 0; }
+    return load_generic_key_prefix(key.data_ + model_prefix_.size(), key.size_ - model_prefix_.size());
+  }
+
+  // number of fences that are smaller than the key.
+  size_t lower_bound_in_fences(const ApproxKey &key, size_t begin, size_t end) const {
+    while (begin < end) {
+      size_t mid = (begin + end) / 2;
+      if (compare_keys(fences_[mid], key) < 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+
+  // the leaf that holds the first entry not smaller than the key.
+  size_t locate_leaf(const ApproxKey &key) const {
+    size_t fence_count = fences_.size();
+    if (fence_count == 0) { return 0; }
+    if (segments_.empty()) { return lower_bound_in_fences(key, 0, fence_count); }
+
+    // keys that do not share the common prefix lie before or after the fences seen in training.
+    size_t pos = 0;
+    int rt = memcmp(key.data_, model_prefix_.data(), std::min(model_prefix_.size(), key.size_));
+    if (rt > 0) {
+      pos = fence_count;
+    } else if (rt == 0 && key.size_ >= model_prefix_.size()) {
+      uint64_t x = model_input(key);
+      size_t segment_id = std::upper_bound(segment_xs_.begin(), segment_xs_.end(), x) - segment_xs_.begin();
+      const Segment &segment = segments_[segment_id == 0 ? 0 : segment_id - 1];
+
+      double predicted = segment.y_ + segment.slope_ * (x >= segment.x_ ? (double)(x - segment.x_) : 0.0);
+      pos = std::min((size_t)std::max(predicted, 0.0), fence_count);
+    }
+
+    size_t error = MODEL_ERROR + stale_count_;
+
+    size_t begin = pos > error ? pos - error : 0;
+    size_t end = std::min(pos + error + 1, fence_count);
+
+    // fall back to the whole fence array if the window misses the key.
+    if ((begin != 0 && compare_keys(fences_[begin - 1], key) >= 0) ||
+        (end != fence_count && compare_keys(fences_[end], key) < 0)) {
+      return lower_bound_in_fences(key, 0, fence_count);
+    }
+    return lower_bound_in_fences(key, begin, end);
+  }
+
+  void split_leaf(const size_t leaf_id) {
+    std::vector<ApproxEntry> &entries = leaves_[leaf_id]->entries_;
+    size_t mid = entries.size() / 2;
+
+    ApproxLeaf *new_leaf = new ApproxLeaf();
+    new_leaf->entries_.assign(entries.begin() + mid, entries.end());
+    entries.resize(mid);
+
+    leaves_.insert(leaves_.begin() + leaf_id + 1, new_leaf);
+    fences_.insert(fences_.begin() + leaf_id, copy_key(new_leaf->entries_[0].key_));
+
+    update_model();
+  }
+
+  void remove_leaf(const size_t leaf_id) {
+    delete leaves_[leaf_id];
+    leaves_.erase(leaves_.begin() + leaf_id);
+
+    size_t fence_id = (leaf_id < fences_.size()) ? leaf_id : leaf_id - 1;
+    delete[] fences_[fence_id].data_;
+    fences_.erase(fences_.begin() + fence_id);
+
+    update_model();
+  }
+
+  // every fence added or removed shifts the positions by at most one.
+  void update_model() {
+    ++stale_count_;
+    if (stale_count_ >= std::max(MODEL_ERROR, fences_.size() / 64)) {
+      train_model();
+    }
+  }
+
+  // shrinking cone segmentation: a segment grows while one slope keeps all of its fences
+  // within MODEL_ERROR positions.
+  void train_model() {
+    stale_count_ = 0;
+    segments_.clear();
+    segment_xs_.clear();
+
+    size_t fence_count = fences_.size();
+    if (fence_count == 0) { return; }
+
+    const ApproxKey &first = fences_[0];
+    const ApproxKey &last = fences_[fence_count - 1];
+    size_t prefix_size = 0;
+    while (prefix_size < first.size_ && prefix_size < last.size_ &&
+           first.data_[prefix_size] == last.data_[prefix_size]) {
+      ++prefix_size;
+    }
+    model_prefix_.assign(first.data_, prefix_size);
+
+    size_t begin = 0;
+    while (begin < fence_count) {
+      Segment segment;
+      segment.x_ = model_input(fences_[begin]);
+      segment.y_ = begin;
+
+      double slope_lo = 0;
+      double slope_hi = std::numeric_limits<double>::max();
+
+      size_t end = begin + 1;
+      for (; end < fence_count; ++end) {
+        uint64_t x = model_input(fences_[end]);
+        double dy = end - begin;
+        if (x == segment.x_) {
+          if (dy > MODEL_ERROR) { break; }
+          continue;
+        }
+        double dx = x - segment.x_;
+        double lo = std::max(slope_lo, (dy - MODEL_ERROR) / dx);
+        double hi = std::min(slope_hi, (dy + MODEL_ERROR) / dx);
+        if (lo > hi) { break; }
+        slope_lo = lo;
+        slope_hi = hi;
+      }
+      segment.slope_ = (slope_hi == std::numeric_limits<double>::max()) ? 0 : (slope_lo + slope_hi) / 2;
+
+      segments_.push_back(segment);
+      segment_xs_.push_back(segment.x_);
+      begin = end;
+    }
   }
 
 private:
+  std::vector<ApproxLeaf*> leaves_;
+  std::vector<ApproxKey> fences_;
+  size_t size_;
 
+  std::vector<Segment> segments_;
+  std::vector<uint64_t> segment_xs_;
+  std::string model_prefix_; // common prefix of the fences seen in training
+  size_t stale_count_;
 };
 
 }
-}
\ No newline at end of file
+}
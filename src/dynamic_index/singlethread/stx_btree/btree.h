@@ -1265,6 +1265,12 @@ public:
         /// Base B+ tree parameter: The number of key slots in each inner node.
         static const unsigned short innerslots = self_type::innerslotmax;
 
+        /// Size in bytes of a leaf
+        static const size_t leafbytes = sizeof(leaf_node);
+
+        /// Size in bytes of an inner node
+        static const size_t innerbytes = sizeof(inner_node);
+
         /// Zero initialized
         inline tree_stats()
             : itemcount(0),
@@ -1748,6 +1754,16 @@ public:
         return m_stats;
     }
 
+private:
+    /// Issue prefetches for the header and the first key slots of a node. The
+    /// binary search in find_lower() touches these lines first.
+    static inline void prefetch_node(const node* n)
+    {
+        const char* p = reinterpret_cast<const char*>(n);
+        for (size_t i = 0; i < 4; ++i)
+            __builtin_prefetch(p + i * 64, 0, 3);
+    }
+
 public:
     // *** Standard Access Functions Querying the Tree by Descending to a Leaf
 
@@ -1935,6 +1951,61 @@ public:
         return const_iterator(leaf, slot);
     }
 
+    /// Non-STL function: searches the B+ tree for a batch of keys and stores
+    /// the lower_bound() of keys[i] in results[i]. All descents of a group
+    /// advance one level per round and the child nodes of the next round are
+    /// prefetched, so that the cache misses of the group overlap.
+    void lower_bound_batch(const key_type* keys, const size_type count,
+                           iterator* results)
+    {
+        static const size_type batchgroup = 32;
+
+        if (!m_root)
+        {
+            for (size_type i = 0; i < count; ++i)
+                results[i] = end();
+            return;
+        }
+
+        node* nodes[batchgroup];
+
+        for (size_type begin = 0; begin < count; begin += batchgroup)
+        {
+            const size_type group = std::min(count - begin, batchgroup);
+
+            for (size_type i = 0; i < group; ++i)
+                nodes[i] = m_root;
+
+            for (unsigned short level = m_root->level; level > 0; --level)
+            {
+                for (size_type i = 0; i < group; ++i)
+                {
+                    const inner_node* inner = static_cast<const inner_node*>(nodes[i]);
+                    int slot = find_lower(inner, keys[begin + i]);
+
+                    nodes[i] = inner->childid[slot];
+                    prefetch_node(nodes[i]);
+                }
+            }
+
+            for (size_type i = 0; i < group; ++i)
+            {
+                leaf_node* leaf = static_cast<leaf_node*>(nodes[i]);
+
+                int slot = find_lower(leaf, keys[begin + i]);
+
+                // step onto the next leaf, so that the result can always be
+                // dereferenced unless it is end().
+                if (slot >= leaf->slotuse && leaf->nextleaf)
+                {
+                    leaf = leaf->nextleaf;
+                    slot = 0;
+                }
+                results[begin + i] = iterator(leaf, slot);
+            }
+        }
+    }
+
     /// Searches the B+ tree and returns both lower_bound() and upper_bound().
     inline std::pair<iterator, iterator> equal_range(const key_type& key)
     {
@@ -388,6 +388,14 @@ public:
         return tree.upper_bound(key);
     }
 
+    /// Non-STL function: stores the lower_bound() of keys[i] in results[i]
+    /// for a batch of keys. The descents are interleaved with prefetching.
+    void lower_bound_batch(const key_type* keys, const size_type count,
+                           iterator* results)
+    {
+        tree.lower_bound_batch(keys, count, results);
+    }
+
     /// Searches the B+ tree and returns both lower_bound() and upper_bound().
     inline std::pair<iterator, iterator> equal_range(const key_type& key)
     {
@@ -17,39 +17,65 @@ public:
 
   virtual void insert(const GenericKey &key, const Uint64 &offset) final {
 
-    container_.insert(std::pair<GenericKey, Uint64>(key, offset));
+    container_.insert(std::pair<PrefixGenericKey, Uint64>(PrefixGenericKey(key), offset));
   }
 
-  virtual void find(const GenericKey &key, std::vector<Uint64> &offsets) final {
-    auto ret = container_.equal_range(key);
-    for (auto iter = ret.first; iter != ret.second; ++iter) {
-      offsets.push_back(iter->second);
+  // stx builds full leaves and the inner levels on top of them.
+  virtual void bulk_load(const std::pair<GenericKey, Uint64> *entries, const size_t count) final {
+    ASSERT(container_.empty(), "bulk load requires an empty index");
+
+    std::vector<std::pair<PrefixGenericKey, Uint64>> prefix_entries;
+    prefix_entries.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      prefix_entries.push_back(std::make_pair(PrefixGenericKey(entries[i].first), entries[i].second));
     }
+    container_.bulk_load(prefix_entries.begin(), prefix_entries.end());
   }
 
-  virtual void find_range(const GenericKey &lhs_key, const GenericKey &rhs_key, std::vector<Uint64> &offsets) final {
+  virtual void find(const GenericKeyView &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
 
-    if (lhs_key > rhs_key) { return; }
+  virtual void find(const GenericKeyView &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
 
-    if (lhs_key == rhs_key) { 
-      find(lhs_key, offsets);
-      return;
-    }
+  virtual void find_batch(const GenericKey *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    static thread_local PrefixGenericKey probes[FIND_BATCH_GROUP_SIZE];
+    ContainerT::iterator iters[FIND_BATCH_GROUP_SIZE];
 
-    auto itlow = container_.lower_bound(lhs_key);
-    auto itup = container_.upper_bound(rhs_key);
+    for (size_t begin = 0; begin < count; begin += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(count - begin, FIND_BATCH_GROUP_SIZE);
 
-    for (auto it = itlow; it != itup; ++it) {
-      offsets.push_back(it->second);
+      for (size_t i = 0; i < group_size; ++i) {
+        probes[i].assign(keys[begin + i]);
+      }
+
+      container_.lower_bound_batch(probes, group_size, iters);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        for (auto iter = iters[i]; iter != container_.end() && iter->first == probes[i]; ++iter) {
+          offsets[begin + i].push_back(iter->second);
+        }
+      }
     }
   }
 
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  virtual void find_range(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
   virtual void scan(const GenericKey &key, std::vector<Uint64> &offsets) final {
+    PrefixGenericKey probe(key);
     for (auto it = container_.begin(); it != container_.end(); ++it) {
-      if (it->first == key) {
+      if (it->first == probe) {
         offsets.push_back(it->second);
       }
-      if (it->first > key) {
+      if (it->first > probe) {
         return;
       }
     }
@@ -58,6 +84,74 @@ public:
   virtual void scan_reverse(const GenericKey &key, std::vector<Uint64> &offsets) final {}
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
+    scan_full_into(offsets, count);
+  }
+
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    scan_full_into(sink, count);
+  }
+
+  virtual void erase(const GenericKey &key) final {
+    container_.erase(PrefixGenericKey(key));
+  }
+
+  virtual void erase(const GenericKey &key, const Uint64 &offset) final {
+    auto ret = container_.equal_range(make_probe(key, 0));
+    for (auto iter = ret.first; iter != ret.second; ++iter) {
+      if (iter->second == offset) {
+        container_.erase(iter);
+        return;
+      }
+    }
+  }
+
+  virtual size_t size() const final {
+    return container_.size();
+  }
+
+  // keys longer than the inline buffer of a key add their heap bytes to the leaves.
+  virtual IndexMemoryStats memory_usage() const final {
+    auto &tree_stats = container_.get_stats();
+
+    IndexMemoryStats stats;
+    stats.entry_count_ = container_.size();
+    stats.inner_bytes_ = tree_stats.innernodes * tree_stats.innerbytes;
+    stats.leaf_bytes_ = tree_stats.leaves * tree_stats.leafbytes;
+    for (auto iter = container_.begin(); iter != container_.end(); ++iter) {
+      stats.leaf_bytes_ += iter->first.heap_bytes();
+    }
+    return stats;
+  }
+
+private:
+  template<typename OutputT>
+  void find_into(const GenericKeyView &key, OutputT &offsets) {
+    auto ret = container_.equal_range(make_probe(key, 0));
+    for (auto iter = ret.first; iter != ret.second; ++iter) {
+      offsets.push_back(iter->second);
+    }
+  }
+
+  template<typename OutputT>
+  void find_range_into(const GenericKeyView &lhs_key, const GenericKeyView &rhs_key, OutputT &offsets) {
+
+    if (lhs_key > rhs_key) { return; }
+
+    if (lhs_key == rhs_key) { 
+      find_into(lhs_key, offsets);
+      return;
+    }
+
+    auto itlow = container_.lower_bound(make_probe(lhs_key, 0));
+    auto itup = container_.upper_bound(make_probe(rhs_key, 1));
+
+    for (auto it = itlow; it != itup; ++it) {
+      offsets.push_back(it->second);
+    }
+  }
+
+  template<typename OutputT>
+  void scan_full_into(OutputT &offsets, const size_t count) {
     size_t i = 0;
     for (auto it = container_.begin(); it != container_.end(); ++it) {
       if (i < count) {
@@ -69,16 +163,17 @@ public:
     }
   }
 
-  virtual void erase(const GenericKey &key) final {
-    container_.erase(key);
+  // a per-thread key that a lookup probes with. its buffer is reused, so lookups do not allocate.
+  static const PrefixGenericKey& make_probe(const GenericKeyView &key, const size_t probe_id) {
+    static thread_local PrefixGenericKey probes[2];
+    probes[probe_id].assign(key);
+    return probes[probe_id];
   }
 
-  virtual size_t size() const final {
-    return container_.size();
-  }
+  // keys carry their 8-byte prefix, so that most comparisons are one integer compare.
+  typedef stx::btree_multimap<PrefixGenericKey, Uint64> ContainerT;
 
-private:
-  stx::btree_multimap<GenericKey, Uint64> container_;
+  ContainerT container_;
 };
 
 }
@@ -20,30 +20,44 @@ public:
     container_.insert(std::pair<KeyT, Uint64>(key, offset));
   }
 
+  // stx builds full leaves and the inner levels on top of them.
+  virtual void bulk_load(const std::pair<KeyT, Uint64> *entries, const size_t count) final {
+    ASSERT(container_.empty(), "bulk load requires an empty index");
+    container_.bulk_load(entries, entries + count);
+  }
+
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
-    auto ret = container_.equal_range(key);
-    for (auto iter = ret.first; iter != ret.second; ++iter) {
-      offsets.push_back(iter->second);
-    }
+    find_into(key, offsets);
   }
 
-  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
-    
-    if (lhs_key > rhs_key) { return; }
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
 
-    if (lhs_key == rhs_key) { 
-      find(lhs_key, offsets);
-      return;
-    }
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    typename stx::btree_multimap<KeyT, Uint64>::iterator iters[FIND_BATCH_GROUP_SIZE];
 
-    auto itlow = container_.lower_bound(lhs_key);
-    auto itup = container_.upper_bound(rhs_key);
+    for (size_t begin = 0; begin < count; begin += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(count - begin, FIND_BATCH_GROUP_SIZE);
 
-    for (auto it = itlow; it != itup; ++it) {
-      offsets.push_back(it->second);
+      container_.lower_bound_batch(keys + begin, group_size, iters);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        for (auto iter = iters[i]; iter != container_.end() && iter->first == keys[begin + i]; ++iter) {
+          offsets[begin + i].push_back(iter->second);
+        }
+      }
     }
   }
 
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
   virtual void scan(const KeyT &key, std::vector<Uint64> &offsets) final {
     for (auto it = container_.begin(); it != container_.end(); ++it) {
       if (it->first == key) {
@@ -58,26 +72,81 @@ public:
   virtual void scan_reverse(const KeyT &key, std::vector<Uint64> &offsets) final {}
 
   virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
-    size_t i = 0;
-    for (auto it = container_.begin(); it != container_.end(); ++it) {
-      if (i < count) {
-        offsets.push_back(it->second);
-        ++i;
-      } else {
-        return;
-      }
-    }
+    scan_full_into(offsets, count);
+  }
+
+  virtual void scan_full(ResultSink &sink, const size_t count) final {
+    scan_full_into(sink, count);
   }
 
   virtual void erase(const KeyT &key) final {
     container_.erase(key);
   }
 
+  virtual void erase(const KeyT &key, const Uint64 &offset) final {
+    auto ret = container_.equal_range(key);
+    for (auto iter = ret.first; iter != ret.second; ++iter) {
+      if (iter->second == offset) {
+        container_.erase(iter);
+        return;
+      }
+    }
+  }
+
   virtual size_t size() const final {
     return container_.size();
   }
 
+  virtual IndexMemoryStats memory_usage() const final {
+    auto &tree_stats = container_.get_stats();
+
+    IndexMemoryStats stats;
+    stats.entry_count_ = container_.size();
+    stats.inner_bytes_ = tree_stats.innernodes * tree_stats.innerbytes;
+    stats.leaf_bytes_ = tree_stats.leaves * tree_stats.leafbytes;
+    return stats;
+  }
+
 private:
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
+    auto ret = container_.equal_range(key);
+    for (auto iter = ret.first; iter != ret.second; ++iter) {
+      offsets.push_back(iter->second);
+    }
+  }
+
+  template<typename OutputT>
+  void find_range_into(const KeyT &lhs_key, const KeyT &rhs_key, OutputT &offsets) {
+    
+    if (lhs_key > rhs_key) { return; }
+
+    if (lhs_key == rhs_key) { 
+      find_into(lhs_key, offsets);
+      return;
+    }
+
+    auto itlow = container_.lower_bound(lhs_key);
+    auto itup = container_.upper_bound(rhs_key);
+
+    for (auto it = itlow; it != itup; ++it) {
+      offsets.push_back(it->second);
+    }
+  }
+
+  template<typename OutputT>
+  void scan_full_into(OutputT &offsets, const size_t count) {
+    size_t i = 0;
+    for (auto it = container_.begin(); it != container_.end(); ++it) {
+      if (i < count) {
+        offsets.push_back(it->second);
+        ++i;
+      } else {
+        return;
+      }
+    }
+  }
+
   stx::btree_multimap<KeyT, Uint64> container_;
 };
 
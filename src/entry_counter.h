@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "utils.h"
+
+// number of entries in a concurrent index. every thread adds to a slot of its own, picked by
+// the thread id given to register_thread(), so that writers do not share the counter's cache
+// line. threads that never registered use slot 0. get() sums the slots, so it is exact only
+// while no thread modifies the index.
+class EntryCounter {
+
+  static const size_t SLOT_COUNT = 64;
+
+  static const size_t CACHELINE_SIZE = 64;
+
+  struct CounterSlot {
+    std::atomic<int64_t> count_;
+    char padding_[CACHELINE_SIZE - sizeof(std::atomic<int64_t>)];
+  };
+
+public:
+  EntryCounter() {
+    void *ptr = nullptr;
+    int rt = posix_memalign(&ptr, CACHELINE_SIZE, SLOT_COUNT * sizeof(CounterSlot));
+    ASSERT(rt == 0, "failed to allocate counter slots");
+    slots_ = reinterpret_cast<CounterSlot*>(ptr);
+    for (size_t i = 0; i < SLOT_COUNT; ++i) {
+      slots_[i].count_.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  ~EntryCounter() {
+    free(slots_);
+    slots_ = nullptr;
+  }
+
+  static void register_thread(const size_t thread_id) {
+    slot_id() = thread_id % SLOT_COUNT;
+  }
+
+  inline void add(const int64_t delta) {
+    slots_[slot_id()].count_.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  size_t get() const {
+    int64_t count = 0;
+    for (size_t i = 0; i < SLOT_COUNT; ++i) {
+      count += slots_[i].count_.load(std::memory_order_relaxed);
+    }
+    return count < 0 ? 0 : count;
+  }
+
+private:
+  EntryCounter(const EntryCounter&);
+  EntryCounter& operator=(const EntryCounter&);
+
+  static size_t& slot_id() {
+    static thread_local size_t id = 0;
+    return id;
+  }
+
+private:
+  CounterSlot *slots_;
+};
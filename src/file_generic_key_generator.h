@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base_generic_key_generator.h"
+
+// a key file with one key per line, mapped read-only, so that a key set larger than memory is
+// paged in as it is read rather than copied up front. generators take the file in chunks of
+// CHUNK_SIZE bytes from a shared cursor, and a chunk owns the lines that start in it. after
+// the last chunk, the file is read again from the start.
+class MappedKeyFile {
+
+  static const size_t CHUNK_SIZE = 1ull << 16;
+
+public:
+  MappedKeyFile(const std::string &path) : data_(nullptr), size_(0), next_chunk_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT(fd >= 0, "failed to open key file: " << path);
+
+    struct stat st;
+    int rt = fstat(fd, &st);
+    ASSERT(rt == 0, "failed to stat key file: " << path);
+    size_ = st.st_size;
+    ASSERT(size_ != 0, "key file is empty: " << path);
+
+    void *ptr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT(ptr != MAP_FAILED, "failed to map key file: " << path);
+    data_ = reinterpret_cast<const char*>(ptr);
+    close(fd);
+
+    madvise(ptr, size_, MADV_SEQUENTIAL);
+
+    chunk_count_ = (size_ + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    bool has_key = false;
+    for (size_t i = 0; i < size_ && !has_key; ++i) {
+      has_key = !is_line_end(data_[i]);
+    }
+    ASSERT(has_key, "key file has no keys: " << path);
+  }
+
+  ~MappedKeyFile() {
+    munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+  }
+
+  inline const char* data() const { return data_; }
+
+  inline size_t size() const { return size_; }
+
+  // claim the next chunk. lines starting in [begin, end) belong to the caller.
+  void next_chunk(size_t &begin, size_t &end) {
+    size_t chunk_id = next_chunk_.fetch_add(1, std::memory_order_relaxed) % chunk_count_;
+    begin = chunk_id * CHUNK_SIZE;
+    end = std::min(begin + CHUNK_SIZE, size_);
+  }
+
+  static inline bool is_line_end(const char c) {
+    return c == '\n' || c == '\r';
+  }
+
+private:
+  MappedKeyFile(const MappedKeyFile&);
+  MappedKeyFile& operator=(const MappedKeyFile&);
+
+private:
+  const char *data_;
+  size_t size_;
+  size_t chunk_count_;
+  std::atomic<uint64_t> next_chunk_;
+};
+
+// reads keys from a mapped key file. keys longer than max_key_size are truncated, and empty
+// lines are skipped.
+class FileGenericKeyGenerator : public BaseGenericKeyGenerator {
+public:
+
+  FileGenericKeyGenerator(MappedKeyFile *key_file, const size_t max_key_size) :
+    key_file_(key_file), max_key_size_(max_key_size), pos_(0), chunk_end_(0) {}
+
+  virtual ~FileGenericKeyGenerator() {}
+
+  virtual void get_next_key(GenericKey &key) final {
+    const char *data = key_file_->data();
+    const size_t size = key_file_->size();
+
+    while (true) {
+      // skip line ends, so that pos_ is at the start of a key.
+      while (pos_ < chunk_end_ && MappedKeyFile::is_line_end(data[pos_])) {
+        ++pos_;
+      }
+      if (pos_ < chunk_end_) {
+        break;
+      }
+
+      // claim a chunk, and skip the line that started in the chunk before.
+      key_file_->next_chunk(pos_, chunk_end_);
+      if (pos_ != 0 && !MappedKeyFile::is_line_end(data[pos_ - 1])) {
+        while (pos_ < chunk_end_ && !MappedKeyFile::is_line_end(data[pos_])) {
+          ++pos_;
+        }
+      }
+    }
+
+    // the last key of a chunk may end in the next chunk.
+    size_t key_end = pos_;
+    while (key_end < size && !MappedKeyFile::is_line_end(data[key_end])) {
+      ++key_end;
+    }
+
+    key.assign(data + pos_, std::min(key_end - pos_, max_key_size_));
+    pos_ = key_end;
+  }
+
+private:
+  MappedKeyFile *key_file_;
+  size_t max_key_size_;
+
+  size_t pos_;
+  size_t chunk_end_;
+};
@@ -1,89 +1,106 @@
 #pragma once
 
 #include <cassert>
+#include <limits>
 #include <vector>
 
-#include "data_block.h"
+#include "block_directory.h"
 
 class GenericDataTableIterator;
 
+// tuples are stored as variable-length records, appended to pages of bytes.
+// a record is a header followed by the key and the value, and is padded to TUPLE_ALIGNMENT.
+// an offset points at the header of its record, so the key size is known without scanning
+// the key. a page reserves room for max_block_capacity records of the maximum size, and
+// holds more records if keys are shorter.
 class GenericDataTable {
 
   friend GenericDataTableIterator;
 
-public:
-  GenericDataTable(const uint64_t max_key_size, const uint64_t max_value_size, const uint64_t max_block_capacity = MaxBlockCapacity) {
+  static const size_t TUPLE_ALIGNMENT = 8;
 
-    max_key_size_ = max_key_size;
-    max_value_size_ = max_value_size;
-    max_block_capacity_ = max_block_capacity;
+  struct TupleHeader {
+    // the size of the whole record. never 0, so zeroed memory marks the end of a page.
+    uint32_t record_size_;
+    uint16_t key_size_;
+    uint16_t value_size_;
+  };
 
-    data_blocks_.emplace_back(new DataBlock(0, max_key_size_ + max_value_size_, max_block_capacity_));
-    active_data_block_ = data_blocks_.at(0);
+public:
+  // the allocator provides the block storage. it must outlive the table.
+  GenericDataTable(const uint64_t max_key_size, const uint64_t max_value_size, const uint64_t max_block_capacity = MaxBlockCapacity, BlockAllocator *allocator = HeapBlockAllocator::get_instance()) :
+    max_key_size_(max_key_size),
+    max_value_size_(max_value_size),
+    max_block_capacity_(max_block_capacity),
+    data_blocks_(1, max_block_capacity * record_size(max_key_size, max_value_size), allocator) {
+
+    ASSERT(max_key_size_ <= std::numeric_limits<uint16_t>::max(), "exceed max key size: " << max_key_size_);
+    ASSERT(max_value_size_ <= std::numeric_limits<uint16_t>::max(), "exceed max value size: " << max_value_size_);
   }
-  
-  ~GenericDataTable() {
-    for (auto entry : data_blocks_) {
-      delete entry;
-      entry = nullptr;
-    }
+
+  ~GenericDataTable() {}
+
+  // give every inserting thread its own block, so that threads do not contend on one block.
+  // must be called before the threads start inserting.
+  void prepare_threads(const size_t thread_count) {
+    data_blocks_.prepare_slots(thread_count);
   }
 
-  OffsetT insert_tuple(const char *key, const uint64_t key_size, const char *value, const uint64_t value_size) {
-    // key_size must be at least 1 byte smaller than max_key_size_
+  // thread_id selects the block to append to. threads may share an id, at the cost of contention.
+  OffsetT insert_tuple(const char *key, const uint64_t key_size, const char *value, const uint64_t value_size, const size_t thread_id = 0) {
     ASSERT(key_size <= max_key_size_, "exceed max key size: " << key_size << " " << max_key_size_);
     ASSERT(value_size <= max_value_size_, "exceed max value size: " << value_size << " " << max_value_size_);
 
-    while (true) {
-      DataBlock* tmp_block = active_data_block_;
-
-      RelOffsetT rel_offset = tmp_block->get_next_rel_offset();
-
-      if (rel_offset != INVALID_OFFSET) {
-        
-        OffsetT tuple_offset(tmp_block->get_block_id(), rel_offset);
+    TupleHeader header;
+    header.record_size_ = record_size(key_size, value_size);
+    header.key_size_ = key_size;
+    header.value_size_ = value_size;
 
-        // copy data.
-        char* data = tmp_block->get_tuple(rel_offset);
-        memcpy(data, key, key_size);
-        memcpy(data + max_key_size_, value, value_size);
+    RelOffsetT rel_offset = INVALID_OFFSET;
+    DataBlock *block = data_blocks_.allocate_tuple(thread_id, rel_offset, header.record_size_);
 
-        if (rel_offset == tmp_block->get_max_rel_offset() - 1) {
-          auto new_block = new DataBlock(tmp_block->get_block_id() + 1, max_key_size_ + max_value_size_, max_block_capacity_);
-          data_blocks_.emplace_back(new_block);
+    // copy data. the header goes last, so that a record is complete once its header is visible.
+    char* data = block->get_tuple(rel_offset);
+    memcpy(data + sizeof(TupleHeader), key, key_size);
+    memcpy(data + sizeof(TupleHeader) + key_size, value, value_size);
 
-          COMPILER_MEMORY_FENCE;
+    COMPILER_MEMORY_FENCE;
 
-          active_data_block_ = new_block;
-        }
+    memcpy(data, &header, sizeof(TupleHeader));
 
-        return tuple_offset;
-      }
-    }
+    return OffsetT(block->get_block_id(), rel_offset);
   }
 
   char* get_tuple_key(const BlockIDT block_id, const RelOffsetT rel_offset) const {
 
-    char *data = data_blocks_.at(block_id)->get_tuple(rel_offset);
-    return data;
+    char *data = data_blocks_.get(block_id)->get_tuple(rel_offset);
+    return data + sizeof(TupleHeader);
   }
 
   char* get_tuple_value(const BlockIDT block_id, const RelOffsetT rel_offset) const {
 
-    char *data = data_blocks_.at(block_id)->get_tuple(rel_offset);
-    return data + max_key_size_;
+    char *data = data_blocks_.get(block_id)->get_tuple(rel_offset);
+    return data + sizeof(TupleHeader) + get_header(data)->key_size_;
   }
 
   char* get_tuple_key(const OffsetT offset) const {
-
-    char *data = data_blocks_.at(offset.block_id())->get_tuple(offset.rel_offset());
-    return data;
+    return get_tuple_key(offset.block_id(), offset.rel_offset());
   }
 
   char* get_tuple_value(const OffsetT offset) const {
+    return get_tuple_value(offset.block_id(), offset.rel_offset());
+  }
+
+  size_t get_tuple_key_size(const OffsetT offset) const {
 
-    char *data = data_blocks_.at(offset.block_id())->get_tuple(offset.rel_offset());
-    return data + max_key_size_;
+    char *data = data_blocks_.get(offset.block_id())->get_tuple(offset.rel_offset());
+    return get_header(data)->key_size_;
+  }
+
+  size_t get_tuple_value_size(const OffsetT offset) const {
+
+    char *data = data_blocks_.get(offset.block_id())->get_tuple(offset.rel_offset());
+    return get_header(data)->value_size_;
   }
 
   inline size_t get_max_key_size() const { return max_key_size_; }
@@ -91,27 +108,54 @@ public:
   inline size_t get_max_value_size() const { return max_value_size_; }
 
 
+  // records have no fixed size, so this walks all records.
   size_t size() const {
-    ASSERT(data_blocks_.size() != 0, "must have at least one data block");
-    if (data_blocks_.size() == 1) {
-      return data_blocks_.at(0)->size();
-    } else {
-      return (data_blocks_.size() - 1) * max_block_capacity_ + data_blocks_.at(data_blocks_.size() - 1)->size();
+    size_t count = 0;
+    size_t block_count = data_blocks_.block_count();
+    for (size_t block_id = 0; block_id < block_count; ++block_id) {
+      if (!has_tuple(block_id, 0)) { continue; }
+
+      for (RelOffsetT rel_offset = 0; rel_offset != INVALID_OFFSET; rel_offset = next_tuple(block_id, rel_offset)) {
+        ++count;
+      }
     }
+    return count;
   }
 
-  // approximate data table size
+  // approximate size of the pages, in bytes.
   size_t size_approx() const {
-    assert(data_blocks_.size() != 0);
-    return data_blocks_.size() * max_block_capacity_;
+    return data_blocks_.block_count() * max_block_capacity_ * record_size(max_key_size_, max_value_size_);
+  }
+
+private:
+  static size_t record_size(const size_t key_size, const size_t value_size) {
+    return (sizeof(TupleHeader) + key_size + value_size + TUPLE_ALIGNMENT - 1) / TUPLE_ALIGNMENT * TUPLE_ALIGNMENT;
+  }
+
+  static const TupleHeader* get_header(const char *data) {
+    return reinterpret_cast<const TupleHeader*>(data);
+  }
+
+  bool has_tuple(const BlockIDT block_id, const RelOffsetT rel_offset) const {
+    DataBlock *block = data_blocks_.try_get(block_id);
+    if (block == nullptr || rel_offset + sizeof(TupleHeader) > block->size()) {
+      return false;
+    }
+    return get_header(block->get_tuple(rel_offset))->record_size_ != 0;
+  }
+
+  // the record after the given one in the same page, or INVALID_OFFSET.
+  RelOffsetT next_tuple(const BlockIDT block_id, const RelOffsetT rel_offset) const {
+    char *data = data_blocks_.get(block_id)->get_tuple(rel_offset);
+    RelOffsetT next_rel_offset = rel_offset + get_header(data)->record_size_;
+    return has_tuple(block_id, next_rel_offset) ? next_rel_offset : INVALID_OFFSET;
   }
 
 private:
   uint64_t max_key_size_;
   uint64_t max_value_size_;
   uint64_t max_block_capacity_;
-  std::vector<DataBlock*> data_blocks_;
-  DataBlock* active_data_block_;
+  BlockDirectory data_blocks_;
 
 };
 
@@ -119,7 +163,7 @@ class GenericDataTableIterator {
 
 public:
   struct IteratorEntry {
-    IteratorEntry(const BlockIDT block_id, const RelOffsetT rel_offset, char *key, char *value) : 
+    IteratorEntry(const BlockIDT block_id, const RelOffsetT rel_offset, char *key, char *value) :
       offset_(OffsetT::construct_raw_data(block_id, rel_offset)), key_(key), value_(value) {}
 
     Uint64 offset_;
@@ -128,46 +172,42 @@ public:
   };
 
 public:
-  GenericDataTableIterator(GenericDataTable *table_ptr) : 
+  GenericDataTableIterator(GenericDataTable *table_ptr) :
     table_ptr_(table_ptr), curr_block_id_(0), curr_rel_offset_(0) {
-    
-    ASSERT(table_ptr_->data_blocks_.size() != 0, "table must contain at least one data block!");
-    ASSERT(!(table_ptr_->data_blocks_.size() == 1 && table_ptr_->data_blocks_.at(0)->size() == 0), "table must contain at least one tuple!");
 
-    max_rel_offset_ = table_ptr_->max_block_capacity_ - 1; 
+    last_block_id_ = table_ptr_->data_blocks_.block_count() - 1;
 
-    last_block_id_ = table_ptr_->data_blocks_.size() - 1;
+    skip_empty_blocks();
 
-    size_t last_block_size = table_ptr_->data_blocks_.at(last_block_id_)->size();
-    if (last_block_size == 0) {
-      last_rel_offset_ = max_rel_offset_;
-      last_block_id_ = last_block_id_ - 1;
-    } else {
-      last_rel_offset_ = last_block_size - 1;
-    }
+    // the first non-empty page holds a tuple. size() would walk every record.
+    ASSERT(has_next(), "table must contain at least one tuple!");
   }
 
   bool has_next() const {
-    if (curr_block_id_ > last_block_id_ || (curr_block_id_ == last_block_id_ && curr_rel_offset_ > last_rel_offset_)) {
-      return false;
-    } else {
-      return true;
-    }
+    return curr_block_id_ <= last_block_id_;
   }
 
   IteratorEntry next() {
     BlockIDT ret_block_id = curr_block_id_;
     RelOffsetT ret_rel_offset = curr_rel_offset_;
 
-    if (curr_rel_offset_ != max_rel_offset_) {
-      curr_rel_offset_++;
-    } else {
+    curr_rel_offset_ = table_ptr_->next_tuple(curr_block_id_, curr_rel_offset_);
+    if (curr_rel_offset_ == INVALID_OFFSET) {
       curr_block_id_++;
       curr_rel_offset_ = 0;
+      skip_empty_blocks();
     }
+
     return IteratorEntry(ret_block_id, ret_rel_offset, table_ptr_->get_tuple_key(ret_block_id, ret_rel_offset), table_ptr_->get_tuple_value(ret_block_id, ret_rel_offset));
   }
 
+private:
+  // pages are partially filled, and pages that lost a creation race are empty.
+  void skip_empty_blocks() {
+    while (curr_block_id_ <= last_block_id_ && !table_ptr_->has_tuple(curr_block_id_, 0)) {
+      curr_block_id_++;
+    }
+  }
 
 private:
   GenericDataTable *table_ptr_;
@@ -176,6 +216,4 @@ private:
   RelOffsetT curr_rel_offset_;
 
   BlockIDT last_block_id_;
-  RelOffsetT last_rel_offset_;
-  RelOffsetT max_rel_offset_;
 };
@@ -9,10 +9,15 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <algorithm>
 #include <unistd.h>
 #include <getopt.h>
 
 #include "time_measurer.h"
+#include "latency_histogram.h"
+#include "open_loop_pacer.h"
+#include "access_distribution.h"
+#include "workload_mix.h"
 #include "generic_data_table.h"
 #include "index_all.h"
 #include "generic_key_generator_all.h"
@@ -27,6 +32,8 @@ void usage(FILE *out) {
           "   -i --index             :  index type: \n"
           "                              --  (0) dynamic - singlethread - stx-btree index (default)  \n"
           "                              --  (1) dynamic - singlethread - art-tree index \n"
+          "                              --  (2) dynamic - singlethread - approx-tree index \n"
+          "                              --  (3) dynamic - singlethread - prefix-btree index \n"
           "                              -- (10) dynamic - multithread  - libcuckoo index \n"
           "                              -- (11) dynamic - multithread  - art-tree index \n"
           "                              -- (12) dynamic - multithread  - bw-tree index \n"
@@ -39,12 +46,38 @@ void usage(FILE *out) {
           "                              -- (1) index scan \n"
           "                              -- (2) index reverse scan \n"
           "   -r --read_ratio        :  read ratio (default: 1.0) \n"
+          "   -W --mix               :  operation mix, instead of -r and -y: a ycsb core workload (a to f), \n"
+          "                             or shares of lookup, insert, scan, update, rmw and delete, e.g. lookup=0.9,scan=0.1 \n"
+          "   -e --scan_length       :  scans read between 1 and this many keys (default: 100) \n"
+          "   -b --batch_size        :  number of lookups issued as one batch (default: 1) \n"
           "   -s --thread_count      :  thread count (default: 1) \n"
+          "   -a --block_allocator   :  table block allocator: \n"
+          "                              -- (0) heap (default) \n"
+          "                              -- (1) huge-page arena \n"
+          "                              -- (2) huge-page arena, numa-local to the inserting thread \n"
+          "   -L --bulk_load         :  load the initial keys in key order through bulk_load, instead of inserting them \n"
+          "   -C --churn             :  every insert also erases the oldest live entry of its thread, so that the live set keeps its size \n"
+          "   -O --target_rate       :  open loop: issue operations at this aggregate rate in ops/s, 0 for closed loop (default: 0) \n"
+          "   -A --arrival           :  open loop inter-arrival times: \n"
+          "                              -- (0) constant (default) \n"
+          "                              -- (1) poisson \n"
+          "   -z --access            :  which initial keys the reads pick: \n"
+          "                              -- (0) uniform (default) \n"
+          "                              -- (1) zipfian, scrambled over the key space \n"
+          "                              -- (2) hotspot \n"
+          "                              -- (3) latest: zipfian over recency, including the thread's own inserts \n"
+          "   -Z --zipf_theta        :  zipfian and latest skew, in (0, 1) (default: 0.99) \n"
+          "   -H --hot_op_fraction   :  hotspot: fraction of reads on the hot keys (default: 0.9) \n"
+          "   -K --hot_key_fraction  :  hotspot: fraction of the keys that are hot (default: 0.1) \n"
+          "   -x --latency_sample    :  time one in N operations per thread for latency percentiles, 0 to disable (default: 64) \n"
           "   -m --key_count         :  key count (default: 1ull<<20) \n"
           "   -w --workload          :  workload type: \n"
           "                              -- (0) synthetic (default) \n"
           "                              -- (1) username \n"
           "                              -- (2) url \n"
+          "                              -- (3) keys from a file, one per line (see -f) \n"
+          "   -g --mean_key_size     :  username and url workloads: mean key size (default: 12 for usernames, 64 for urls) \n"
+          "   -f --key_file          :  file workload: key file. mapped and read in order, from the start again once exhausted \n"
           "   -c --record           :  record all keys \n"
           "   -v --verbose          :  verbose \n"
   );
@@ -58,10 +91,25 @@ static struct option opts[] = {
     { "time_duration",     optional_argument, NULL, 't' },
     { "read_type",         optional_argument, NULL, 'y' },
     { "read_ratio",        optional_argument, NULL, 'r' },
+    { "batch_size",        optional_argument, NULL, 'b' },
+    { "mix",               optional_argument, NULL, 'W' },
+    { "scan_length",       optional_argument, NULL, 'e' },
     { "thread_count",      optional_argument, NULL, 's' },
+    { "block_allocator",   optional_argument, NULL, 'a' },
+    { "bulk_load",         optional_argument, NULL, 'L' },
+    { "churn",             optional_argument, NULL, 'C' },
+    { "access",            optional_argument, NULL, 'z' },
+    { "zipf_theta",        optional_argument, NULL, 'Z' },
+    { "hot_op_fraction",   optional_argument, NULL, 'H' },
+    { "hot_key_fraction",  optional_argument, NULL, 'K' },
+    { "latency_sample",    optional_argument, NULL, 'x' },
+    { "target_rate",       optional_argument, NULL, 'O' },
+    { "arrival",           optional_argument, NULL, 'A' },
     // data distribution
     { "key_count",         optional_argument, NULL, 'm' },
     { "workload",          optional_argument, NULL, 'w' },
+    { "mean_key_size",     optional_argument, NULL, 'g' },
+    { "key_file",          optional_argument, NULL, 'f' },
     { "record",            optional_argument, NULL, 'c' },
     { "verbose",           optional_argument, NULL, 'v' },
     { NULL, 0, NULL, 0 }
@@ -83,10 +131,28 @@ struct Config {
   int time_duration_ = 10;
   ReadType index_read_type_ = ReadType::IndexLookupType;
   double read_ratio_ = 1.0;
+  int batch_size_ = 1;
+  std::string mix_spec_;
+  WorkloadMix mix_;
+  bool mix_enabled_ = false;
+  uint64_t scan_length_ = DEFAULT_SCAN_LENGTH;
+  bool access_type_set_ = false;
   int thread_count_ = 1;
+  BlockAllocatorType block_allocator_type_ = BlockAllocatorType::HeapType;
+  bool bulk_load_ = false;
+  bool churn_ = false;
+  AccessType access_type_ = AccessType::UniformAccessType;
+  double zipf_theta_ = DEFAULT_ZIPF_THETA;
+  double hot_op_fraction_ = DEFAULT_HOT_OP_FRACTION;
+  double hot_key_fraction_ = DEFAULT_HOT_KEY_FRACTION;
+  uint64_t latency_sample_ = 64;
+  double target_rate_ = 0;
+  ArrivalType arrival_type_ = ArrivalType::ConstantType;
   // data distribution
   uint64_t key_count_ = 1ull << 20;
   WorkloadType workload_type_ = WorkloadType::SyntheticType;
+  int mean_key_size_ = 0;
+  std::string key_file_;
   bool record_ = false;
   bool verbose_ = false;
 
@@ -94,10 +160,38 @@ struct Config {
     std::cout << "=====     INDEX STRUCTURE    =====" << std::endl;
     std::cout << "max key size: " << key_size_ << std::endl;
     std::cout << "===== WORKLOAD CONFIGURATION =====" << std::endl;
-    std::cout << "read ratio: " << read_ratio_ << std::endl;
+    if (mix_enabled_ == true) {
+      std::cout << "workload mix:";
+      mix_.print();
+      std::cout << std::endl;
+    } else {
+      std::cout << "read ratio: " << read_ratio_ << std::endl;
+    }
+    std::cout << "scan length: " << scan_length_ << std::endl;
+    std::cout << "batch size: " << batch_size_ << std::endl;
     std::cout << "thread count: " << thread_count_ << std::endl;
+    std::cout << "block allocator: " << int(block_allocator_type_) << std::endl;
+    std::cout << "bulk load: " << (bulk_load_ ? "on" : "off") << std::endl;
+    std::cout << "churn: " << (churn_ ? "on" : "off") << std::endl;
+    std::cout << "access type: " << int(access_type_) << std::endl;
+    if (access_type_ == AccessType::ZipfianAccessType || access_type_ == AccessType::LatestAccessType) {
+      std::cout << "zipf theta: " << zipf_theta_ << std::endl;
+    } else if (access_type_ == AccessType::HotspotAccessType) {
+      std::cout << "hotspot: " << hot_op_fraction_ << " of reads on " << hot_key_fraction_ << " of keys" << std::endl;
+    }
+    std::cout << "latency sample: " << latency_sample_ << std::endl;
+    if (target_rate_ > 0) {
+      std::cout << "target rate: " << target_rate_ << " ops/s, " << (arrival_type_ == ArrivalType::PoissonType ? "poisson" : "constant") << " arrivals" << std::endl;
+    }
     std::cout << "=====    DATA DISTRIBUTION   =====" << std::endl;
     std::cout << "key count: " << key_count_ << std::endl;
+    std::cout << "workload: " << int(workload_type_) << std::endl;
+    if (mean_key_size_ != 0) {
+      std::cout << "mean key size: " << mean_key_size_ << std::endl;
+    }
+    if (!key_file_.empty()) {
+      std::cout << "key file: " << key_file_ << std::endl;
+    }
     std::cout << ">>>>>>>>>>>>>>>>>>>>>>" << std::endl;
   }
 };
@@ -106,7 +200,7 @@ void parse_args(int argc, char* argv[], Config &config) {
   
   while (1) {
     int idx = 0;
-    int c = getopt_long(argc, argv, "hcvi:k:t:y:r:s:m:w:", opts, &idx);
+    int c = getopt_long(argc, argv, "hcvLCi:k:t:y:r:b:s:m:w:a:x:O:A:z:Z:H:K:W:e:g:f:", opts, &idx);
 
     if (c == -1) break;
 
@@ -131,10 +225,26 @@ void parse_args(int argc, char* argv[], Config &config) {
         config.read_ratio_ = (double)atof(optarg);
         break;
       }
+      case 'W': {
+        config.mix_spec_ = optarg;
+        break;
+      }
+      case 'e': {
+        config.scan_length_ = (uint64_t)strtoull(optarg, nullptr, 10); // uint64_t
+        break;
+      }
+      case 'b': {
+        config.batch_size_ = atoi(optarg);
+        break;
+      }
       case 's': {
         config.thread_count_ = atoi(optarg);
         break;
       }
+      case 'a': {
+        config.block_allocator_type_ = (BlockAllocatorType)atoi(optarg);
+        break;
+      }
       case 'm': {
         config.key_count_ = (uint64_t)strtoull(optarg, nullptr, 10); // uint64_t
         break;
@@ -143,6 +253,51 @@ void parse_args(int argc, char* argv[], Config &config) {
         config.workload_type_ = (WorkloadType)atoi(optarg);
         break;
       }
+      case 'g': {
+        config.mean_key_size_ = atoi(optarg);
+        break;
+      }
+      case 'f': {
+        config.key_file_ = optarg;
+        break;
+      }
+      case 'L': {
+        config.bulk_load_ = true;
+        break;
+      }
+      case 'C': {
+        config.churn_ = true;
+        break;
+      }
+      case 'x': {
+        config.latency_sample_ = (uint64_t)strtoull(optarg, nullptr, 10); // uint64_t
+        break;
+      }
+      case 'z': {
+        config.access_type_ = (AccessType)atoi(optarg);
+        config.access_type_set_ = true;
+        break;
+      }
+      case 'Z': {
+        config.zipf_theta_ = (double)atof(optarg);
+        break;
+      }
+      case 'H': {
+        config.hot_op_fraction_ = (double)atof(optarg);
+        break;
+      }
+      case 'K': {
+        config.hot_key_fraction_ = (double)atof(optarg);
+        break;
+      }
+      case 'O': {
+        config.target_rate_ = (double)atof(optarg);
+        break;
+      }
+      case 'A': {
+        config.arrival_type_ = (ArrivalType)atoi(optarg);
+        break;
+      }
       case 'c': {
         config.record_ = true;
         break;
@@ -165,102 +320,366 @@ void parse_args(int argc, char* argv[], Config &config) {
     }
   }
 
+  if (config.batch_size_ < 1) {
+    std::cerr << "batch size must be positive" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (!config.mix_spec_.empty()) {
+    std::string error;
+    if (!config.mix_.parse(config.mix_spec_, error)) {
+      std::cerr << error << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    config.mix_enabled_ = true;
+
+    // a ycsb workload brings its request distribution, unless one is given.
+    if (config.access_type_set_ == false) {
+      config.access_type_ = config.mix_.preset_access_type();
+    }
+  }
+
+  if (config.scan_length_ < 1) {
+    std::cerr << "scan length must be positive" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.churn_ == true && config.key_count_ < (uint64_t)config.thread_count_) {
+    std::cerr << "churn requires at least one initial key per thread" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.target_rate_ < 0) {
+    std::cerr << "target rate must not be negative" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.workload_type_ == WorkloadType::FileType && config.key_file_.empty()) {
+    std::cerr << "file workload needs a key file" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.mean_key_size_ < 0) {
+    std::cerr << "mean key size must not be negative" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  validate_access_params(config.access_type_, config.zipf_theta_, config.hot_op_fraction_, config.hot_key_fraction_);
+
   config.print();
 
 }
 
 bool is_running = false;
 uint64_t *operation_counts = nullptr;
+uint64_t *operation_type_counts = nullptr; // per thread and operation type
+LatencyRecorder *latency_recorder = nullptr;
 
-void run_thread(const size_t &thread_id, const Config &config, const GenericKey *query_keys, GenericDataTable *data_table, BaseGenericIndex *data_index) {
+void run_thread(const size_t &thread_id, const Config &config, const GenericKeyView *query_keys, const GenericKeyView *sorted_keys, const AccessDistribution *access_distribution, std::pair<GenericKeyView, Uint64> *live_entries, MappedKeyFile *key_file, GenericDataTable *data_table, BaseGenericIndex *data_index) {
 
   pin_to_core(thread_id);
 
   data_index->register_thread(thread_id);
 
-  std::unique_ptr<BaseGenericKeyGenerator> key_generator(construct_generic_key_generator(config.workload_type_, thread_id, config.key_size_));
+  std::unique_ptr<BaseGenericKeyGenerator> key_generator(construct_generic_key_generator(config.workload_type_, thread_id, config.key_size_, config.mean_key_size_, key_file));
 
   uint64_t &operation_count = operation_counts[thread_id];
   operation_count = 0;
 
+  uint64_t *type_counts = operation_type_counts + thread_id * OPERATION_TYPE_COUNT;
+
   FastRandom rand_gen(thread_id);
 
+  // chooses the keys of reads.
+  AccessKeyPicker<GenericKeyView> key_picker(access_distribution, query_keys, thread_id);
+
   GenericKey insert_key;
 
   ValueT value = 100;
 
+  const size_t batch_size = config.batch_size_;
+  std::vector<GenericKey> batch_keys(batch_size);
+  std::vector<std::vector<Uint64>> batch_offsets(batch_size);
+
+  // scans stream their matches into a counter, so that a scan does not store its range.
+  size_t scan_match_count = 0;
+  auto scan_sink = make_visitor_sink([&scan_match_count](const Uint64 &) { ++scan_match_count; });
+  const bool scan_reverse = (config.index_read_type_ == ReadType::IndexScanReverseType);
+
+  // churn: the thread owns a slice of the live entries, oldest first from the cursor on.
+  // an insert replaces the entry at the cursor.
+  size_t live_begin = 0;
+  size_t live_end = 0;
+  size_t live_cursor = 0;
+  if (live_entries != nullptr) {
+    live_begin = config.key_count_ * thread_id / config.thread_count_;
+    live_end = config.key_count_ * (thread_id + 1) / config.thread_count_;
+    live_cursor = live_begin;
+  }
+  GenericKey erase_key;
+
+  // open loop: the thread issues its share of the target rate.
+  std::unique_ptr<OpenLoopPacer> pacer(nullptr);
+  if (config.target_rate_ > 0) {
+    pacer.reset(new OpenLoopPacer(config.target_rate_ / config.thread_count_, config.arrival_type_, latency_recorder->cycles_per_ns(), thread_id));
+  }
+
   while (true) {
     if (is_running == false) {
       break;
     }
 
-    double next_rand = rand_gen.next_uniform();
+    // a workload mix picks the operation. otherwise, reads and inserts split by the read ratio.
+    OperationType operation_type = OperationType::InsertOpType;
+    if (config.mix_enabled_ == true) {
+      operation_type = config.mix_.next(rand_gen);
+    } else if (rand_gen.next_uniform() < config.read_ratio_) {
+      operation_type = (config.index_read_type_ == ReadType::IndexLookupType) ? OperationType::LookupOpType : OperationType::ScanOpType;
+    }
+
+    bool is_batch = (operation_type == OperationType::LookupOpType && batch_size > 1);
+
+    // in open loop, wait until the operation is due, and time it from then, so that queueing
+    // behind slow operations counts. a batch is due with its last lookup.
+    uint64_t due_cycles = 0;
+    if (pacer != nullptr) {
+      due_cycles = pacer->wait_arrivals(is_batch ? batch_size : 1, is_running);
+      if (is_running == false) {
+        break;
+      }
+    }
+
+    if (is_batch) {
+      for (size_t i = 0; i < batch_size; ++i) {
+        const GenericKeyView &key = key_picker.next();
+        batch_keys[i].assign(key.raw(), key.size());
+        batch_offsets[i].clear();
+      }
 
-    if (next_rand < config.read_ratio_) {
+      bool is_sampled = latency_recorder->is_sampled(operation_count / batch_size);
+      uint64_t start_cycles = is_sampled ? (pacer != nullptr ? due_cycles : read_cycle_counter()) : 0;
 
-      std::vector<Uint64> offsets;
+      // retrieve tuple locations of the whole batch
+      data_index->find_batch(batch_keys.data(), batch_size, batch_offsets.data());
 
-      // retrieve tuple locations
-      data_index->find(query_keys[rand_gen.next<uint64_t>() % config.key_count_], offsets);
+      // a lookup in a batch is charged its share of the batch.
+      if (is_sampled) {
+        latency_recorder->record(thread_id, OperationType::LookupOpType, (read_cycle_counter() - start_cycles) / batch_size);
+      }
 
-      // ASSERT(offsets.size() == 1, "must be 1! " << key);
-    } else {
-      // insert
+      type_counts[size_t(OperationType::LookupOpType)] += batch_size;
+      operation_count += batch_size;
+      continue;
+    }
+
+    // pick keys before the timer starts. deletes take an owned key.
+    GenericKeyView key;
+    uint64_t lhs_rank = 0;
+    uint64_t rhs_rank = 0;
+    if (operation_type == OperationType::InsertOpType) {
       key_generator->get_next_key(insert_key);
-      
-      OffsetT offset = data_table->insert_tuple(insert_key.raw(), insert_key.size(), (char*)(&value), sizeof(value));
+    } else if (operation_type == OperationType::ScanOpType) {
+      pick_scan_range(access_distribution, rand_gen, config.scan_length_, scan_reverse, lhs_rank, rhs_rank);
+    } else {
+      key = key_picker.next();
+      if (operation_type == OperationType::DeleteOpType) {
+        insert_key.assign(key.raw(), key.size());
+      }
+    }
+
+    bool is_sampled = latency_recorder->is_sampled(operation_count);
+    uint64_t start_cycles = is_sampled ? (pacer != nullptr ? due_cycles : read_cycle_counter()) : 0;
+
+    std::pair<GenericKeyView, Uint64> inserted_entry;
+
+    switch (operation_type) {
+      case OperationType::LookupOpType: {
+        // matches are kept inline, so that a lookup does not allocate
+        InlineResultSink<8> offsets;
 
-      // insert tuple locations into index
-      data_index->insert(insert_key, offset.raw_data());
+        // retrieve tuple locations
+        data_index->find(key, offsets);
+        break;
+      }
+      case OperationType::ScanOpType: {
+        // a range between two init keys holds about as many keys as their ranks are apart.
+        data_index->find_range(sorted_keys[lhs_rank], sorted_keys[rhs_rank], scan_sink);
+        break;
+      }
+      case OperationType::UpdateOpType:
+      case OperationType::ReadModifyWriteOpType: {
+        InlineResultSink<8> offsets;
+        data_index->find(key, offsets);
+
+        // update the tuples in place. the index is unchanged.
+        for (size_t i = 0; i < offsets.size(); ++i) {
+          char *tuple_value = data_table->get_tuple_value(OffsetT(offsets[i]));
+          ValueT new_value = ValueT(operation_count);
+          if (operation_type == OperationType::ReadModifyWriteOpType) {
+            memcpy(&new_value, tuple_value, sizeof(ValueT));
+            ++new_value;
+          }
+          memcpy(tuple_value, &new_value, sizeof(ValueT));
+        }
+        break;
+      }
+      case OperationType::DeleteOpType: {
+        data_index->erase(insert_key);
+        break;
+      }
+      default: {
+        // insert
+        OffsetT offset = data_table->insert_tuple(insert_key.raw(), insert_key.size(), (char*)(&value), sizeof(value), thread_id);
+
+        // insert tuple locations into index
+        data_index->insert(insert_key, offset.raw_data());
+
+        // the table keeps the key, the insert buffer is reused.
+        inserted_entry = std::make_pair(GenericKeyView(data_table->get_tuple_key(offset), insert_key.size()), offset.raw_data());
+        key_picker.inserted(inserted_entry.first);
+        break;
+      }
     }
 
+    if (is_sampled) {
+      latency_recorder->record(thread_id, operation_type, read_cycle_counter() - start_cycles);
+    }
+
+    ++type_counts[size_t(operation_type)];
     ++operation_count;
+
+    // the oldest live entry of the thread leaves, and the new one takes its place.
+    if (live_entries != nullptr && operation_type == OperationType::InsertOpType) {
+      std::pair<GenericKeyView, Uint64> &oldest = live_entries[live_cursor];
+      erase_key.assign(oldest.first.raw(), oldest.first.size());
+
+      // the erase is timed along with its insert.
+      start_cycles = is_sampled ? read_cycle_counter() : 0;
+
+      data_index->erase(erase_key, oldest.second);
+
+      if (is_sampled) {
+        latency_recorder->record(thread_id, OperationType::DeleteOpType, read_cycle_counter() - start_cycles);
+      }
+
+      oldest = inserted_entry;
+      if (++live_cursor == live_end) {
+        live_cursor = live_begin;
+      }
+
+      ++type_counts[size_t(OperationType::DeleteOpType)];
+      ++operation_count;
+    }
   }
 }
 
 void run_workload(const Config &config) {
 
-  // create table
+  // create table. the allocator outlives the table.
+  std::unique_ptr<BlockAllocator> block_allocator(create_block_allocator(config.block_allocator_type_));
+
   std::unique_ptr<GenericDataTable> data_table(nullptr);
   // note that the max_key_size passed to GenericDataTable must be at least 1 byte
   // larger than the real key_size.
   // this is because some index structures need to access base table to determine
   // key data. 
-  data_table.reset(new GenericDataTable(config.key_size_ + 1, config.value_size_));
+  data_table.reset(new GenericDataTable(config.key_size_ + 1, config.value_size_, MaxBlockCapacity, block_allocator.get()));
 
   // create index
   std::unique_ptr<BaseGenericIndex> data_index(nullptr);
   data_index.reset(create_generic_index(config.index_type_, data_table.get()));
 
-  // prepare threads
+  // prepare threads. every thread appends to its own table block.
+  data_table->prepare_threads(config.thread_count_);
   data_index->prepare_threads(config.thread_count_);
   data_index->register_thread(0);
 
   //=================================
   // populate table
   //=================================
-  std::unique_ptr<BaseGenericKeyGenerator> key_generator(construct_generic_key_generator(config.workload_type_, 0, config.key_size_));
+  std::unique_ptr<MappedKeyFile> key_file(nullptr);
+  if (config.workload_type_ == WorkloadType::FileType) {
+    key_file.reset(new MappedKeyFile(config.key_file_));
+  }
 
-  double query_key_size_mb = 0;
+  std::unique_ptr<BaseGenericKeyGenerator> key_generator(construct_generic_key_generator(config.workload_type_, 0, config.key_size_, config.mean_key_size_, key_file.get()));
 
-  GenericKey *init_keys = new GenericKey[config.key_count_]; // store all init keys
+  // the init keys are views of the keys in the table, so that a large key set is stored once.
+  GenericKeyView *init_keys = new GenericKeyView[config.key_count_];
+
+  std::vector<Uint64> init_offsets(config.key_count_);
 
   uint64_t value = 100;
 
+  GenericKey key;
+
   for (size_t i = 0; i < config.key_count_; ++i) {
 
-    key_generator->get_next_key(init_keys[i]);
+    key_generator->get_next_key(key);
     
-    OffsetT offset = data_table->insert_tuple(init_keys[i].raw(), init_keys[i].size(), (char*)(&value), sizeof(value));
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(value));
 
-    data_index->insert(init_keys[i], offset.raw_data());
+    init_keys[i] = GenericKeyView(data_table->get_tuple_key(offset), key.size());
+    init_offsets[i] = offset.raw_data();
+  }
 
-    query_key_size_mb += init_keys[i].size();
+  // churn erases entries in load order. the keys are views of the table.
+  std::vector<std::pair<GenericKeyView, Uint64>> live_entries;
+  if (config.churn_ == true) {
+    live_entries.resize(config.key_count_);
+    for (size_t i = 0; i < config.key_count_; ++i) {
+      live_entries[i] = std::make_pair(init_keys[i], init_offsets[i]);
+    }
+  }
 
+  //=================================
+  // populate index
+  //=================================
+  // bulk load takes owned keys, which are freed after loading.
+  std::vector<std::pair<GenericKey, Uint64>> init_entries;
+  if (config.bulk_load_ == true) {
+    init_entries.resize(config.key_count_);
+    for (size_t i = 0; i < config.key_count_; ++i) {
+      init_entries[i].first.assign(init_keys[i].raw(), init_keys[i].size());
+      init_entries[i].second = init_offsets[i];
+    }
+  }
+
+  double pre_load_mem_size = get_memory_mb();
+
+  // sorting is part of the bulk load path, but is reported separately.
+  TimeMeasurer sort_timer;
+  TimeMeasurer load_timer;
+
+  if (config.bulk_load_ == true) {
+    sort_timer.tic();
+    std::sort(init_entries.begin(), init_entries.end(), 
+      [](const std::pair<GenericKey, Uint64> &lhs, const std::pair<GenericKey, Uint64> &rhs) { return lhs.first < rhs.first; });
+    sort_timer.toc();
+
+    load_timer.tic();
+    data_index->bulk_load(init_entries.data(), init_entries.size());
+    load_timer.toc();
+
+  } else {
+    load_timer.tic();
+    for (size_t i = 0; i < config.key_count_; ++i) {
+      key.assign(init_keys[i].raw(), init_keys[i].size());
+      data_index->insert(key, init_offsets[i]);
+    }
+    load_timer.toc();
   }
+
+  std::cout << "index load time: " << load_timer.time_us() / 1000.0 << " ms, "
+            << "sort time: " << (config.bulk_load_ ? sort_timer.time_us() / 1000.0 : 0) << " ms, "
+            << "index memory size: " << (get_memory_mb() - pre_load_mem_size) << " MB" << std::endl;
+
+  std::vector<std::pair<GenericKey, Uint64>>().swap(init_entries);
+  std::vector<Uint64>().swap(init_offsets);
+
   data_index->reorganize();
 
-  query_key_size_mb = query_key_size_mb * 1.0 / 1024 / 1024;
+  double query_key_size_mb = (config.key_count_ * sizeof(GenericKeyView) + live_entries.size() * sizeof(std::pair<GenericKeyView, Uint64>)) * 1.0 / 1024 / 1024;
   //=================================
 
   //=================================
@@ -283,6 +702,9 @@ void run_workload(const Config &config) {
   //=================================
 
   operation_counts = new uint64_t[config.thread_count_];
+  operation_type_counts = new uint64_t[config.thread_count_ * OPERATION_TYPE_COUNT];
+  memset(operation_type_counts, 0, config.thread_count_ * OPERATION_TYPE_COUNT * sizeof(uint64_t));
+  latency_recorder = new LatencyRecorder(config.thread_count_, config.latency_sample_);
   uint64_t profile_round = (uint64_t)(config.time_duration_ / config.profile_duration_);
 
   uint64_t **operation_counts_profiles = new uint64_t*[profile_round];
@@ -297,7 +719,20 @@ void run_workload(const Config &config) {
 
   double init_mem_size = get_memory_mb();
   std::cout << "init memory size (index + table): " << (init_mem_size - query_key_size_mb) << " MB" << std::endl;
+  std::cout << "init index memory (counted by the index): ";
+  data_index->memory_usage().print();
   
+  // scans run between init keys in key order.
+  std::vector<GenericKeyView> sorted_keys;
+  bool has_scans = config.mix_enabled_ ? (config.mix_.share(OperationType::ScanOpType) > 0) : (config.index_read_type_ != ReadType::IndexLookupType && config.read_ratio_ > 0);
+  if (has_scans == true) {
+    sorted_keys.assign(init_keys, init_keys + config.key_count_);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+  }
+  query_key_size_mb += sorted_keys.size() * sizeof(GenericKeyView) * 1.0 / 1024 / 1024;
+
+  std::unique_ptr<AccessDistribution> access_distribution(new AccessDistribution(config.access_type_, config.key_count_, config.zipf_theta_, config.hot_op_fraction_, config.hot_key_fraction_));
+
   // launch a group of threads
   is_running = true;
   std::vector<std::thread> worker_threads;
@@ -306,7 +741,7 @@ void run_workload(const Config &config) {
   // PAPIProfiler::start_measure_cache_miss_rate();
   
   for (uint64_t thread_id = 0; thread_id < config.thread_count_; ++thread_id) {
-    worker_threads.push_back(std::move(std::thread(run_thread, thread_id, std::ref(config), init_keys, data_table.get(), data_index.get())));
+    worker_threads.push_back(std::move(std::thread(run_thread, thread_id, std::ref(config), init_keys, sorted_keys.data(), access_distribution.get(), live_entries.empty() ? nullptr : live_entries.data(), key_file.get(), data_table.get(), data_index.get())));
   }
 
   std::cout << "        TIME       THROUGHPUT   RAM (tot.)   RAM (tab.)" << std::endl;
@@ -316,7 +751,7 @@ void run_workload(const Config &config) {
     
     memcpy(operation_counts_profiles[round_id], operation_counts, sizeof(uint64_t) * config.thread_count_);
 
-    double table_size_approx = data_table->size_approx() * (config.key_size_ + 1 + config.value_size_) * 1.0 / 1024 / 1024;
+    double table_size_approx = data_table->size_approx() * 1.0 / 1024 / 1024;
 
     table_size_profiles.push_back(table_size_approx);
     act_size_profiles.push_back(get_memory_mb() - query_key_size_mb);
@@ -362,6 +797,10 @@ void run_workload(const Config &config) {
               << table_size_profiles.at(round_id)
               << " MB"
               << std::endl;
+
+    if (latency_recorder->enabled() == true) {
+      latency_recorder->print_round();
+    }
   }
   
   // join all the threads
@@ -371,6 +810,9 @@ void run_workload(const Config &config) {
     worker_threads.at(i).join();
   }
 
+  std::cout << "final index memory (counted by the index): ";
+  data_index->memory_usage().print();
+
   // PAPIProfiler::stop_measure_cache_miss_rate();
   
   uint64_t total_count = 0;
@@ -381,6 +823,51 @@ void run_workload(const Config &config) {
   std::cout << "average throughput: " << total_count * 1.0 / config.time_duration_ / 1000 / 1000 << " M ops" 
             << std::endl;
 
+  for (size_t type = 0; type < OPERATION_TYPE_COUNT; ++type) {
+    uint64_t type_count = 0;
+    for (uint64_t i = 0; i < config.thread_count_; ++i) {
+      type_count += operation_type_counts[i * OPERATION_TYPE_COUNT + type];
+    }
+    if (type_count != 0) {
+      std::cout << "  " << get_operation_name(OperationType(type)) << " throughput: " 
+                << type_count * 1.0 / config.time_duration_ / 1000 / 1000 << " M ops" << std::endl;
+    }
+  }
+
+  // under churn, the second half of the run is taken as the steady state. the table keeps
+  // every tuple, so the index memory is the total less the table.
+  if (config.churn_ == true && profile_round >= 2) {
+    uint64_t steady_begin = profile_round / 2;
+    uint64_t steady_count = 0;
+    double steady_mem_size = 0;
+    double steady_index_size = 0;
+    for (uint64_t round_id = steady_begin; round_id < profile_round; ++round_id) {
+      steady_count += total_operation_counts.at(round_id);
+      steady_mem_size += act_size_profiles.at(round_id);
+      steady_index_size += act_size_profiles.at(round_id) - table_size_profiles.at(round_id);
+    }
+    uint64_t steady_round = profile_round - steady_begin;
+    double steady_duration = steady_round * config.profile_duration_;
+    double index_size_drift = (act_size_profiles.back() - table_size_profiles.back()) - (act_size_profiles.at(steady_begin) - table_size_profiles.at(steady_begin));
+
+    std::cout << "steady state (last " << steady_duration << " s): "
+              << "throughput: " << steady_count * 1.0 / steady_duration / 1000 / 1000 << " M ops, "
+              << "memory (index + table): " << steady_mem_size / steady_round << " MB, "
+              << "index memory: " << steady_index_size / steady_round << " MB, "
+              << "index memory drift: " << index_size_drift << " MB"
+              << std::endl;
+  }
+
+  if (config.target_rate_ > 0) {
+    std::cout << "offered rate: " << config.target_rate_ / 1000 / 1000 << " M ops, "
+              << "achieved rate: " << total_count * 1.0 / config.time_duration_ / 1000 / 1000 << " M ops"
+              << std::endl;
+  }
+
+  if (latency_recorder->enabled() == true) {
+    latency_recorder->print_total();
+  }
+
   if (config.verbose_ == true) {
     data_index->print(); 
   }
@@ -396,6 +883,12 @@ void run_workload(const Config &config) {
   delete[] operation_counts;
   operation_counts = nullptr;
 
+  delete[] operation_type_counts;
+  operation_type_counts = nullptr;
+
+  delete latency_recorder;
+  latency_recorder = nullptr;
+
   delete[] init_keys;
   init_keys = nullptr;
 }
@@ -8,62 +8,141 @@
 
 struct GenericComparator;
 
-struct GenericKey {
+struct GenericKey;
 
-friend GenericComparator;
+// compare two byte strings. a proper prefix is smaller.
+static inline int compare_generic_key(const char *lhs, const size_t lhs_size, const char *rhs, const size_t rhs_size) {
+  size_t cmp_len = (lhs_size < rhs_size) ? lhs_size : rhs_size;
+  int rt = memcmp(lhs, rhs, cmp_len);
+  if (rt != 0) {
+    return rt;
+  }
+  return (lhs_size < rhs_size) ? -1 : (lhs_size > rhs_size ? 1 : 0);
+}
 
-public:
-  GenericKey() : data_(nullptr), data_size_(0) {}
+// the first 8 bytes of a key as a big-endian integer, padded with zeros. keys with
+// different prefixes compare like their prefixes.
+static inline uint64_t load_generic_key_prefix(const char *data, const size_t size) {
+  if (size >= 8) {
+    uint64_t prefix;
+    memcpy(&prefix, data, 8);
+    return __builtin_bswap64(prefix);
+  }
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    prefix = (prefix << 8) | (i < size ? (uint8_t)data[i] : 0);
+  }
+  return prefix;
+}
 
-  GenericKey(const size_t data_size) {
-    if (data_size == 0) {
-      data_ = nullptr;
-      data_size_ = 0;
-    } else {
-      data_ = new char[data_size];
-      memset(data_, 0, data_size);
-      data_size_ = data_size;
+// radix trees need that no key is a proper prefix of another ("mary" and "mary1"). keys are
+// encoded with 0x00 and 0x01 escaped as 0x01 0x01 and 0x01 0x02, followed by a 0x00
+// terminator. encoded keys are prefix-free, and compare like the original keys.
+static inline size_t prefix_free_key_size(const char *data, const size_t size) {
+  size_t encoded_size = size + 1;
+  for (size_t i = 0; i < size; ++i) {
+    if ((uint8_t)data[i] <= 1) {
+      ++encoded_size;
     }
   }
+  return encoded_size;
+}
 
-  GenericKey(const char* data, const size_t data_size) { 
-    if (data_size == 0) {
-      data_size_ = 0;
-      ASSERT(data == nullptr, "data must be nullptr");
+// out must hold prefix_free_key_size(data, size) bytes.
+static inline void encode_prefix_free_key(const char *data, const size_t size, uint8_t *out) {
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t byte = (uint8_t)data[i];
+    if (byte <= 1) {
+      *out++ = 1;
+      *out++ = byte + 1;
     } else {
-      data_ = new char[data_size];
-      memcpy(data_, data, data_size);
-      data_size_ = data_size;
+      *out++ = byte;
     }
   }
+  *out = 0;
+}
 
-  GenericKey(const GenericKey &key) {
-    if (key.data_size_ == 0) {
-      data_ = nullptr;
-      data_size_ = 0;
-    } else {
-      data_ = new char[key.data_size_];
-      memcpy(data_, key.data_, key.data_size_);
-      data_size_ = key.data_size_;
-    }
+// a non-owning reference to key bytes, e.g. a key in the table or in a caller's buffer.
+// lookups take a view, so that probing does not copy the key.
+struct GenericKeyView {
+
+public:
+  GenericKeyView() : data_(nullptr), data_size_(0) {}
+
+  GenericKeyView(const char *data, const size_t data_size) : data_(data), data_size_(data_size) {}
+
+  inline GenericKeyView(const GenericKey &key);
+
+  inline const char* raw() const { return data_; }
+
+  inline size_t size() const { return data_size_; }
+
+  bool operator==(const GenericKeyView &rhs) const {
+    return data_size_ == rhs.data_size_ && memcmp(data_, rhs.data_, data_size_) == 0;
+  }
+
+  bool operator<(const GenericKeyView &rhs) const {
+    return compare_generic_key(data_, data_size_, rhs.data_, rhs.data_size_) < 0;
+  }
+
+  bool operator>(const GenericKeyView &rhs) const {
+    return compare_generic_key(data_, data_size_, rhs.data_, rhs.data_size_) > 0;
+  }
+
+private:
+  const char *data_;
+  size_t data_size_;
+};
+
+// an owning key. keys up to INLINE_SIZE bytes are kept inside the object, so that short keys
+// are created, copied and moved without touching the allocator.
+struct GenericKey {
+
+friend GenericComparator;
+
+public:
+  static const size_t INLINE_SIZE = 24;
+
+  GenericKey() : data_(inline_data_), data_size_(0), capacity_(INLINE_SIZE) {}
+
+  GenericKey(const size_t data_size) : data_(inline_data_), data_size_(0), capacity_(INLINE_SIZE) {
+    resize(data_size);
+  }
+
+  GenericKey(const char* data, const size_t data_size) : data_(inline_data_), data_size_(0), capacity_(INLINE_SIZE) {
+    assign(data, data_size);
+  }
+
+  explicit GenericKey(const GenericKeyView &key) : data_(inline_data_), data_size_(0), capacity_(INLINE_SIZE) {
+    assign(key.raw(), key.size());
+  }
+
+  GenericKey(const GenericKey &key) : data_(inline_data_), data_size_(0), capacity_(INLINE_SIZE) {
+    assign(key.data_, key.data_size_);
+  }
+
+  GenericKey(GenericKey &&key) : data_(inline_data_), data_size_(0), capacity_(INLINE_SIZE) {
+    take(key);
   }
 
   ~GenericKey() {
-    delete[] data_;
-    data_ = nullptr;
-    data_size_ = 0;
+    release();
     COMPILER_MEMORY_FENCE;
   }
 
+  // reuses the buffer if it is large enough.
   GenericKey& operator=(const GenericKey &key) {
-    if (data_ != nullptr) {
-      ASSERT(data_size_ != 0, "data size cannot be 0");
-      delete[] data_;
-      data_size_ = 0;
+    if (this != &key) {
+      assign(key.data_, key.data_size_);
+    }
+    return *this;
+  }
+
+  GenericKey& operator=(GenericKey &&key) {
+    if (this != &key) {
+      release();
+      take(key);
     }
-    data_ = new char[key.data_size_];
-    memcpy(data_, key.data_, key.data_size_);
-    data_size_ = key.data_size_;
     return *this;
   }
 
@@ -71,94 +150,88 @@ public:
 
   inline size_t size() const { return data_size_; }
 
-  // transfer ownership
-  // void reset(char *data, const size_t data_size) {
-  //   ASSERT(data_ == nullptr && data_size_ == 0, "must be uninitiated");
-
-  //   data_ = data;
-  //   data_size_ = data_size;
+  inline GenericKeyView view() const { return GenericKeyView(data_, data_size_); }
 
-  // }
+  // bytes held outside the object, for keys longer than INLINE_SIZE.
+  inline size_t heap_bytes() const { return is_inline() ? 0 : capacity_; }
 
+  // set the size, and zero the key. reuses the buffer if it is large enough.
   void resize(const size_t data_size) {
-    ASSERT(data_ == nullptr && data_size_ == 0, "must be uninitiated");
-    
-    if (data_size == 0) {
-      data_ = nullptr;
-      data_size_ = 0;
-    } else {
-      data_ = new char[data_size];
-      memset(data_, 0, data_size);
-      data_size_ = data_size;
+    reserve(data_size);
+    memset(data_, 0, data_size);
+    data_size_ = data_size;
+  }
+
+  void assign(const char *data, const size_t data_size) {
+    reserve(data_size);
+    if (data_size != 0) {
+      memcpy(data_, data, data_size);
     }
+    data_size_ = data_size;
   }
 
   bool operator==(const GenericKey &rhs) const {
-    if (data_size_ != rhs.data_size_) {
-      return false;
-    }
-    int rt = memcmp(data_, rhs.data_, data_size_);
-    if (rt == 0) {
-      return true;
-    } else {
-      return false;
-    }
+    return data_size_ == rhs.data_size_ && memcmp(data_, rhs.data_, data_size_) == 0;
   }
 
   bool operator<(const GenericKey &rhs) const {
-    size_t cmp_len = (data_size_ < rhs.data_size_) ? data_size_ : rhs.data_size_;
-    int rt = memcmp(data_, rhs.data_, cmp_len);
-    if (rt == 0) {
-      if (data_size_ < rhs.data_size_) {
-        return true;
-      } else {
-        return false;
-      }
-    } else if (rt < 0) {
-      return true;
-    } else {
-      return false;
-    }
+    return compare_generic_key(data_, data_size_, rhs.data_, rhs.data_size_) < 0;
   }
 
   bool operator>(const GenericKey &rhs) const {
-    size_t cmp_len = (data_size_ < rhs.data_size_) ? data_size_ : rhs.data_size_;
-    int rt = memcmp(data_, rhs.data_, cmp_len);
-    if (rt == 0) {
-      if (data_size_ > rhs.data_size_) {
-        return true;
-      } else {
-        return false;
-      }
-    } else if (rt > 0) {
-      return true;
+    return compare_generic_key(data_, data_size_, rhs.data_, rhs.data_size_) > 0;
+  }
+
+private:
+  inline bool is_inline() const { return data_ == inline_data_; }
+
+  // make room for data_size bytes. the content is not kept.
+  void reserve(const size_t data_size) {
+    if (data_size <= capacity_) {
+      return;
+    }
+    release();
+    data_ = new char[data_size];
+    capacity_ = data_size;
+  }
+
+  void release() {
+    if (!is_inline()) {
+      delete[] data_;
+    }
+    data_ = inline_data_;
+    data_size_ = 0;
+    capacity_ = INLINE_SIZE;
+  }
+
+  // steal the heap buffer of key, or copy its inline bytes.
+  void take(GenericKey &key) {
+    if (key.is_inline()) {
+      memcpy(inline_data_, key.inline_data_, key.data_size_);
+      data_size_ = key.data_size_;
     } else {
-      return false;
+      data_ = key.data_;
+      data_size_ = key.data_size_;
+      capacity_ = key.capacity_;
+      key.data_ = key.inline_data_;
+      key.data_size_ = 0;
+      key.capacity_ = INLINE_SIZE;
     }
   }
 
 private:
-  char *data_ = nullptr;
-  size_t data_size_ = 0;
+  char *data_;
+  size_t data_size_;
+  size_t capacity_;
+  char inline_data_[INLINE_SIZE];
 };
 
+inline GenericKeyView::GenericKeyView(const GenericKey &key) : data_(key.raw()), data_size_(key.size()) {}
+
 // "less than" relation
 struct GenericKeyComparator {
   inline bool operator()(const GenericKey &lhs, const GenericKey &rhs) const {
-    size_t cmp_len = (lhs.size() < rhs.size()) ? lhs.size() : rhs.size();
-    int rt = memcmp(lhs.raw(), rhs.raw(), cmp_len);
-    if (rt == 0) {
-      if (lhs.size() < rhs.size()) {
-        return true;
-      } else {
-        return false;
-      }
-    } else if (rt < 0) {
-      return true;
-    } else {
-      return false;
-    }
-
+    return compare_generic_key(lhs.raw(), lhs.size(), rhs.raw(), rhs.size()) < 0;
   }
 };
 
@@ -182,3 +255,77 @@ struct GenericKeyHasher {
   }
 };
 
+
+
+// a key that carries its prefix. most comparisons are settled by one integer compare, and
+// only keys that share the first 8 bytes fall back to memcmp over the remaining bytes.
+struct PrefixGenericKey {
+
+public:
+  PrefixGenericKey() : prefix_(0) {}
+
+  explicit PrefixGenericKey(const GenericKeyView &key) : prefix_(load_generic_key_prefix(key.raw(), key.size())), key_(key) {}
+
+  // reuses the key buffer, so that a probe kept across lookups stops allocating.
+  void assign(const GenericKeyView &key) {
+    prefix_ = load_generic_key_prefix(key.raw(), key.size());
+    key_.assign(key.raw(), key.size());
+  }
+
+  inline uint64_t prefix() const { return prefix_; }
+
+  inline const GenericKey& key() const { return key_; }
+
+  inline const char* raw() const { return key_.raw(); }
+
+  inline size_t size() const { return key_.size(); }
+
+  inline size_t heap_bytes() const { return key_.heap_bytes(); }
+
+  inline int compare(const PrefixGenericKey &rhs) const {
+    if (prefix_ != rhs.prefix_) {
+      return prefix_ < rhs.prefix_ ? -1 : 1;
+    }
+    // the first min(8, size) bytes are equal.
+    size_t lhs_size = key_.size();
+    size_t rhs_size = rhs.key_.size();
+    if (lhs_size > 8 && rhs_size > 8) {
+      return compare_generic_key(key_.raw() + 8, lhs_size - 8, rhs.key_.raw() + 8, rhs_size - 8);
+    }
+    return (lhs_size < rhs_size) ? -1 : (lhs_size > rhs_size ? 1 : 0);
+  }
+
+  bool operator==(const PrefixGenericKey &rhs) const {
+    return prefix_ == rhs.prefix_ && key_ == rhs.key_;
+  }
+
+  bool operator<(const PrefixGenericKey &rhs) const {
+    return compare(rhs) < 0;
+  }
+
+  bool operator>(const PrefixGenericKey &rhs) const {
+    return compare(rhs) > 0;
+  }
+
+private:
+  uint64_t prefix_;
+  GenericKey key_;
+};
+
+struct PrefixGenericKeyComparator {
+  inline bool operator()(const PrefixGenericKey &lhs, const PrefixGenericKey &rhs) const {
+    return lhs.compare(rhs) < 0;
+  }
+};
+
+struct PrefixGenericKeyEqualityChecker {
+  inline bool operator()(const PrefixGenericKey &lhs, const PrefixGenericKey &rhs) const {
+    return lhs == rhs;
+  }
+};
+
+struct PrefixGenericKeyHasher {
+  inline std::size_t operator()(const PrefixGenericKey &key) const {
+    return CityHash64(key.raw(), key.size());
+  }
+};
@@ -1,14 +1,24 @@
 #pragma once
 
 #include "synthetic_generic_key_generator.h"
+#include "username_generic_key_generator.h"
+#include "url_generic_key_generator.h"
+#include "file_generic_key_generator.h"
 
 enum class WorkloadType {
   SyntheticType = 0,
   UsernameType = 1,
   UrlType = 2,
+  FileType = 3,
 };
 
-static BaseGenericKeyGenerator* construct_generic_key_generator(const WorkloadType workload_type, const uint64_t thread_id, const size_t key_size) {
+// mean key sizes of the username and url workloads, unless a mean is given.
+static const size_t DEFAULT_USERNAME_KEY_SIZE = 12;
+static const size_t DEFAULT_URL_KEY_SIZE = 64;
+
+// key_size is the maximum key size. a mean key size of 0 picks the workload's default.
+// file workloads read from key_file, which generators of all threads share.
+static BaseGenericKeyGenerator* construct_generic_key_generator(const WorkloadType workload_type, const uint64_t thread_id, const size_t key_size, const size_t mean_key_size = 0, MappedKeyFile *key_file = nullptr) {
 
   if (workload_type == WorkloadType::SyntheticType) {
 
@@ -16,9 +26,23 @@ static BaseGenericKeyGenerator* construct_generic_key_generator(const WorkloadTy
 
     return new SyntheticGenericKeyGenerator(thread_id, key_size);
 
+  } else if (workload_type == WorkloadType::UsernameType) {
+
+    size_t mean_size = mean_key_size != 0 ? mean_key_size : DEFAULT_USERNAME_KEY_SIZE;
+
+    return new UsernameGenericKeyGenerator(thread_id, key_size, std::min(mean_size, key_size));
+
+  } else if (workload_type == WorkloadType::UrlType) {
+
+    size_t mean_size = mean_key_size != 0 ? mean_key_size : DEFAULT_URL_KEY_SIZE;
+
+    return new UrlGenericKeyGenerator(thread_id, key_size, std::min(mean_size, key_size));
+
   } else {
-    ASSERT(false, "unsupported yet...");
-    return nullptr;
+    ASSERT(workload_type == WorkloadType::FileType, "unsupported workload type: " << int(workload_type));
+    ASSERT(key_file != nullptr, "file workload needs a key file");
+
+    return new FileGenericKeyGenerator(key_file, key_size);
   }
 
 }
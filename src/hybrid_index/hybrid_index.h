@@ -0,0 +1,475 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "base_index.h"
+#include "base_static_index.h"
+#include "shared_mutex.h"
+
+namespace hybrid_index {
+
+// hybrid index: a read-optimized static main index plus a small dynamic delta index.
+//  - inserts go to the active delta. once it holds merge_threshold entries, it is frozen, and
+//    a background thread merges it with the main index into a new static main index.
+//  - erase removes a key from the active delta, and hides the key in the frozen delta and the
+//    main index by a tombstone. tombstones are applied by the next merge.
+// the main index and the frozen delta are immutable, and are published together as a snapshot.
+// readers hold a reference to the snapshot they started with, so they never wait for a merge.
+// the active delta and its tombstones are not: the delta is a single-threaded index, and
+// they are guarded by a reader/writer lock that is held for single operations only.
+// readers take it shared to copy the snapshot and probe the active delta, and every insert
+// and erase takes it alone. readers do wait for delta writes, so a steady stream of inserts
+// serializes all lookups, and the index does not scale with writer threads. a concurrent
+// delta would let reads skip the lock, but the tombstone set and the freeze would have to
+// become concurrent with it.
+template<typename KeyT, typename ValueT>
+class HybridIndex : public BaseIndex<KeyT, ValueT> {
+
+public:
+  // main_factory creates an empty static index for the given number of entries.
+  typedef std::function<BaseStaticIndex<KeyT, ValueT>*(const size_t size)> MainFactory;
+  // delta_factory creates an empty dynamic index.
+  typedef std::function<BaseIndex<KeyT, ValueT>*()> DeltaFactory;
+
+  static const size_t DEFAULT_MERGE_THRESHOLD = 1ull << 16;
+
+private:
+  typedef std::unordered_set<KeyT> KeySet;
+
+  struct Snapshot {
+    Snapshot() : erased_(new KeySet()) {}
+
+    std::shared_ptr<BaseStaticIndex<KeyT, ValueT>> main_; // nullptr before the first build
+    std::shared_ptr<BaseIndex<KeyT, ValueT>> frozen_; // nullptr unless a merge or a rebuild is running
+    std::shared_ptr<const KeySet> erased_; // erased before the freeze. hides entries of main_.
+  };
+
+public:
+  HybridIndex(DataTable<KeyT, ValueT> *table_ptr, const MainFactory &main_factory, const DeltaFactory &delta_factory, const size_t merge_threshold = DEFAULT_MERGE_THRESHOLD)
+    : BaseIndex<KeyT, ValueT>(table_ptr)
+    , main_factory_(main_factory)
+    , delta_factory_(delta_factory)
+    , merge_threshold_(merge_threshold)
+    , snapshot_(new Snapshot())
+    , active_(delta_factory())
+    , active_erased_(new KeySet())
+    , merging_(false)
+    , merge_count_(0) {
+
+    ASSERT(merge_threshold_ >= 1, "merge threshold must be positive");
+  }
+
+  virtual ~HybridIndex() {
+    wait_for_merge();
+  }
+
+  virtual void insert(const KeyT &key, const Uint64 &offset) final {
+    std::lock_guard<SharedMutex> guard(mutex_);
+
+    if (is_in_main(key, offset)) {
+      return;
+    }
+    active_->insert(key, offset);
+
+    if (!merging_ && active_->size() >= merge_threshold_) {
+      start_merge();
+    }
+  }
+
+  virtual void erase(const KeyT &key) final {
+    std::lock_guard<SharedMutex> guard(mutex_);
+
+    active_->erase(key);
+    // range queries may still hold the tombstones, so they are copied on write.
+    if (active_erased_.use_count() > 1) {
+      active_erased_.reset(new KeySet(*active_erased_));
+    }
+    active_erased_->insert(key);
+  }
+
+  virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
+
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
+
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    std::shared_ptr<Snapshot> snapshot;
+    std::vector<size_t> erased_sizes;
+    {
+      SharedLockGuard guard(mutex_);
+      snapshot = snapshot_;
+      active_->find_batch(keys, count, offsets);
+      if (!active_erased_->empty()) {
+        erased_sizes.resize(count, std::numeric_limits<size_t>::max());
+        for (size_t i = 0; i < count; ++i) {
+          if (active_erased_->find(keys[i]) != active_erased_->end()) {
+            erased_sizes[i] = offsets[i].size();
+          }
+        }
+      }
+    }
+
+    if (snapshot->frozen_) {
+      snapshot->frozen_->find_batch(keys, count, offsets);
+    }
+    if (snapshot->main_) {
+      if (!snapshot->erased_->empty() && erased_sizes.empty()) {
+        erased_sizes.resize(count, std::numeric_limits<size_t>::max());
+      }
+      std::vector<size_t> main_sizes(snapshot->erased_->empty() ? 0 : count);
+      for (size_t i = 0; i < main_sizes.size(); ++i) {
+        main_sizes[i] = offsets[i].size();
+      }
+      snapshot->main_->find_batch(keys, count, offsets);
+      for (size_t i = 0; i < main_sizes.size(); ++i) {
+        if (snapshot->erased_->find(keys[i]) != snapshot->erased_->end()) {
+          erased_sizes[i] = std::min(erased_sizes[i], main_sizes[i]);
+        }
+      }
+    }
+
+    // drop the matches that tombstones hide.
+    for (size_t i = 0; i < erased_sizes.size(); ++i) {
+      if (erased_sizes[i] < offsets[i].size()) {
+        offsets[i].resize(erased_sizes[i]);
+      }
+    }
+  }
+
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    if (lhs_key > rhs_key) { return; }
+
+    std::shared_ptr<Snapshot> snapshot;
+    std::shared_ptr<const KeySet> active_erased;
+    {
+      SharedLockGuard guard(mutex_);
+      snapshot = snapshot_;
+      active_->find_range(lhs_key, rhs_key, offsets);
+      active_erased = active_erased_;
+    }
+
+    if (snapshot->frozen_) {
+      std::vector<Uint64> frozen_offsets;
+      snapshot->frozen_->find_range(lhs_key, rhs_key, frozen_offsets);
+      append_visible(frozen_offsets, *active_erased, nullptr, offsets);
+    }
+    if (snapshot->main_) {
+      std::vector<Uint64> main_offsets;
+      snapshot->main_->find_range(lhs_key, rhs_key, main_offsets);
+      append_visible(main_offsets, *active_erased, snapshot->erased_.get(), offsets);
+    }
+  }
+
+  virtual void scan(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find(key, offsets);
+  }
+
+  virtual void scan_reverse(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find(key, offsets);
+  }
+
+  // entries of the active delta, the frozen delta and the main index, in this order.
+  virtual void scan_full(std::vector<Uint64> &offsets, const size_t count) final {
+    std::shared_ptr<Snapshot> snapshot;
+    std::shared_ptr<const KeySet> active_erased;
+    {
+      SharedLockGuard guard(mutex_);
+      snapshot = snapshot_;
+      active_->scan_full(offsets, count);
+      active_erased = active_erased_;
+    }
+
+    if (snapshot->frozen_ && offsets.size() < count) {
+      std::vector<Uint64> frozen_offsets;
+      snapshot->frozen_->scan_full(frozen_offsets, std::numeric_limits<size_t>::max());
+      append_visible(frozen_offsets, *active_erased, nullptr, offsets);
+    }
+    if (snapshot->main_ && offsets.size() < count) {
+      std::vector<Uint64> main_offsets;
+      snapshot->main_->scan_full(main_offsets, std::numeric_limits<size_t>::max());
+      append_visible(main_offsets, *active_erased, snapshot->erased_.get(), offsets);
+    }
+    if (offsets.size() > count) {
+      offsets.resize(count);
+    }
+  }
+
+  // entries hidden by tombstones are counted until the next merge.
+  virtual size_t size() const final {
+    SharedLockGuard guard(mutex_);
+
+    size_t size = active_->size();
+    if (snapshot_->frozen_) {
+      size += snapshot_->frozen_->size();
+    }
+    if (snapshot_->main_) {
+      size += snapshot_->main_->size();
+    }
+    return size;
+  }
+
+  // the sum over the main index and the deltas. tombstones count as delta bytes.
+  virtual IndexMemoryStats memory_usage() const final {
+    SharedLockGuard guard(mutex_);
+
+    IndexMemoryStats stats = active_->memory_usage();
+    size_t tombstone_count = active_erased_->size();
+    if (snapshot_->frozen_) {
+      stats += snapshot_->frozen_->memory_usage();
+    }
+    if (snapshot_->main_) {
+      stats += snapshot_->main_->memory_usage();
+    }
+    tombstone_count += snapshot_->erased_->size();
+    stats.delta_bytes_ += tombstone_count * sizeof(KeyT);
+    return stats;
+  }
+
+  // rebuild the main index from the whole table, and start over with an empty delta.
+  // entries erased before are restored, as the table keeps all tuples.
+  // no merge starts during the rebuild. the active delta is frozen, so that readers keep
+  // seeing its entries, and the entries inserted meanwhile go to a new active delta.
+  // a tuple that is being written to the table while the rebuild reads it may be gathered
+  // before its key is written, as the table reserves a slot before filling it.
+  virtual void reorganize(const size_t thread_count = 1) final {
+    while (true) {
+      wait_for_merge();
+
+      std::lock_guard<SharedMutex> guard(mutex_);
+      // a merge may have started since the wait.
+      if (!merging_) {
+        freeze_active();
+        merging_ = true;
+        break;
+      }
+    }
+
+    std::vector<size_t> gathered_sizes;
+    std::vector<std::pair<KeyT, Uint64>> run = gather_table(gathered_sizes);
+
+    std::shared_ptr<Snapshot> next(new Snapshot());
+    if (!run.empty()) {
+      next->main_.reset(main_factory_(run.size()));
+      next->main_->reorganize_merged(nullptr, run, [](const KeyT &) { return false; }, thread_count);
+    }
+
+    std::lock_guard<SharedMutex> guard(mutex_);
+    gathered_sizes_.swap(gathered_sizes);
+    snapshot_ = next;
+
+    // an entry inserted during the rebuild is in the new main index already if its tuple
+    // was gathered. tombstones set during the rebuild still apply.
+    std::vector<Uint64> offsets;
+    active_->scan_full(offsets, std::numeric_limits<size_t>::max());
+    for (auto offset : offsets) {
+      const KeyT &key = *(this->table_ptr_->get_tuple_key(offset));
+      if (is_in_main(key, offset)) {
+        active_->erase(key, offset);
+      }
+    }
+    merging_ = false;
+  }
+
+  virtual void prepare_threads(const size_t thread_count) final {}
+
+  virtual void register_thread(const size_t thread_id) final {}
+
+  virtual void print() const final {
+    SharedLockGuard guard(mutex_);
+
+    std::cout << "number of merges: " << merge_count_ << std::endl;
+    std::cout << "main size: " << (snapshot_->main_ ? snapshot_->main_->size() : 0) << std::endl;
+    std::cout << "frozen delta size: " << (snapshot_->frozen_ ? snapshot_->frozen_->size() : 0) << std::endl;
+    std::cout << "active delta size: " << active_->size() << std::endl;
+  }
+
+  // block until the running merge, if any, is published.
+  void wait_for_merge() {
+    std::thread merge_thread;
+    {
+      std::lock_guard<SharedMutex> guard(mutex_);
+      merge_thread.swap(merge_thread_);
+    }
+    if (merge_thread.joinable()) {
+      merge_thread.join();
+    }
+  }
+
+private:
+
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
+    std::shared_ptr<Snapshot> snapshot;
+    {
+      SharedLockGuard guard(mutex_);
+      snapshot = snapshot_;
+      active_->find(key, offsets);
+      if (active_erased_->find(key) != active_erased_->end()) {
+        return;
+      }
+    }
+
+    if (snapshot->frozen_) {
+      snapshot->frozen_->find(key, offsets);
+    }
+    if (snapshot->main_ && snapshot->erased_->find(key) == snapshot->erased_->end()) {
+      snapshot->main_->find(key, offsets);
+    }
+  }
+
+  // read every tuple of the table, and record how many tuples of each block were read.
+  std::vector<std::pair<KeyT, Uint64>> gather_table(std::vector<size_t> &block_sizes) const {
+    size_t block_count = this->table_ptr_->block_count();
+    block_sizes.resize(block_count);
+
+    std::vector<std::pair<KeyT, Uint64>> run;
+    for (size_t block_id = 0; block_id < block_count; ++block_id) {
+      block_sizes[block_id] = this->table_ptr_->block_size(block_id);
+      for (size_t rel_offset = 0; rel_offset < block_sizes[block_id]; ++rel_offset) {
+        run.push_back(std::pair<KeyT, Uint64>(*(this->table_ptr_->get_tuple_key(block_id, rel_offset)), OffsetT::construct_raw_data(block_id, rel_offset)));
+      }
+    }
+    std::sort(run.begin(), run.end(), compare_func);
+    return run;
+  }
+
+  static bool is_gathered(const std::vector<size_t> &block_sizes, const Uint64 offset) {
+    OffsetT tuple_offset(offset);
+    return tuple_offset.block_id() < block_sizes.size() && tuple_offset.rel_offset() < block_sizes[tuple_offset.block_id()];
+  }
+
+  // whether the entry is visible in the main index already. the tuple of an insert may have
+  // been gathered by the last rebuild before the insert. requires mutex_.
+  bool is_in_main(const KeyT &key, const Uint64 &offset) const {
+    if (!snapshot_->main_ || !is_gathered(gathered_sizes_, offset)) {
+      return false;
+    }
+    if (active_erased_->find(key) != active_erased_->end() || snapshot_->erased_->find(key) != snapshot_->erased_->end()) {
+      return false;
+    }
+    std::vector<Uint64> offsets;
+    snapshot_->main_->find(key, offsets);
+    return std::find(offsets.begin(), offsets.end(), offset) != offsets.end();
+  }
+
+  // publish the active delta and its tombstones as the frozen delta, and start over with an
+  // empty one. requires mutex_ in exclusive mode, and no running merge.
+  std::shared_ptr<Snapshot> freeze_active() {
+    std::shared_ptr<Snapshot> snapshot(new Snapshot());
+    snapshot->main_ = snapshot_->main_;
+    snapshot->frozen_.reset(active_.release());
+    snapshot->erased_ = active_erased_;
+
+    active_.reset(delta_factory_());
+    active_erased_.reset(new KeySet());
+    snapshot_ = snapshot;
+    return snapshot;
+  }
+
+  // freeze the active delta, and merge it in the background. requires mutex_ in exclusive mode.
+  void start_merge() {
+    std::shared_ptr<Snapshot> snapshot = freeze_active();
+    merging_ = true;
+
+    // the previous merge thread has published its snapshot already.
+    if (merge_thread_.joinable()) {
+      merge_thread_.join();
+    }
+    merge_thread_ = std::thread(&HybridIndex::merge, this, snapshot);
+  }
+
+  void merge(std::shared_ptr<Snapshot> snapshot) {
+
+    // the frozen delta lists its entries in key order. keys are read back from the table.
+    std::vector<Uint64> offsets;
+    snapshot->frozen_->scan_full(offsets, std::numeric_limits<size_t>::max());
+
+    std::vector<std::pair<KeyT, Uint64>> run;
+    run.reserve(offsets.size());
+    for (auto offset : offsets) {
+      run.push_back(std::pair<KeyT, Uint64>(*(this->table_ptr_->get_tuple_key(offset)), offset));
+    }
+    if (!std::is_sorted(run.begin(), run.end(), compare_func)) {
+      std::stable_sort(run.begin(), run.end(), compare_func);
+    }
+
+    const BaseStaticIndex<KeyT, ValueT> *main = snapshot->main_.get();
+
+    size_t merged_size = run.size();
+    if (main != nullptr) {
+      merged_size += main->size();
+      for (auto &key : *snapshot->erased_) {
+        std::vector<Uint64> erased_offsets;
+        snapshot->main_->find(key, erased_offsets);
+        merged_size -= erased_offsets.size();
+      }
+    }
+
+    std::shared_ptr<BaseStaticIndex<KeyT, ValueT>> new_main(main_factory_(merged_size));
+    new_main->reorganize_merged(main, run, [&snapshot](const KeyT &key) {
+      return snapshot->erased_->find(key) != snapshot->erased_->end();
+    });
+
+    std::shared_ptr<Snapshot> next(new Snapshot());
+    next->main_ = new_main;
+
+    std::lock_guard<SharedMutex> guard(mutex_);
+    snapshot_ = next;
+    merging_ = false;
+    ++merge_count_;
+  }
+
+  // append the offsets whose keys are not hidden by a tombstone.
+  void append_visible(const std::vector<Uint64> &src, const KeySet &erased, const KeySet *main_erased, std::vector<Uint64> &dst) const {
+    if (erased.empty() && (main_erased == nullptr || main_erased->empty())) {
+      dst.insert(dst.end(), src.begin(), src.end());
+      return;
+    }
+    for (auto offset : src) {
+      const KeyT &key = *(this->table_ptr_->get_tuple_key(offset));
+      if (erased.find(key) != erased.end()) { continue; }
+      if (main_erased != nullptr && main_erased->find(key) != main_erased->end()) { continue; }
+      dst.push_back(offset);
+    }
+  }
+
+  static bool compare_func(const std::pair<KeyT, Uint64> &lhs, const std::pair<KeyT, Uint64> &rhs) {
+    return lhs.first < rhs.first;
+  }
+
+private:
+  MainFactory main_factory_;
+  DeltaFactory delta_factory_;
+  size_t merge_threshold_;
+
+  // guards snapshot_, active_, active_erased_ and the merge state. reads take it shared, and
+  // inserts and erases take it exclusive, so lookups queue behind delta writes.
+  mutable SharedMutex mutex_;
+
+  std::shared_ptr<Snapshot> snapshot_;
+
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> active_;
+  // erased since the last freeze. hides entries of the frozen delta and the main index.
+  // shared with the range queries that read it, and replaced rather than modified then.
+  std::shared_ptr<KeySet> active_erased_;
+
+  // the number of tuples of each block that the last rebuild read from the table. inserts of
+  // these tuples may find them in the main index already.
+  std::vector<size_t> gathered_sizes_;
+
+  bool merging_;
+  std::thread merge_thread_;
+  size_t merge_count_;
+};
+
+}
@@ -6,6 +6,7 @@
 #include "static_index/binary_index.h"
 #include "static_index/kary_index.h"
 #include "static_index/fast_index.h"
+#include "static_index/learned_index.h"
 
 #include "dynamic_index/singlethread/stx_btree_index.h"
 #include "dynamic_index/singlethread/art_tree_index.h"
@@ -18,12 +19,15 @@
 #include "dynamic_index/singlethread/stx_btree_generic_index.h"
 #include "dynamic_index/singlethread/art_tree_generic_index.h"
 #include "dynamic_index/singlethread/sd_tree_generic_index.h"
+#include "dynamic_index/singlethread/prefix_btree_generic_index.h"
 
 #include "dynamic_index/multithread/libcuckoo_generic_index.h"
 #include "dynamic_index/multithread/art_tree_generic_index.h"
 #include "dynamic_index/multithread/bw_tree_generic_index.h"
 #include "dynamic_index/multithread/masstree_generic_index.h"
 
+#include "hybrid_index/hybrid_index.h"
+
 
 enum class IndexType {
 
@@ -31,6 +35,7 @@ enum class IndexType {
   D_ST_StxBtree = 0,
   D_ST_ArtTree,
   D_ST_SdTree,
+  D_ST_PrefixBtree,
   
   // dynamic indexes - multithread
   D_MT_Libcuckoo = 10,
@@ -43,6 +48,10 @@ enum class IndexType {
   S_Binary, 
   S_KAry, 
   S_Fast,
+  S_Learned,
+
+  // hybrid indexes
+  H_Hybrid = 30,
 
 };
 
@@ -56,12 +65,18 @@ static std::string get_index_name(const IndexType index_type) {
     return "static - k-ary index";
   } else if (index_type == IndexType::S_Fast) {
     return "static - fast index";
+  } else if (index_type == IndexType::S_Learned) {
+    return "static - learned index";
+  } else if (index_type == IndexType::H_Hybrid) {
+    return "hybrid - static main + dynamic delta";
   } else if (index_type == IndexType::D_ST_StxBtree) {
     return "dynamic - singlethread - stx-btree index";
   } else if (index_type == IndexType::D_ST_ArtTree) {
     return "dynamic - singlethread - art-tree index";
   } else if (index_type == IndexType::D_ST_SdTree) {
     return "dynamic - singlethread - approx-tree index";
+  } else if (index_type == IndexType::D_ST_PrefixBtree) {
+    return "dynamic - singlethread - prefix-btree index";
   } else if (index_type == IndexType::D_MT_Libcuckoo) {
     return "dynamic - multithread - libcuckoo index";
   } else if (index_type == IndexType::D_MT_ArtTree) {
@@ -143,6 +158,58 @@ static void validate_index_params(const IndexType index_type, const int index_pa
     std::cout << "index type: static - fast index" << std::endl;
     std::cout << "number of layers: " << index_param_1 << std::endl;
 
+  } else if (index_type == IndexType::S_Learned) {
+
+    if (index_param_1 != 0 && index_param_1 != 1) {
+      std::cerr << "expected index type: static - learned index" << std::endl;
+      std::cerr << "error: model type must be 0 (rmi) or 1 (pgm)!" << std::endl;
+      exit(EXIT_FAILURE);
+      return;
+    }
+
+    if (index_param_2 == INVALID_INDEX_PARAM || index_param_2 < 1) {
+      std::cerr << "expected index type: static - learned index" << std::endl;
+      if (index_param_1 == 0) {
+        std::cerr << "error: number of leaf models is unset!" << std::endl;
+      } else {
+        std::cerr << "error: epsilon is unset!" << std::endl;
+      }
+      exit(EXIT_FAILURE);
+      return;
+    }
+
+    std::cout << "index type: static - learned index" << std::endl;
+    if (index_param_1 == 0) {
+      std::cout << "model type: rmi" << std::endl;
+      std::cout << "number of leaf models: " << index_param_2 << std::endl;
+    } else {
+      std::cout << "model type: pgm" << std::endl;
+      std::cout << "epsilon: " << index_param_2 << std::endl;
+    }
+
+  } else if (index_type == IndexType::H_Hybrid) {
+
+    if (index_param_1 < 0 || index_param_1 > 2) {
+      std::cerr << "expected index type: hybrid - static main + dynamic delta" << std::endl;
+      std::cerr << "error: main index type must be 0 (binary), 1 (k-ary) or 2 (learned)!" << std::endl;
+      exit(EXIT_FAILURE);
+      return;
+    }
+
+    if (index_param_2 != 0 && index_param_2 != 1) {
+      std::cerr << "expected index type: hybrid - static main + dynamic delta" << std::endl;
+      std::cerr << "error: delta index type must be 0 (stx-btree) or 1 (art-tree)!" << std::endl;
+      exit(EXIT_FAILURE);
+      return;
+    }
+
+    const char *main_names[] = { "binary", "k-ary", "learned" };
+    const char *delta_names[] = { "stx-btree", "art-tree" };
+
+    std::cout << "index type: hybrid - static main + dynamic delta" << std::endl;
+    std::cout << "main index type: " << main_names[index_param_1] << std::endl;
+    std::cout << "delta index type: " << delta_names[index_param_2] << std::endl;
+
   } else {
     
     std::cout << "index type: " << get_index_name(index_type) << std::endl;
@@ -151,24 +218,71 @@ static void validate_index_params(const IndexType index_type, const int index_pa
   }
 }
 
+// static main index of a hybrid index. the layers are sized to the number of entries,
+// so that a leaf range holds about HYBRID_LEAF_SIZE entries.
+static const size_t HYBRID_LEAF_SIZE = 16;
+
+template<typename KeyT, typename ValueT>
+static BaseStaticIndex<KeyT, ValueT>* create_hybrid_main(const int main_type, DataTable<KeyT, uint64_t> *table_ptr, const size_t size, const StorageLayout layout) {
+
+  if (main_type == 0) {
+
+    size_t num_layers = 0;
+    while (num_layers < 20 && ((2ull << num_layers) - 1) * HYBRID_LEAF_SIZE < size) { ++num_layers; }
+    return new static_index::BinaryIndex<KeyT, ValueT>(table_ptr, num_layers, layout);
+
+  } else if (main_type == 1) {
+
+    size_t num_layers = 0;
+    size_t num_nodes = 8 - 1;
+    while (num_layers < 6 && num_nodes * HYBRID_LEAF_SIZE < size) { num_nodes = num_nodes * 8 + 7; ++num_layers; }
+    return new static_index::KAryIndex<KeyT, ValueT>(table_ptr, num_layers, 8, layout);
+
+  } else {
+
+    return new static_index::LearnedIndex<KeyT, ValueT>(table_ptr, static_index::LearnedModelType::PGM, 64, layout);
+  }
+}
+
+// dynamic delta index of a hybrid index.
 template<typename KeyT, typename ValueT>
-static BaseIndex<KeyT, ValueT>* create_numeric_index(const IndexType index_type, DataTable<KeyT, uint64_t> *table_ptr, const int index_param_1 = INVALID_INDEX_PARAM, const int index_param_2 = INVALID_INDEX_PARAM) {
+static BaseIndex<KeyT, ValueT>* create_hybrid_delta(const int delta_type, DataTable<KeyT, uint64_t> *table_ptr) {
+
+  if (delta_type == 0) {
+    return new dynamic_index::singlethread::StxBtreeIndex<KeyT, ValueT>(table_ptr);
+  } else {
+    return new dynamic_index::singlethread::ArtTreeIndex<KeyT, ValueT>(table_ptr);
+  }
+}
+
+template<typename KeyT, typename ValueT>
+static BaseIndex<KeyT, ValueT>* create_numeric_index(const IndexType index_type, DataTable<KeyT, uint64_t> *table_ptr, const int index_param_1 = INVALID_INDEX_PARAM, const int index_param_2 = INVALID_INDEX_PARAM, const StorageLayout layout = StorageLayout::AoS) {
 
   if (index_type == IndexType::S_Interpolation) {
 
-    return new static_index::InterpolationIndex<KeyT, ValueT>(table_ptr, index_param_1);
+    return new static_index::InterpolationIndex<KeyT, ValueT>(table_ptr, index_param_1, layout);
   
   } else if (index_type == IndexType::S_Binary) {
 
-    return new static_index::BinaryIndex<KeyT, ValueT>(table_ptr, index_param_1);
+    return new static_index::BinaryIndex<KeyT, ValueT>(table_ptr, index_param_1, layout);
 
   } else if (index_type == IndexType::S_KAry) {
 
-    return new static_index::KAryIndex<KeyT, ValueT>(table_ptr, index_param_1, index_param_2);
+    return new static_index::KAryIndex<KeyT, ValueT>(table_ptr, index_param_1, index_param_2, layout);
 
   } else if (index_type == IndexType::S_Fast) {
 
-    return new static_index::FastIndex<KeyT, ValueT>(table_ptr, index_param_1);
+    return new static_index::FastIndex<KeyT, ValueT>(table_ptr, index_param_1, layout);
+
+  } else if (index_type == IndexType::S_Learned) {
+
+    return new static_index::LearnedIndex<KeyT, ValueT>(table_ptr, static_cast<static_index::LearnedModelType>(index_param_1), index_param_2, layout);
+
+  } else if (index_type == IndexType::H_Hybrid) {
+
+    return new hybrid_index::HybridIndex<KeyT, ValueT>(table_ptr, 
+      [=](const size_t size) { return create_hybrid_main<KeyT, ValueT>(index_param_1, table_ptr, size, layout); },
+      [=]() { return create_hybrid_delta<KeyT, ValueT>(index_param_2, table_ptr); });
 
   } else if (index_type == IndexType::D_ST_StxBtree) {
 
@@ -216,6 +330,10 @@ static BaseGenericIndex* create_generic_index(const IndexType index_type, Generi
     
     return new dynamic_index::singlethread::SdTreeGenericIndex(table_ptr);
 
+  } else if (index_type == IndexType::D_ST_PrefixBtree) {
+
+    return new dynamic_index::singlethread::PrefixBtreeGenericIndex(table_ptr);
+
   } else if (index_type == IndexType::D_MT_Libcuckoo) {
 
     return new dynamic_index::multithread::LibcuckooGenericIndex(table_ptr);
@@ -9,10 +9,15 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <algorithm>
 #include <unistd.h>
 #include <getopt.h>
 
 #include "time_measurer.h"
+#include "latency_histogram.h"
+#include "open_loop_pacer.h"
+#include "access_distribution.h"
+#include "workload_mix.h"
 #include "data_table.h"
 #include "index_all.h"
 #include "key_generator_all.h"
@@ -35,9 +40,19 @@ void usage(FILE *out) {
           "                              -- (21) static  - binary index \n"
           "                              -- (22) static  - kary index \n"
           "                              -- (23) static  - fast index \n"
+          "                              -- (24) static  - learned index \n"
+          "                              -- (30) hybrid  - static main + dynamic delta \n"
           "   -k --key_size          :  index key size (default: 8 bytes) \n"
           "   -S --index_param_1     :  1st index parameter \n"
           "   -T --index_param_2     :  2nd index parameter \n"
+          "                              -- learned index: -S model type (0: rmi, 1: pgm), \n"
+          "                                 -T number of leaf models (rmi) or epsilon (pgm) \n"
+          "                              -- hybrid index: -S main index type (0: binary, 1: k-ary, 2: learned), \n"
+          "                                 -T delta index type (0: stx-btree, 1: art-tree) \n"
+          "   -l --layout            :  static index storage layout: \n"
+          "                              -- (0) array of (key, offset) pairs (default) \n"
+          "                              -- (1) separate key and offset arrays \n"
+          "   -f --index_file        :  static index file. mapped if it exists, otherwise written after reorganize \n"
           // configuration
           "   -t --time_duration     :  time duration (default: 10) \n"
           "   -y --read_type         :  read type: \n"
@@ -45,7 +60,31 @@ void usage(FILE *out) {
           "                              -- (1) index scan \n"
           "                              -- (2) index reverse scan \n"
           "   -r --read_ratio        :  read ratio (default: 1.0) \n"
+          "   -W --mix               :  operation mix, instead of -r and -y: a ycsb core workload (a to f), \n"
+          "                             or shares of lookup, insert, scan, update, rmw and delete, e.g. lookup=0.9,scan=0.1 \n"
+          "   -e --scan_length       :  scans read between 1 and this many keys (default: 100) \n"
+          "   -b --batch_size        :  number of lookups issued as one batch (default: 1) \n"
           "   -s --thread_count      :  thread count (default: 1) \n"
+          "   -a --block_allocator   :  table block allocator: \n"
+          "                              -- (0) heap (default) \n"
+          "                              -- (1) huge-page arena \n"
+          "                              -- (2) huge-page arena, numa-local to the inserting thread \n"
+          "   -R --reorganize_threads:  number of threads that build static indexes (default: 1) \n"
+          "   -L --bulk_load         :  load the initial keys in key order through bulk_load, instead of inserting them \n"
+          "   -C --churn             :  every insert also erases the oldest live entry of its thread, so that the live set keeps its size \n"
+          "   -O --target_rate       :  open loop: issue operations at this aggregate rate in ops/s, 0 for closed loop (default: 0) \n"
+          "   -A --arrival           :  open loop inter-arrival times: \n"
+          "                              -- (0) constant (default) \n"
+          "                              -- (1) poisson \n"
+          "   -z --access            :  which initial keys the reads pick: \n"
+          "                              -- (0) uniform (default) \n"
+          "                              -- (1) zipfian, scrambled over the key space \n"
+          "                              -- (2) hotspot \n"
+          "                              -- (3) latest: zipfian over recency, including the thread's own inserts \n"
+          "   -Z --zipf_theta        :  zipfian and latest skew, in (0, 1) (default: 0.99) \n"
+          "   -H --hot_op_fraction   :  hotspot: fraction of reads on the hot keys (default: 0.9) \n"
+          "   -K --hot_key_fraction  :  hotspot: fraction of the keys that are hot (default: 0.1) \n"
+          "   -x --latency_sample    :  time one in N operations per thread for latency percentiles, 0 to disable (default: 64) \n"
           "   -m --key_count         :  key count (default: 1ull<<20) \n"
           // numeric data distribution
           "   -d --distribution      :  numerical data distribution: \n"
@@ -69,11 +108,27 @@ static struct option opts[] = {
     { "key_size",          optional_argument, NULL, 'k' },
     { "index_param_1",     optional_argument, NULL, 'S' },
     { "index_param_2",     optional_argument, NULL, 'T' },
+    { "layout",            optional_argument, NULL, 'l' },
     // configuration
     { "time_duration",     optional_argument, NULL, 't' },
     { "read_type",         optional_argument, NULL, 'y' },
     { "read_ratio",        optional_argument, NULL, 'r' },
+    { "batch_size",        optional_argument, NULL, 'b' },
+    { "mix",               optional_argument, NULL, 'W' },
+    { "scan_length",       optional_argument, NULL, 'e' },
     { "thread_count",      optional_argument, NULL, 's' },
+    { "block_allocator",   optional_argument, NULL, 'a' },
+    { "reorganize_threads", optional_argument, NULL, 'R' },
+    { "bulk_load",         optional_argument, NULL, 'L' },
+    { "churn",             optional_argument, NULL, 'C' },
+    { "index_file",        optional_argument, NULL, 'f' },
+    { "access",            optional_argument, NULL, 'z' },
+    { "zipf_theta",        optional_argument, NULL, 'Z' },
+    { "hot_op_fraction",   optional_argument, NULL, 'H' },
+    { "hot_key_fraction",  optional_argument, NULL, 'K' },
+    { "latency_sample",    optional_argument, NULL, 'x' },
+    { "target_rate",       optional_argument, NULL, 'O' },
+    { "arrival",           optional_argument, NULL, 'A' },
     // data distribution
     { "key_count",         optional_argument, NULL, 'm' },
     { "distribution",      optional_argument, NULL, 'd' },
@@ -96,12 +151,31 @@ struct Config {
   int key_size_ = 8; // unit: bytes
   int index_param_1_ = INVALID_INDEX_PARAM;
   int index_param_2_ = INVALID_INDEX_PARAM;
+  StorageLayout layout_ = StorageLayout::AoS;
+  std::string index_file_;
   // configuration
   const double profile_duration_ = 0.5; // fixed
   int time_duration_ = 10;
   ReadType index_read_type_ = ReadType::IndexLookupType;
   double read_ratio_ = 1.0;
+  int batch_size_ = 1;
+  std::string mix_spec_;
+  WorkloadMix mix_;
+  bool mix_enabled_ = false;
+  uint64_t scan_length_ = DEFAULT_SCAN_LENGTH;
+  bool access_type_set_ = false;
   int thread_count_ = 1;
+  BlockAllocatorType block_allocator_type_ = BlockAllocatorType::HeapType;
+  int reorganize_thread_count_ = 1;
+  bool bulk_load_ = false;
+  bool churn_ = false;
+  AccessType access_type_ = AccessType::UniformAccessType;
+  double zipf_theta_ = DEFAULT_ZIPF_THETA;
+  double hot_op_fraction_ = DEFAULT_HOT_OP_FRACTION;
+  double hot_key_fraction_ = DEFAULT_HOT_KEY_FRACTION;
+  uint64_t latency_sample_ = 64;
+  double target_rate_ = 0;
+  ArrivalType arrival_type_ = ArrivalType::ConstantType;
   // data distribution
   uint64_t key_count_ = 1ull << 20;
   DistributionType distribution_type_ = DistributionType::SequenceType;
@@ -114,9 +188,35 @@ struct Config {
     std::cout << "=====     INDEX STRUCTURE    =====" << std::endl;
     std::cout << "key size: " << key_size_ << std::endl;
     std::cout << "index param " << index_param_1_ << ", " << index_param_2_ << std::endl;
+    std::cout << "storage layout: " << (layout_ == StorageLayout::AoS ? "AoS" : "SoA") << std::endl;
+    if (!index_file_.empty()) {
+      std::cout << "index file: " << index_file_ << std::endl;
+    }
     std::cout << "===== WORKLOAD CONFIGURATION =====" << std::endl;
-    std::cout << "read ratio: " << read_ratio_ << std::endl;
+    if (mix_enabled_ == true) {
+      std::cout << "workload mix:";
+      mix_.print();
+      std::cout << std::endl;
+    } else {
+      std::cout << "read ratio: " << read_ratio_ << std::endl;
+    }
+    std::cout << "scan length: " << scan_length_ << std::endl;
+    std::cout << "batch size: " << batch_size_ << std::endl;
     std::cout << "thread count: " << thread_count_ << std::endl;
+    std::cout << "block allocator: " << int(block_allocator_type_) << std::endl;
+    std::cout << "reorganize thread count: " << reorganize_thread_count_ << std::endl;
+    std::cout << "bulk load: " << (bulk_load_ ? "on" : "off") << std::endl;
+    std::cout << "churn: " << (churn_ ? "on" : "off") << std::endl;
+    std::cout << "access type: " << int(access_type_) << std::endl;
+    if (access_type_ == AccessType::ZipfianAccessType || access_type_ == AccessType::LatestAccessType) {
+      std::cout << "zipf theta: " << zipf_theta_ << std::endl;
+    } else if (access_type_ == AccessType::HotspotAccessType) {
+      std::cout << "hotspot: " << hot_op_fraction_ << " of reads on " << hot_key_fraction_ << " of keys" << std::endl;
+    }
+    std::cout << "latency sample: " << latency_sample_ << std::endl;
+    if (target_rate_ > 0) {
+      std::cout << "target rate: " << target_rate_ << " ops/s, " << (arrival_type_ == ArrivalType::PoissonType ? "poisson" : "constant") << " arrivals" << std::endl;
+    }
     std::cout << "=====    DATA DISTRIBUTION   =====" << std::endl;
     std::cout << "key count: " << key_count_ << std::endl;
     std::cout << "key bound: " << key_bound_ << std::endl;
@@ -131,7 +231,7 @@ void parse_args(int argc, char* argv[], Config &config) {
   
   while (1) {
     int idx = 0;
-    int c = getopt_long(argc, argv, "hcvi:k:S:T:t:y:r:s:m:d:P:Q:", opts, &idx);
+    int c = getopt_long(argc, argv, "hcvLCi:k:S:T:l:f:t:y:r:b:s:R:m:d:P:Q:a:x:O:A:z:Z:H:K:W:e:", opts, &idx);
 
     if (c == -1) break;
 
@@ -152,6 +252,20 @@ void parse_args(int argc, char* argv[], Config &config) {
         config.index_param_2_ = atoi(optarg);
         break;
       }
+      case 'l': {
+        int layout = atoi(optarg);
+        if (layout != int(StorageLayout::AoS) && layout != int(StorageLayout::SoA)) {
+          fprintf(stderr, "Unknown layout: %d\n", layout);
+          usage(stderr);
+          exit(EXIT_FAILURE);
+        }
+        config.layout_ = (StorageLayout)layout;
+        break;
+      }
+      case 'f': {
+        config.index_file_ = optarg;
+        break;
+      }
       case 't': {
         config.time_duration_ = atoi(optarg);
         break;
@@ -164,10 +278,30 @@ void parse_args(int argc, char* argv[], Config &config) {
         config.read_ratio_ = (double)atof(optarg);
         break;
       }
+      case 'W': {
+        config.mix_spec_ = optarg;
+        break;
+      }
+      case 'e': {
+        config.scan_length_ = (uint64_t)strtoull(optarg, nullptr, 10); // uint64_t
+        break;
+      }
+      case 'b': {
+        config.batch_size_ = atoi(optarg);
+        break;
+      }
       case 's': {
         config.thread_count_ = atoi(optarg);
         break;
       }
+      case 'a': {
+        config.block_allocator_type_ = (BlockAllocatorType)atoi(optarg);
+        break;
+      }
+      case 'R': {
+        config.reorganize_thread_count_ = atoi(optarg);
+        break;
+      }
       case 'm': {
         config.key_count_ = (uint64_t)strtoull(optarg, nullptr, 10); // uint64_t
         break;
@@ -184,6 +318,43 @@ void parse_args(int argc, char* argv[], Config &config) {
         config.key_stddev_ = (double)atof(optarg);
         break;
       }
+      case 'L': {
+        config.bulk_load_ = true;
+        break;
+      }
+      case 'C': {
+        config.churn_ = true;
+        break;
+      }
+      case 'x': {
+        config.latency_sample_ = (uint64_t)strtoull(optarg, nullptr, 10); // uint64_t
+        break;
+      }
+      case 'z': {
+        config.access_type_ = (AccessType)atoi(optarg);
+        config.access_type_set_ = true;
+        break;
+      }
+      case 'Z': {
+        config.zipf_theta_ = (double)atof(optarg);
+        break;
+      }
+      case 'H': {
+        config.hot_op_fraction_ = (double)atof(optarg);
+        break;
+      }
+      case 'K': {
+        config.hot_key_fraction_ = (double)atof(optarg);
+        break;
+      }
+      case 'O': {
+        config.target_rate_ = (double)atof(optarg);
+        break;
+      }
+      case 'A': {
+        config.arrival_type_ = (ArrivalType)atoi(optarg);
+        break;
+      }
       case 'c': {
         config.record_ = true;
         break;
@@ -206,6 +377,47 @@ void parse_args(int argc, char* argv[], Config &config) {
     }
   }
 
+  if (config.reorganize_thread_count_ < 1) {
+    std::cerr << "reorganize thread count must be positive" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.batch_size_ < 1) {
+    std::cerr << "batch size must be positive" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (!config.mix_spec_.empty()) {
+    std::string error;
+    if (!config.mix_.parse(config.mix_spec_, error)) {
+      std::cerr << error << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    config.mix_enabled_ = true;
+
+    // a ycsb workload brings its request distribution, unless one is given.
+    if (config.access_type_set_ == false) {
+      config.access_type_ = config.mix_.preset_access_type();
+    }
+  }
+
+  if (config.scan_length_ < 1) {
+    std::cerr << "scan length must be positive" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.churn_ == true && config.key_count_ < (uint64_t)config.thread_count_) {
+    std::cerr << "churn requires at least one initial key per thread" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.target_rate_ < 0) {
+    std::cerr << "target rate must not be negative" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  validate_access_params(config.access_type_, config.zipf_theta_, config.hot_op_fraction_, config.hot_key_fraction_);
+
   validate_index_params(config.index_type_, config.index_param_1_, config.index_param_2_);
 
   validate_key_generator_params(config.distribution_type_, config.key_bound_, config.key_stddev_);
@@ -216,9 +428,11 @@ void parse_args(int argc, char* argv[], Config &config) {
 
 bool is_running = false;
 uint64_t *operation_counts = nullptr;
+uint64_t *operation_type_counts = nullptr; // per thread and operation type
+LatencyRecorder *latency_recorder = nullptr;
 
 template<typename KeyT, typename ValueT>
-void run_thread(const size_t &thread_id, const Config &config, const KeyT *query_keys, DataTable<KeyT, ValueT> *data_table, BaseIndex<KeyT, ValueT> *data_index) {
+void run_thread(const size_t &thread_id, const Config &config, const KeyT *query_keys, const KeyT *sorted_keys, const AccessDistribution *access_distribution, std::pair<KeyT, Uint64> *live_entries, DataTable<KeyT, ValueT> *data_table, BaseIndex<KeyT, ValueT> *data_index) {
 
   pin_to_core(thread_id);
 
@@ -229,52 +443,198 @@ void run_thread(const size_t &thread_id, const Config &config, const KeyT *query
   uint64_t &operation_count = operation_counts[thread_id];
   operation_count = 0;
 
+  uint64_t *type_counts = operation_type_counts + thread_id * OPERATION_TYPE_COUNT;
+
   FastRandom rand_gen(thread_id);
 
+  // chooses the keys of reads.
+  AccessKeyPicker<KeyT> key_picker(access_distribution, query_keys, thread_id);
+
+  const size_t batch_size = config.batch_size_;
+  std::vector<KeyT> batch_keys(batch_size);
+  std::vector<std::vector<Uint64>> batch_offsets(batch_size);
+
+  // scans stream their matches into a counter, so that a scan does not store its range.
+  size_t scan_match_count = 0;
+  auto scan_sink = make_visitor_sink([&scan_match_count](const Uint64 &) { ++scan_match_count; });
+  const bool scan_reverse = (config.index_read_type_ == ReadType::IndexScanReverseType);
+
+  // churn: the thread owns a slice of the live entries, oldest first from the cursor on.
+  // an insert replaces the entry at the cursor.
+  size_t live_begin = 0;
+  size_t live_end = 0;
+  size_t live_cursor = 0;
+  if (live_entries != nullptr) {
+    live_begin = config.key_count_ * thread_id / config.thread_count_;
+    live_end = config.key_count_ * (thread_id + 1) / config.thread_count_;
+    live_cursor = live_begin;
+  }
+
+  // open loop: the thread issues its share of the target rate.
+  std::unique_ptr<OpenLoopPacer> pacer(nullptr);
+  if (config.target_rate_ > 0) {
+    pacer.reset(new OpenLoopPacer(config.target_rate_ / config.thread_count_, config.arrival_type_, latency_recorder->cycles_per_ns(), thread_id));
+  }
+
   while (true) {
     if (is_running == false) {
       break;
     }
 
-    double next_rand = rand_gen.next_uniform();
+    // a workload mix picks the operation. otherwise, reads and inserts split by the read ratio.
+    OperationType operation_type = OperationType::InsertOpType;
+    if (config.mix_enabled_ == true) {
+      operation_type = config.mix_.next(rand_gen);
+    } else if (rand_gen.next_uniform() < config.read_ratio_) {
+      operation_type = (config.index_read_type_ == ReadType::IndexLookupType) ? OperationType::LookupOpType : OperationType::ScanOpType;
+    }
+
+    bool is_batch = (operation_type == OperationType::LookupOpType && batch_size > 1);
+
+    // in open loop, wait until the operation is due, and time it from then, so that queueing
+    // behind slow operations counts. a batch is due with its last lookup.
+    uint64_t due_cycles = 0;
+    if (pacer != nullptr) {
+      due_cycles = pacer->wait_arrivals(is_batch ? batch_size : 1, is_running);
+      if (is_running == false) {
+        break;
+      }
+    }
+
+    if (is_batch) {
+      for (size_t i = 0; i < batch_size; ++i) {
+        batch_keys[i] = key_picker.next();
+        batch_offsets[i].clear();
+      }
 
-    if (next_rand < config.read_ratio_) {
-      KeyT key = query_keys[rand_gen.next<uint64_t>() % config.key_count_];
+      bool is_sampled = latency_recorder->is_sampled(operation_count / batch_size);
+      uint64_t start_cycles = is_sampled ? (pacer != nullptr ? due_cycles : read_cycle_counter()) : 0;
 
-      std::vector<Uint64> offsets;
+      // retrieve tuple locations of the whole batch
+      data_index->find_batch(batch_keys.data(), batch_size, batch_offsets.data());
 
-      // retrieve tuple locations
-      data_index->find(key, offsets);
+      // a lookup in a batch is charged its share of the batch.
+      if (is_sampled) {
+        latency_recorder->record(thread_id, OperationType::LookupOpType, (read_cycle_counter() - start_cycles) / batch_size);
+      }
 
-      // ASSERT(offsets.size() == 1, "must be 1! " << key);
+      type_counts[size_t(OperationType::LookupOpType)] += batch_size;
+      operation_count += batch_size;
+      continue;
+    }
+
+    // pick keys before the timer starts.
+    KeyT key = 0;
+    uint64_t lhs_rank = 0;
+    uint64_t rhs_rank = 0;
+    if (operation_type == OperationType::InsertOpType) {
+      key = key_generator->get_next_key();
+    } else if (operation_type == OperationType::ScanOpType) {
+      pick_scan_range(access_distribution, rand_gen, config.scan_length_, scan_reverse, lhs_rank, rhs_rank);
     } else {
-      // insert
-      KeyT key = key_generator->get_next_key();
+      key = key_picker.next();
+    }
+
+    bool is_sampled = latency_recorder->is_sampled(operation_count);
+    uint64_t start_cycles = is_sampled ? (pacer != nullptr ? due_cycles : read_cycle_counter()) : 0;
+
+    Uint64 inserted_offset = 0;
 
-      ValueT value = 100;
-      
-      OffsetT offset = data_table->insert_tuple(key, value);
+    switch (operation_type) {
+      case OperationType::LookupOpType: {
+        // matches are kept inline, so that a lookup does not allocate
+        InlineResultSink<8> offsets;
 
-      // insert tuple locations into index
-      data_index->insert(key, offset.raw_data());
+        // retrieve tuple locations
+        data_index->find(key, offsets);
+        break;
+      }
+      case OperationType::ScanOpType: {
+        // a range between two init keys holds about as many keys as their ranks are apart.
+        data_index->find_range(sorted_keys[lhs_rank], sorted_keys[rhs_rank], scan_sink);
+        break;
+      }
+      case OperationType::UpdateOpType:
+      case OperationType::ReadModifyWriteOpType: {
+        InlineResultSink<8> offsets;
+        data_index->find(key, offsets);
+
+        // update the tuples in place. the index is unchanged.
+        for (size_t i = 0; i < offsets.size(); ++i) {
+          ValueT *value = data_table->get_tuple_value(OffsetT(offsets[i]));
+          if (operation_type == OperationType::UpdateOpType) {
+            *value = ValueT(operation_count);
+          } else {
+            *value = *value + 1;
+          }
+        }
+        break;
+      }
+      case OperationType::DeleteOpType: {
+        data_index->erase(key);
+        break;
+      }
+      default: {
+        // insert
+        ValueT value = 100;
+
+        OffsetT offset = data_table->insert_tuple(key, value, thread_id);
+
+        // insert tuple locations into index
+        data_index->insert(key, offset.raw_data());
+
+        key_picker.inserted(key);
+        inserted_offset = offset.raw_data();
+        break;
+      }
     }
 
+    if (is_sampled) {
+      latency_recorder->record(thread_id, operation_type, read_cycle_counter() - start_cycles);
+    }
+
+    ++type_counts[size_t(operation_type)];
     ++operation_count;
+
+    // the oldest live entry of the thread leaves, and the new one takes its place.
+    if (live_entries != nullptr && operation_type == OperationType::InsertOpType) {
+      std::pair<KeyT, Uint64> &oldest = live_entries[live_cursor];
+
+      // the erase is timed along with its insert.
+      start_cycles = is_sampled ? read_cycle_counter() : 0;
+
+      data_index->erase(oldest.first, oldest.second);
+
+      if (is_sampled) {
+        latency_recorder->record(thread_id, OperationType::DeleteOpType, read_cycle_counter() - start_cycles);
+      }
+
+      oldest = std::pair<KeyT, Uint64>(key, inserted_offset);
+      if (++live_cursor == live_end) {
+        live_cursor = live_begin;
+      }
+
+      ++type_counts[size_t(OperationType::DeleteOpType)];
+      ++operation_count;
+    }
   }
 }
 
 template<typename KeyT, typename ValueT>
 void run_workload(const Config &config) {
 
-  // create table
+  // create table. the allocator outlives the table.
+  std::unique_ptr<BlockAllocator> block_allocator(create_block_allocator(config.block_allocator_type_));
+
   std::unique_ptr<DataTable<KeyT, ValueT>> data_table(nullptr);
-  data_table.reset(new DataTable<KeyT, ValueT>());
+  data_table.reset(new DataTable<KeyT, ValueT>(MaxBlockCapacity, block_allocator.get()));
 
   // create index
   std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(nullptr);
-  data_index.reset(create_numeric_index<KeyT, ValueT>(config.index_type_, data_table.get(), config.index_param_1_, config.index_param_2_));
+  data_index.reset(create_numeric_index<KeyT, ValueT>(config.index_type_, data_table.get(), config.index_param_1_, config.index_param_2_, config.layout_));
 
-  // prepare threads
+  // prepare threads. every thread appends to its own table block.
+  data_table->prepare_threads(config.thread_count_);
   data_index->prepare_threads(config.thread_count_);
   data_index->register_thread(0);
 
@@ -285,6 +645,8 @@ void run_workload(const Config &config) {
 
   KeyT *init_keys = new KeyT[config.key_count_]; // store all init keys
 
+  std::vector<std::pair<KeyT, Uint64>> init_entries(config.key_count_);
+
   for (size_t i = 0; i < config.key_count_; ++i) {
 
     KeyT key = key_generator->get_next_key();
@@ -292,14 +654,77 @@ void run_workload(const Config &config) {
     
     OffsetT offset = data_table->insert_tuple(key, value);
 
-    data_index->insert(key, offset.raw_data());
+    init_entries[i] = std::pair<KeyT, Uint64>(key, offset.raw_data());
 
     // record init input keys
     init_keys[i] = key;
   }
-  data_index->reorganize();
 
-  double query_key_size_mb = config.key_count_ * sizeof(KeyT) * 1.0 / 1024 / 1024;
+  //=================================
+  // populate index
+  //=================================
+  // churn erases entries in load order, so keep them before a bulk load sorts them.
+  std::vector<std::pair<KeyT, Uint64>> live_entries;
+  if (config.churn_ == true) {
+    live_entries = init_entries;
+  }
+
+  double pre_load_mem_size = get_memory_mb();
+
+  // sorting is part of the bulk load path, but is reported separately.
+  TimeMeasurer sort_timer;
+  TimeMeasurer load_timer;
+
+  if (config.bulk_load_ == true) {
+    sort_timer.tic();
+    std::sort(init_entries.begin(), init_entries.end(), 
+      [](const std::pair<KeyT, Uint64> &lhs, const std::pair<KeyT, Uint64> &rhs) { return lhs.first < rhs.first; });
+    sort_timer.toc();
+
+    load_timer.tic();
+    data_index->bulk_load(init_entries.data(), init_entries.size());
+
+  } else {
+    load_timer.tic();
+    for (auto &entry : init_entries) {
+      data_index->insert(entry.first, entry.second);
+    }
+  }
+
+  load_timer.toc();
+
+  std::cout << "index load time: " << load_timer.time_us() / 1000.0 << " ms, "
+            << "sort time: " << (config.bulk_load_ ? sort_timer.time_us() / 1000.0 : 0) << " ms, "
+            << "index memory size: " << (get_memory_mb() - pre_load_mem_size) << " MB" << std::endl;
+
+  std::vector<std::pair<KeyT, Uint64>>().swap(init_entries);
+
+  BaseStaticIndex<KeyT, ValueT> *static_index = dynamic_cast<BaseStaticIndex<KeyT, ValueT>*>(data_index.get());
+
+  // the table is populated deterministically, so a saved static index matches it.
+  if (static_index != nullptr && !config.index_file_.empty() && access(config.index_file_.c_str(), R_OK) == 0) {
+    TimeMeasurer timer;
+    timer.tic();
+    static_index->load(config.index_file_);
+    timer.toc();
+    std::cout << "load time: " << timer.time_us() / 1000.0 << " ms" << std::endl;
+
+  } else {
+    data_index->reorganize(config.reorganize_thread_count_);
+
+    if (static_index != nullptr) {
+      auto &timings = static_index->reorganize_timings();
+      std::cout << "reorganize time: gather " << timings.gather_ms_ << " ms, "
+                << "sort " << timings.sort_ms_ << " ms, "
+                << "build " << timings.build_ms_ << " ms" << std::endl;
+
+      if (!config.index_file_.empty()) {
+        static_index->save(config.index_file_);
+      }
+    }
+  }
+
+  double query_key_size_mb = (config.key_count_ * sizeof(KeyT) + live_entries.size() * sizeof(std::pair<KeyT, Uint64>)) * 1.0 / 1024 / 1024;
   //=================================
 
   //=================================
@@ -322,6 +747,9 @@ void run_workload(const Config &config) {
   //=================================
 
   operation_counts = new uint64_t[config.thread_count_];
+  operation_type_counts = new uint64_t[config.thread_count_ * OPERATION_TYPE_COUNT];
+  memset(operation_type_counts, 0, config.thread_count_ * OPERATION_TYPE_COUNT * sizeof(uint64_t));
+  latency_recorder = new LatencyRecorder(config.thread_count_, config.latency_sample_);
   uint64_t profile_round = (uint64_t)(config.time_duration_ / config.profile_duration_);
 
   uint64_t **operation_counts_profiles = new uint64_t*[profile_round];
@@ -336,7 +764,20 @@ void run_workload(const Config &config) {
 
   double init_mem_size = get_memory_mb();
   std::cout << "init memory size (index + table): " << (init_mem_size - query_key_size_mb) << " MB" << std::endl;
+  std::cout << "init index memory (counted by the index): ";
+  data_index->memory_usage().print();
   
+  // scans run between init keys in key order.
+  std::vector<KeyT> sorted_keys;
+  bool has_scans = config.mix_enabled_ ? (config.mix_.share(OperationType::ScanOpType) > 0) : (config.index_read_type_ != ReadType::IndexLookupType && config.read_ratio_ > 0);
+  if (has_scans == true) {
+    sorted_keys.assign(init_keys, init_keys + config.key_count_);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+  }
+  query_key_size_mb += sorted_keys.size() * sizeof(KeyT) * 1.0 / 1024 / 1024;
+
+  std::unique_ptr<AccessDistribution> access_distribution(new AccessDistribution(config.access_type_, config.key_count_, config.zipf_theta_, config.hot_op_fraction_, config.hot_key_fraction_));
+
   // launch a group of threads
   is_running = true;
   std::vector<std::thread> worker_threads;
@@ -345,7 +786,7 @@ void run_workload(const Config &config) {
   // PAPIProfiler::start_measure_cache_miss_rate();
   
   for (uint64_t thread_id = 0; thread_id < config.thread_count_; ++thread_id) {
-    worker_threads.push_back(std::move(std::thread(run_thread<KeyT, ValueT>, thread_id, std::ref(config), init_keys, data_table.get(), data_index.get())));
+    worker_threads.push_back(std::move(std::thread(run_thread<KeyT, ValueT>, thread_id, std::ref(config), init_keys, sorted_keys.data(), access_distribution.get(), live_entries.empty() ? nullptr : live_entries.data(), data_table.get(), data_index.get())));
   }
 
   std::cout << "        TIME       THROUGHPUT   RAM (tot.)   RAM (tab.)" << std::endl;
@@ -401,6 +842,10 @@ void run_workload(const Config &config) {
               << table_size_profiles.at(round_id)
               << " MB"
               << std::endl;
+
+    if (latency_recorder->enabled() == true) {
+      latency_recorder->print_round();
+    }
   }
   
   // join all the threads
@@ -410,6 +855,9 @@ void run_workload(const Config &config) {
     worker_threads.at(i).join();
   }
 
+  std::cout << "final index memory (counted by the index): ";
+  data_index->memory_usage().print();
+
   // PAPIProfiler::stop_measure_cache_miss_rate();
   
   uint64_t total_count = 0;
@@ -420,6 +868,51 @@ void run_workload(const Config &config) {
   std::cout << "average throughput: " << total_count * 1.0 / config.time_duration_ / 1000 / 1000 << " M ops" 
             << std::endl;
 
+  for (size_t type = 0; type < OPERATION_TYPE_COUNT; ++type) {
+    uint64_t type_count = 0;
+    for (uint64_t i = 0; i < config.thread_count_; ++i) {
+      type_count += operation_type_counts[i * OPERATION_TYPE_COUNT + type];
+    }
+    if (type_count != 0) {
+      std::cout << "  " << get_operation_name(OperationType(type)) << " throughput: " 
+                << type_count * 1.0 / config.time_duration_ / 1000 / 1000 << " M ops" << std::endl;
+    }
+  }
+
+  // under churn, the second half of the run is taken as the steady state. the table keeps
+  // every tuple, so the index memory is the total less the table.
+  if (config.churn_ == true && profile_round >= 2) {
+    uint64_t steady_begin = profile_round / 2;
+    uint64_t steady_count = 0;
+    double steady_mem_size = 0;
+    double steady_index_size = 0;
+    for (uint64_t round_id = steady_begin; round_id < profile_round; ++round_id) {
+      steady_count += total_operation_counts.at(round_id);
+      steady_mem_size += act_size_profiles.at(round_id);
+      steady_index_size += act_size_profiles.at(round_id) - table_size_profiles.at(round_id);
+    }
+    uint64_t steady_round = profile_round - steady_begin;
+    double steady_duration = steady_round * config.profile_duration_;
+    double index_size_drift = (act_size_profiles.back() - table_size_profiles.back()) - (act_size_profiles.at(steady_begin) - table_size_profiles.at(steady_begin));
+
+    std::cout << "steady state (last " << steady_duration << " s): "
+              << "throughput: " << steady_count * 1.0 / steady_duration / 1000 / 1000 << " M ops, "
+              << "memory (index + table): " << steady_mem_size / steady_round << " MB, "
+              << "index memory: " << steady_index_size / steady_round << " MB, "
+              << "index memory drift: " << index_size_drift << " MB"
+              << std::endl;
+  }
+
+  if (config.target_rate_ > 0) {
+    std::cout << "offered rate: " << config.target_rate_ / 1000 / 1000 << " M ops, "
+              << "achieved rate: " << total_count * 1.0 / config.time_duration_ / 1000 / 1000 << " M ops"
+              << std::endl;
+  }
+
+  if (latency_recorder->enabled() == true) {
+    latency_recorder->print_total();
+  }
+
   if (config.verbose_ == true) {
     data_index->print(); 
   }
@@ -435,6 +928,12 @@ void run_workload(const Config &config) {
   delete[] operation_counts;
   operation_counts = nullptr;
 
+  delete[] operation_type_counts;
+  operation_type_counts = nullptr;
+
+  delete latency_recorder;
+  latency_recorder = nullptr;
+
   delete[] init_keys;
   init_keys = nullptr;
 }
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+// on-disk format of static indexes.
+// a file is a header followed by a sequence of values and arrays. every array starts at a
+// page boundary, so that a mapped array is as aligned as an allocated one, and arrays can be
+// used in place once the file is mapped.
+
+static const uint64_t INDEX_FILE_MAGIC = 0x4349544154535A49ull; // "IZSTATIC"
+static const uint64_t INDEX_FILE_VERSION = 1;
+static const size_t INDEX_FILE_ALIGNMENT = 4096;
+
+class IndexFileWriter {
+public:
+  IndexFileWriter(const std::string &path) : out_(path.c_str(), std::ios::binary | std::ios::trunc), pos_(0) {
+    ASSERT(out_.good(), "failed to open index file: " << path);
+    write_value(INDEX_FILE_MAGIC);
+    write_value(INDEX_FILE_VERSION);
+  }
+
+  ~IndexFileWriter() {
+    out_.flush();
+    ASSERT(out_.good(), "failed to write index file");
+  }
+
+  template<typename T>
+  void write_value(const T &value) {
+    out_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    pos_ += sizeof(T);
+  }
+
+  // pad to the start of an array. the elements are then written by write_value().
+  void begin_array() {
+    static const char zeros[INDEX_FILE_ALIGNMENT] = {0};
+    size_t padding = (INDEX_FILE_ALIGNMENT - pos_ % INDEX_FILE_ALIGNMENT) % INDEX_FILE_ALIGNMENT;
+    out_.write(zeros, padding);
+    pos_ += padding;
+  }
+
+  template<typename T>
+  void write_array(const T *data, const size_t count) {
+    begin_array();
+    out_.write(reinterpret_cast<const char*>(data), sizeof(T) * count);
+    pos_ += sizeof(T) * count;
+  }
+
+private:
+  IndexFileWriter(const IndexFileWriter&);
+  IndexFileWriter& operator=(const IndexFileWriter&);
+
+private:
+  std::ofstream out_;
+  size_t pos_;
+};
+
+
+// maps an index file read-only. the mapping is shared, so processes that map the same
+// file share its page cache. arrays returned by read_array() live as long as the reader.
+class IndexFileReader {
+public:
+  IndexFileReader(const std::string &path) : data_(nullptr), size_(0), pos_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT(fd >= 0, "failed to open index file: " << path);
+
+    struct stat st;
+    int rt = fstat(fd, &st);
+    ASSERT(rt == 0, "failed to stat index file: " << path);
+    size_ = st.st_size;
+
+    void *ptr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT(ptr != MAP_FAILED, "failed to map index file: " << path);
+    data_ = reinterpret_cast<const char*>(ptr);
+    close(fd);
+
+    ASSERT(read_value<uint64_t>() == INDEX_FILE_MAGIC, "not an index file: " << path);
+    ASSERT(read_value<uint64_t>() == INDEX_FILE_VERSION, "unsupported index file version: " << path);
+  }
+
+  ~IndexFileReader() {
+    munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+  }
+
+  template<typename T>
+  T read_value() {
+    ASSERT(pos_ + sizeof(T) <= size_, "index file is truncated");
+    T value;
+    memcpy(&value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  template<typename T>
+  const T* read_array(const size_t count) {
+    pos_ += (INDEX_FILE_ALIGNMENT - pos_ % INDEX_FILE_ALIGNMENT) % INDEX_FILE_ALIGNMENT;
+    if (count == 0) {
+      return nullptr;
+    }
+    ASSERT(pos_ + sizeof(T) * count <= size_, "index file is truncated");
+    const T *data = reinterpret_cast<const T*>(data_ + pos_);
+    pos_ += sizeof(T) * count;
+    return data;
+  }
+
+private:
+  IndexFileReader(const IndexFileReader&);
+  IndexFileReader& operator=(const IndexFileReader&);
+
+private:
+  const char *data_;
+  size_t size_;
+  size_t pos_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+// the memory that an index holds, by the kind of structure that holds it. counted by the
+// index itself rather than by the allocator, so that the table and other indexes are left out.
+//  inner: nodes that route a lookup, e.g. inner nodes, art inner nodes, hash buckets.
+//  leaf: nodes or arrays that hold the entries.
+//  delta: delta records not yet consolidated into their node.
+//  garbage: unlinked memory awaiting reclamation by an epoch.
+// allocator headers and padding are not counted.
+struct IndexMemoryStats {
+  size_t entry_count_ = 0;
+  size_t inner_bytes_ = 0;
+  size_t leaf_bytes_ = 0;
+  size_t delta_bytes_ = 0;
+  size_t garbage_bytes_ = 0;
+
+  size_t total_bytes() const {
+    return inner_bytes_ + leaf_bytes_ + delta_bytes_ + garbage_bytes_;
+  }
+
+  double bytes_per_entry() const {
+    return entry_count_ == 0 ? 0 : total_bytes() * 1.0 / entry_count_;
+  }
+
+  IndexMemoryStats& operator+=(const IndexMemoryStats &rhs) {
+    entry_count_ += rhs.entry_count_;
+    inner_bytes_ += rhs.inner_bytes_;
+    leaf_bytes_ += rhs.leaf_bytes_;
+    delta_bytes_ += rhs.delta_bytes_;
+    garbage_bytes_ += rhs.garbage_bytes_;
+    return *this;
+  }
+
+  // leaves the format of std::cout as it was.
+  void print() const {
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "entries: " << entry_count_
+              << ", total: " << std::fixed << std::setprecision(2) << total_bytes() / 1024.0 / 1024 << " MB"
+              << " (inner: " << inner_bytes_ / 1024.0 / 1024
+              << ", leaf: " << leaf_bytes_ / 1024.0 / 1024
+              << ", delta: " << delta_bytes_ / 1024.0 / 1024
+              << ", garbage: " << garbage_bytes_ / 1024.0 / 1024 << ")"
+              << ", bytes/entry: " << std::setprecision(1) << bytes_per_entry() << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+  }
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// cycle counter for timing single operations.
+static inline uint64_t read_cycle_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// number of counter cycles per nanosecond, measured against the steady clock.
+static double calibrate_cycles_per_ns() {
+#if defined(__x86_64__) || defined(__i386__)
+  auto start_time = std::chrono::steady_clock::now();
+  uint64_t start_cycles = read_cycle_counter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  uint64_t end_cycles = read_cycle_counter();
+  auto end_time = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+  return (end_cycles - start_cycles) / ns;
+#else
+  return 1.0;
+#endif
+}
+
+// a log-linear histogram of latencies in the style of hdr histograms: values below
+// SUB_BUCKET_COUNT have a bucket each, and every power of two above is split into
+// SUB_BUCKET_COUNT buckets, so a value is reported within 1 / SUB_BUCKET_COUNT of itself.
+// a histogram has a single writer. other threads may read it while it is written, and see
+// counts that are at most a few records behind.
+class LatencyHistogram {
+
+  static const size_t SUB_BUCKET_BITS = 5;
+  static const size_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+  static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+public:
+  LatencyHistogram() {
+    reset();
+  }
+
+  void reset() {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      counts_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  // single writer, so plain stores suffice.
+  inline void record(const uint64_t value) {
+    std::atomic<uint64_t> &bucket = counts_[bucket_index(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  void merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      counts_[i].store(counts_[i].load(std::memory_order_relaxed) + other.counts_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    count_.store(count_.load(std::memory_order_relaxed) + other.count(), std::memory_order_relaxed);
+    max_.store(std::max(max(), other.max()), std::memory_order_relaxed);
+  }
+
+  // the records of this histogram that are not in an older snapshot of it. the exact
+  // maximum is not known for the difference, so it is taken from the highest bucket.
+  void subtract(const LatencyHistogram &older) {
+    uint64_t max_value = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      uint64_t count = counts_[i].load(std::memory_order_relaxed) - older.counts_[i].load(std::memory_order_relaxed);
+      counts_[i].store(count, std::memory_order_relaxed);
+      if (count != 0) {
+        max_value = bucket_value(i);
+      }
+    }
+    count_.store(count_.load(std::memory_order_relaxed) - older.count(), std::memory_order_relaxed);
+    max_.store(max_value, std::memory_order_relaxed);
+  }
+
+  void copy_from(const LatencyHistogram &other) {
+    reset();
+    merge(other);
+  }
+
+  inline uint64_t count() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  inline uint64_t max() const {
+    return max_.load(std::memory_order_relaxed);
+  }
+
+  // the smallest recorded value that is not exceeded by the given fraction of the records.
+  uint64_t percentile(const double fraction) const {
+    uint64_t total = count();
+    if (total == 0) { return 0; }
+
+    uint64_t target = std::max<uint64_t>(1, (uint64_t)(fraction * total + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      seen += counts_[i].load(std::memory_order_relaxed);
+      if (seen >= target) {
+        return std::min(bucket_value(i), max());
+      }
+    }
+    return max();
+  }
+
+  // p50/p90/p99/p999/max in nanoseconds, on one line.
+  void print(const std::string &name, const double cycles_per_ns) const {
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    std::cout << std::fixed << std::setprecision(0) << std::left << std::setw(8) << name << std::right
+              << "count: " << std::setw(10) << count()
+              << "  p50: " << std::setw(8) << percentile(0.5) / cycles_per_ns
+              << "  p90: " << std::setw(8) << percentile(0.9) / cycles_per_ns
+              << "  p99: " << std::setw(8) << percentile(0.99) / cycles_per_ns
+              << "  p999: " << std::setw(8) << percentile(0.999) / cycles_per_ns
+              << "  max: " << std::setw(10) << max() / cycles_per_ns
+              << " ns" << std::endl;
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+  }
+
+private:
+  static inline size_t bucket_index(const uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+      return value;
+    }
+    size_t shift = (63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + ((value >> shift) - SUB_BUCKET_COUNT);
+  }
+
+  // the highest value that falls into the bucket.
+  static inline uint64_t bucket_value(const size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+      return index;
+    }
+    size_t shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t sub_bucket = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+
+private:
+  LatencyHistogram(const LatencyHistogram &);
+  LatencyHistogram& operator=(const LatencyHistogram &);
+
+private:
+  std::atomic<uint64_t> counts_[BUCKET_COUNT];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> max_;
+};
+
+
+enum class OperationType {
+  LookupOpType = 0,
+  InsertOpType,
+  ScanOpType,
+  UpdateOpType,
+  ReadModifyWriteOpType,
+  DeleteOpType,
+};
+
+static const size_t OPERATION_TYPE_COUNT = 6;
+
+static const char* get_operation_name(const OperationType type) {
+  switch (type) {
+    case OperationType::LookupOpType:
+      return "lookup";
+    case OperationType::InsertOpType:
+      return "insert";
+    case OperationType::ScanOpType:
+      return "scan";
+    case OperationType::UpdateOpType:
+      return "update";
+    case OperationType::ReadModifyWriteOpType:
+      return "rmw";
+    case OperationType::DeleteOpType:
+      return "delete";
+    default:
+      return "unknown";
+  }
+}
+
+// one histogram per thread and operation type. a worker times one in sample_interval
+// operations, so that reading the cycle counter does not slow down the workload.
+class LatencyRecorder {
+
+public:
+  LatencyRecorder(const size_t thread_count, const uint64_t sample_interval) :
+    thread_count_(thread_count), sample_interval_(sample_interval),
+    histograms_(new LatencyHistogram[thread_count * OPERATION_TYPE_COUNT]),
+    merged_(new LatencyHistogram[OPERATION_TYPE_COUNT]),
+    last_merged_(new LatencyHistogram[OPERATION_TYPE_COUNT]),
+    cycles_per_ns_(calibrate_cycles_per_ns()) {}
+
+  ~LatencyRecorder() {
+    delete[] histograms_;
+    histograms_ = nullptr;
+    delete[] merged_;
+    merged_ = nullptr;
+    delete[] last_merged_;
+    last_merged_ = nullptr;
+  }
+
+  inline bool enabled() const {
+    return sample_interval_ != 0;
+  }
+
+  inline double cycles_per_ns() const {
+    return cycles_per_ns_;
+  }
+
+  // whether the operation_id-th operation of a thread is timed.
+  inline bool is_sampled(const uint64_t operation_id) const {
+    return sample_interval_ != 0 && operation_id % sample_interval_ == 0;
+  }
+
+  inline void record(const size_t thread_id, const OperationType type, const uint64_t cycles) {
+    histograms_[thread_id * OPERATION_TYPE_COUNT + size_t(type)].record(cycles);
+  }
+
+  // print the latencies of the operations since the previous call.
+  void print_round() {
+    LatencyHistogram round;
+    for (size_t type = 0; type < OPERATION_TYPE_COUNT; ++type) {
+      merge_threads(type, merged_[type]);
+
+      round.copy_from(merged_[type]);
+      round.subtract(last_merged_[type]);
+      last_merged_[type].copy_from(merged_[type]);
+
+      if (round.count() != 0) {
+        std::cout << "                 ";
+        round.print(get_operation_name(OperationType(type)), cycles_per_ns_);
+      }
+    }
+  }
+
+  // print the latencies of all operations.
+  void print_total() {
+    std::cout << "latency (sampled 1 / " << sample_interval_ << " operations):" << std::endl;
+    for (size_t type = 0; type < OPERATION_TYPE_COUNT; ++type) {
+      merge_threads(type, merged_[type]);
+      if (merged_[type].count() != 0) {
+        merged_[type].print(get_operation_name(OperationType(type)), cycles_per_ns_);
+      }
+    }
+  }
+
+private:
+  void merge_threads(const size_t type, LatencyHistogram &merged) const {
+    merged.reset();
+    for (size_t thread_id = 0; thread_id < thread_count_; ++thread_id) {
+      merged.merge(histograms_[thread_id * OPERATION_TYPE_COUNT + type]);
+    }
+  }
+
+private:
+  LatencyRecorder(const LatencyRecorder &);
+  LatencyRecorder& operator=(const LatencyRecorder &);
+
+private:
+  size_t thread_count_;
+  uint64_t sample_interval_;
+
+  LatencyHistogram *histograms_;
+  LatencyHistogram *merged_;
+  LatencyHistogram *last_merged_;
+
+  double cycles_per_ns_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "fast_random.h"
+#include "latency_histogram.h"
+
+enum class ArrivalType {
+  ConstantType = 0,
+  PoissonType,
+};
+
+// the arrival schedule of an open-loop client. operations are due at fixed or exponentially
+// distributed intervals, regardless of when earlier operations completed, so a slow operation
+// delays the ones queued behind it, and their latency is measured from their due time.
+class OpenLoopPacer {
+
+public:
+  // rate is in operations per second.
+  OpenLoopPacer(const double rate, const ArrivalType arrival_type, const double cycles_per_ns, const uint64_t seed) :
+    arrival_type_(arrival_type), mean_interval_(cycles_per_ns * 1000 * 1000 * 1000 / rate),
+    next_arrival_(read_cycle_counter()), rand_gen_(seed) {}
+
+  // the due time of the next operation, in counter cycles.
+  inline uint64_t next_arrival() {
+    uint64_t arrival = next_arrival_;
+    if (arrival_type_ == ArrivalType::PoissonType) {
+      next_arrival_ += uint64_t(-std::log(1 - rand_gen_.next_uniform()) * mean_interval_);
+    } else {
+      next_arrival_ += uint64_t(mean_interval_);
+    }
+    return arrival;
+  }
+
+  // wait until count more operations are due, and return the due time of the last one.
+  // returns early once is_running is cleared.
+  inline uint64_t wait_arrivals(const size_t count, const volatile bool &is_running) {
+    uint64_t arrival = 0;
+    for (size_t i = 0; i < count; ++i) {
+      arrival = next_arrival();
+    }
+    while (read_cycle_counter() < arrival && is_running == true) {}
+    return arrival;
+  }
+
+private:
+  ArrivalType arrival_type_;
+  double mean_interval_;
+  uint64_t next_arrival_;
+  FastRandom rand_gen_;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "utils.h"
+
+// receives the offsets found by a lookup, one at a time.
+// indexes that produce offsets in place stream them into the sink, so the caller decides
+// whether they are stored at all.
+class ResultSink {
+public:
+  virtual ~ResultSink() {}
+
+  virtual void push_back(const Uint64 &offset) = 0;
+};
+
+
+// keeps up to N offsets inline. only offsets beyond N go to the heap, so lookups with
+// few matches do not allocate.
+template<size_t N>
+class InlineResultSink : public ResultSink {
+public:
+  InlineResultSink() : size_(0) {}
+
+  virtual void push_back(const Uint64 &offset) final {
+    if (size_ < N) {
+      inline_offsets_[size_] = offset;
+    } else {
+      overflow_offsets_.push_back(offset);
+    }
+    ++size_;
+  }
+
+  inline size_t size() const { return size_; }
+
+  inline bool empty() const { return size_ == 0; }
+
+  inline Uint64 operator[](const size_t i) const {
+    return i < N ? inline_offsets_[i] : overflow_offsets_[i - N];
+  }
+
+  void clear() {
+    size_ = 0;
+    overflow_offsets_.clear();
+  }
+
+private:
+  Uint64 inline_offsets_[N];
+  std::vector<Uint64> overflow_offsets_;
+  size_t size_;
+};
+
+
+// hands every offset to a callback, e.g. to stream a range scan without storing it.
+template<typename Func>
+class VisitorResultSink : public ResultSink {
+public:
+  VisitorResultSink(Func func) : func_(func) {}
+
+  virtual void push_back(const Uint64 &offset) final {
+    func_(offset);
+  }
+
+private:
+  Func func_;
+};
+
+template<typename Func>
+VisitorResultSink<Func> make_visitor_sink(Func func) {
+  return VisitorResultSink<Func>(func);
+}
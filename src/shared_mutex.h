@@ -0,0 +1,54 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "utils.h"
+
+// a reader/writer lock, as std::shared_mutex is not available in c++11. lock() and unlock()
+// make it usable with std::lock_guard, and SharedLockGuard takes it in shared mode.
+class SharedMutex {
+
+public:
+  SharedMutex() {
+    int rt = pthread_rwlock_init(&lock_, nullptr);
+    ASSERT(rt == 0, "failed to initialize rwlock");
+  }
+
+  ~SharedMutex() {
+    pthread_rwlock_destroy(&lock_);
+  }
+
+  void lock() { pthread_rwlock_wrlock(&lock_); }
+
+  void unlock() { pthread_rwlock_unlock(&lock_); }
+
+  void lock_shared() { pthread_rwlock_rdlock(&lock_); }
+
+  void unlock_shared() { pthread_rwlock_unlock(&lock_); }
+
+private:
+  SharedMutex(const SharedMutex&);
+  SharedMutex& operator=(const SharedMutex&);
+
+private:
+  pthread_rwlock_t lock_;
+};
+
+class SharedLockGuard {
+
+public:
+  explicit SharedLockGuard(SharedMutex &mutex) : mutex_(mutex) {
+    mutex_.lock_shared();
+  }
+
+  ~SharedLockGuard() {
+    mutex_.unlock_shared();
+  }
+
+private:
+  SharedLockGuard(const SharedLockGuard&);
+  SharedLockGuard& operator=(const SharedLockGuard&);
+
+private:
+  SharedMutex &mutex_;
+};
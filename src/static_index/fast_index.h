@@ -1,300 +1,478 @@
 #pragma once
 
 #include <vector>
+#include <limits>
+#include <type_traits>
 
-#include <emmintrin.h>
+#include <cstdlib>
+#include <immintrin.h>
 
 #include "base_static_index.h"
 
 namespace static_index {
 
+// FAST: architecture sensitive tree search on modern CPUs and GPUs (SIGMOD 2010).
+//
+// the inner layers form a tree of cacheline blocks. every cacheline block holds the
+// separators of B children, where B is 16 for 4-byte keys and 8 for 8-byte keys:
+//  - 4-byte keys: a cacheline block is a 2-level tree of SIMD blocks. each SIMD block
+//    holds 3 keys, so that 4 keys (one 128-bit register) decide among 4 branches.
+//  - 8-byte keys: a cacheline block holds 7 keys plus one padding key, and all of them
+//    are compared at once (AVX2 or SSE4.2, selected at runtime).
+// cacheline blocks are further grouped into page blocks of 2 cacheline levels. each page
+// block is stored contiguously and never crosses a page boundary.
 template<typename KeyT, typename ValueT>
 class FastIndex : public BaseStaticIndex<KeyT, ValueT> {
 
-  // the FAST index paper assumes SIMD size is 128 bits.
-  // It is hard to extend its method to 256/512-bit SIMD
-  // as most computers' cacheline size is 64 bytes.
-  const size_t SIMD_SIZE = 16; // unit: byte (128 bits)
-  const size_t CACHELINE_SIZE = 64; // unit: byte
-  const size_t PAGE_SIZE = 4096; // unit: byte (4 KB)
+  // keys are stored as signed integers of the same size, so that SIMD signed
+  // comparisons can be used. unsigned keys have their sign bit flipped.
+  typedef typename std::conditional<sizeof(KeyT) == 4, int32_t, int64_t>::type SimdKeyT;
 
-  const size_t KEY_SIZE = 4; // FAST only support 4-byte keys.
-  const size_t SIMD_KEY_CAPACITY = 3; 
-  const size_t CACHELINE_KEY_CAPACITY = 15;
-  const size_t CACHELINE_DEPTH = 4;
+  static const size_t CACHELINE_SIZE = 64; // unit: byte
+  static const size_t PAGE_SIZE = 4096; // unit: byte (4 KB)
 
+  static const size_t CACHELINE_KEY_CAPACITY = CACHELINE_SIZE / sizeof(SimdKeyT);
+  // number of branches of a cacheline block.
+  static const size_t CACHELINE_FANOUT = CACHELINE_KEY_CAPACITY;
+  // number of cacheline levels in a page block.
+  static const size_t PAGE_DEPTH = 2;
 
-public:
-  FastIndex(DataTable<KeyT, ValueT> *table_ptr, const size_t num_layers)
-    : BaseStaticIndex<KeyT, ValueT>(table_ptr)
-    , num_layers_(num_layers) {
+  enum class SimdPath {
+    Avx2 = 0,
+    Sse42,
+    Sse2,
+  };
 
-    ASSERT(sizeof(KeyT) == KEY_SIZE, "only support 4-byte keys");
+public:
+  FastIndex(DataTable<KeyT, ValueT> *table_ptr, const size_t num_layers, const StorageLayout layout = StorageLayout::AoS)
+    : BaseStaticIndex<KeyT, ValueT>(table_ptr, layout)
+    , num_layers_(num_layers)
+    , inner_nodes_(nullptr)
+    , inner_size_(0)
+    , cacheline_levels_(0)
+    , num_buckets_(1) {
+
+    ASSERT(sizeof(KeyT) == 4 || sizeof(KeyT) == 8, "only support 4-byte and 8-byte keys");
+
+    if (sizeof(KeyT) == 4) {
+      simd_path_ = SimdPath::Sse2;
+    } else if (__builtin_cpu_supports("avx2")) {
+      simd_path_ = SimdPath::Avx2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+      simd_path_ = SimdPath::Sse42;
+    } else {
+      simd_path_ = SimdPath::Sse2;
+    }
   }
 
   virtual ~FastIndex() {
-    if (num_layers_ != 0) {
-      delete[] inner_nodes_;
-      inner_nodes_ = nullptr;
-
-      delete num_cachelines_;
-      num_cachelines_ = nullptr;
+    if (!this->is_mapped()) {
+      free(inner_nodes_);
     }
+    inner_nodes_ = nullptr;
   }
 
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
+
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
+
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
 
     if (this->size_ == 0) {
       return;
     }
 
-    if (key > key_max_ || key < key_min_) {
-      return;
-    }
-    if (key_max_ == key_min_) {
-      if (key_max_ == key) {
-        for (size_t i = 0; i < this->size_; ++i) {
-          offsets.push_back(this->container_[i].offset_);
+    size_t begins[FIND_BATCH_GROUP_SIZE];
+    size_t ends[FIND_BATCH_GROUP_SIZE];
+
+    for (size_t base = 0; base < count; base += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(FIND_BATCH_GROUP_SIZE, count - base);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        const KeyT &key = keys[base + i];
+        if (key > key_max_ || key < key_min_) {
+          begins[i] = this->size_;
+          ends[i] = this->size_;
+          continue;
         }
+        bucket_range(find_inner_layers(key), begins[i], ends[i]);
       }
-      return;
-    }
 
-    size_t offset_find = this->size_;
-    std::pair<int, int> offset_range = find_inner_layers(key);
-    if (offset_range.first == offset_range.second) {
-      offset_find = offset_range.first;
-    } else {
-      offset_find = find_internal(key, offset_range.first, offset_range.second);
-    }
+      this->lower_bound_group(keys + base, group_size, begins, ends);
 
-    if (offset_find == this->size_) {
-      // find nothing
-      return;
+      for (size_t i = 0; i < group_size; ++i) {
+        this->scan_matches(keys[base + i], begins[i], offsets[base + i]);
+      }
     }
+  }
 
-    offsets.push_back(this->container_[offset_find].offset_);
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
 
-    // move left
-    int offset_find_lhs = offset_find - 1;
-    while (offset_find_lhs >= 0) {
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
 
-      if (this->container_[offset_find_lhs].key_ == key) {
-        offsets.push_back(this->container_[offset_find_lhs].offset_);
-        offset_find_lhs -= 1;
-      } else {
-        break;
-      }
-    }
-    // move right
-    int offset_find_rhs = offset_find + 1;
-    while (offset_find_rhs <= this->size_ - 1) {
-
-      if (this->container_[offset_find_rhs].key_ == key) {
-        offsets.push_back(this->container_[offset_find_rhs].offset_);
-        offset_find_rhs += 1;
-      } else {
-        break;
+  virtual void print() const final {
+    if (inner_nodes_ != nullptr) {
+      for (size_t i = 0; i < inner_size_; ++i) {
+        std::cout << from_simd_key(inner_nodes_[i]) << " ";
       }
+      std::cout << std::endl;
     }
   }
 
-  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
-    assert(lhs_key < rhs_key);
+protected:
+
+  virtual void reorganize_inner(const size_t thread_count) final {
 
     if (this->size_ == 0) {
       return;
     }
-    if (lhs_key > key_max_ || rhs_key < key_min_) {
+
+    key_min_ = this->key_at(0);
+    key_max_ = this->key_at(this->size_ - 1);
+
+    // every cacheline level resolves log2(CACHELINE_FANOUT) binary layers.
+    size_t layers_per_cacheline = __builtin_ctzll(CACHELINE_FANOUT);
+    cacheline_levels_ = (num_layers_ + layers_per_cacheline - 1) / layers_per_cacheline;
+
+    num_buckets_ = 1;
+    for (size_t i = 0; i < cacheline_levels_; ++i) {
+      num_buckets_ *= CACHELINE_FANOUT;
+      ASSERT(num_buckets_ <= this->size_, "exceed maximum layers");
+    }
+
+    if (cacheline_levels_ == 0) {
       return;
     }
 
+    // lay out page levels.
+    size_t page_levels = (cacheline_levels_ + PAGE_DEPTH - 1) / PAGE_DEPTH;
+    page_level_offsets_.resize(page_levels);
+    page_block_strides_.resize(page_levels);
+
+    size_t num_cachelines = 0;
+    size_t num_page_blocks = 1;
+    for (size_t p = 0; p < page_levels; ++p) {
+      page_level_offsets_[p] = num_cachelines;
+      page_block_strides_[p] = page_block_stride(page_depth(p));
+      num_cachelines += num_page_blocks * page_block_strides_[p];
+      num_page_blocks *= CACHELINE_FANOUT * CACHELINE_FANOUT;
+    }
+
+    inner_size_ = num_cachelines * CACHELINE_KEY_CAPACITY;
+
+    void *ptr = nullptr;
+    int rt = posix_memalign(&ptr, PAGE_SIZE, num_cachelines * CACHELINE_SIZE);
+    ASSERT(rt == 0, "failed to allocate inner nodes");
+    inner_nodes_ = reinterpret_cast<SimdKeyT*>(ptr);
+
+    construct_inner_layers(thread_count);
   }
 
-  virtual void reorganize() final {
+  // the inner nodes are page aligned in the file, so page blocks are used in place.
+  virtual void save_inner(IndexFileWriter &writer) const final {
+    writer.write_value(uint64_t(num_layers_));
+    writer.write_value(key_min_);
+    writer.write_value(key_max_);
+    writer.write_value(uint64_t(cacheline_levels_));
+    writer.write_value(uint64_t(num_buckets_));
+    writer.write_value(uint64_t(inner_size_));
+    writer.write_value(uint64_t(page_level_offsets_.size()));
+    writer.write_array(page_level_offsets_.data(), page_level_offsets_.size());
+    writer.write_array(page_block_strides_.data(), page_block_strides_.size());
+    writer.write_array(inner_nodes_, inner_size_);
+  }
+
+  virtual void load_inner(IndexFileReader &reader) final {
+    ASSERT(reader.read_value<uint64_t>() == num_layers_, "mismatched number of layers");
+    key_min_ = reader.read_value<KeyT>();
+    key_max_ = reader.read_value<KeyT>();
+    cacheline_levels_ = reader.read_value<uint64_t>();
+    num_buckets_ = reader.read_value<uint64_t>();
+    inner_size_ = reader.read_value<uint64_t>();
+
+    size_t page_levels = reader.read_value<uint64_t>();
+    const size_t *level_offsets = reader.read_array<size_t>(page_levels);
+    const size_t *block_strides = reader.read_array<size_t>(page_levels);
+    page_level_offsets_.assign(level_offsets, level_offsets + page_levels);
+    page_block_strides_.assign(block_strides, block_strides + page_levels);
+
+    inner_nodes_ = const_cast<SimdKeyT*>(reader.read_array<SimdKeyT>(inner_size_));
+  }
 
-    this->base_reorganize();
+  virtual size_t inner_bytes() const final {
+    return inner_size_ * sizeof(SimdKeyT) + (page_level_offsets_.size() + page_block_strides_.size()) * sizeof(size_t);
+  }
 
-    size_t inner_node_size = std::pow(2.0, num_layers_) - 1;
+private:
 
-    ASSERT(inner_node_size < this->size_, "exceed maximum layers");
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
 
-    cacheline_levels_ = num_layers_ / CACHELINE_DEPTH;
-    num_cachelines_ = new size_t[cacheline_levels_ + 1];
-    for (size_t i = 0; i < cacheline_levels_ + 1; ++i) {
-      num_cachelines_[i] = std::pow(16, i);
+    if (this->size_ == 0) {
+      return;
     }
-    
-    lhs_offset_ = 0;
-    rhs_offset_ = this->size_ - 1 - this->size_ % num_cachelines_[cacheline_levels_];
 
-    last_level_step_ = (rhs_offset_ - lhs_offset_ + 1) / num_cachelines_[cacheline_levels_];
+    if (key > key_max_ || key < key_min_) {
+      return;
+    }
 
-    key_min_ = this->container_[0].key_;
-    key_max_ = this->container_[this->size_ - 1].key_;
+    this->scan_matches(key, lower_bound(key), offsets);
+  }
 
-    if (num_layers_ != 0) {
+  template<typename OutputT>
+  void find_range_into(const KeyT &lhs_key, const KeyT &rhs_key, OutputT &offsets) {
 
-      size_t num_cachelines = inner_node_size / CACHELINE_KEY_CAPACITY;
-      inner_size_ = num_cachelines * CACHELINE_SIZE / sizeof(KeyT);
-      inner_nodes_ = new KeyT[inner_size_];
-      memset(inner_nodes_, 0, sizeof(KeyT) * inner_size_);
+    if (lhs_key > rhs_key) { return; }
 
-      construct_inner_layers();
-    } else {
-      inner_nodes_ = nullptr;
+    if (this->size_ == 0) {
+      return;
+    }
+    if (lhs_key > key_max_ || rhs_key < key_min_) {
+      return;
+    }
+
+    for (size_t pos = lower_bound(lhs_key); pos < this->size_ && this->key_at(pos) <= rhs_key; ++pos) {
+      offsets.push_back(this->offset_at(pos));
     }
   }
 
-  virtual void print() const final {
-    if (inner_nodes_ != nullptr) {
-      for (size_t i = 0; i < inner_size_; ++i) {
-        std::cout << inner_nodes_[i] << " ";
-      }
-      std::cout << std::endl;
+  static inline SimdKeyT to_simd_key(const KeyT &key) {
+    if (std::is_signed<KeyT>::value) {
+      return SimdKeyT(key);
     }
+    typedef typename std::make_unsigned<SimdKeyT>::type UnsignedT;
+    return SimdKeyT(UnsignedT(key) ^ (UnsignedT(1) << (sizeof(SimdKeyT) * 8 - 1)));
   }
 
-private:
+  static inline KeyT from_simd_key(const SimdKeyT &key) {
+    if (std::is_signed<KeyT>::value) {
+      return KeyT(key);
+    }
+    typedef typename std::make_unsigned<SimdKeyT>::type UnsignedT;
+    return KeyT(UnsignedT(key) ^ (UnsignedT(1) << (sizeof(SimdKeyT) * 8 - 1)));
+  }
 
-  void construct_inner_layers() {
-    ASSERT(num_layers_ != 0, "number of layers cannot be 0");
+  // number of cacheline levels in page level p.
+  size_t page_depth(const size_t p) const {
+    size_t remaining_levels = cacheline_levels_ - p * PAGE_DEPTH;
+    return remaining_levels < PAGE_DEPTH ? remaining_levels : PAGE_DEPTH;
+  }
 
-    // cacheline level 0
-    size_t current_pos = 0;
-    construct_cacheline_block(current_pos, lhs_offset_, rhs_offset_);
-    current_pos += 16; // cacheline size
+  // number of cachelines reserved for a page block, padded to a power of 2
+  // so that page blocks never cross page boundaries.
+  static size_t page_block_stride(const size_t depth) {
+    size_t num_cachelines = 0;
+    size_t level_cachelines = 1;
+    for (size_t i = 0; i < depth; ++i) {
+      num_cachelines += level_cachelines;
+      level_cachelines *= CACHELINE_FANOUT;
+    }
+    size_t stride = 1;
+    while (stride < num_cachelines) {
+      stride *= 2;
+    }
+    return stride;
+  }
 
-    // cacheline level i
-    for (size_t i = 1; i < cacheline_levels_; ++i) {
-      size_t num_cachelines = std::pow(16, i);
-      size_t step = (rhs_offset_ - lhs_offset_ + 1) / num_cachelines;
+  // root cacheline block of the block_id-th page block of page level p.
+  // its children, if any, follow it directly.
+  inline SimdKeyT* page_block(const size_t p, const size_t block_id) const {
+    return inner_nodes_ + (page_level_offsets_[p] + block_id * page_block_strides_[p]) * CACHELINE_KEY_CAPACITY;
+  }
 
-      for (size_t j = 0; j < num_cachelines; ++j) {
-        construct_cacheline_block(current_pos, step * j, step * (j + 1) - 1);
-        current_pos += 16;
-      }
-    }
+  // first position of bucket i. the buckets evenly divide the sorted container.
+  inline size_t bucket_boundary(const size_t i) const {
+    return i * (this->size_ / num_buckets_) + i * (this->size_ % num_buckets_) / num_buckets_;
   }
- 
-  // we only support the case for simd key capacity = 3.
-  // in this case, the number of simd blocks in each cacheline block is 5.
-  void construct_cacheline_block(const size_t current_pos, const size_t lhs_offset, const size_t rhs_offset) {
 
-    // simd level 0
-    construct_simd_block(current_pos, lhs_offset, rhs_offset);
+  // the lower bound of a key that falls into bucket i lies in [begin, end].
+  inline void bucket_range(const size_t i, size_t &begin, size_t &end) const {
+    begin = bucket_boundary(i) + (i > 0 ? 1 : 0);
+    end = bucket_boundary(i + 1);
+  }
 
-    // simd level 1
-    size_t step = (rhs_offset - lhs_offset + 1) / 4;
-    for (size_t i = 0; i < 4; ++i) {
-      construct_simd_block(current_pos + 3 * (i + 1), lhs_offset + step * i, lhs_offset + step * (i + 1) - 1);
+  // last step
+  // lower bound of the key within its bucket.
+  size_t lower_bound(const KeyT &key) const {
+    size_t begin, end;
+    bucket_range(find_inner_layers(key), begin, end);
+    return this->lower_bound_in(key, begin, end);
+  }
+
+  // page blocks are independent of each other, so every thread fills a range of them.
+  void construct_inner_layers(const size_t thread_count) {
+
+    size_t num_page_blocks = 1;
+
+    for (size_t p = 0; p < page_level_offsets_.size(); ++p) {
+      size_t level = p * PAGE_DEPTH;
+
+      run_in_parallel(thread_count, [&](const size_t thread_id) {
+        size_t block_begin = num_page_blocks * thread_id / thread_count;
+        size_t block_end = num_page_blocks * (thread_id + 1) / thread_count;
+
+        for (size_t block_id = block_begin; block_id < block_end; ++block_id) {
+          SimdKeyT *block = page_block(p, block_id);
+          construct_cacheline_block(block, level, block_id);
+
+          if (page_depth(p) == 1) { continue; }
+
+          for (size_t child = 0; child < CACHELINE_FANOUT; ++child) {
+            construct_cacheline_block(block + (child + 1) * CACHELINE_KEY_CAPACITY, level + 1, block_id * CACHELINE_FANOUT + child);
+          }
+        }
+      });
+      num_page_blocks *= CACHELINE_FANOUT * CACHELINE_FANOUT;
     }
   }
 
-  // we only support the case for simd key capacity = 3.
-  void construct_simd_block(const size_t current_pos, const size_t lhs_offset, const size_t rhs_offset) {
+  // fill the cacheline block at position node_id of cacheline level `level'.
+  // the separator of child i is the first key of the child's leftmost bucket.
+  void construct_cacheline_block(SimdKeyT *line, const size_t level, const size_t node_id) {
 
-    size_t step = (rhs_offset - lhs_offset + 1) / 4;
+    size_t buckets_per_child = 1;
+    for (size_t i = level + 1; i < cacheline_levels_; ++i) {
+      buckets_per_child *= CACHELINE_FANOUT;
+    }
 
-    inner_nodes_[current_pos + 0] = this->container_[lhs_offset + 2 * step - 1].key_;
-    inner_nodes_[current_pos + 1] = this->container_[lhs_offset + 1 * step - 1].key_;
-    inner_nodes_[current_pos + 2] = this->container_[lhs_offset + 3 * step - 1].key_;
+    for (size_t i = 0; i < CACHELINE_KEY_CAPACITY; ++i) {
+      line[i] = std::numeric_limits<SimdKeyT>::max();
+    }
 
+    for (size_t child = 1; child < CACHELINE_FANOUT; ++child) {
+      size_t bucket_id = (node_id * CACHELINE_FANOUT + child) * buckets_per_child;
+      line[separator_slot(child)] = to_simd_key(this->key_at(bucket_boundary(bucket_id)));
+    }
   }
 
-  // find in inner nodes
-  std::pair<int, int> find_inner_layers(const KeyT &key) {
-
-    if (num_layers_ == 0) { return std::pair<int, int>(0, this->size_ - 1); }
-
-    // cacheline level 0
-    size_t current_pos = 0;
-    size_t branch_id = lookup_cacheline_block(key, current_pos);
-    current_pos += 16; // beginning position in next level
-    
-    size_t num_cachelines = std::pow(16, 1); // number of cachelines in next level
-    
-    for (size_t i = 1; i < cacheline_levels_; ++i) {
-      
-      size_t new_branch_id = lookup_cacheline_block(key, current_pos + branch_id * 16);
-      
-      branch_id = branch_id * 16 + new_branch_id;
-      current_pos += 16 * num_cachelines; // beginning position in next level
-
-      num_cachelines = std::pow(16, (i + 1)); // number of cachelines in next level
+  // slot of the separator of child i in a cacheline block.
+  static size_t separator_slot(const size_t child) {
+    if (sizeof(SimdKeyT) == 8) {
+      return child - 1;
+    }
+    // 4-byte keys: the root SIMD block holds children 4, 8, 12 and is followed by
+    // 4 SIMD blocks, where SIMD block j holds children 4j+1, 4j+2, 4j+3.
+    if (child % 4 == 0) {
+      return child / 4 - 1;
     }
-    
-    if (branch_id < num_cachelines - 1) {
+    return 3 + 3 * (child / 4) + (child % 4 - 1);
+  }
 
-      return std::pair<int, int>(branch_id * last_level_step_, (branch_id + 1) * last_level_step_ - 1);
-    } else {
+  // find in inner nodes. returns the bucket that the key falls into.
+  size_t find_inner_layers(const KeyT &key) const {
+
+    SimdKeyT simd_key = to_simd_key(key);
+
+    size_t node_id = 0;
+
+    for (size_t p = 0; p < page_level_offsets_.size(); ++p) {
+      const SimdKeyT *block = page_block(p, node_id);
+
+      size_t child = lookup_cacheline_block(block, simd_key);
+      node_id = node_id * CACHELINE_FANOUT + child;
 
-      return std::pair<int, int>(branch_id * last_level_step_, this->size_ - 1);
+      if (page_depth(p) == 1) { continue; }
+
+      child = lookup_cacheline_block(block + (child + 1) * CACHELINE_KEY_CAPACITY, simd_key);
+      node_id = node_id * CACHELINE_FANOUT + child;
     }
-    
+    return node_id;
   }
 
-  // search in cacheline block
-  size_t lookup_cacheline_block(const KeyT &key, const size_t current_pos) {
+  // search in cacheline block. returns the number of separators that are smaller than the key.
+  // separators are sorted, so the comparison mask is a run of ones starting at bit 0.
+  inline size_t lookup_cacheline_block(const SimdKeyT *line, const SimdKeyT &key) const {
+    if (sizeof(SimdKeyT) == 4) {
+      return lookup_cacheline_block_32(line, key);
+    }
+    if (simd_path_ == SimdPath::Avx2) {
+      return lookup_cacheline_block_64_avx2(line, key);
+    }
+    if (simd_path_ == SimdPath::Sse42) {
+      return lookup_cacheline_block_64_sse42(line, key);
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < CACHELINE_KEY_CAPACITY; ++i) {
+      count += (line[i] < key);
+    }
+    return count;
+  }
 
-    size_t branch_id = lookup_simd_block(key, current_pos);
-    
-    size_t new_pos = current_pos + 3 * (branch_id + 1);
+  // 4-byte keys: 2 levels of SIMD blocks. the 4th lane of each load belongs to
+  // the next SIMD block and is masked out.
+  static inline size_t lookup_cacheline_block_32(const SimdKeyT *line, const SimdKeyT &key) {
 
-    size_t new_branch_id = lookup_simd_block(key, new_pos); 
+    __m128i xmm_key_q = _mm_set1_epi32(key);
+
+    __m128i xmm_tree = _mm_load_si128((const __m128i*)line);
+    __m128i xmm_mask = _mm_cmpgt_epi32(xmm_key_q, xmm_tree);
+    size_t branch_id = __builtin_ctz(~_mm_movemask_ps(_mm_castsi128_ps(xmm_mask)) | 8);
+
+    xmm_tree = _mm_loadu_si128((const __m128i*)(line + 3 + 3 * branch_id));
+    xmm_mask = _mm_cmpgt_epi32(xmm_key_q, xmm_tree);
+    size_t new_branch_id = __builtin_ctz(~_mm_movemask_ps(_mm_castsi128_ps(xmm_mask)) | 8);
 
     return branch_id * 4 + new_branch_id;
   }
 
-  // search in simd block
-  size_t lookup_simd_block(const KeyT &key, const size_t current_pos) {
+  // 8-byte keys: all 8 slots at once. the padding slot never compares smaller.
+  __attribute__((target("avx2")))
+  static size_t lookup_cacheline_block_64_avx2(const SimdKeyT *line, const SimdKeyT &key) {
 
-    __m128i xmm_key_q =_mm_set1_epi32(key);
-    __m128i xmm_tree = _mm_loadu_si128((__m128i*)(inner_nodes_ + current_pos));
-    __m128i xmm_mask = _mm_cmpgt_epi32(xmm_key_q, xmm_tree);
-    unsigned index = _mm_movemask_ps(_mm_castsi128_ps(xmm_mask));
+    __m256i ymm_key_q = _mm256_set1_epi64x(key);
+
+    __m256i ymm_lhs = _mm256_load_si256((const __m256i*)line);
+    __m256i ymm_rhs = _mm256_load_si256((const __m256i*)(line + 4));
 
-    static unsigned table[8] = {0, 9, 1, 2, 9, 9, 9, 3}; // 9 stands for impossible
-    size_t branch_id = table[(index&7)];
+    unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(ymm_key_q, ymm_lhs)))
+                  | (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(ymm_key_q, ymm_rhs))) << 4);
 
-    return branch_id;
+    return __builtin_ctz(~mask);
   }
 
+  __attribute__((target("sse4.2")))
+  static size_t lookup_cacheline_block_64_sse42(const SimdKeyT *line, const SimdKeyT &key) {
 
-  // last step
-  // find in leaf nodes, simple binary search [incl., incl.]
-  size_t find_internal(const KeyT &key, const int offset_begin, const int offset_end) {
-    if (offset_begin > offset_end) {
-      return this->size_;
-    }
-    int offset_lookup = (offset_begin + offset_end) / 2;
-    KeyT key_lookup = this->container_[offset_lookup].key_;
-    if (key == key_lookup) {
-      return offset_lookup;
-    }
-    if (key > key_lookup) {
-      return find_internal(key, offset_lookup + 1, offset_end);
-    } else {
-      return find_internal(key, offset_begin, offset_lookup - 1);
+    __m128i xmm_key_q = _mm_set1_epi64x(key);
+
+    unsigned mask = 0;
+    for (size_t i = 0; i < 4; ++i) {
+      __m128i xmm_tree = _mm_load_si128((const __m128i*)(line + 2 * i));
+      mask |= _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(xmm_key_q, xmm_tree))) << (2 * i);
     }
+
+    return __builtin_ctz(~mask);
   }
 
 private:
-  
+
   size_t num_layers_;
 
   KeyT key_min_;
   KeyT key_max_;
-  KeyT *inner_nodes_;
+
+  SimdKeyT *inner_nodes_;
   size_t inner_size_;
 
-  size_t lhs_offset_;
-  size_t rhs_offset_;
-  size_t last_level_step_;
   size_t cacheline_levels_;
-  size_t *num_cachelines_;
+  // number of leaf buckets, i.e., CACHELINE_FANOUT ^ cacheline_levels_.
+  size_t num_buckets_;
+
+  // start of each page level, in cachelines.
+  std::vector<size_t> page_level_offsets_;
+  // cachelines reserved for each page block of a page level.
+  std::vector<size_t> page_block_strides_;
 
+  SimdPath simd_path_;
 
 };
 
-}
\ No newline at end of file
+}
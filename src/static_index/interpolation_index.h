@@ -41,8 +41,8 @@ class InterpolationIndex : public BaseStaticIndex<KeyT, ValueT> {
   };
 
 public:
-  InterpolationIndex(DataTable<KeyT, ValueT> *table_ptr, const size_t num_segments = 1) 
-    : BaseStaticIndex<KeyT, ValueT>(table_ptr) {
+  InterpolationIndex(DataTable<KeyT, ValueT> *table_ptr, const size_t num_segments = 1, const StorageLayout layout = StorageLayout::AoS) 
+    : BaseStaticIndex<KeyT, ValueT>(table_ptr, layout) {
 
     ASSERT(num_segments >= 1, "must have at least one segment");
 
@@ -72,151 +72,169 @@ public:
   }
 
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
 
-    stats_.increment_find_op_counter();
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
+
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
 
     if (this->size_ == 0) {
       return;
     }
 
-    if (key > key_max_ || key < key_min_) {
-      return;
-    }
+    int64_t guesses[FIND_BATCH_GROUP_SIZE];
 
-    // all keys are equal
-    if (key_min_ == key_max_) {
-      if (key_min_ == key) {
-        for (size_t i = 0; i < this->size_; ++i) {
-          offsets.push_back(this->container_[i].offset_);
+    for (size_t base = 0; base < count; base += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(FIND_BATCH_GROUP_SIZE, count - base);
+
+      // compute all guesses first, so that the loads of the guessed entries overlap.
+      for (size_t i = 0; i < group_size; ++i) {
+        const KeyT &key = keys[base + i];
+        if (key > key_max_ || key < key_min_ || key_min_ == key_max_) {
+          guesses[i] = -1;
+          continue;
         }
+        guesses[i] = guess_position(key);
+        PREFETCH(&this->key_at(guesses[i]));
       }
-      return;
-    }
 
-    // find suitable segment
-    size_t segment_id = (key - key_min_) / ((key_max_ - key_min_) / num_segments_);
-    if (segment_id > num_segments_ - 1) {
-      segment_id = num_segments_ - 1;
+      for (size_t i = 0; i < group_size; ++i) {
+        if (guesses[i] < 0) {
+          find(keys[base + i], offsets[base + i]);
+          continue;
+        }
+        stats_.increment_find_op_counter();
+        find_from_guess(keys[base + i], guesses[i], offsets[base + i]);
+      }
     }
+  }
 
-    // the key should fall into: 
-    //  [ segment_key_boundaries_[i], segment_key_boundaries_[i + 1] ) -- if 0 <= i < num_segments_ - 1
-    //  [ segment_key_boundaries_[i], segment_key_boundaries_[i + 1] ] -- if i == num_segments_ - 1
-    if (segment_id < num_segments_ - 1) {
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
 
-      ASSERT(segment_key_boundaries_[segment_id] <= key, 
-        "beyond boundary: " << segment_key_boundaries_[segment_id] << " " << key);
-      ASSERT(key < segment_key_boundaries_[segment_id + 1], 
-        "beyond boundary: " << key << " " << segment_key_boundaries_[segment_id + 1]);
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
 
-    } else {
 
-      ASSERT(segment_id == num_segments_ - 1, 
-        "incorrect segment id: " << segment_id << " " << num_segments_ - 1);
 
-      ASSERT(segment_key_boundaries_[segment_id] <= key, 
-        "beyond boundary: " << segment_key_boundaries_[segment_id] << " " << key);
-      ASSERT(key <= segment_key_boundaries_[segment_id + 1], 
-        "beyond boundary: " << key << " " << segment_key_boundaries_[segment_id + 1]);
-    }
+  virtual void print() const final {
 
-    KeyT segment_key_range = segment_key_boundaries_[segment_id + 1] - segment_key_boundaries_[segment_id];
-    
-    // guess where the data lives
-    int64_t guess = int64_t((key - segment_key_boundaries_[segment_id]) * 1.0 / segment_key_range * (segment_sizes_[segment_id] - 1) + segment_offset_boundaries_[segment_id]);
+    std::cout << "aggregated guess distance = " << stats_.find_op_guess_distance_ << std::endl;
 
-    // TODO: workaround!!
-    if (guess >= this->size_) {
-      guess = this->size_ - 1;
-    }
+    std::cout << "number of profiled find operations = " << stats_.find_op_profile_count_ << std::endl;
 
-    int64_t origin_guess = guess;
-    
-    // if the guess is correct
-    if (this->container_[guess].key_ == key) {
+    std::cout << "average guess distance = " << stats_.find_op_guess_distance_ * 1.0 / stats_.find_op_profile_count_ << std::endl;
+  }
 
-      stats_.measure_find_op_guess_distance(origin_guess, guess);
+protected:
 
-      offsets.push_back(this->container_[guess].offset_);
-      
-      // move left
-      int64_t guess_lhs = guess - 1;
-      while (guess_lhs >= 0) {
+  virtual void reorganize_inner(const size_t thread_count) final {
 
-        if (this->container_[guess_lhs].key_ == key) {
-          offsets.push_back(this->container_[guess_lhs].offset_);
-          guess_lhs -= 1;
-        } else {
-          break;
-        }
-      }
-      // move right
-      int64_t guess_rhs = guess + 1;
-      while (guess_rhs <= this->size_ - 1) {
+    key_min_ = this->key_at(0); // min key
+    key_max_ = this->key_at(this->size_ - 1); // max key
 
-        if (this->container_[guess_rhs].key_ == key) {
-          offsets.push_back(this->container_[guess_rhs].offset_);
-          guess_rhs += 1;
-        } else {
-          break;
+    segment_key_boundaries_[0] = key_min_;
+    segment_key_boundaries_[num_segments_] = key_max_;
+
+    KeyT key_range = key_max_ - key_min_;
+    KeyT segment_key_range = key_range / num_segments_;
+
+    for (size_t i = 1; i < num_segments_; ++i) {
+      segment_key_boundaries_[i] = this->key_at(0) + segment_key_range * i;
+    }
+
+    segment_offset_boundaries_[0] = 0;
+
+    // the offset boundary of a segment is the lower bound of its key boundary.
+    // segments are independent, so they are searched in parallel.
+    run_in_parallel(thread_count, [&](const size_t thread_id) {
+      for (size_t i = 1 + thread_id; i < num_segments_; i += thread_count) {
+        size_t begin = 0;
+        size_t len = this->size_;
+        while (len > 0) {
+          size_t half = len / 2;
+          if (this->key_at(begin + half) < segment_key_boundaries_[i]) {
+            begin += half + 1;
+            len -= half + 1;
+          } else {
+            len = half;
+          }
         }
+        segment_offset_boundaries_[i] = begin;
       }
+    });
+
+    for (size_t i = 0; i < num_segments_ - 1; ++i) {
+      segment_sizes_[i] = segment_offset_boundaries_[i + 1] - segment_offset_boundaries_[i];
     }
-    // if the guess is larger than the key
-    else if (this->container_[guess].key_ > key) {
-      // move left
-      guess -= 1;
-      while (guess >= 0) {
 
-        if (this->container_[guess].key_ < key) {
-          break;
-        }
-        else if (this->container_[guess].key_ > key) {
-          guess -= 1;
-          continue;
-        } 
-        else {
+    segment_sizes_[num_segments_ - 1] = this->size_ - segment_offset_boundaries_[num_segments_ - 1];
 
-          stats_.measure_find_op_guess_distance(origin_guess, guess);
+  }
 
-          offsets.push_back(this->container_[guess].offset_);
-          guess -= 1;
-          continue;
-        }
-      }
-    } 
-    // if the guess is smaller than the key
-    else {
-      // move right
-      guess += 1;
-      while (guess < this->size_ - 1) {
+  // segment boundaries are small, so they are copied out of the mapping.
+  virtual void save_inner(IndexFileWriter &writer) const final {
+    writer.write_value(uint64_t(num_segments_));
+    writer.write_value(key_min_);
+    writer.write_value(key_max_);
+    writer.write_array(segment_key_boundaries_, num_segments_ + 1);
+    writer.write_array(segment_offset_boundaries_, num_segments_);
+    writer.write_array(segment_sizes_, num_segments_);
+  }
 
-        if (this->container_[guess].key_ > key) {
-          break;
-        }
-        else if (this->container_[guess].key_ < key) {
-          guess += 1;
-          continue;
-        }
-        else {
-          
-          stats_.measure_find_op_guess_distance(origin_guess, guess);
+  virtual void load_inner(IndexFileReader &reader) final {
+    ASSERT(reader.read_value<uint64_t>() == num_segments_, "mismatched number of segments");
+    key_min_ = reader.read_value<KeyT>();
+    key_max_ = reader.read_value<KeyT>();
+    memcpy(segment_key_boundaries_, reader.read_array<KeyT>(num_segments_ + 1), sizeof(KeyT) * (num_segments_ + 1));
+    memcpy(segment_offset_boundaries_, reader.read_array<size_t>(num_segments_), sizeof(size_t) * num_segments_);
+    memcpy(segment_sizes_, reader.read_array<size_t>(num_segments_), sizeof(size_t) * num_segments_);
+  }
 
-          offsets.push_back(this->container_[guess].offset_);
-          guess += 1;
-          continue;
+  virtual size_t inner_bytes() const final {
+    return sizeof(KeyT) * (num_segments_ + 1) + sizeof(size_t) * num_segments_ * 2;
+  }
+
+private:
+
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
+
+    stats_.increment_find_op_counter();
+
+    if (this->size_ == 0) {
+      return;
+    }
+
+    if (key > key_max_ || key < key_min_) {
+      return;
+    }
+
+    // all keys are equal
+    if (key_min_ == key_max_) {
+      if (key_min_ == key) {
+        for (size_t i = 0; i < this->size_; ++i) {
+          offsets.push_back(this->offset_at(i));
         }
       }
+      return;
     }
-    return;
+
+    find_from_guess(key, guess_position(key), offsets);
   }
 
-  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+  template<typename OutputT>
+  void find_range_into(const KeyT &lhs_key, const KeyT &rhs_key, OutputT &offsets) {
 
     if (lhs_key > rhs_key) { return; }
 
     if (lhs_key == rhs_key) {
-      find(lhs_key, offsets);
+      find_into(lhs_key, offsets);
       return;
     }
 
@@ -232,67 +250,74 @@ public:
     if (key_min_ == key_max_) {
       if (key_min_ >= lhs_key && key_min_ <= rhs_key) {
         for (size_t i = 0; i < this->size_; ++i) {
-          offsets.push_back(this->container_[i].offset_);
+          offsets.push_back(this->offset_at(i));
         }
       }
       return;
     }
 
-    int64_t lower_bound = find_lower_bound(lhs_key);
-    int64_t upper_bound = find_upper_bound(rhs_key);
-
-    for (size_t i = lower_bound; i <= upper_bound; ++i) {
-      offsets.push_back(this->container_[i].offset_);
+    for (size_t i = find_lower_bound(lhs_key); i < this->size_ && this->key_at(i) <= rhs_key; ++i) {
+      offsets.push_back(this->offset_at(i));
     }
     return;
   }
 
+  // guess the position of a key that lies within [key_min_, key_max_].
+  int64_t guess_position(const KeyT &key) const {
 
-  virtual void reorganize() final {
+    // find suitable segment
+    size_t segment_id = (key - key_min_) / ((key_max_ - key_min_) / num_segments_);
+    if (segment_id > num_segments_ - 1) {
+      segment_id = num_segments_ - 1;
+    }
 
-    this->base_reorganize();
+    // the key should fall into: 
+    //  [ segment_key_boundaries_[i], segment_key_boundaries_[i + 1] ) -- if 0 <= i < num_segments_ - 1
+    //  [ segment_key_boundaries_[i], segment_key_boundaries_[i + 1] ] -- if i == num_segments_ - 1
+    if (segment_id < num_segments_ - 1) {
 
-    key_min_ = this->container_[0].key_; // min key
-    key_max_ = this->container_[this->size_ - 1].key_; // max key
+      ASSERT(segment_key_boundaries_[segment_id] <= key, 
+        "beyond boundary: " << segment_key_boundaries_[segment_id] << " " << key);
+      ASSERT(key < segment_key_boundaries_[segment_id + 1], 
+        "beyond boundary: " << key << " " << segment_key_boundaries_[segment_id + 1]);
 
-    segment_key_boundaries_[0] = key_min_;
-    segment_key_boundaries_[num_segments_] = key_max_;
+    } else {
 
-    KeyT key_range = key_max_ - key_min_;
-    KeyT segment_key_range = key_range / num_segments_;
+      ASSERT(segment_id == num_segments_ - 1, 
+        "incorrect segment id: " << segment_id << " " << num_segments_ - 1);
 
-    for (size_t i = 1; i < num_segments_; ++i) {
-      segment_key_boundaries_[i] = this->container_[0].key_ + segment_key_range * i;
+      ASSERT(segment_key_boundaries_[segment_id] <= key, 
+        "beyond boundary: " << segment_key_boundaries_[segment_id] << " " << key);
+      ASSERT(key <= segment_key_boundaries_[segment_id + 1], 
+        "beyond boundary: " << key << " " << segment_key_boundaries_[segment_id + 1]);
     }
 
-    size_t current_offset = 0;
-
-    segment_offset_boundaries_[0] = current_offset;
+    KeyT segment_key_range = segment_key_boundaries_[segment_id + 1] - segment_key_boundaries_[segment_id];
+    
+    // guess where the data lives
+    int64_t guess = int64_t((key - segment_key_boundaries_[segment_id]) * 1.0 / segment_key_range * (segment_sizes_[segment_id] - 1) + segment_offset_boundaries_[segment_id]);
 
-    for (size_t i = 0; i < num_segments_ - 1; ++i) {
-      // scan the entire table to find offset boundaries
-      while (this->container_[current_offset].key_ < segment_key_boundaries_[i + 1]) {
-        ++segment_sizes_[i];
-        ++current_offset;
-      }
-      segment_offset_boundaries_[i + 1] = current_offset;
+    // TODO: workaround!!
+    if (guess >= this->size_) {
+      guess = this->size_ - 1;
     }
 
-    segment_sizes_[num_segments_ - 1] = this->size_ - current_offset;
-
+    return guess;
   }
 
-  virtual void print() const final {
+  // look up a key starting from a guessed position.
+  template<typename OutputT>
+  void find_from_guess(const KeyT &key, int64_t guess, OutputT &offsets) {
 
-    std::cout << "aggregated guess distance = " << stats_.find_op_guess_distance_ << std::endl;
+    size_t pos = this->lower_bound_around(key, guess);
 
-    std::cout << "number of profiled find operations = " << stats_.find_op_profile_count_ << std::endl;
+    if (pos < this->size_ && this->key_at(pos) == key) {
+      stats_.measure_find_op_guess_distance(guess, pos);
+    }
 
-    std::cout << "average guess distance = " << stats_.find_op_guess_distance_ * 1.0 / stats_.find_op_profile_count_ << std::endl;
+    this->scan_matches(key, pos, offsets);
   }
 
-private:
-
   int64_t find_lower_bound(const KeyT &lower_key) {
 
     ASSERT(lower_key <= key_max_, "lower_key must be <= key_max_");
@@ -336,105 +361,9 @@ private:
       guess = this->size_ - 1;
     }
 
-    if (this->container_[guess].key_ >= lower_key) {
-      // move left
-      while (guess - 1 >= 0) {
-        if (this->container_[guess - 1].key_ >= lower_key) {
-          --guess;
-        } else {
-          return guess;
-        }
-      }
-      return guess;
-
-    } else {
-      // move right
-      ++guess;
-      while (guess < this->size_) {
-        if (this->container_[guess].key_ < lower_key) {
-          ++guess;
-        } else {
-          return guess;
-        }
-      }
-      ASSERT(false, "shouldn't touch this line of code");
-      return guess;
-    }
-
+    return this->lower_bound_around(lower_key, guess);
   }
   
-  int64_t find_upper_bound(const KeyT &upper_key) {
-    
-    ASSERT(upper_key >= key_min_, "upper_key must be >= key_min_");
-
-    if (upper_key >= key_max_) {
-      return this->size_ - 1;
-    }
-
-    size_t segment_id = (upper_key - key_min_) / ((key_max_ - key_min_) / num_segments_);
-    if (segment_id > num_segments_ - 1) {
-      segment_id = num_segments_ - 1;
-    }
-
-    // the upper_key should fall into: 
-    //  [ segment_key_boundaries_[i], segment_key_boundaries_[i + 1] ) -- if 0 <= i < num_segments_ - 1
-    //  [ segment_key_boundaries_[i], segment_key_boundaries_[i + 1] ] -- if i == num_segments_ - 1
-    if (segment_id < num_segments_ - 1) {
-
-      ASSERT(segment_key_boundaries_[segment_id] <= upper_key, 
-        "beyond boundary: " << segment_key_boundaries_[segment_id] << " " << upper_key);
-      ASSERT(upper_key < segment_key_boundaries_[segment_id + 1], 
-        "beyond boundary: " << upper_key << " " << segment_key_boundaries_[segment_id + 1]);
-
-    } else {
-
-      ASSERT(segment_id == num_segments_ - 1, 
-        "incorrect segment id: " << segment_id << " " << num_segments_ - 1);
-
-      ASSERT(segment_key_boundaries_[segment_id] <= upper_key, 
-        "beyond boundary: " << segment_key_boundaries_[segment_id] << " " << upper_key);
-      ASSERT(upper_key <= segment_key_boundaries_[segment_id + 1], 
-        "beyond boundary: " << upper_key << " " << segment_key_boundaries_[segment_id + 1]);
-    }
-
-    KeyT segment_key_range = segment_key_boundaries_[segment_id + 1] - segment_key_boundaries_[segment_id];
-    // guess where the data lives
-    int64_t guess = int64_t((upper_key - segment_key_boundaries_[segment_id]) * 1.0 / segment_key_range * (segment_sizes_[segment_id] - 1) + segment_offset_boundaries_[segment_id]);
-
-    // TODO: workaround!!
-    if (guess >= this->size_) {
-      guess = this->size_ - 1;
-    }
-
-    if (this->container_[guess].key_ <= upper_key) {
-      // move right
-      while (guess +1 <= this->size_ - 1) {
-        if (this->container_[guess + 1].key_ <= upper_key) {
-          ++guess;
-        } else {
-          return guess;
-        }
-      }
-      return guess;
-
-    } else {
-      // move left
-      --guess;
-      while (guess > 0) {
-        if (this->container_[guess].key_ > upper_key) {
-          --guess;
-        } else {
-          return guess;
-        }
-      }
-      ASSERT(false, "shouldn't touch this line of code");
-      return guess;
-    }
-
-
-  }
-
-
   void find_range_by_scan(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) {
 
     if (lhs_key > rhs_key) { return; }
@@ -456,7 +385,7 @@ private:
     if (key_min_ == key_max_) {
       if (key_min_ >= lhs_key && key_min_ <= rhs_key) {
         for (size_t i = 0; i < this->size_; ++i) {
-          offsets.push_back(this->container_[i].offset_);
+          offsets.push_back(this->offset_at(i));
         }
       }
       return;
@@ -504,14 +433,14 @@ private:
     }
 
     // if the guess is in [lhs_key, rhs_key]
-    if (this->container_[guess].key_ >= lhs_key && this->container_[guess].key_ <= rhs_key) {
-      offsets.push_back(this->container_[guess].offset_);
+    if (this->key_at(guess) >= lhs_key && this->key_at(guess) <= rhs_key) {
+      offsets.push_back(this->offset_at(guess));
       
       // move left
       int64_t guess_lhs = guess - 1;
       while (guess_lhs >= 0) {
-        if (this->container_[guess_lhs].key_ >= lhs_key) {
-          offsets.push_back(this->container_[guess_lhs].offset_);
+        if (this->key_at(guess_lhs) >= lhs_key) {
+          offsets.push_back(this->offset_at(guess_lhs));
           guess_lhs -= 1;
         } else {
           break;
@@ -520,22 +449,22 @@ private:
       // move right
       int64_t guess_rhs = guess + 1;
       while (guess_rhs <= this->size_ - 1) {
-        if (this->container_[guess_rhs].key_ <= rhs_key) {
-          offsets.push_back(this->container_[guess_rhs].offset_);
+        if (this->key_at(guess_rhs) <= rhs_key) {
+          offsets.push_back(this->offset_at(guess_rhs));
           guess_rhs += 1;
         } else {
           break;
         }
       }
     }
-    else if (this->container_[guess].key_ > rhs_key) {
+    else if (this->key_at(guess) > rhs_key) {
       // move left
       int64_t guess_lhs = guess - 1;
       while (guess_lhs >= 0) {
-        if (this->container_[guess_lhs].key_ < lhs_key) {
+        if (this->key_at(guess_lhs) < lhs_key) {
           break;
-        } else if (this->container_[guess_lhs].key_ <= rhs_key) {
-          offsets.push_back(this->container_[guess_lhs].offset_);
+        } else if (this->key_at(guess_lhs) <= rhs_key) {
+          offsets.push_back(this->offset_at(guess_lhs));
           guess_lhs -= 1;
         } else {
           guess_lhs -= 1;
@@ -547,15 +476,15 @@ private:
       // move right
       guess += 1;
       while (guess < this->size_ - 1) {
-        if (this->container_[guess].key_ < lhs_key) {
+        if (this->key_at(guess) < lhs_key) {
           guess += 1;
           continue;
         }
-        else if (this->container_[guess].key_ > rhs_key) {
+        else if (this->key_at(guess) > rhs_key) {
           break;
         }
         else {
-          offsets.push_back(this->container_[guess].offset_);
+          offsets.push_back(this->offset_at(guess));
           guess += 1;
           continue;
         }
@@ -12,121 +12,134 @@ template<typename KeyT, typename ValueT>
 class KAryIndex : public BaseStaticIndex<KeyT, ValueT> {
 
 public:
-  KAryIndex(DataTable<KeyT, ValueT> *table_ptr, const size_t num_layers, const size_t num_arys) : BaseStaticIndex<KeyT, ValueT>(table_ptr), num_layers_(num_layers), num_arys_(num_arys) {
+  KAryIndex(DataTable<KeyT, ValueT> *table_ptr, const size_t num_layers, const size_t num_arys, const StorageLayout layout = StorageLayout::AoS) : BaseStaticIndex<KeyT, ValueT>(table_ptr, layout), num_layers_(num_layers), num_arys_(num_arys), inner_nodes_(nullptr), inner_node_count_(0) {
     ASSERT(num_arys_ >= 2, "num_arys must be larger than or equal to 2");
   }
 
   virtual ~KAryIndex() {
-    if (num_layers_ != 0) {
+    if (num_layers_ != 0 && !this->is_mapped()) {
       delete[] inner_nodes_;
-      inner_nodes_ = nullptr;
     }
+    inner_nodes_ = nullptr;
   }
 
   virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
 
-    if (this->size_ == 0) {
-      return;
-    }
-
-    if (key > key_max_ || key < key_min_) {
-      return;
-    }
-    if (key_max_ == key_min_) {
-      if (key_max_ == key) {
-        for (size_t i = 0; i < this->size_; ++i) {
-          offsets.push_back(this->container_[i].offset_);
-        }
-      }
-      return;
-    }
-
-    size_t offset_find = this->size_;
-    std::pair<int, int> offset_range = find_inner_layers(key);
-    if (offset_range.first == offset_range.second) {
-      offset_find = offset_range.first;
-    } else {
-      offset_find = find_internal(key, offset_range.first, offset_range.second);
-    }
-
-    if (offset_find == this->size_) {
-      // find nothing
-      return;
-    }
-
-    offsets.push_back(this->container_[offset_find].offset_);
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
 
-    // move left
-    int offset_find_lhs = offset_find - 1;
-    while (offset_find_lhs >= 0) {
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
+    this->find_batch_in_ranges(keys, count, offsets, key_min_, key_max_,
+      [this](const KeyT &key) { return find_inner_layers(key); });
+  }
 
-      if (this->container_[offset_find_lhs].key_ == key) {
-        offsets.push_back(this->container_[offset_find_lhs].offset_);
-        offset_find_lhs -= 1;
-      } else {
-        break;
-      }
-    }
-    // move right
-    int offset_find_rhs = offset_find + 1;
-    while (offset_find_rhs <= this->size_ - 1) {
-
-      if (this->container_[offset_find_rhs].key_ == key) {
-        offsets.push_back(this->container_[offset_find_rhs].offset_);
-        offset_find_rhs += 1;
-      } else {
-        break;
-      }
-    }
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
   }
 
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
 
-  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
-    ASSERT(lhs_key < rhs_key, "lhs_key must be smaller than rhs_key: " << lhs_key << " " << rhs_key);
+  virtual void print() const final {
+    if (inner_nodes_ != nullptr) {
 
-    if (this->size_ == 0) {
-      return;
-    }
-    if (lhs_key > key_max_ || rhs_key < key_min_) {
-      return;
+      for (size_t i = 0; i < inner_node_count_; ++i) {
+        std::cout << inner_nodes_[i] << " ";
+      }
+      std::cout << std::endl;
     }
-
   }
 
-  virtual void reorganize() final {
+protected:
 
-    this->base_reorganize();
+  virtual void reorganize_inner(const size_t thread_count) final {
 
     inner_node_count_ = std::pow(num_arys_, num_layers_) - 1;
 
     ASSERT(inner_node_count_ < this->size_, "exceed maximum layers");
 
-    key_min_ = this->container_[0].key_;
-    key_max_ = this->container_[this->size_ - 1].key_;
+    key_min_ = this->key_at(0);
+    key_max_ = this->key_at(this->size_ - 1);
 
     if (num_layers_ != 0) {
 
       inner_nodes_ = new KeyT[inner_node_count_];
-      construct_inner_layers();
+      construct_inner_layers(thread_count);
 
     } else {
       inner_nodes_ = nullptr;
     }
   }
 
-  virtual void print() const final {
-    if (inner_nodes_ != nullptr) {
+  virtual void save_inner(IndexFileWriter &writer) const final {
+    writer.write_value(uint64_t(num_layers_));
+    writer.write_value(uint64_t(num_arys_));
+    writer.write_value(key_min_);
+    writer.write_value(key_max_);
+    writer.write_value(uint64_t(inner_node_count_));
+    writer.write_array(inner_nodes_, num_layers_ != 0 ? inner_node_count_ : 0);
+  }
 
-      for (size_t i = 0; i < inner_node_count_; ++i) {
-        std::cout << inner_nodes_[i] << " ";
+  virtual void load_inner(IndexFileReader &reader) final {
+    ASSERT(reader.read_value<uint64_t>() == num_layers_, "mismatched number of layers");
+    ASSERT(reader.read_value<uint64_t>() == num_arys_, "mismatched number of arys");
+    key_min_ = reader.read_value<KeyT>();
+    key_max_ = reader.read_value<KeyT>();
+    inner_node_count_ = reader.read_value<uint64_t>();
+    inner_nodes_ = const_cast<KeyT*>(reader.read_array<KeyT>(num_layers_ != 0 ? inner_node_count_ : 0));
+  }
+
+  virtual size_t inner_bytes() const final {
+    return num_layers_ != 0 ? inner_node_count_ * sizeof(KeyT) : 0;
+  }
+
+private:
+
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
+
+    if (this->size_ == 0) {
+      return;
+    }
+
+    if (key > key_max_ || key < key_min_) {
+      return;
+    }
+    if (key_max_ == key_min_) {
+      if (key_max_ == key) {
+        for (size_t i = 0; i < this->size_; ++i) {
+          offsets.push_back(this->offset_at(i));
+        }
       }
-      std::cout << std::endl;
+      return;
     }
+
+    this->scan_matches(key, this->lower_bound_in_range(key, find_inner_layers(key)), offsets);
   }
 
-private:
+  template<typename OutputT>
+  void find_range_into(const KeyT &lhs_key, const KeyT &rhs_key, OutputT &offsets) {
+
+    if (lhs_key > rhs_key) { return; }
+
+    if (this->size_ == 0) {
+      return;
+    }
+    if (lhs_key > key_max_ || rhs_key < key_min_) {
+      return;
+    }
 
-  void construct_inner_layers() {
+    size_t pos = (lhs_key <= key_min_) ? 0 : this->lower_bound_in_range(lhs_key, find_inner_layers(lhs_key));
+    for (; pos < this->size_ && this->key_at(pos) <= rhs_key; ++pos) {
+      offsets.push_back(this->offset_at(pos));
+    }
+  }
+
+  void construct_inner_layers(const size_t thread_count) {
     ASSERT (num_layers_ != 0, "number of layers cannot be 0");
 
     size_t begin_offset = 0;
@@ -139,19 +152,25 @@ private:
       ASSERT(i < inner_node_count_, 
         "out of array: " << i << " " << inner_node_count_);
 
-      inner_nodes_[i] = this->container_[begin_offset + step_offset * (i + 1)].key_;
+      inner_nodes_[i] = this->key_at(begin_offset + step_offset * (i + 1));
     }
     if (num_layers_ == 1) { return; }
 
     size_t base_pos = num_arys_ - 1;
     size_t next_layer = 1;
 
-    // construct (num_arys_ + 1) children
-    construct_inner_layers_internal(begin_offset, begin_offset + step_offset - 1, base_pos, 0, next_layer);
-    for (size_t i = 1; i < num_arys_ - 1; ++i) {
-      construct_inner_layers_internal(begin_offset + step_offset * i + 1, begin_offset + step_offset * (i + 1) - 1, base_pos, i * (num_arys_ - 1), next_layer);
-    }
-    construct_inner_layers_internal(begin_offset + step_offset * (num_arys_ - 1) + 1, end_offset, base_pos, (num_arys_ - 1) * (num_arys_ - 1), next_layer);
+    // construct num_arys_ children. the subtrees are disjoint, so they are built in parallel.
+    run_in_parallel(thread_count, [&](const size_t thread_id) {
+      for (size_t i = thread_id; i < num_arys_; i += thread_count) {
+        if (i == 0) {
+          construct_inner_layers_internal(begin_offset, begin_offset + step_offset - 1, base_pos, 0, next_layer);
+        } else if (i < num_arys_ - 1) {
+          construct_inner_layers_internal(begin_offset + step_offset * i + 1, begin_offset + step_offset * (i + 1) - 1, base_pos, i * (num_arys_ - 1), next_layer);
+        } else {
+          construct_inner_layers_internal(begin_offset + step_offset * (num_arys_ - 1) + 1, end_offset, base_pos, (num_arys_ - 1) * (num_arys_ - 1), next_layer);
+        }
+      }
+    });
   }
 
   void construct_inner_layers_internal(const int begin_offset, const int end_offset, const size_t base_pos, const size_t dst_pos, const size_t curr_layer) {
@@ -163,7 +182,7 @@ private:
       ASSERT(base_pos + dst_pos + i < inner_node_count_, 
         "out of array: " << (base_pos + dst_pos + i) << " " << inner_node_count_);
 
-      inner_nodes_[base_pos + dst_pos + i] = this->container_[begin_offset + step_offset * (i + 1)].key_;
+      inner_nodes_[base_pos + dst_pos + i] = this->key_at(begin_offset + step_offset * (i + 1));
     }
     if (num_layers_ == curr_layer + 1) { return; }
 
@@ -177,24 +196,6 @@ private:
     construct_inner_layers_internal(begin_offset + step_offset * (num_arys_ - 1) + 1, end_offset, new_base_pos, new_dst_pos + (num_arys_ - 1) * (num_arys_ - 1), next_layer);
   }
 
-  // binary search
-  // this function directly find key in leaf nodes
-  size_t find_internal(const KeyT &key, const int offset_begin, const int offset_end) {
-    if (offset_begin > offset_end) {
-      return this->size_;
-    }
-    int offset_lookup = (offset_begin + offset_end) / 2;
-    KeyT key_lookup = this->container_[offset_lookup].key_;
-    if (key == key_lookup) {
-      return offset_lookup;
-    }
-    if (key > key_lookup) {
-      return find_internal(key, offset_lookup + 1, offset_end);
-    } else {
-      return find_internal(key, offset_begin, offset_lookup - 1);
-    }
-  }
-
   // find key in inner nodes
   std::pair<int, int> find_inner_layers(const KeyT &key) {
 
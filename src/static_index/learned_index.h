@@ -0,0 +1,588 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cmath>
+
+#include "base_static_index.h"
+
+namespace static_index {
+
+enum class LearnedModelType {
+  RMI = 0,
+  PGM,
+};
+
+// learned index: a model predicts the position of a key in the sorted container, and the
+// key is then searched within the error bound of the model.
+//  RMI: two-level recursive model index (SIGMOD 2018). a linear root model selects one of
+//       the linear leaf models, and every leaf model records its own error bound.
+//  PGM: piecewise linear segments with error bound epsilon (VLDB 2020). segments are indexed
+//       by upper levels of segments, until a single segment is left.
+// models are trained on the first position of every distinct key, that is, its lower bound.
+// the lower bound of an absent key may fall outside of the error bound, so a search that ends
+// at the edge of its window is verified, and redone within the range covered by the model.
+template<typename KeyT, typename ValueT>
+class LearnedIndex : public BaseStaticIndex<KeyT, ValueT> {
+
+  // leaf model of RMI. position = intercept_ + slope_ * x.
+  struct LinearModel {
+    LinearModel() : slope_(0), intercept_(0), min_error_(0), max_error_(0), begin_(0), end_(0) {}
+
+    double slope_;
+    double intercept_;
+    // signed errors (true position - predicted position) of the training keys.
+    int64_t min_error_;
+    int64_t max_error_;
+    // the lower bound of any key routed to this model lies in [begin_, end_].
+    size_t begin_;
+    size_t end_;
+  };
+
+  // segment of PGM. position = pos_ + slope_ * (key - key_).
+  struct Segment {
+    Segment() : key_(0), slope_(0), pos_(0) {}
+
+    KeyT key_; // first key covered by the segment
+    double slope_;
+    size_t pos_; // position of key_ in the level below
+  };
+
+  struct Level {
+    Level() : max_error_(0) {}
+
+    std::vector<Segment> segments_;
+    int64_t max_error_;
+  };
+
+  // the lower bound is searched in [lo_, hi_), and is guaranteed to lie in [range_lo_, range_hi_].
+  struct SearchBound {
+    size_t lo_;
+    size_t hi_;
+    size_t range_lo_;
+    size_t range_hi_;
+  };
+
+public:
+  // model_param is the number of leaf models for RMI, and epsilon for PGM.
+  LearnedIndex(DataTable<KeyT, ValueT> *table_ptr, const LearnedModelType model_type, const size_t model_param, const StorageLayout layout = StorageLayout::AoS)
+    : BaseStaticIndex<KeyT, ValueT>(table_ptr, layout)
+    , model_type_(model_type)
+    , model_param_(model_param)
+    , key_min_(0)
+    , key_max_(0)
+    , root_slope_(0)
+    , root_intercept_(0)
+    , max_error_(0)
+    , avg_error_(0) {
+
+    ASSERT(model_type == LearnedModelType::RMI || model_type == LearnedModelType::PGM, "unsupported model type");
+    ASSERT(model_param >= 1, "model parameter must be positive");
+  }
+
+  virtual ~LearnedIndex() {}
+
+  virtual void find(const KeyT &key, std::vector<Uint64> &offsets) final {
+    find_into(key, offsets);
+  }
+
+  virtual void find(const KeyT &key, ResultSink &sink) final {
+    find_into(key, sink);
+  }
+
+  virtual void find_batch(const KeyT *keys, const size_t count, std::vector<Uint64> *offsets) final {
+
+    if (this->size_ == 0) {
+      return;
+    }
+
+    SearchBound bounds[FIND_BATCH_GROUP_SIZE];
+    size_t begins[FIND_BATCH_GROUP_SIZE];
+    size_t ends[FIND_BATCH_GROUP_SIZE];
+
+    for (size_t base = 0; base < count; base += FIND_BATCH_GROUP_SIZE) {
+      size_t group_size = std::min(FIND_BATCH_GROUP_SIZE, count - base);
+
+      // predict all windows first, then search them in lockstep.
+      for (size_t i = 0; i < group_size; ++i) {
+        const KeyT &key = keys[base + i];
+        if (key > key_max_ || key < key_min_) {
+          bounds[i].lo_ = bounds[i].hi_ = bounds[i].range_lo_ = bounds[i].range_hi_ = this->size_;
+        } else {
+          bounds[i] = predict(key);
+        }
+        begins[i] = bounds[i].lo_;
+        ends[i] = bounds[i].hi_;
+      }
+
+      this->lower_bound_group(keys + base, group_size, begins, ends);
+
+      for (size_t i = 0; i < group_size; ++i) {
+        this->scan_matches(keys[base + i], settle_in_window(keys[base + i], begins[i], bounds[i]), offsets[base + i]);
+      }
+    }
+  }
+
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, std::vector<Uint64> &offsets) final {
+    find_range_into(lhs_key, rhs_key, offsets);
+  }
+
+  virtual void find_range(const KeyT &lhs_key, const KeyT &rhs_key, ResultSink &sink) final {
+    find_range_into(lhs_key, rhs_key, sink);
+  }
+
+  virtual void print() const final {
+    if (model_type_ == LearnedModelType::RMI) {
+      std::cout << "model type: rmi" << std::endl;
+      std::cout << "number of leaf models: " << models_.size() << std::endl;
+    } else {
+      std::cout << "model type: pgm" << std::endl;
+      std::cout << "epsilon: " << model_param_ << std::endl;
+      std::cout << "number of segments:";
+      for (size_t l = 0; l < levels_.size(); ++l) {
+        std::cout << " " << levels_[l].segments_.size();
+      }
+      std::cout << std::endl;
+    }
+    std::cout << "max error = " << max_error_ << std::endl;
+    std::cout << "average error = " << avg_error_ << std::endl;
+  }
+
+protected:
+
+  virtual void reorganize_inner(const size_t thread_count) final {
+
+    if (this->size_ == 0) {
+      return;
+    }
+
+    key_min_ = this->key_at(0);
+    key_max_ = this->key_at(this->size_ - 1);
+
+    if (model_type_ == LearnedModelType::RMI) {
+      train_rmi(thread_count);
+    } else {
+      train_pgm();
+    }
+  }
+
+  // models are small, so they are copied out of the mapping.
+  virtual void save_inner(IndexFileWriter &writer) const final {
+    writer.write_value(uint64_t(model_type_));
+    writer.write_value(uint64_t(model_param_));
+    writer.write_value(key_min_);
+    writer.write_value(key_max_);
+    writer.write_value(max_error_);
+    writer.write_value(avg_error_);
+
+    writer.write_value(root_slope_);
+    writer.write_value(root_intercept_);
+    writer.write_value(uint64_t(models_.size()));
+    writer.write_array(models_.data(), models_.size());
+
+    writer.write_value(uint64_t(levels_.size()));
+    for (size_t l = 0; l < levels_.size(); ++l) {
+      writer.write_value(levels_[l].max_error_);
+      writer.write_value(uint64_t(levels_[l].segments_.size()));
+      writer.write_array(levels_[l].segments_.data(), levels_[l].segments_.size());
+    }
+  }
+
+  virtual void load_inner(IndexFileReader &reader) final {
+    ASSERT(reader.read_value<uint64_t>() == uint64_t(model_type_), "mismatched model type");
+    ASSERT(reader.read_value<uint64_t>() == model_param_, "mismatched model parameter");
+    key_min_ = reader.read_value<KeyT>();
+    key_max_ = reader.read_value<KeyT>();
+    max_error_ = reader.read_value<int64_t>();
+    avg_error_ = reader.read_value<double>();
+
+    root_slope_ = reader.read_value<double>();
+    root_intercept_ = reader.read_value<double>();
+    size_t num_models = reader.read_value<uint64_t>();
+    const LinearModel *models = reader.read_array<LinearModel>(num_models);
+    models_.assign(models, models + num_models);
+
+    levels_.resize(reader.read_value<uint64_t>());
+    for (size_t l = 0; l < levels_.size(); ++l) {
+      levels_[l].max_error_ = reader.read_value<int64_t>();
+      size_t num_segments = reader.read_value<uint64_t>();
+      const Segment *segments = reader.read_array<Segment>(num_segments);
+      levels_[l].segments_.assign(segments, segments + num_segments);
+    }
+  }
+
+  virtual size_t inner_bytes() const final {
+    size_t bytes = models_.size() * sizeof(LinearModel);
+    for (auto &level : levels_) {
+      bytes += sizeof(Level) + level.segments_.size() * sizeof(Segment);
+    }
+    return bytes;
+  }
+
+private:
+
+  template<typename OutputT>
+  void find_into(const KeyT &key, OutputT &offsets) {
+
+    if (this->size_ == 0) {
+      return;
+    }
+
+    if (key > key_max_ || key < key_min_) {
+      return;
+    }
+
+    this->scan_matches(key, lower_bound(key), offsets);
+  }
+
+  template<typename OutputT>
+  void find_range_into(const KeyT &lhs_key, const KeyT &rhs_key, OutputT &offsets) {
+
+    if (lhs_key > rhs_key) { return; }
+
+    if (this->size_ == 0) {
+      return;
+    }
+
+    if (lhs_key > key_max_ || rhs_key < key_min_) {
+      return;
+    }
+
+    size_t pos = (lhs_key <= key_min_) ? 0 : lower_bound(lhs_key);
+    for (; pos < this->size_ && this->key_at(pos) <= rhs_key; ++pos) {
+      offsets.push_back(this->offset_at(pos));
+    }
+  }
+
+  // keys are mapped to doubles relative to the minimum key. the mapping is monotonic,
+  // so are the models.
+  inline double to_x(const KeyT &key) const {
+    return double(key) - double(key_min_);
+  }
+
+  struct DataKeyFunc {
+    DataKeyFunc(const LearnedIndex *index) : index_(index) {}
+    inline const KeyT& operator()(const size_t i) const { return index_->key_at(i); }
+    const LearnedIndex *index_;
+  };
+
+  struct SegmentKeyFunc {
+    SegmentKeyFunc(const std::vector<Segment> &segments) : segments_(segments) {}
+    inline const KeyT& operator()(const size_t i) const { return segments_[i].key_; }
+    const std::vector<Segment> &segments_;
+  };
+
+  DataKeyFunc data_key_func() const { return DataKeyFunc(this); }
+
+  // clamp the window [pos + min_error, pos + max_error + 1) into [range_lo, range_hi].
+  static SearchBound make_bound(const int64_t pos, const int64_t min_error, const int64_t max_error, const size_t range_lo, const size_t range_hi) {
+    SearchBound bound;
+    bound.range_lo_ = range_lo;
+    bound.range_hi_ = range_hi;
+
+    int64_t lo = pos + min_error;
+    int64_t hi = pos + max_error + 1;
+    bound.lo_ = lo < int64_t(range_lo) ? range_lo : (lo > int64_t(range_hi) ? range_hi : size_t(lo));
+    bound.hi_ = hi < int64_t(bound.lo_) ? bound.lo_ : (hi > int64_t(range_hi) ? range_hi : size_t(hi));
+    return bound;
+  }
+
+  // lower bound of the key among segments within [lo, hi). returns hi if all keys in the window are smaller.
+  template<typename KeyFunc>
+  static size_t bounded_lower_bound(const KeyFunc &key_of, const KeyT &key, size_t lo, const size_t hi) {
+    size_t len = hi - lo;
+    while (len > 1) {
+      size_t half = len / 2;
+      PREFETCH(&key_of(lo + half / 2));
+      PREFETCH(&key_of(lo + half + half / 2));
+      lo = (key_of(lo + half) < key) ? lo + half : lo;
+      len -= half;
+    }
+    if (len == 1) {
+      lo += (key_of(lo) < key);
+    }
+    return lo;
+  }
+
+  // a result strictly inside the window is exact. at the edges, check the neighbour
+  // outside of the window. if the window missed, the whole range has to be searched.
+  template<typename KeyFunc>
+  static bool window_missed(const KeyFunc &key_of, const KeyT &key, const size_t pos, const SearchBound &bound) {
+    return (pos == bound.lo_ && pos > bound.range_lo_ && !(key_of(pos - 1) < key)) ||
+           (pos == bound.hi_ && pos < bound.range_hi_ && key_of(pos) < key);
+  }
+
+  // lower bound in the container, given the search window found by lower_bound_group() or lower_bound_in().
+  size_t settle_in_window(const KeyT &key, const size_t pos, const SearchBound &bound) const {
+    if (window_missed(data_key_func(), key, pos, bound)) {
+      return this->lower_bound_in(key, bound.range_lo_, bound.range_hi_);
+    }
+    return pos;
+  }
+
+  // requires key_min_ <= key <= key_max_.
+  size_t lower_bound(const KeyT &key) const {
+    SearchBound bound = predict(key);
+    return settle_in_window(key, this->lower_bound_in(key, bound.lo_, bound.hi_), bound);
+  }
+
+  // predict the search window of a key in the container.
+  SearchBound predict(const KeyT &key) const {
+    if (model_type_ == LearnedModelType::RMI) {
+      const LinearModel &model = models_[rmi_model_id(key)];
+      int64_t pos = int64_t(model.intercept_ + model.slope_ * to_x(key));
+      return make_bound(pos, model.min_error_, model.max_error_, model.begin_, model.end_);
+    }
+
+    // descend the segment levels. every level locates the last segment whose first key
+    // is not larger than the key.
+    size_t segment_id = 0;
+    for (size_t l = levels_.size() - 1; l > 0; --l) {
+      const std::vector<Segment> &below = levels_[l - 1].segments_;
+      SegmentKeyFunc key_of(below);
+      SearchBound bound = segment_bound(levels_[l], segment_id, key, below.size());
+      size_t pos = bounded_lower_bound(key_of, key, bound.lo_, bound.hi_);
+      if (window_missed(key_of, key, pos, bound)) {
+        pos = bounded_lower_bound(key_of, key, bound.range_lo_, bound.range_hi_);
+      }
+      segment_id = (pos < below.size() && below[pos].key_ == key) ? pos : pos - 1;
+    }
+    return segment_bound(levels_[0], segment_id, key, this->size_);
+  }
+
+  SearchBound segment_bound(const Level &level, const size_t segment_id, const KeyT &key, const size_t level_size) const {
+    const Segment &segment = level.segments_[segment_id];
+    size_t range_hi = (segment_id + 1 < level.segments_.size()) ? level.segments_[segment_id + 1].pos_ : level_size;
+    int64_t pos = int64_t(segment.pos_) + int64_t(segment.slope_ * (double(key) - double(segment.key_)));
+    return make_bound(pos, -level.max_error_, level.max_error_, segment.pos_, range_hi);
+  }
+
+  /////////////////////////////////////////////////////////////////////
+  // RMI
+  /////////////////////////////////////////////////////////////////////
+
+  inline size_t rmi_model_id(const KeyT &key) const {
+    double id = root_intercept_ + root_slope_ * to_x(key);
+    if (id < 0) {
+      return 0;
+    }
+    if (id >= double(models_.size())) {
+      return models_.size() - 1;
+    }
+    return size_t(id);
+  }
+
+  // least squares fit of (key, position * scale) over the distinct keys in [begin, end).
+  void fit_linear(const size_t begin, const size_t end, const double scale, double &slope, double &intercept) const {
+    size_t count = 0;
+    double mean_x = 0;
+    double mean_y = 0;
+    for (size_t i = begin; i < end; ++i) {
+      if (i > begin && this->key_at(i) == this->key_at(i - 1)) { continue; }
+      ++count;
+      mean_x += (to_x(this->key_at(i)) - mean_x) / count;
+      mean_y += (i * scale - mean_y) / count;
+    }
+
+    double sxx = 0;
+    double sxy = 0;
+    for (size_t i = begin; i < end; ++i) {
+      if (i > begin && this->key_at(i) == this->key_at(i - 1)) { continue; }
+      double dx = to_x(this->key_at(i)) - mean_x;
+      sxx += dx * dx;
+      sxy += dx * (i * scale - mean_y);
+    }
+
+    // a negative slope would break the monotonicity of the model.
+    slope = (sxx > 0 && sxy > 0) ? sxy / sxx : 0;
+    intercept = (count == 0) ? begin * scale : mean_y - slope * mean_x;
+  }
+
+  void train_rmi(const size_t thread_count) {
+
+    size_t num_models = std::min(model_param_, this->size_);
+    models_.assign(num_models, LinearModel());
+
+    fit_linear(0, this->size_, double(num_models) / this->size_, root_slope_, root_intercept_);
+
+    // the root model is monotonic, so every leaf model covers a contiguous range
+    // of the container. leaf models are independent, and trained in parallel.
+    run_in_parallel(thread_count, [&](const size_t thread_id) {
+      for (size_t m = thread_id; m < num_models; m += thread_count) {
+        models_[m].begin_ = rmi_partition_begin(m);
+        models_[m].end_ = rmi_partition_begin(m + 1);
+      }
+    });
+
+    std::vector<double> abs_errors(num_models, 0);
+    std::vector<size_t> counts(num_models, 0);
+
+    run_in_parallel(thread_count, [&](const size_t thread_id) {
+      for (size_t m = thread_id; m < num_models; m += thread_count) {
+        LinearModel &model = models_[m];
+        fit_linear(model.begin_, model.end_, 1.0, model.slope_, model.intercept_);
+
+        for (size_t i = model.begin_; i < model.end_; ++i) {
+          if (i > model.begin_ && this->key_at(i) == this->key_at(i - 1)) { continue; }
+          int64_t error = int64_t(i) - int64_t(model.intercept_ + model.slope_ * to_x(this->key_at(i)));
+          model.min_error_ = std::min(model.min_error_, error);
+          model.max_error_ = std::max(model.max_error_, error);
+          abs_errors[m] += std::abs(error);
+          counts[m] += 1;
+        }
+      }
+    });
+
+    max_error_ = 0;
+    double total_error = 0;
+    size_t total_count = 0;
+    for (size_t m = 0; m < num_models; ++m) {
+      max_error_ = std::max(max_error_, std::max(-models_[m].min_error_, models_[m].max_error_));
+      total_error += abs_errors[m];
+      total_count += counts[m];
+    }
+    avg_error_ = total_error / total_count;
+  }
+
+  // first position whose key is routed to leaf model m or above.
+  size_t rmi_partition_begin(const size_t m) const {
+    if (m == 0) {
+      return 0;
+    }
+    if (m >= models_.size()) {
+      return this->size_;
+    }
+    size_t lo = 0;
+    size_t hi = this->size_;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (rmi_model_id(this->key_at(mid)) < m) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  /////////////////////////////////////////////////////////////////////
+  // PGM
+  /////////////////////////////////////////////////////////////////////
+
+  // levels are built bottom-up. segmentation is a sequential greedy pass.
+  void train_pgm() {
+
+    levels_.clear();
+    levels_.push_back(Level());
+    build_level(data_key_func(), this->size_, levels_.back());
+
+    double total_error = 0;
+    size_t total_count = 0;
+    max_error_ = measure_level(data_key_func(), this->size_, levels_.back(), total_error, total_count);
+    avg_error_ = total_error / total_count;
+
+    while (levels_.back().segments_.size() > 1) {
+      Level level;
+      SegmentKeyFunc key_of(levels_.back().segments_);
+      double level_error = 0;
+      size_t level_count = 0;
+      build_level(key_of, levels_.back().segments_.size(), level);
+      measure_level(key_of, levels_.back().segments_.size(), level, level_error, level_count);
+      levels_.push_back(level);
+    }
+  }
+
+  // shrinking cone: extend the current segment as long as there is a slope that
+  // keeps all of its keys within epsilon.
+  template<typename KeyFunc>
+  void build_level(const KeyFunc &key_of, const size_t count, Level &level) const {
+
+    const double epsilon = double(model_param_);
+
+    Segment segment;
+    double slope_lo = 0;
+    double slope_hi = std::numeric_limits<double>::infinity();
+
+    for (size_t i = 0; i < count; ++i) {
+      if (i > 0 && key_of(i) == key_of(i - 1)) { continue; }
+
+      if (i == 0) {
+        segment.key_ = key_of(i);
+        segment.pos_ = i;
+        continue;
+      }
+
+      double dx = double(key_of(i)) - double(segment.key_);
+      double dy = double(i - segment.pos_);
+
+      double new_lo = slope_lo;
+      double new_hi = slope_hi;
+      if (dx > 0) {
+        new_lo = std::max(slope_lo, (dy - epsilon) / dx);
+        new_hi = std::min(slope_hi, (dy + epsilon) / dx);
+      }
+
+      if ((dx > 0 && new_lo <= new_hi) || (dx == 0 && dy <= epsilon)) {
+        slope_lo = new_lo;
+        slope_hi = new_hi;
+        continue;
+      }
+
+      segment.slope_ = (slope_hi == std::numeric_limits<double>::infinity()) ? slope_lo : (slope_lo + slope_hi) / 2;
+      level.segments_.push_back(segment);
+
+      segment.key_ = key_of(i);
+      segment.pos_ = i;
+      slope_lo = 0;
+      slope_hi = std::numeric_limits<double>::infinity();
+    }
+
+    segment.slope_ = (slope_hi == std::numeric_limits<double>::infinity()) ? slope_lo : (slope_lo + slope_hi) / 2;
+    level.segments_.push_back(segment);
+  }
+
+  // the error bound of a level is measured rather than taken from epsilon, so that
+  // floating point rounding can never exclude a key from its window.
+  template<typename KeyFunc>
+  int64_t measure_level(const KeyFunc &key_of, const size_t count, Level &level, double &total_error, size_t &total_count) const {
+
+    level.max_error_ = 0;
+
+    for (size_t s = 0; s < level.segments_.size(); ++s) {
+      const Segment &segment = level.segments_[s];
+      size_t end = (s + 1 < level.segments_.size()) ? level.segments_[s + 1].pos_ : count;
+
+      for (size_t i = segment.pos_; i < end; ++i) {
+        if (i > segment.pos_ && key_of(i) == key_of(i - 1)) { continue; }
+        int64_t pos = int64_t(segment.pos_) + int64_t(segment.slope_ * (double(key_of(i)) - double(segment.key_)));
+        int64_t error = std::abs(int64_t(i) - pos);
+        level.max_error_ = std::max(level.max_error_, error);
+        total_error += error;
+        total_count += 1;
+      }
+    }
+    return level.max_error_;
+  }
+
+private:
+
+  LearnedModelType model_type_;
+  size_t model_param_;
+
+  KeyT key_min_;
+  KeyT key_max_;
+
+  // RMI
+  double root_slope_;
+  double root_intercept_;
+  std::vector<LinearModel> models_;
+
+  // PGM. levels_[0] indexes the container, and levels_[l] indexes the segments of levels_[l - 1].
+  std::vector<Level> levels_;
+
+  // statistics of the bottom level.
+  int64_t max_error_;
+  double avg_error_;
+};
+
+}
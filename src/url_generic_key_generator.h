@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fast_random.h"
+#include "access_distribution.h"
+
+#include "base_generic_key_generator.h"
+
+// urls with a scheme, a host from a pool of HOST_COUNT hosts and a path of common segments,
+// ending in a page name or a numeric id. hosts and segments are picked with a zipf skew, so
+// keys share long prefixes like crawled urls do. key lengths are log-normal around
+// mean_key_size: path segments are added until a key reaches its length.
+class UrlGenericKeyGenerator : public BaseGenericKeyGenerator {
+
+  static const size_t HOST_COUNT = 4096;
+  static const size_t SEGMENT_COUNT = 48;
+
+  // every thread builds the same host pool.
+  static const uint64_t HOST_SEED = 0x75726c;
+
+public:
+
+  UrlGenericKeyGenerator(const uint64_t thread_id, const size_t max_key_size, const size_t mean_key_size) :
+    fast_rand_(thread_id), max_key_size_(max_key_size),
+    host_distribution_(AccessType::ZipfianAccessType, HOST_COUNT),
+    segment_distribution_(AccessType::ZipfianAccessType, SEGMENT_COUNT),
+    size_gen_(thread_id), size_dist_(std::log(mean_key_size), 0.3) {
+
+    build_hosts();
+  }
+
+  virtual ~UrlGenericKeyGenerator() {}
+
+  virtual void get_next_key(GenericKey &key) final {
+    static const char* segments[SEGMENT_COUNT] = {
+      "en", "us", "api", "v1", "v2", "blog", "news", "products",
+      "category", "item", "users", "profile", "search", "images", "static", "assets",
+      "docs", "help", "about", "posts", "articles", "tags", "archive", "2019",
+      "2020", "2021", "2022", "2023", "shop", "cart", "account", "settings",
+      "media", "video", "watch", "wiki", "forum", "threads", "download", "files",
+      "events", "sports", "tech", "world", "business", "health", "travel", "food" };
+    static const char* pages[] = { "index.html", "index.php", "default.aspx", "view", "details", "page" };
+
+    size_t target_size = std::min<size_t>(max_key_size_, size_t(size_dist_(size_gen_)));
+
+    // the last segment tells pages apart.
+    page_.clear();
+    page_ += '/';
+    if (fast_rand_.next<uint64_t>() % 2 == 0) {
+      page_ += std::to_string(fast_rand_.next<uint64_t>() % 100000000);
+    } else {
+      page_ += pages[fast_rand_.next<uint64_t>() % (sizeof(pages) / sizeof(pages[0]))];
+      page_ += "?id=";
+      page_ += std::to_string(fast_rand_.next<uint64_t>() % 1000000);
+    }
+
+    buffer_.clear();
+    buffer_ += (fast_rand_.next<uint64_t>() % 5 == 0) ? "http://" : "https://";
+    buffer_ += hosts_[host_distribution_.next(fast_rand_)];
+
+    // every depth has its own popular segments.
+    for (size_t depth = 0; buffer_.size() + page_.size() < target_size; ++depth) {
+      buffer_ += '/';
+      buffer_ += segments[(segment_distribution_.next(fast_rand_) + depth * 11) % SEGMENT_COUNT];
+    }
+
+    buffer_ += page_;
+
+    key.assign(buffer_.data(), std::min(buffer_.size(), max_key_size_));
+  }
+
+private:
+  // hosts like www.kalomira.com: a subdomain, two or three syllables and a top-level domain.
+  void build_hosts() {
+    static const char* subdomains[] = { "www.", "www.", "www.", "m.", "blog.", "shop.", "api.", "news.", "" };
+    static const char* syllables[] = {
+      "ka", "lo", "mi", "ra", "ne", "to", "su", "vi", "da", "pe", "go", "ba",
+      "ri", "no", "sa", "te", "fa", "zu", "me", "li", "co", "net", "web", "hub" };
+    static const char* tlds[] = { ".com", ".com", ".com", ".org", ".net", ".de", ".io", ".co.uk", ".fr", ".jp" };
+
+    FastRandom host_rand(HOST_SEED);
+    hosts_.resize(HOST_COUNT);
+    for (auto &host : hosts_) {
+      host = subdomains[host_rand.next<uint64_t>() % (sizeof(subdomains) / sizeof(subdomains[0]))];
+      size_t syllable_count = 2 + host_rand.next<uint64_t>() % 2;
+      for (size_t i = 0; i < syllable_count; ++i) {
+        host += syllables[host_rand.next<uint64_t>() % (sizeof(syllables) / sizeof(syllables[0]))];
+      }
+      host += tlds[host_rand.next<uint64_t>() % (sizeof(tlds) / sizeof(tlds[0]))];
+    }
+  }
+
+private:
+  FastRandom fast_rand_;
+  size_t max_key_size_;
+
+  std::vector<std::string> hosts_;
+
+  AccessDistribution host_distribution_;
+  AccessDistribution segment_distribution_;
+
+  std::default_random_engine size_gen_;
+  std::lognormal_distribution<double> size_dist_;
+
+  std::string buffer_;
+  std::string page_;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "fast_random.h"
+#include "access_distribution.h"
+
+#include "base_generic_key_generator.h"
+
+// usernames built like real ones: a popular name or word, often followed by a surname or a
+// second word, and padded with digits. popular names are shared by many keys, so keys share
+// prefixes the way usernames do. key lengths are log-normal around mean_key_size.
+class UsernameGenericKeyGenerator : public BaseGenericKeyGenerator {
+
+  static const size_t NAME_COUNT = 48;
+  static const size_t SURNAME_COUNT = 32;
+  static const size_t WORD_COUNT = 32;
+
+public:
+
+  UsernameGenericKeyGenerator(const uint64_t thread_id, const size_t max_key_size, const size_t mean_key_size) :
+    fast_rand_(thread_id), max_key_size_(max_key_size),
+    name_distribution_(AccessType::ZipfianAccessType, NAME_COUNT),
+    surname_distribution_(AccessType::ZipfianAccessType, SURNAME_COUNT),
+    word_distribution_(AccessType::ZipfianAccessType, WORD_COUNT),
+    size_gen_(thread_id), size_dist_(std::log(mean_key_size), 0.3) {}
+
+  virtual ~UsernameGenericKeyGenerator() {}
+
+  virtual void get_next_key(GenericKey &key) final {
+    static const char* names[NAME_COUNT] = {
+      "james", "mary", "john", "patricia", "robert", "jennifer", "michael", "linda",
+      "william", "elizabeth", "david", "barbara", "richard", "susan", "joseph", "jessica",
+      "thomas", "sarah", "charles", "karen", "chris", "nancy", "daniel", "lisa",
+      "matthew", "betty", "anthony", "margaret", "mark", "sandra", "paul", "ashley",
+      "steven", "emily", "andrew", "donna", "kevin", "michelle", "brian", "carol",
+      "george", "amanda", "edward", "melissa", "ronald", "deborah", "tim", "anna" };
+    static const char* surnames[SURNAME_COUNT] = {
+      "smith", "johnson", "williams", "brown", "jones", "garcia", "miller", "davis",
+      "rodriguez", "martinez", "hernandez", "lopez", "gonzalez", "wilson", "anderson", "thomas",
+      "taylor", "moore", "jackson", "martin", "lee", "perez", "thompson", "white",
+      "harris", "sanchez", "clark", "ramirez", "lewis", "robinson", "walker", "young" };
+    static const char* words[WORD_COUNT] = {
+      "the", "dark", "cool", "super", "mr", "real", "little", "big",
+      "shadow", "dragon", "star", "ninja", "wolf", "pixel", "gamer", "sky",
+      "fire", "ice", "storm", "night", "king", "queen", "lucky", "happy",
+      "crazy", "silent", "red", "blue", "golden", "iron", "cyber", "music" };
+    static const char separators[] = { '.', '_', '-' };
+
+    size_t target_size = std::min<size_t>(max_key_size_, std::max<size_t>(1, size_t(size_dist_(size_gen_))));
+
+    buffer_.clear();
+
+    uint64_t pattern = fast_rand_.next<uint64_t>() % 10;
+    if (pattern < 4) {
+      // name and surname: john.smith
+      buffer_ += names[name_distribution_.next(fast_rand_)];
+      if (fast_rand_.next<uint64_t>() % 2 == 0) {
+        buffer_ += separators[fast_rand_.next<uint64_t>() % sizeof(separators)];
+      }
+      buffer_ += surnames[surname_distribution_.next(fast_rand_)];
+    } else if (pattern < 7) {
+      // name and digits: mary1987
+      buffer_ += names[name_distribution_.next(fast_rand_)];
+    } else {
+      // words: darkwolf42
+      buffer_ += words[word_distribution_.next(fast_rand_)];
+      buffer_ += words[word_distribution_.next(fast_rand_)];
+    }
+
+    // pad with digits, at least one in every other key.
+    if (buffer_.size() >= target_size && fast_rand_.next<uint64_t>() % 2 == 0) {
+      buffer_ += char('0' + fast_rand_.next<uint64_t>() % 10);
+    }
+    while (buffer_.size() < target_size) {
+      buffer_ += char('0' + fast_rand_.next<uint64_t>() % 10);
+    }
+
+    key.assign(buffer_.data(), std::min(buffer_.size(), max_key_size_));
+  }
+
+private:
+  FastRandom fast_rand_;
+  size_t max_key_size_;
+
+  AccessDistribution name_distribution_;
+  AccessDistribution surname_distribution_;
+  AccessDistribution word_distribution_;
+
+  std::default_random_engine size_gen_;
+  std::lognormal_distribution<double> size_dist_;
+
+  std::string buffer_;
+};
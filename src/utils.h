@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <csignal>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 typedef uint16_t Uint16;
 typedef uint32_t Uint32;
@@ -11,6 +13,14 @@ typedef uint64_t Uint64;
 
 #define COMPILER_MEMORY_FENCE asm volatile("" ::: "memory")
 
+#define PREFETCH(addr) __builtin_prefetch((const void*)(addr), 0, 3)
+
+// number of probes that a batched lookup keeps in flight at the same time.
+static const size_t FIND_BATCH_GROUP_SIZE = 32;
+
+// number of entries that a batched bulk load inserts per step, e.g. within one epoch.
+static const size_t BULK_LOAD_GROUP_SIZE = 1024;
+
 static double get_memory_mb() {
   uint64_t epoch = 1;
   size_t sz = sizeof(epoch);
@@ -49,6 +59,23 @@ static void pin_to_core(const size_t core) {
   #endif
 }
 
+// run func(thread_id) on thread_count threads, including the calling thread, and wait for all of them.
+template<typename Func>
+static void run_in_parallel(const size_t thread_count, Func func) {
+  if (thread_count <= 1) {
+    func(0);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 1; thread_id < thread_count; ++thread_id) {
+    threads.emplace_back(func, thread_id);
+  }
+  func(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
 template<typename KeyT>
 static KeyT byte_swap(KeyT x);
 
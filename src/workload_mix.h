@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "fast_random.h"
+#include "access_distribution.h"
+#include "latency_histogram.h"
+
+static const uint64_t DEFAULT_SCAN_LENGTH = 100;
+
+// the share of each operation type in a workload, e.g. 95% lookups and 5% inserts.
+// a mix is given either as a ycsb core workload, a to f, or as a list of shares:
+//   lookup=0.5,update=0.5
+// with the types lookup (or read), insert, scan, update, rmw and delete.
+class WorkloadMix {
+
+public:
+  WorkloadMix() : preset_access_type_(AccessType::UniformAccessType) {
+    for (size_t i = 0; i < OPERATION_TYPE_COUNT; ++i) {
+      thresholds_[i] = 0;
+    }
+  }
+
+  // returns false and describes the problem if the mix is malformed.
+  bool parse(const std::string &spec, std::string &error) {
+    double shares[OPERATION_TYPE_COUNT] = { 0 };
+
+    if (spec.size() == 1) {
+      if (!parse_preset(spec[0], shares)) {
+        error = "unknown ycsb workload: " + spec;
+        return false;
+      }
+    } else {
+      std::stringstream stream(spec);
+      std::string entry;
+      while (std::getline(stream, entry, ',')) {
+        size_t pos = entry.find('=');
+        OperationType type;
+        if (pos == std::string::npos || !parse_operation_name(entry.substr(0, pos), type)) {
+          error = "malformed mix entry: " + entry;
+          return false;
+        }
+        double share = atof(entry.substr(pos + 1).c_str());
+        if (share < 0) {
+          error = "negative share: " + entry;
+          return false;
+        }
+        shares[size_t(type)] += share;
+      }
+    }
+
+    double total = 0;
+    for (size_t i = 0; i < OPERATION_TYPE_COUNT; ++i) {
+      total += shares[i];
+    }
+    if (total < 0.999 || total > 1.001) {
+      error = "shares do not add up to 1: " + spec;
+      return false;
+    }
+
+    double sum = 0;
+    size_t last_type = 0;
+    for (size_t i = 0; i < OPERATION_TYPE_COUNT; ++i) {
+      sum += shares[i] / total;
+      thresholds_[i] = sum;
+      if (shares[i] > 0) {
+        last_type = i;
+      }
+    }
+    // the last type with a share catches rounding.
+    for (size_t i = last_type; i < OPERATION_TYPE_COUNT; ++i) {
+      thresholds_[i] = 2.0;
+    }
+    return true;
+  }
+
+  inline OperationType next(FastRandom &rand_gen) const {
+    double next_rand = rand_gen.next_uniform();
+    size_t type = 0;
+    while (next_rand >= thresholds_[type]) {
+      ++type;
+    }
+    return OperationType(type);
+  }
+
+  inline double share(const OperationType type) const {
+    size_t i = size_t(type);
+    return std::min(thresholds_[i], 1.0) - (i == 0 ? 0 : std::min(thresholds_[i - 1], 1.0));
+  }
+
+  // the request distribution of the ycsb workload, or uniform for custom mixes.
+  inline AccessType preset_access_type() const { return preset_access_type_; }
+
+  void print() const {
+    for (size_t i = 0; i < OPERATION_TYPE_COUNT; ++i) {
+      double type_share = share(OperationType(i));
+      if (type_share > 1e-6) {
+        std::cout << " " << get_operation_name(OperationType(i)) << "=" << type_share;
+      }
+    }
+  }
+
+private:
+  bool parse_preset(const char name, double *shares) {
+    preset_access_type_ = AccessType::ZipfianAccessType;
+    switch (name) {
+      case 'a': case 'A':
+        // update heavy
+        shares[size_t(OperationType::LookupOpType)] = 0.5;
+        shares[size_t(OperationType::UpdateOpType)] = 0.5;
+        return true;
+      case 'b': case 'B':
+        // read mostly
+        shares[size_t(OperationType::LookupOpType)] = 0.95;
+        shares[size_t(OperationType::UpdateOpType)] = 0.05;
+        return true;
+      case 'c': case 'C':
+        // read only
+        shares[size_t(OperationType::LookupOpType)] = 1.0;
+        return true;
+      case 'd': case 'D':
+        // read latest
+        shares[size_t(OperationType::LookupOpType)] = 0.95;
+        shares[size_t(OperationType::InsertOpType)] = 0.05;
+        preset_access_type_ = AccessType::LatestAccessType;
+        return true;
+      case 'e': case 'E':
+        // short ranges
+        shares[size_t(OperationType::ScanOpType)] = 0.95;
+        shares[size_t(OperationType::InsertOpType)] = 0.05;
+        return true;
+      case 'f': case 'F':
+        // read-modify-write
+        shares[size_t(OperationType::LookupOpType)] = 0.5;
+        shares[size_t(OperationType::ReadModifyWriteOpType)] = 0.5;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  static bool parse_operation_name(const std::string &name, OperationType &type) {
+    if (name == "read") {
+      type = OperationType::LookupOpType;
+      return true;
+    }
+    for (size_t i = 0; i < OPERATION_TYPE_COUNT; ++i) {
+      if (name == get_operation_name(OperationType(i))) {
+        type = OperationType(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  // thresholds_[i] is the share of the types up to and including i.
+  double thresholds_[OPERATION_TYPE_COUNT];
+  AccessType preset_access_type_;
+};
+
+// the ranks of the first and the last key of a scan, among item_count keys in key order.
+// a scan reads up to scan_length keys, from a key picked by the access distribution. a
+// reverse scan ends at the picked key. the latest keys are the largest ones, which holds for
+// sequential keys.
+static inline void pick_scan_range(const AccessDistribution *distribution, FastRandom &rand_gen, const uint64_t scan_length, const bool reverse, uint64_t &lhs_rank, uint64_t &rhs_rank) {
+  uint64_t item_count = distribution->item_count();
+  uint64_t rank = distribution->next(rand_gen);
+  if (distribution->access_type() == AccessType::LatestAccessType) {
+    rank = item_count - 1 - rank;
+  }
+  uint64_t length = 1 + rand_gen.next<uint64_t>() % scan_length;
+
+  if (reverse) {
+    lhs_rank = rank + 1 >= length ? rank + 1 - length : 0;
+    rhs_rank = rank;
+  } else {
+    lhs_rank = rank;
+    rhs_rank = std::min(rank + length - 1, item_count - 1);
+  }
+}
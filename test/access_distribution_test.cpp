@@ -0,0 +1,85 @@
+#include <cmath>
+#include <vector>
+
+#include "access_distribution.h"
+
+#include "harness.h"
+
+
+class AccessDistributionTest : public IndexZooTest {};
+
+std::vector<uint64_t> count_accesses(const AccessDistribution &distribution, const size_t draw_count) {
+  FastRandom rand_gen(0);
+  std::vector<uint64_t> counts(distribution.item_count(), 0);
+  for (size_t i = 0; i < draw_count; ++i) {
+    uint64_t item = distribution.next(rand_gen);
+    EXPECT_LT(item, distribution.item_count());
+    ++counts[item];
+  }
+  return counts;
+}
+
+// the most recent items are drawn with zipf frequencies: rank r with weight 1 / (r + 1)^theta.
+TEST_F(AccessDistributionTest, ZipfianTest) {
+  const uint64_t item_count = 1000;
+  const size_t draw_count = 1000000;
+  const double theta = 0.99;
+
+  double zeta_n = 0;
+  for (uint64_t i = 1; i <= item_count; ++i) {
+    zeta_n += 1.0 / std::pow(i, theta);
+  }
+
+  AccessDistribution latest(AccessType::LatestAccessType, item_count, theta);
+  std::vector<uint64_t> counts = count_accesses(latest, draw_count);
+  for (uint64_t rank = 0; rank < 2; ++rank) {
+    double expected = draw_count / std::pow(rank + 1, theta) / zeta_n;
+    EXPECT_NEAR(counts[rank], expected, expected * 0.05);
+  }
+  EXPECT_GT(counts[2], counts[100]);
+
+  // scrambling moves the hot items, but keeps the skew.
+  AccessDistribution zipfian(AccessType::ZipfianAccessType, item_count, theta);
+  counts = count_accesses(zipfian, draw_count);
+  uint64_t max_count = 0;
+  for (auto count : counts) {
+    max_count = std::max(max_count, count);
+  }
+  EXPECT_GT(max_count, draw_count / zeta_n * 0.95);
+}
+
+TEST_F(AccessDistributionTest, HotspotTest) {
+  const uint64_t item_count = 1000;
+  const size_t draw_count = 1000000;
+
+  AccessDistribution hotspot(AccessType::HotspotAccessType, item_count, DEFAULT_ZIPF_THETA, 0.8, 0.2);
+  std::vector<uint64_t> counts = count_accesses(hotspot, draw_count);
+
+  uint64_t hot_count = 0;
+  for (uint64_t i = 0; i < 200; ++i) {
+    hot_count += counts[i];
+  }
+  EXPECT_NEAR(hot_count, draw_count * 0.8, draw_count * 0.01);
+}
+
+TEST_F(AccessDistributionTest, LatestKeyPickerTest) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    keys.push_back(i);
+  }
+
+  AccessDistribution latest(AccessType::LatestAccessType, keys.size());
+  AccessKeyPicker<uint64_t> picker(&latest, keys.data(), 0);
+
+  // keys inserted later are newer than all initial keys.
+  picker.inserted(5000);
+  picker.inserted(6000);
+
+  size_t newest_count = 0;
+  for (size_t i = 0; i < 10000; ++i) {
+    uint64_t key = picker.next();
+    EXPECT_TRUE(key < 1000 || key == 5000 || key == 6000);
+    newest_count += (key == 6000);
+  }
+  EXPECT_GT(newest_count, 10000 / 10);
+}
@@ -1,4 +1,6 @@
 #include <map>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -14,7 +16,7 @@ class DataTableTest : public IndexZooTest {};
 
 
 template<typename KeyT>
-void data_table_numeric_test() {
+void data_table_numeric_test(BlockAllocator *allocator) {
   // size_t n = 54321;
   size_t n = 1000;
 
@@ -22,7 +24,7 @@ void data_table_numeric_test() {
   std::vector<std::pair<KeyT, uint64_t>> test_vector;
 
   std::unique_ptr<DataTable<KeyT, uint64_t>> data_table(
-    new DataTable<KeyT, uint64_t>());
+    new DataTable<KeyT, uint64_t>(MaxBlockCapacity, allocator));
 
   // insert
   for (size_t i = 0; i < n; ++i) {
@@ -51,9 +53,16 @@ void data_table_numeric_test() {
 }
 
 TEST_F(DataTableTest, NumericTest) {
-  data_table_numeric_test<uint16_t>();
-  data_table_numeric_test<uint32_t>();
-  data_table_numeric_test<uint64_t>();
+  data_table_numeric_test<uint16_t>(HeapBlockAllocator::get_instance());
+  data_table_numeric_test<uint32_t>(HeapBlockAllocator::get_instance());
+  data_table_numeric_test<uint64_t>(HeapBlockAllocator::get_instance());
+
+  // blocks carved from huge-page arenas.
+  for (int type = 1; type <= 2; ++type) {
+    std::unique_ptr<BlockAllocator> allocator(create_block_allocator((BlockAllocatorType)type));
+    data_table_numeric_test<uint16_t>(allocator.get());
+    data_table_numeric_test<uint64_t>(allocator.get());
+  }
 }
 
 
@@ -105,3 +114,110 @@ void data_table_generic_test(const uint64_t max_key_size) {
 TEST_F(DataTableTest, GenericTest) {
   data_table_generic_test(16);
 }
+
+
+// records take the space of their own key, and keep the key size.
+void data_table_generic_variable_length_test(const uint64_t max_key_size) {
+  size_t n = 5000;
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t), 16));
+
+  FastRandom fast_rand(0);
+
+  std::vector<std::string> keys;
+  std::vector<Uint64> offsets;
+
+  for (size_t i = 0; i < n; ++i) {
+    std::string key(fast_rand.next<uint64_t>() % max_key_size + 1, 'a');
+    fast_rand.next_readable_chars(key.size(), &key[0]);
+    uint64_t value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key.c_str(), key.size(), (char*)(&value), sizeof(uint64_t));
+
+    keys.push_back(key);
+    offsets.push_back(offset.raw_data());
+  }
+
+  EXPECT_EQ(data_table->size(), n);
+
+  for (size_t i = 0; i < n; ++i) {
+    OffsetT offset(offsets.at(i));
+    EXPECT_EQ(data_table->get_tuple_key_size(offset), keys.at(i).size());
+    EXPECT_EQ(std::string(data_table->get_tuple_key(offset), keys.at(i).size()), keys.at(i));
+    EXPECT_EQ(*(uint64_t*)(data_table->get_tuple_value(offset)), i + 2048);
+  }
+
+  size_t i = 0;
+  GenericDataTableIterator iterator(data_table.get());
+  while (iterator.has_next()) {
+    auto entry = iterator.next();
+    ASSERT_LT(i, n);
+    EXPECT_EQ(entry.offset_, offsets.at(i));
+    EXPECT_EQ(std::string(entry.key_, keys.at(i).size()), keys.at(i));
+    ++i;
+  }
+  EXPECT_EQ(i, n);
+}
+
+TEST_F(DataTableTest, GenericVariableLengthTest) {
+  data_table_generic_variable_length_test(8);
+  data_table_generic_variable_length_test(255);
+}
+
+
+// concurrent writers must receive distinct offsets, and every tuple must be readable
+// once the writers are done.
+void data_table_concurrent_test(const size_t thread_count, const bool per_thread_blocks) {
+  size_t n = 20000;
+
+  std::unique_ptr<DataTable<uint64_t, uint64_t>> data_table(
+    new DataTable<uint64_t, uint64_t>(64));
+
+  if (per_thread_blocks) {
+    data_table->prepare_threads(thread_count);
+  }
+
+  std::vector<std::vector<Uint64>> offsets(thread_count);
+
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_count; ++thread_id) {
+    threads.push_back(std::thread([&, thread_id]() {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t key = thread_id * n + i;
+        offsets[thread_id].push_back(data_table->insert_tuple(key, key + 2048, per_thread_blocks ? thread_id : 0).raw_data());
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(data_table->size(), n * thread_count);
+
+  std::unordered_map<Uint64, uint64_t> offset_map;
+  for (size_t thread_id = 0; thread_id < thread_count; ++thread_id) {
+    for (size_t i = 0; i < n; ++i) {
+      Uint64 offset = offsets[thread_id][i];
+      EXPECT_EQ(*(data_table->get_tuple_key(OffsetT(offset))), thread_id * n + i);
+      EXPECT_EQ(*(data_table->get_tuple_value(OffsetT(offset))), thread_id * n + i + 2048);
+      offset_map[offset] = thread_id * n + i;
+    }
+  }
+  EXPECT_EQ(offset_map.size(), n * thread_count);
+
+  size_t count = 0;
+  DataTableIterator<uint64_t, uint64_t> iterator(data_table.get());
+  while (iterator.has_next()) {
+    auto entry = iterator.next();
+    EXPECT_EQ(offset_map.at(entry.offset_), *(entry.key_));
+    ++count;
+  }
+  EXPECT_EQ(count, n * thread_count);
+}
+
+TEST_F(DataTableTest, ConcurrentTest) {
+  data_table_concurrent_test(1, false);
+  data_table_concurrent_test(4, false);
+  data_table_concurrent_test(4, true);
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
@@ -77,7 +78,8 @@ TEST_F(DynamicIndexGenericTest, UniqueKeyFindTest) {
     // dynamic indexes - singlethread
     IndexType::D_ST_StxBtree,
     IndexType::D_ST_ArtTree,
-    // IndexType::D_ST_SdTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
     
     // dynamic indexes - multithread
     IndexType::D_MT_Libcuckoo,
@@ -166,6 +168,8 @@ TEST_F(DynamicIndexGenericTest, NonUniqueKeyFindTest) {
     // dynamic indexes - singlethread
     IndexType::D_ST_StxBtree,
     IndexType::D_ST_ArtTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
     
     // dynamic indexes - multithread
     IndexType::D_MT_Libcuckoo,
@@ -241,6 +245,13 @@ void test_dynamic_index_generic_unique_key_find_range(const uint64_t max_key_siz
       real_offsets.push_back(iter->second.first);
     }
 
+    // a visitor receives the offsets of the range in the order of the vector.
+    std::vector<Uint64> visited;
+    auto visitor = make_visitor_sink([&visited](const Uint64 &offset) { visited.push_back(offset); });
+    data_index->find_range(lower_key, upper_key, visitor);
+
+    EXPECT_EQ(visited, offsets);
+
     EXPECT_EQ(real_offsets.size(), offsets.size());
 
     if (real_offsets.size() == offsets.size()) {
@@ -262,12 +273,14 @@ TEST_F(DynamicIndexGenericTest, UniqueKeyFindRangeTest) {
     // dynamic indexes - singlethread
     IndexType::D_ST_StxBtree,
     // IndexType::D_ST_ArtTree, // do not fully support range queries
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
     
     // dynamic indexes - multithread
     // IndexType::D_MT_Libcuckoo, // do not support range queries
     IndexType::D_MT_ArtTree,
     IndexType::D_MT_BwTree,
-    // IndexType::D_MT_Masstree, // do not support range queries
+    IndexType::D_MT_Masstree,
   };
 
   for (auto index_type : index_types) {
@@ -367,6 +380,8 @@ TEST_F(DynamicIndexGenericTest, NonUniqueKeyFindRangeTest) {
     // dynamic indexes - singlethread
     IndexType::D_ST_StxBtree,
     // IndexType::D_ST_ArtTree, // do not support non-unique keys
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
     
     // dynamic indexes - multithread
     // IndexType::D_MT_Libcuckoo, // do not support range queries
@@ -442,6 +457,8 @@ TEST_F(DynamicIndexGenericTest, ScanTest) {
   std::vector<IndexType> index_types {
     IndexType::D_ST_StxBtree,
     IndexType::D_ST_ArtTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
   };
 
   for (auto index_type : index_types) {
@@ -452,3 +469,611 @@ TEST_F(DynamicIndexGenericTest, ScanTest) {
 }
 
 
+
+
+void test_dynamic_index_generic_find_batch(const uint64_t max_key_size, const IndexType index_type) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+  
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t)));
+  std::unique_ptr<BaseGenericIndex> data_index(
+    create_generic_index(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::map<GenericKey, std::unordered_set<Uint64>> validation_set;
+  
+  // the second half of the keys is never inserted
+  std::vector<GenericKey> unique_keys;
+
+  size_t key_size = max_key_size;
+  
+  GenericKey key(key_size);
+  
+  for (size_t i = 0; i < m * 2; ++i) {
+    rand_gen.next_readable_chars(key_size, key.raw());
+    unique_keys.push_back(key);
+  }
+
+  // insert
+  for (size_t i = 0; i < n; ++i) {
+
+    uint64_t key_id = rand_gen.next<uint64_t>() % m;
+    GenericKey key = unique_keys.at(key_id);
+
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(uint64_t));
+    
+    validation_set[key].insert(offset.raw_data());
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // find
+  size_t batch_size = 100;
+  std::vector<GenericKey> keys(batch_size);
+  std::vector<std::vector<Uint64>> batch_offsets(batch_size);
+
+  for (size_t round = 0; round < 20; ++round) {
+    for (size_t i = 0; i < batch_size; ++i) {
+      keys[i] = unique_keys.at(rand_gen.next<uint64_t>() % (m * 2));
+      batch_offsets[i].clear();
+    }
+
+    data_index->find_batch(keys.data(), batch_size, batch_offsets.data());
+
+    for (size_t i = 0; i < batch_size; ++i) {
+      auto entry = validation_set.find(keys[i]);
+      if (entry == validation_set.end()) {
+        EXPECT_EQ(batch_offsets[i].size(), 0);
+        continue;
+      }
+      EXPECT_EQ(batch_offsets[i].size(), entry->second.size());
+
+      for (auto offset : batch_offsets[i]) {
+        EXPECT_NE(entry->second.end(), entry->second.find(offset));
+      }
+    }
+  }
+}
+
+
+TEST_F(DynamicIndexGenericTest, FindBatchTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
+    
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    // IndexType::D_MT_Masstree, // do not support non-unique keys
+  };
+
+  for (auto index_type : index_types) {
+    test_dynamic_index_generic_find_batch(32, index_type);
+
+    test_dynamic_index_generic_find_batch(64, index_type);
+  }
+}
+
+
+void test_dynamic_index_generic_erase(const uint64_t max_key_size, const IndexType index_type) {
+
+  size_t n = 20000;
+  size_t m = 5000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t)));
+  std::unique_ptr<BaseGenericIndex> data_index(
+    create_generic_index(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::map<GenericKey, std::unordered_set<Uint64>> validation_set;
+
+  // variable-length keys that share a common prefix
+  std::vector<GenericKey> unique_keys;
+  std::string prefix = "http://";
+
+  for (size_t i = 0; i < m; ++i) {
+    size_t key_size = prefix.size() + 1 + rand_gen.next<uint64_t>() % (max_key_size - prefix.size());
+    GenericKey key(key_size);
+    memcpy(key.raw(), prefix.data(), prefix.size());
+    rand_gen.next_readable_chars(key_size - prefix.size(), key.raw() + prefix.size());
+    unique_keys.push_back(key);
+  }
+
+  // insert
+  for (size_t i = 0; i < n; ++i) {
+
+    GenericKey &key = unique_keys.at(rand_gen.next<uint64_t>() % m);
+
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(uint64_t));
+
+    validation_set[key].insert(offset.raw_data());
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // erase every other key
+  size_t erased_count = 0;
+  for (size_t i = 0; i < m; i += 2) {
+    auto entry = validation_set.find(unique_keys.at(i));
+    if (entry != validation_set.end()) {
+      erased_count += entry->second.size();
+      validation_set.erase(entry);
+    }
+    data_index->erase(unique_keys.at(i));
+  }
+
+  EXPECT_EQ(data_index->size(), n - erased_count);
+
+  // find
+  for (auto &key : unique_keys) {
+    std::vector<Uint64> offsets;
+    data_index->find(key, offsets);
+
+    auto entry = validation_set.find(key);
+    if (entry == validation_set.end()) {
+      EXPECT_EQ(offsets.size(), 0);
+      continue;
+    }
+    EXPECT_EQ(offsets.size(), entry->second.size());
+
+    for (auto offset : offsets) {
+      EXPECT_NE(entry->second.end(), entry->second.find(offset));
+    }
+  }
+
+  // scan full
+  std::vector<Uint64> offsets;
+  data_index->scan_full(offsets);
+
+  EXPECT_EQ(offsets.size(), n - erased_count);
+}
+
+
+TEST_F(DynamicIndexGenericTest, EraseTest) {
+
+  std::vector<IndexType> index_types {
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
+  };
+
+  for (auto index_type : index_types) {
+    test_dynamic_index_generic_erase(32, index_type);
+
+    test_dynamic_index_generic_erase(64, index_type);
+  }
+}
+
+
+void test_dynamic_index_generic_erase_entry(const uint64_t max_key_size, const IndexType index_type, const bool unique_key) {
+
+  size_t n = 10000;
+  size_t m = unique_key ? n : 1000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t)));
+  std::unique_ptr<BaseGenericIndex> data_index(
+    create_generic_index(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::map<GenericKey, std::unordered_set<Uint64>> validation_set;
+  std::vector<std::pair<GenericKey, Uint64>> entries;
+
+  std::vector<GenericKey> unique_keys;
+
+  GenericKey key(max_key_size);
+
+  for (size_t i = 0; i < m; ++i) {
+    rand_gen.next_readable_chars(max_key_size, key.raw());
+    unique_keys.push_back(key);
+  }
+
+  // insert
+  for (size_t i = 0; i < n; ++i) {
+
+    GenericKey &key = unique_keys.at(unique_key ? i : rand_gen.next<uint64_t>() % m);
+
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(uint64_t));
+
+    validation_set[key].insert(offset.raw_data());
+    entries.push_back(std::make_pair(key, offset.raw_data()));
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // erase every third entry. the other entries of its key stay.
+  for (size_t i = 0; i < n; i += 3) {
+    data_index->erase(entries[i].first, entries[i].second);
+    validation_set[entries[i].first].erase(entries[i].second);
+  }
+
+  // an entry that does not exist is not erased.
+  for (size_t i = 1; i < n; i += 3) {
+    data_index->erase(entries[i].first, Uint64(-2));
+  }
+
+  // erase every seventh key with all its entries.
+  for (size_t i = 0; i < m; i += 7) {
+    data_index->erase(unique_keys.at(i));
+    validation_set[unique_keys.at(i)].clear();
+  }
+
+  // find
+  for (auto &entry : validation_set) {
+    std::vector<Uint64> offsets;
+
+    data_index->find(entry.first, offsets);
+
+    EXPECT_EQ(offsets.size(), entry.second.size());
+
+    for (auto offset : offsets) {
+      EXPECT_NE(entry.second.end(), entry.second.find(offset));
+    }
+  }
+}
+
+
+TEST_F(DynamicIndexGenericTest, EraseEntryTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
+
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    IndexType::D_MT_Masstree,
+  };
+
+  for (auto index_type : index_types) {
+
+    test_dynamic_index_generic_erase_entry(32, index_type, true);
+
+    // masstree does not support non-unique keys
+    if (index_type != IndexType::D_MT_Masstree) {
+      test_dynamic_index_generic_erase_entry(32, index_type, false);
+    }
+  }
+}
+
+
+void test_dynamic_index_generic_bulk_load(const uint64_t max_key_size, const IndexType index_type) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+  
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t)));
+  std::unique_ptr<BaseGenericIndex> data_index(
+    create_generic_index(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::map<GenericKey, std::unordered_map<Uint64, uint64_t>> validation_set;
+  
+  std::vector<GenericKey> unique_keys;
+
+  GenericKey key(max_key_size);
+  
+  for (size_t i = 0; i < 2 * m; ++i) {
+    rand_gen.next_readable_chars(max_key_size, key.raw());
+    unique_keys.push_back(key);
+  }
+
+  std::vector<std::pair<GenericKey, Uint64>> entries;
+
+  for (size_t i = 0; i < n; ++i) {
+
+    const GenericKey &key = unique_keys.at(rand_gen.next<uint64_t>() % m);
+
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(uint64_t));
+    
+    validation_set[key][offset.raw_data()] = value;
+
+    entries.push_back(std::pair<GenericKey, Uint64>(key, offset.raw_data()));
+  }
+
+  // bulk load
+  std::sort(entries.begin(), entries.end(), 
+    [](const std::pair<GenericKey, Uint64> &lhs, const std::pair<GenericKey, Uint64> &rhs) { return lhs.first < rhs.first; });
+
+  data_index->bulk_load(entries.data(), entries.size());
+
+  // the loaded index takes further inserts, of loaded and of new keys
+  for (size_t i = 0; i < n / 10; ++i) {
+
+    const GenericKey &key = unique_keys.at(rand_gen.next<uint64_t>() % (2 * m));
+
+    ValueT value = i + 4096;
+    
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(uint64_t));
+    
+    validation_set[key][offset.raw_data()] = value;
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // find
+  for (auto &entry : validation_set) {
+    std::vector<Uint64> offsets;
+
+    data_index->find(entry.first, offsets);
+
+    EXPECT_EQ(offsets.size(), entry.second.size());
+
+    for (auto offset : offsets) {
+      EXPECT_NE(entry.second.end(), entry.second.find(offset));
+
+      EXPECT_EQ((*(uint64_t*)data_table->get_tuple_value(offset)), entry.second.at(offset));
+    }
+  }
+}
+
+
+TEST_F(DynamicIndexGenericTest, BulkLoadTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
+    
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    // IndexType::D_MT_Masstree, // do not support non-unique keys
+  };
+
+  for (auto index_type : index_types) {
+    test_dynamic_index_generic_bulk_load(32, index_type);
+
+    test_dynamic_index_generic_bulk_load(64, index_type);
+  }
+}
+
+
+// keys of different lengths, where many keys are prefixes of others, and some carry the
+// bytes 0x00 and 0x01.
+void test_dynamic_index_generic_shared_prefix_key(const uint64_t max_key_size, const IndexType index_type, const bool bulk_load, const bool find_range) {
+
+  size_t m = 1000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t)));
+  std::unique_ptr<BaseGenericIndex> data_index(
+    create_generic_index(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::vector<GenericKey> keys;
+
+  for (size_t i = 0; i < m; ++i) {
+    size_t base_size = 1 + rand_gen.next<uint64_t>() % 8;
+
+    GenericKey key(max_key_size);
+    rand_gen.next_readable_chars(max_key_size, key.raw());
+
+    // the base key, and each of its extensions up to the full size.
+    for (size_t key_size = base_size; key_size <= max_key_size; key_size += 1 + rand_gen.next<uint64_t>() % 4) {
+      keys.push_back(GenericKey(key.raw(), key_size));
+    }
+
+    GenericKey escaped_key(key.raw(), base_size + 1);
+    escaped_key.raw()[base_size] = 0;
+    keys.push_back(escaped_key);
+    escaped_key.raw()[base_size] = 1;
+    keys.push_back(escaped_key);
+  }
+
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  std::map<GenericKey, Uint64> validation_set;
+  std::vector<std::pair<GenericKey, Uint64>> entries;
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(keys[i].raw(), keys[i].size(), (char*)(&value), sizeof(value));
+
+    validation_set[keys[i]] = offset.raw_data();
+
+    entries.push_back(std::pair<GenericKey, Uint64>(keys[i], offset.raw_data()));
+  }
+
+  if (bulk_load) {
+    data_index->bulk_load(entries.data(), entries.size());
+  } else {
+    for (auto &entry : entries) {
+      data_index->insert(entry.first, entry.second);
+    }
+  }
+
+  EXPECT_EQ(data_index->size(), keys.size());
+
+  // find
+  for (auto &entry : validation_set) {
+    std::vector<Uint64> offsets;
+
+    data_index->find(entry.first, offsets);
+
+    ASSERT_EQ(offsets.size(), 1);
+
+    EXPECT_EQ(offsets.at(0), entry.second);
+  }
+
+  // a key shorter than all its extensions finds nothing, unless it was inserted
+  for (auto &entry : validation_set) {
+    if (entry.first.size() <= 1) { continue; }
+
+    GenericKey key(entry.first.raw(), entry.first.size() - 1);
+
+    std::vector<Uint64> offsets;
+
+    data_index->find(key, offsets);
+
+    EXPECT_EQ(offsets.size(), validation_set.count(key));
+  }
+
+  // find range
+  if (find_range) {
+    for (size_t i = 0; i < keys.size() / 2; i += 97) {
+      const GenericKey &lower_key = keys.at(i);
+      const GenericKey &upper_key = keys.at(keys.size() - 1 - i);
+
+      std::vector<Uint64> offsets;
+      data_index->find_range(lower_key, upper_key, offsets);
+
+      std::vector<Uint64> real_offsets;
+      for (auto iter = validation_set.lower_bound(lower_key); iter != validation_set.upper_bound(upper_key); ++iter) {
+        real_offsets.push_back(iter->second);
+      }
+
+      std::sort(real_offsets.begin(), real_offsets.end());
+      std::sort(offsets.begin(), offsets.end());
+
+      EXPECT_EQ(real_offsets, offsets);
+    }
+  }
+
+  // erase every other key, which leaves the prefixes or extensions of the erased keys
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    data_index->erase(keys[i]);
+  }
+
+  EXPECT_EQ(data_index->size(), keys.size() / 2);
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::vector<Uint64> offsets;
+
+    data_index->find(keys[i], offsets);
+
+    if (i % 2 == 0) {
+      EXPECT_EQ(offsets.size(), 0);
+    } else {
+      ASSERT_EQ(offsets.size(), 1);
+      EXPECT_EQ(offsets.at(0), validation_set.at(keys[i]));
+    }
+  }
+}
+
+TEST_F(DynamicIndexGenericTest, SharedPrefixKeyTest) {
+
+  std::vector<std::pair<IndexType, bool>> index_types {
+
+    // dynamic indexes - singlethread
+    std::make_pair(IndexType::D_ST_StxBtree, true),
+    std::make_pair(IndexType::D_ST_ArtTree, false), // do not fully support range queries
+    std::make_pair(IndexType::D_ST_SdTree, true),
+    std::make_pair(IndexType::D_ST_PrefixBtree, true),
+
+    // dynamic indexes - multithread
+    std::make_pair(IndexType::D_MT_Libcuckoo, false), // do not support range queries
+    std::make_pair(IndexType::D_MT_ArtTree, true),
+    std::make_pair(IndexType::D_MT_BwTree, true),
+  };
+
+  for (auto index_type : index_types) {
+    test_dynamic_index_generic_shared_prefix_key(32, index_type.first, false, index_type.second);
+
+    test_dynamic_index_generic_shared_prefix_key(32, index_type.first, true, index_type.second);
+  }
+}
+
+
+void test_dynamic_index_generic_memory_usage(const uint64_t max_key_size, const IndexType index_type) {
+
+  size_t n = 10000;
+
+  std::unique_ptr<GenericDataTable> data_table(
+    new GenericDataTable(max_key_size, sizeof(uint64_t)));
+  std::unique_ptr<BaseGenericIndex> data_index(
+    create_generic_index(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  FastRandom rand;
+
+  GenericKey key(max_key_size);
+
+  for (size_t i = 0; i < n; ++i) {
+    rand.next_readable_chars(max_key_size, key.raw());
+
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key.raw(), key.size(), (char*)(&value), sizeof(value));
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  IndexMemoryStats stats = data_index->memory_usage();
+  EXPECT_EQ(stats.entry_count_, n);
+  // the multithread art loads keys from the table, but every index takes an offset per entry.
+  EXPECT_GE(stats.total_bytes(), n * sizeof(Uint64));
+}
+
+TEST_F(DynamicIndexGenericTest, MemoryUsageTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+    IndexType::D_ST_SdTree,
+    IndexType::D_ST_PrefixBtree,
+
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    IndexType::D_MT_Masstree,
+  };
+
+  for (auto index_type : index_types) {
+    test_dynamic_index_generic_memory_usage(32, index_type);
+  }
+}
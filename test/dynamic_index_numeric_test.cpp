@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <map>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -440,3 +442,504 @@ TEST_F(DynamicIndexNumericTest, ScanTest) {
   }
 }
 
+
+
+template<typename KeyT, typename ValueT>
+void test_dynamic_index_numeric_find_batch(const IndexType index_type) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+  
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::unordered_map<KeyT, std::unordered_set<Uint64>> validation_set;
+  
+  // insert even keys only, so that odd keys miss
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = (rand_gen.next<KeyT>() % m) * 2;
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key].insert(offset.raw_data());
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // find
+  size_t batch_size = 100;
+  std::vector<KeyT> keys(batch_size);
+  std::vector<std::vector<Uint64>> batch_offsets(batch_size);
+
+  for (size_t round = 0; round < 20; ++round) {
+    for (size_t i = 0; i < batch_size; ++i) {
+      keys[i] = rand_gen.next<KeyT>() % (m * 2 + 2);
+      batch_offsets[i].clear();
+    }
+
+    data_index->find_batch(keys.data(), batch_size, batch_offsets.data());
+
+    for (size_t i = 0; i < batch_size; ++i) {
+      auto entry = validation_set.find(keys[i]);
+      if (entry == validation_set.end()) {
+        EXPECT_EQ(batch_offsets[i].size(), 0);
+        continue;
+      }
+      EXPECT_EQ(batch_offsets[i].size(), entry->second.size());
+
+      for (auto offset : batch_offsets[i]) {
+        EXPECT_NE(entry->second.end(), entry->second.find(offset));
+      }
+    }
+  }
+}
+
+
+TEST_F(DynamicIndexNumericTest, FindBatchTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+    
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    // IndexType::D_MT_Masstree, // do not support non-unique keys
+  };
+
+  for (auto index_type : index_types) {
+
+    test_dynamic_index_numeric_find_batch<uint32_t, uint64_t>(index_type);
+
+    test_dynamic_index_numeric_find_batch<uint64_t, uint64_t>(index_type);
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_dynamic_index_numeric_result_sink(const IndexType index_type, const bool find_range) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  // insert
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = rand_gen.next<KeyT>() % m;
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key, value);
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // find: the sink receives the same offsets as the vector.
+  for (size_t i = 0; i < m * 2; ++i) {
+    KeyT key = i;
+
+    std::vector<Uint64> offsets;
+    data_index->find(key, offsets);
+
+    InlineResultSink<4> sink;
+    data_index->find(key, sink);
+
+    EXPECT_EQ(sink.size(), offsets.size());
+    for (size_t j = 0; j < offsets.size() && j < sink.size(); ++j) {
+      EXPECT_EQ(sink[j], offsets[j]);
+    }
+  }
+
+  // find range: the visitor receives the offsets of the range in the order of the vector.
+  if (find_range) {
+    for (size_t i = 0; i < m; i += 97) {
+      KeyT lhs_key = i;
+      KeyT rhs_key = i + m / 4;
+
+      std::vector<Uint64> offsets;
+      data_index->find_range(lhs_key, rhs_key, offsets);
+
+      std::vector<Uint64> visited;
+      auto visitor = make_visitor_sink([&visited](const Uint64 &offset) { visited.push_back(offset); });
+      data_index->find_range(lhs_key, rhs_key, visitor);
+
+      EXPECT_EQ(visited, offsets);
+    }
+  }
+
+  // scan full: stream the offsets to a visitor.
+  std::vector<Uint64> offsets;
+  data_index->scan_full(offsets);
+
+  std::vector<Uint64> visited;
+  auto visitor = make_visitor_sink([&visited](const Uint64 &offset) { visited.push_back(offset); });
+  data_index->scan_full(visitor);
+
+  EXPECT_EQ(visited, offsets);
+}
+
+
+TEST_F(DynamicIndexNumericTest, ResultSinkTest) {
+
+  std::vector<std::pair<IndexType, bool>> index_types {
+
+    // dynamic indexes - singlethread
+    std::make_pair(IndexType::D_ST_StxBtree, true),
+    std::make_pair(IndexType::D_ST_ArtTree, true),
+
+    // dynamic indexes - multithread
+    std::make_pair(IndexType::D_MT_Libcuckoo, false), // do not support range queries
+    std::make_pair(IndexType::D_MT_ArtTree, true),
+    std::make_pair(IndexType::D_MT_BwTree, true),
+    // IndexType::D_MT_Masstree, // do not support non-unique keys
+  };
+
+  for (auto index_type : index_types) {
+
+    test_dynamic_index_numeric_result_sink<uint32_t, uint64_t>(index_type.first, index_type.second);
+
+    test_dynamic_index_numeric_result_sink<uint64_t, uint64_t>(index_type.first, index_type.second);
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_dynamic_index_numeric_bulk_load(const IndexType index_type) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+  
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::unordered_map<KeyT, std::unordered_map<Uint64, ValueT>> validation_set;
+  
+  std::vector<std::pair<KeyT, Uint64>> entries;
+
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = rand_gen.next<KeyT>() % m;
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key][offset.raw_data()] = value;
+
+    entries.push_back(std::pair<KeyT, Uint64>(key, offset.raw_data()));
+  }
+
+  // bulk load
+  std::sort(entries.begin(), entries.end(), 
+    [](const std::pair<KeyT, Uint64> &lhs, const std::pair<KeyT, Uint64> &rhs) { return lhs.first < rhs.first; });
+
+  data_index->bulk_load(entries.data(), entries.size());
+
+  // the loaded index takes further inserts
+  for (size_t i = 0; i < n / 10; ++i) {
+
+    KeyT key = rand_gen.next<KeyT>() % (2 * m);
+    ValueT value = i + 4096;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key][offset.raw_data()] = value;
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // find
+  for (auto entry : validation_set) {
+    KeyT key = entry.first;
+
+    std::vector<Uint64> offsets;
+
+    data_index->find(key, offsets);
+
+    EXPECT_EQ(offsets.size(), entry.second.size());
+
+    for (auto offset : offsets) {
+      EXPECT_NE(entry.second.end(), entry.second.find(offset));
+
+      EXPECT_EQ(*data_table->get_tuple_value(offset), entry.second.at(offset));
+    }
+  }
+}
+
+
+TEST_F(DynamicIndexNumericTest, BulkLoadTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    // IndexType::D_MT_Masstree, // do not support non-unique keys
+  };
+
+  for (auto index_type : index_types) {
+
+    test_dynamic_index_numeric_bulk_load<uint32_t, uint64_t>(index_type);
+
+    test_dynamic_index_numeric_bulk_load<uint64_t, uint64_t>(index_type);
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_dynamic_index_numeric_erase(const IndexType index_type, const bool unique_key) {
+
+  size_t n = 10000;
+  size_t m = unique_key ? n : 1000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  std::unordered_map<KeyT, std::unordered_set<Uint64>> validation_set;
+  std::vector<std::pair<KeyT, Uint64>> entries;
+
+  // insert
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = unique_key ? KeyT(i) : KeyT(rand_gen.next<KeyT>() % m);
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key].insert(offset.raw_data());
+    entries.push_back(std::make_pair(key, offset.raw_data()));
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  // erase every third entry. the other entries of its key stay.
+  for (size_t i = 0; i < n; i += 3) {
+    data_index->erase(entries[i].first, entries[i].second);
+    validation_set[entries[i].first].erase(entries[i].second);
+  }
+
+  // an entry that does not exist is not erased.
+  for (size_t i = 1; i < n; i += 3) {
+    data_index->erase(entries[i].first, Uint64(-2));
+  }
+
+  // erase every seventh key with all its entries.
+  for (size_t i = 0; i < m; i += 7) {
+    data_index->erase(KeyT(i));
+    validation_set[KeyT(i)].clear();
+  }
+
+  // find
+  for (auto &entry : validation_set) {
+    std::vector<Uint64> offsets;
+
+    data_index->find(entry.first, offsets);
+
+    EXPECT_EQ(offsets.size(), entry.second.size());
+
+    for (auto offset : offsets) {
+      EXPECT_NE(entry.second.end(), entry.second.find(offset));
+    }
+  }
+
+  // erased entries can be inserted again.
+  for (size_t i = 0; i < n; i += 3) {
+    data_index->insert(entries[i].first, entries[i].second);
+    
+    std::vector<Uint64> offsets;
+    data_index->find(entries[i].first, offsets);
+
+    EXPECT_NE(offsets.end(), std::find(offsets.begin(), offsets.end(), entries[i].second));
+  }
+}
+
+
+TEST_F(DynamicIndexNumericTest, EraseTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    IndexType::D_MT_Masstree,
+  };
+
+  for (auto index_type : index_types) {
+
+    test_dynamic_index_numeric_erase<uint32_t, uint64_t>(index_type, true);
+
+    test_dynamic_index_numeric_erase<uint64_t, uint64_t>(index_type, true);
+
+    // masstree does not support non-unique keys
+    if (index_type != IndexType::D_MT_Masstree) {
+      test_dynamic_index_numeric_erase<uint32_t, uint64_t>(index_type, false);
+
+      test_dynamic_index_numeric_erase<uint64_t, uint64_t>(index_type, false);
+    }
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_dynamic_index_numeric_memory_usage(const IndexType index_type) {
+
+  size_t n = 10000;
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get()));
+
+  data_index->prepare_threads(1);
+  data_index->register_thread(0);
+
+  EXPECT_EQ(data_index->size(), 0);
+
+  for (size_t i = 0; i < n; ++i) {
+    KeyT key = KeyT(i * 7919);
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key, value);
+
+    data_index->insert(key, offset.raw_data());
+  }
+
+  EXPECT_EQ(data_index->size(), n);
+
+  IndexMemoryStats stats = data_index->memory_usage();
+  EXPECT_EQ(stats.entry_count_, n);
+  // every structure takes at least a bare (key, offset) pair per entry. the multithread art
+  // keeps single offsets in the child pointers, so its leaves may take no bytes.
+  EXPECT_GE(stats.total_bytes(), n * (sizeof(KeyT) + sizeof(Uint64)));
+
+  // erase half of the keys. an erase of a missing key changes nothing.
+  for (size_t i = 0; i < n; i += 2) {
+    data_index->erase(KeyT(i * 7919));
+  }
+  data_index->erase(KeyT(1));
+
+  EXPECT_EQ(data_index->size(), n / 2);
+  EXPECT_EQ(data_index->memory_usage().entry_count_, n / 2);
+}
+
+TEST_F(DynamicIndexNumericTest, MemoryUsageTest) {
+
+  std::vector<IndexType> index_types {
+
+    // dynamic indexes - singlethread
+    IndexType::D_ST_StxBtree,
+    IndexType::D_ST_ArtTree,
+
+    // dynamic indexes - multithread
+    IndexType::D_MT_Libcuckoo,
+    IndexType::D_MT_ArtTree,
+    IndexType::D_MT_BwTree,
+    IndexType::D_MT_Masstree,
+  };
+
+  for (auto index_type : index_types) {
+
+    test_dynamic_index_numeric_memory_usage<uint32_t, uint64_t>(index_type);
+
+    test_dynamic_index_numeric_memory_usage<uint64_t, uint64_t>(index_type);
+  }
+}
+
+
+// every tree keeps the thread infos of its own epoch, so a thread may work on several trees,
+// and outlive any of them.
+TEST_F(DynamicIndexNumericTest, MultipleArtTreeTest) {
+
+  size_t n = 10000;
+
+  std::unique_ptr<DataTable<uint64_t, uint64_t>> data_table(
+    new DataTable<uint64_t, uint64_t>());
+  std::unique_ptr<BaseIndex<uint64_t, uint64_t>> lhs_index(
+    create_numeric_index<uint64_t, uint64_t>(IndexType::D_MT_ArtTree, data_table.get()));
+  std::unique_ptr<BaseIndex<uint64_t, uint64_t>> rhs_index(
+    create_numeric_index<uint64_t, uint64_t>(IndexType::D_MT_ArtTree, data_table.get()));
+
+  lhs_index->prepare_threads(1);
+  lhs_index->register_thread(0);
+  rhs_index->prepare_threads(1);
+  rhs_index->register_thread(0);
+
+  std::vector<Uint64> offsets;
+  for (size_t i = 0; i < n; ++i) {
+    OffsetT offset = data_table->insert_tuple(uint64_t(i), uint64_t(i + 2048));
+    offsets.push_back(offset.raw_data());
+    lhs_index->insert(uint64_t(i), offset.raw_data());
+    rhs_index->insert(uint64_t(i), offset.raw_data());
+  }
+
+  // erasing retires nodes to the garbage of the tree they belong to.
+  for (size_t i = 0; i < n; i += 2) {
+    rhs_index->erase(uint64_t(i));
+  }
+  rhs_index.reset();
+
+  for (size_t i = 0; i < n; i += 3) {
+    lhs_index->erase(uint64_t(i));
+  }
+
+  // a thread that never registered works as well.
+  std::thread reader([&]() {
+    for (size_t i = 0; i < n; ++i) {
+      std::vector<Uint64> found;
+      lhs_index->find(uint64_t(i), found);
+      if (i % 3 == 0) {
+        EXPECT_EQ(found.size(), 0);
+      } else {
+        ASSERT_EQ(found.size(), 1);
+        EXPECT_EQ(found[0], offsets[i]);
+      }
+    }
+  });
+  reader.join();
+
+  EXPECT_EQ(lhs_index->size(), n - (n + 2) / 3);
+}
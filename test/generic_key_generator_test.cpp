@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "generic_key_generator_all.h"
+
+#include "harness.h"
+
+
+class GenericKeyGeneratorTest : public IndexZooTest {};
+
+void string_key_generator_test(const WorkloadType workload_type, const size_t max_key_size, const size_t mean_key_size) {
+  std::unique_ptr<BaseGenericKeyGenerator> key_generator(construct_generic_key_generator(workload_type, 0, max_key_size, mean_key_size));
+
+  const size_t key_count = 10000;
+  size_t total_size = 0;
+  std::map<std::string, size_t> prefix_counts;
+
+  GenericKey key;
+  for (size_t i = 0; i < key_count; ++i) {
+    key_generator->get_next_key(key);
+    EXPECT_GT(key.size(), 0);
+    EXPECT_LE(key.size(), max_key_size);
+    total_size += key.size();
+    ++prefix_counts[std::string(key.raw(), std::min<size_t>(key.size(), 4))];
+  }
+
+  // lengths follow the mean, and keys share prefixes.
+  EXPECT_NEAR(total_size * 1.0 / key_count, mean_key_size, mean_key_size * 0.25);
+  EXPECT_LT(prefix_counts.size(), key_count / 10);
+}
+
+TEST_F(GenericKeyGeneratorTest, UsernameTest) {
+  string_key_generator_test(WorkloadType::UsernameType, 32, 12);
+}
+
+TEST_F(GenericKeyGeneratorTest, UrlTest) {
+  string_key_generator_test(WorkloadType::UrlType, 256, 80);
+}
+
+// generators sharing a file read every key once before the file repeats.
+TEST_F(GenericKeyGeneratorTest, FileTest) {
+  const std::string path = "/tmp/generic_key_generator_test.txt";
+  const size_t key_count = 50000;
+
+  std::map<std::string, size_t> expected_counts;
+  {
+    std::ofstream out(path);
+    for (size_t i = 0; i < key_count; ++i) {
+      std::string key = "key-" + std::to_string(i * 7919 % 100003) + std::string(i % 13, 'x');
+      out << key << (i % 5 == 0 ? "\r\n" : "\n");
+      if (i % 1000 == 0) {
+        out << "\n";
+      }
+      ++expected_counts[key];
+    }
+  }
+
+  MappedKeyFile key_file(path);
+  GenericKey key;
+
+  // one generator reads the file in order, and starts over at its end.
+  std::unique_ptr<BaseGenericKeyGenerator> key_generator(construct_generic_key_generator(WorkloadType::FileType, 0, 64, 0, &key_file));
+  std::map<std::string, size_t> counts;
+  std::string first_key;
+  for (size_t i = 0; i < key_count; ++i) {
+    key_generator->get_next_key(key);
+    ++counts[std::string(key.raw(), key.size())];
+    if (i == 0) {
+      first_key = std::string(key.raw(), key.size());
+    }
+  }
+  EXPECT_TRUE(counts == expected_counts);
+  key_generator->get_next_key(key);
+  EXPECT_EQ(std::string(key.raw(), key.size()), first_key);
+
+  // generators that share the file split it by chunks. over two passes, a generator holds at
+  // most one partly read chunk, so every key is read once or more, and at most three times.
+  std::unique_ptr<BaseGenericKeyGenerator> lhs_generator(construct_generic_key_generator(WorkloadType::FileType, 0, 64, 0, &key_file));
+  std::unique_ptr<BaseGenericKeyGenerator> rhs_generator(construct_generic_key_generator(WorkloadType::FileType, 1, 64, 0, &key_file));
+  counts.clear();
+  for (size_t i = 0; i < key_count * 2; ++i) {
+    BaseGenericKeyGenerator *generator = (i % 3 == 0) ? lhs_generator.get() : rhs_generator.get();
+    generator->get_next_key(key);
+    ++counts[std::string(key.raw(), key.size())];
+  }
+  EXPECT_EQ(counts.size(), expected_counts.size());
+  for (auto &entry : counts) {
+    auto iter = expected_counts.find(entry.first);
+    ASSERT_TRUE(iter != expected_counts.end());
+    EXPECT_LE(entry.second, iter->second * 3);
+  }
+
+  // truncation
+  std::unique_ptr<BaseGenericKeyGenerator> short_generator(construct_generic_key_generator(WorkloadType::FileType, 0, 3, 0, &key_file));
+  short_generator->get_next_key(key);
+  EXPECT_EQ(std::string(key.raw(), key.size()), "key");
+
+  std::remove(path.c_str());
+}
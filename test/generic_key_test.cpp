@@ -0,0 +1,112 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fast_random.h"
+#include "generic_key.h"
+
+#include "harness.h"
+
+
+class GenericKeyTest : public IndexZooTest {};
+
+void validate_generic_key(const GenericKey &key, const std::string &expected) {
+  EXPECT_EQ(key.size(), expected.size());
+  EXPECT_EQ(std::string(key.raw(), key.size()), expected);
+}
+
+void generic_key_copy_move_test(const size_t key_size) {
+  std::string data(key_size, 'x');
+  for (size_t i = 0; i < key_size; ++i) {
+    data[i] = 'a' + i % 26;
+  }
+
+  GenericKey key(data.c_str(), data.size());
+  validate_generic_key(key, data);
+
+  // copy
+  GenericKey copy(key);
+  validate_generic_key(copy, data);
+  EXPECT_NE(copy.raw(), key.raw());
+
+  GenericKey assigned(4);
+  assigned = key;
+  validate_generic_key(assigned, data);
+
+  // move. a heap buffer changes hands, inline bytes are copied.
+  char *buffer = copy.raw();
+  GenericKey moved(std::move(copy));
+  validate_generic_key(moved, data);
+  if (key_size > GenericKey::INLINE_SIZE) {
+    EXPECT_EQ(moved.raw(), buffer);
+  }
+
+  GenericKey move_assigned;
+  move_assigned = std::move(moved);
+  validate_generic_key(move_assigned, data);
+
+  // keys in a vector survive reallocation.
+  std::vector<GenericKey> keys;
+  for (size_t i = 0; i < 100; ++i) {
+    keys.push_back(key);
+  }
+  for (auto &entry : keys) {
+    validate_generic_key(entry, data);
+  }
+
+  // views compare like keys.
+  GenericKeyView view(key);
+  EXPECT_TRUE(view == GenericKeyView(data.c_str(), data.size()));
+  EXPECT_TRUE(GenericKeyView(data.c_str(), data.size() - 1) < view);
+  EXPECT_TRUE(view > GenericKeyView(data.c_str(), data.size() - 1));
+  validate_generic_key(GenericKey(view), data);
+}
+
+TEST_F(GenericKeyTest, CopyMoveTest) {
+  generic_key_copy_move_test(8);
+  generic_key_copy_move_test(GenericKey::INLINE_SIZE);
+  generic_key_copy_move_test(GenericKey::INLINE_SIZE + 1);
+  generic_key_copy_move_test(200);
+}
+
+TEST_F(GenericKeyTest, ResizeTest) {
+  GenericKey key;
+  EXPECT_EQ(key.size(), 0);
+
+  // a key may be resized again, e.g. by a key generator that reuses it.
+  key.resize(16);
+  validate_generic_key(key, std::string(16, '\0'));
+
+  key.resize(100);
+  validate_generic_key(key, std::string(100, '\0'));
+
+  char *buffer = key.raw();
+  key.resize(50);
+  EXPECT_EQ(key.raw(), buffer);
+  validate_generic_key(key, std::string(50, '\0'));
+}
+
+// the prefix settles most comparisons, and must agree with the byte order on ties.
+TEST_F(GenericKeyTest, PrefixCompareTest) {
+  FastRandom rand_gen(0);
+
+  std::vector<GenericKey> keys;
+  for (size_t i = 0; i < 500; ++i) {
+    // short alphabets and lengths around 8 bytes, so that prefixes often tie.
+    GenericKey key(rand_gen.next<uint64_t>() % 20);
+    for (size_t j = 0; j < key.size(); ++j) {
+      key.raw()[j] = rand_gen.next<uint64_t>() % 3;
+    }
+    keys.push_back(key);
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    for (size_t j = 0; j < keys.size(); ++j) {
+      PrefixGenericKey lhs(keys[i]);
+      PrefixGenericKey rhs(keys[j]);
+      EXPECT_EQ(lhs < rhs, keys[i] < keys[j]);
+      EXPECT_EQ(lhs > rhs, keys[i] > keys[j]);
+      EXPECT_EQ(lhs == rhs, keys[i] == keys[j]);
+    }
+  }
+}
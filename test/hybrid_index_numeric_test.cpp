@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "harness.h"
+#include "fast_random.h"
+
+#include "data_table.h"
+
+#include "index_all.h"
+
+
+class HybridIndexNumericTest : public IndexZooTest {};
+
+template<typename KeyT, typename ValueT>
+hybrid_index::HybridIndex<KeyT, ValueT>* create_test_hybrid_index(DataTable<KeyT, ValueT> *table_ptr, const int main_type, const int delta_type, const size_t merge_threshold) {
+  return new hybrid_index::HybridIndex<KeyT, ValueT>(table_ptr,
+    [=](const size_t size) { return create_hybrid_main<KeyT, ValueT>(main_type, table_ptr, size, StorageLayout::AoS); },
+    [=]() { return create_hybrid_delta<KeyT, ValueT>(delta_type, table_ptr); },
+    merge_threshold);
+}
+
+template<typename KeyT>
+void validate_hybrid_offsets(std::vector<Uint64> &offsets, const std::multimap<KeyT, Uint64> &validation_set, const KeyT &lhs_key, const KeyT &rhs_key) {
+  std::vector<Uint64> expected;
+  for (auto iter = validation_set.lower_bound(lhs_key); iter != validation_set.upper_bound(rhs_key); ++iter) {
+    expected.push_back(iter->second);
+  }
+  std::sort(offsets.begin(), offsets.end());
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(offsets, expected);
+}
+
+template<typename KeyT>
+void validate_hybrid_index(BaseIndex<KeyT, uint64_t> *data_index, const std::multimap<KeyT, Uint64> &validation_set, const KeyT key_bound) {
+
+  // find
+  for (KeyT key = 0; key < key_bound; ++key) {
+    std::vector<Uint64> offsets;
+    data_index->find(key, offsets);
+    validate_hybrid_offsets(offsets, validation_set, key, key);
+  }
+
+  // find batch
+  std::vector<KeyT> keys;
+  for (KeyT key = 0; key < key_bound; ++key) {
+    keys.push_back(key);
+  }
+  std::vector<std::vector<Uint64>> batch_offsets(keys.size());
+  data_index->find_batch(keys.data(), keys.size(), batch_offsets.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    validate_hybrid_offsets(batch_offsets[i], validation_set, keys[i], keys[i]);
+  }
+
+  // find range
+  for (KeyT lhs_key = 0; lhs_key < key_bound; lhs_key += key_bound / 16) {
+    std::vector<Uint64> offsets;
+    data_index->find_range(lhs_key, lhs_key + key_bound / 8, offsets);
+    validate_hybrid_offsets(offsets, validation_set, lhs_key, KeyT(lhs_key + key_bound / 8));
+  }
+}
+
+template<typename KeyT, typename ValueT>
+void test_hybrid_index_numeric_insert_find(const int main_type, const int delta_type) {
+
+  size_t n = 20000;
+  KeyT key_bound = 5000;
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<hybrid_index::HybridIndex<KeyT, ValueT>> data_index(
+    create_test_hybrid_index<KeyT, ValueT>(data_table.get(), main_type, delta_type, 512));
+
+  std::multimap<KeyT, Uint64> validation_set;
+
+  FastRandom rand_gen;
+
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = rand_gen.next<KeyT>() % key_bound;
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key, value);
+    data_index->insert(key, offset.raw_data());
+    validation_set.insert(std::pair<KeyT, Uint64>(key, offset.raw_data()));
+
+    // validate while a merge may be running.
+    if (i % 5000 == 4999) {
+      validate_hybrid_index<KeyT>(data_index.get(), validation_set, key_bound);
+    }
+  }
+
+  data_index->wait_for_merge();
+  validate_hybrid_index<KeyT>(data_index.get(), validation_set, key_bound);
+
+  // the art-tree delta counts distinct keys only.
+  if (delta_type == 0) {
+    EXPECT_EQ(data_index->size(), n);
+  }
+
+  // rebuild the main index from the table.
+  data_index->reorganize();
+  validate_hybrid_index<KeyT>(data_index.get(), validation_set, key_bound);
+
+  std::vector<Uint64> offsets;
+  data_index->scan_full(offsets, std::numeric_limits<size_t>::max());
+  EXPECT_EQ(offsets.size(), n);
+}
+
+template<typename KeyT, typename ValueT>
+void test_hybrid_index_numeric_erase(const int main_type) {
+
+  size_t n = 20000;
+  KeyT key_bound = 5000;
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<hybrid_index::HybridIndex<KeyT, ValueT>> data_index(
+    create_test_hybrid_index<KeyT, ValueT>(data_table.get(), main_type, 0, 512));
+
+  std::multimap<KeyT, Uint64> validation_set;
+
+  FastRandom rand_gen;
+
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = rand_gen.next<KeyT>() % key_bound;
+
+    // erase an existing key every few inserts. it may live in any component.
+    if (i % 4 == 3) {
+      data_index->erase(key);
+      validation_set.erase(key);
+      continue;
+    }
+
+    ValueT value = i + 2048;
+
+    OffsetT offset = data_table->insert_tuple(key, value);
+    data_index->insert(key, offset.raw_data());
+    validation_set.insert(std::pair<KeyT, Uint64>(key, offset.raw_data()));
+
+    if (i % 5000 == 4999) {
+      validate_hybrid_index<KeyT>(data_index.get(), validation_set, key_bound);
+    }
+  }
+
+  data_index->wait_for_merge();
+  validate_hybrid_index<KeyT>(data_index.get(), validation_set, key_bound);
+}
+
+TEST_F(HybridIndexNumericTest, InsertFindTest) {
+  for (int main_type = 0; main_type < 3; ++main_type) {
+    for (int delta_type = 0; delta_type < 2; ++delta_type) {
+      test_hybrid_index_numeric_insert_find<uint64_t, uint64_t>(main_type, delta_type);
+      test_hybrid_index_numeric_insert_find<uint32_t, uint64_t>(main_type, delta_type);
+    }
+  }
+}
+
+TEST_F(HybridIndexNumericTest, EraseTest) {
+  for (int main_type = 0; main_type < 3; ++main_type) {
+    test_hybrid_index_numeric_erase<uint64_t, uint64_t>(main_type);
+    test_hybrid_index_numeric_erase<uint32_t, uint64_t>(main_type);
+  }
+}
+
+// entries inserted while the main index is rebuilt are neither lost nor doubled, and readers
+// run alongside. the tuples are in the table before the writer inserts them, so the rebuilds
+// gather tuples that the index has not seen yet.
+template<typename KeyT, typename ValueT>
+void test_hybrid_index_numeric_concurrent_reorganize(const int main_type) {
+
+  size_t n = 40000;
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<hybrid_index::HybridIndex<KeyT, ValueT>> data_index(
+    create_test_hybrid_index<KeyT, ValueT>(data_table.get(), main_type, 0, 512));
+
+  std::vector<Uint64> offsets(n);
+  for (size_t i = 0; i < n; ++i) {
+    ValueT value = i + 2048;
+    offsets[i] = data_table->insert_tuple(KeyT(i), value).raw_data();
+  }
+
+  std::atomic<size_t> inserted_count(0);
+  std::thread writer([&]() {
+    for (size_t i = 0; i < n; ++i) {
+      data_index->insert(KeyT(i), offsets[i]);
+      inserted_count.store(i + 1);
+    }
+  });
+
+  std::atomic<bool> is_running(true);
+  std::thread reader([&]() {
+    FastRandom rand_gen;
+    while (is_running.load()) {
+      size_t count = inserted_count.load();
+      if (count == 0) { continue; }
+      std::vector<Uint64> found;
+      data_index->find(KeyT(rand_gen.next<uint64_t>() % count), found);
+      EXPECT_EQ(found.size(), 1);
+    }
+  });
+
+  while (inserted_count.load() < n / 4) { std::this_thread::yield(); }
+  data_index->reorganize();
+  while (inserted_count.load() < n / 2) { std::this_thread::yield(); }
+  data_index->reorganize();
+
+  writer.join();
+  is_running.store(false);
+  reader.join();
+
+  data_index->wait_for_merge();
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<Uint64> found;
+    data_index->find(KeyT(i), found);
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(found[0], offsets[i]);
+  }
+  EXPECT_EQ(data_index->size(), n);
+}
+
+TEST_F(HybridIndexNumericTest, ConcurrentReorganizeTest) {
+  for (int main_type = 0; main_type < 3; ++main_type) {
+    test_hybrid_index_numeric_concurrent_reorganize<uint64_t, uint64_t>(main_type);
+  }
+}
@@ -0,0 +1,66 @@
+#include "latency_histogram.h"
+
+#include "harness.h"
+
+
+class LatencyHistogramTest : public IndexZooTest {};
+
+TEST_F(LatencyHistogramTest, PercentileTest) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.percentile(0.5), 0);
+
+  for (uint64_t value = 1; value <= 100000; ++value) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(histogram.count(), 100000);
+  EXPECT_EQ(histogram.max(), 100000);
+
+  // values are reported within 1/32 of themselves.
+  double fractions[] = {0.5, 0.9, 0.99, 0.999};
+  for (double fraction : fractions) {
+    double expected = fraction * 100000;
+    uint64_t actual = histogram.percentile(fraction);
+    EXPECT_GE(actual, expected);
+    EXPECT_LE(actual, expected * (1 + 1.0 / 32));
+  }
+  EXPECT_EQ(histogram.percentile(1.0), 100000);
+
+  // small values are exact.
+  LatencyHistogram small;
+  for (uint64_t value = 0; value < 32; ++value) {
+    small.record(value);
+  }
+  EXPECT_EQ(small.percentile(0.5), 15);
+}
+
+TEST_F(LatencyHistogramTest, MergeSubtractTest) {
+  LatencyHistogram lhs;
+  LatencyHistogram rhs;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    lhs.record(100);
+    rhs.record(10000);
+  }
+  rhs.record(1ull << 40);
+
+  LatencyHistogram merged;
+  merged.merge(lhs);
+  merged.merge(rhs);
+  EXPECT_EQ(merged.count(), 2001);
+  EXPECT_EQ(merged.max(), 1ull << 40);
+  EXPECT_GE(merged.percentile(0.25), 100);
+  EXPECT_LE(merged.percentile(0.25), 100 * (1 + 1.0 / 32));
+  EXPECT_GE(merged.percentile(0.75), 10000);
+  EXPECT_LE(merged.percentile(0.75), 10000 * (1 + 1.0 / 32));
+
+  // the difference to an older snapshot holds the records since the snapshot.
+  LatencyHistogram snapshot;
+  snapshot.copy_from(merged);
+  for (uint64_t i = 0; i < 10; ++i) {
+    merged.record(50);
+  }
+  merged.subtract(snapshot);
+  EXPECT_EQ(merged.count(), 10);
+  EXPECT_EQ(merged.percentile(0.5), 50);
+  EXPECT_EQ(merged.max(), 50);
+}
@@ -1,8 +1,11 @@
+#include <limits>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <unistd.h>
+
 #include "harness.h"
 #include "fast_random.h"
 #include "time_measurer.h"
@@ -89,13 +92,23 @@ TEST_F(StaticIndexNumericTest, UniqueKeyFindTest) {
   index_type = IndexType::S_Fast;
   for (size_t layers = 0; layers <= 12; layers += 4) {
     test_static_index_numeric_unique_key_find<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_unique_key_find<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_Learned;
+  for (size_t model_type = 0; model_type <= 1; ++model_type) {
+    for (size_t model_param = 1; model_param <= 64; model_param *= 8) {
+      test_static_index_numeric_unique_key_find<uint16_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_unique_key_find<uint32_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_unique_key_find<uint64_t, uint64_t>(index_type, model_type, model_param);
+    }
   }
 
 }
 
 
 template<typename KeyT, typename ValueT>
-void test_static_index_numeric_non_unique_key_find(const IndexType index_type, const size_t index_param_1, const size_t index_param_2) {
+void test_static_index_numeric_non_unique_key_find(const IndexType index_type, const size_t index_param_1, const size_t index_param_2, const StorageLayout layout = StorageLayout::AoS) {
 
   size_t n = 10000;
   size_t m = 1000;
@@ -105,7 +118,7 @@ void test_static_index_numeric_non_unique_key_find(const IndexType index_type, c
   std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
     new DataTable<KeyT, ValueT>());
   std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
-    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2));
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2, layout));
 
   std::unordered_map<KeyT, std::unordered_map<Uint64, ValueT>> validation_set;
 
@@ -172,6 +185,16 @@ TEST_F(StaticIndexNumericTest, NonUniqueKeyFindTest) {
   index_type = IndexType::S_Fast;
   for (size_t layers = 0; layers <= 12; layers += 4) {
     test_static_index_numeric_non_unique_key_find<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_non_unique_key_find<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_Learned;
+  for (size_t model_type = 0; model_type <= 1; ++model_type) {
+    for (size_t model_param = 1; model_param <= 64; model_param *= 8) {
+      test_static_index_numeric_non_unique_key_find<uint16_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_non_unique_key_find<uint32_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_non_unique_key_find<uint64_t, uint64_t>(index_type, model_type, model_param);
+    }
   }
 
 }
@@ -247,31 +270,41 @@ TEST_F(StaticIndexNumericTest, UniqueKeyFindRangeTest) {
     test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM);
   }
 
-  // index_type = IndexType::S_Binary;
-  // for (size_t layers = 0; layers < 8; ++layers) {
-  //   test_static_index_numeric_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  //   test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  //   test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  // }
+  index_type = IndexType::S_Binary;
+  for (size_t layers = 0; layers < 8; ++layers) {
+    test_static_index_numeric_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_KAry;
+  for (size_t layers = 0; layers < 4; ++layers) {
+    for (size_t k = 2; k < 5; ++k) {
+      test_static_index_numeric_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, k);
+      test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, k);
+      test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, k);
+    }
+  }
 
-  // index_type = IndexType::S_KAry;
-  // for (size_t layers = 0; layers < 4; ++layers) {
-  //   for (size_t k = 2; k < 5; ++k) {
-  //     test_static_index_numeric_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, k);
-  //     test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, k);
-  //     test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, k);
-  //   }
-  // }
+  index_type = IndexType::S_Fast;
+  for (size_t layers = 0; layers <= 12; layers += 4) {
+    test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
 
-  // index_type = IndexType::S_Fast;
-  // for (size_t layers = 0; layers <= 12; layers += 4) {
-  //   test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  // }
+  index_type = IndexType::S_Learned;
+  for (size_t model_type = 0; model_type <= 1; ++model_type) {
+    for (size_t model_param = 1; model_param <= 64; model_param *= 8) {
+      test_static_index_numeric_unique_key_find_range<uint16_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_unique_key_find_range<uint32_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_unique_key_find_range<uint64_t, uint64_t>(index_type, model_type, model_param);
+    }
+  }
 
 }
 
 template<typename KeyT, typename ValueT>
-void test_static_index_numeric_non_unique_key_find_range(const IndexType index_type, const size_t index_param_1, const size_t index_param_2) {
+void test_static_index_numeric_non_unique_key_find_range(const IndexType index_type, const size_t index_param_1, const size_t index_param_2, const StorageLayout layout = StorageLayout::AoS) {
 
   size_t n = 10000;
   size_t m = 1000;
@@ -281,7 +314,7 @@ void test_static_index_numeric_non_unique_key_find_range(const IndexType index_t
   std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
     new DataTable<KeyT, ValueT>());
   std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
-    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2));
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2, layout));
 
   std::map<KeyT, std::unordered_map<Uint64, ValueT>> validation_set;
   std::vector<KeyT> keys_vector;
@@ -344,26 +377,36 @@ TEST_F(StaticIndexNumericTest, NonUniqueKeyFindRangeTest) {
     test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM);
   }
 
-  // index_type = IndexType::S_Binary;
-  // for (size_t layers = 0; layers < 8; ++layers) {
-  //   test_static_index_numeric_non_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  //   test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  //   test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  // }
-
-  // index_type = IndexType::S_KAry;
-  // for (size_t layers = 0; layers < 4; ++layers) {
-  //   for (size_t k = 2; k < 5; ++k) {
-  //     test_static_index_numeric_non_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, k);
-  //     test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, k);
-  //     test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, k);
-  //   }
-  // }
-
-  // index_type = IndexType::S_Fast;
-  // for (size_t layers = 0; layers <= 12; layers += 4) {
-  //   test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
-  // }
+  index_type = IndexType::S_Binary;
+  for (size_t layers = 0; layers < 8; ++layers) {
+    test_static_index_numeric_non_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_KAry;
+  for (size_t layers = 0; layers < 4; ++layers) {
+    for (size_t k = 2; k < 5; ++k) {
+      test_static_index_numeric_non_unique_key_find_range<uint16_t, uint64_t>(index_type, layers, k);
+      test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, k);
+      test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, k);
+    }
+  }
+
+  index_type = IndexType::S_Fast;
+  for (size_t layers = 0; layers <= 12; layers += 4) {
+    test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_Learned;
+  for (size_t model_type = 0; model_type <= 1; ++model_type) {
+    for (size_t model_param = 1; model_param <= 64; model_param *= 8) {
+      test_static_index_numeric_non_unique_key_find_range<uint16_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_non_unique_key_find_range<uint64_t, uint64_t>(index_type, model_type, model_param);
+    }
+  }
 }
 
 
@@ -428,3 +471,410 @@ TEST_F(StaticIndexNumericTest, ScanTest) {
 
 
 
+
+
+template<typename KeyT, typename ValueT>
+void test_static_index_numeric_find_batch(const IndexType index_type, const size_t index_param_1, const size_t index_param_2, const StorageLayout layout = StorageLayout::AoS) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+  
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2, layout));
+
+  std::unordered_map<KeyT, std::unordered_set<Uint64>> validation_set;
+
+  // insert even keys only, so that odd keys miss
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = (rand_gen.next<KeyT>() % m) * 2 + 2;
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key].insert(offset.raw_data());
+  }
+
+  // reorganize data
+  data_index->reorganize();
+
+  // find
+  size_t batch_size = 100;
+  std::vector<KeyT> keys(batch_size);
+  std::vector<std::vector<Uint64>> batch_offsets(batch_size);
+
+  for (size_t round = 0; round < 20; ++round) {
+    for (size_t i = 0; i < batch_size; ++i) {
+      keys[i] = rand_gen.next<KeyT>() % (m * 2 + 4);
+      batch_offsets[i].clear();
+    }
+
+    data_index->find_batch(keys.data(), batch_size, batch_offsets.data());
+
+    for (size_t i = 0; i < batch_size; ++i) {
+      auto entry = validation_set.find(keys[i]);
+      if (entry == validation_set.end()) {
+        EXPECT_EQ(batch_offsets[i].size(), 0);
+        continue;
+      }
+      EXPECT_EQ(batch_offsets[i].size(), entry->second.size());
+
+      for (auto offset : batch_offsets[i]) {
+        EXPECT_NE(entry->second.end(), entry->second.find(offset));
+      }
+    }
+  }
+}
+
+TEST_F(StaticIndexNumericTest, FindBatchTest) {
+
+  IndexType index_type = IndexType::S_Interpolation;
+  for (size_t segments = 1; segments <= 10; segments += 3) {
+    test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM);
+    test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_Binary;
+  for (size_t layers = 0; layers < 8; layers += 3) {
+    test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_KAry;
+  for (size_t layers = 0; layers < 4; ++layers) {
+    test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, layers, 3);
+    test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, layers, 3);
+  }
+
+  index_type = IndexType::S_Fast;
+  for (size_t layers = 0; layers <= 12; layers += 4) {
+    test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_Learned;
+  for (size_t model_type = 0; model_type <= 1; ++model_type) {
+    for (size_t model_param = 1; model_param <= 64; model_param *= 8) {
+      test_static_index_numeric_find_batch<uint16_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, model_type, model_param);
+    }
+  }
+}
+
+
+TEST_F(StaticIndexNumericTest, SoALayoutTest) {
+
+  StorageLayout layout = StorageLayout::SoA;
+
+  IndexType index_type = IndexType::S_Interpolation;
+  for (size_t segments = 1; segments <= 10; segments += 3) {
+    test_static_index_numeric_non_unique_key_find<uint32_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM, layout);
+    test_static_index_numeric_non_unique_key_find<uint64_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM, layout);
+    test_static_index_numeric_non_unique_key_find_range<uint32_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM, layout);
+    test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, segments, INVALID_INDEX_PARAM, layout);
+  }
+
+  index_type = IndexType::S_Binary;
+  for (size_t layers = 0; layers < 8; layers += 3) {
+    test_static_index_numeric_non_unique_key_find<uint16_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM, layout);
+    test_static_index_numeric_non_unique_key_find<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM, layout);
+    test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM, layout);
+  }
+
+  index_type = IndexType::S_KAry;
+  for (size_t layers = 0; layers < 4; ++layers) {
+    test_static_index_numeric_non_unique_key_find<uint32_t, uint64_t>(index_type, layers, 3, layout);
+    test_static_index_numeric_find_batch<uint64_t, uint64_t>(index_type, layers, 3, layout);
+  }
+
+  index_type = IndexType::S_Fast;
+  for (size_t layers = 0; layers <= 12; layers += 4) {
+    test_static_index_numeric_non_unique_key_find<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM, layout);
+    test_static_index_numeric_find_batch<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM, layout);
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_static_index_numeric_large_key_find(const IndexType index_type, const size_t index_param_1, const size_t index_param_2) {
+
+  size_t n = 10000;
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2));
+
+  std::unordered_map<KeyT, Uint64> validation_set;
+
+  // keys spread across the whole domain, including keys with the top bit set.
+  KeyT step = std::numeric_limits<KeyT>::max() / n;
+  for (size_t i = 0; i < n; ++i) {
+
+    KeyT key = step * i;
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key] = offset.raw_data();
+  }
+
+  // reorganize data
+  data_index->reorganize();
+
+  for (size_t i = 0; i < n; ++i) {
+
+    std::vector<Uint64> offsets;
+    data_index->find(step * i, offsets);
+
+    EXPECT_EQ(offsets.size(), 1);
+    EXPECT_EQ(offsets.at(0), validation_set.at(step * i));
+
+    // keys in between never match
+    offsets.clear();
+    data_index->find(step * i + 1, offsets);
+
+    EXPECT_EQ(offsets.size(), 0);
+  }
+}
+
+TEST_F(StaticIndexNumericTest, LargeKeyFindTest) {
+
+  IndexType index_type = IndexType::S_Fast;
+  for (size_t layers = 0; layers <= 12; layers += 3) {
+    test_static_index_numeric_large_key_find<uint32_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+    test_static_index_numeric_large_key_find<uint64_t, uint64_t>(index_type, layers, INVALID_INDEX_PARAM);
+  }
+
+  index_type = IndexType::S_Learned;
+  for (size_t model_type = 0; model_type <= 1; ++model_type) {
+    for (size_t model_param = 1; model_param <= 64; model_param *= 8) {
+      test_static_index_numeric_large_key_find<uint32_t, uint64_t>(index_type, model_type, model_param);
+      test_static_index_numeric_large_key_find<uint64_t, uint64_t>(index_type, model_type, model_param);
+    }
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_static_index_numeric_parallel_reorganize(const IndexType index_type, const size_t index_param_1, const size_t index_param_2, const size_t thread_count) {
+
+  // large enough to take the radix sort path.
+  size_t n = 200000;
+  
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2));
+
+  std::unordered_map<KeyT, std::unordered_set<Uint64>> validation_set;
+
+  for (size_t i = 0; i < n; ++i) {
+
+    // half of the keys are duplicated, and keys cover the whole domain.
+    KeyT key = (i % 2 == 0) ? rand_gen.next<KeyT>() : KeyT(rand_gen.next<KeyT>() % 1000);
+    ValueT value = i + 2048;
+    
+    OffsetT offset = data_table->insert_tuple(key, value);
+    
+    validation_set[key].insert(offset.raw_data());
+  }
+
+  data_index->reorganize(thread_count);
+
+  // all entries come out in key order.
+  std::vector<Uint64> offsets;
+  data_index->scan_full(offsets, n);
+
+  EXPECT_EQ(offsets.size(), n);
+
+  for (size_t i = 1; i < offsets.size(); ++i) {
+    EXPECT_LE(*(data_table->get_tuple_key(offsets.at(i - 1))), *(data_table->get_tuple_key(offsets.at(i))));
+  }
+
+  size_t count = 0;
+  for (auto &entry : validation_set) {
+    if (++count > 2000) { break; }
+
+    std::vector<Uint64> offsets;
+    data_index->find(entry.first, offsets);
+
+    EXPECT_EQ(offsets.size(), entry.second.size());
+
+    for (auto offset : offsets) {
+      EXPECT_NE(entry.second.end(), entry.second.find(offset));
+    }
+  }
+}
+
+TEST_F(StaticIndexNumericTest, ParallelReorganizeTest) {
+
+  for (size_t thread_count = 1; thread_count <= 4; thread_count += 3) {
+    test_static_index_numeric_parallel_reorganize<uint32_t, uint64_t>(IndexType::S_Interpolation, 10, INVALID_INDEX_PARAM, thread_count);
+    test_static_index_numeric_parallel_reorganize<uint64_t, uint64_t>(IndexType::S_Binary, 7, INVALID_INDEX_PARAM, thread_count);
+    test_static_index_numeric_parallel_reorganize<uint64_t, uint64_t>(IndexType::S_KAry, 3, 5, thread_count);
+    test_static_index_numeric_parallel_reorganize<uint32_t, uint64_t>(IndexType::S_Fast, 12, INVALID_INDEX_PARAM, thread_count);
+    test_static_index_numeric_parallel_reorganize<uint64_t, uint64_t>(IndexType::S_Learned, 0, 1024, thread_count);
+    test_static_index_numeric_parallel_reorganize<uint64_t, uint64_t>(IndexType::S_Learned, 1, 32, thread_count);
+    test_static_index_numeric_parallel_reorganize<uint64_t, uint64_t>(IndexType::S_Fast, 12, INVALID_INDEX_PARAM, thread_count);
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_static_index_numeric_save_load(const IndexType index_type, const size_t index_param_1, const size_t index_param_2, const StorageLayout layout = StorageLayout::AoS) {
+
+  size_t n = 20000;
+  size_t m = 5000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2, layout));
+
+  for (size_t i = 0; i < n; ++i) {
+    KeyT key = rand_gen.next<KeyT>() % m;
+    data_table->insert_tuple(key, i);
+  }
+
+  data_index->reorganize();
+
+  std::string path = "static_index_test_" + std::to_string(getpid()) + ".idx";
+  dynamic_cast<BaseStaticIndex<KeyT, ValueT>*>(data_index.get())->save(path);
+
+  // the loaded index shares the table, and must answer exactly as the built one.
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> loaded_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2, layout));
+  BaseStaticIndex<KeyT, ValueT> *loaded_static_index = dynamic_cast<BaseStaticIndex<KeyT, ValueT>*>(loaded_index.get());
+  loaded_static_index->load(path);
+  unlink(path.c_str());
+
+  EXPECT_TRUE(loaded_static_index->is_mapped());
+  EXPECT_EQ(loaded_index->size(), data_index->size());
+
+  for (size_t key = 0; key < m + 10; ++key) {
+    std::vector<Uint64> expected;
+    std::vector<Uint64> offsets;
+    data_index->find(key, expected);
+    loaded_index->find(key, offsets);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(offsets.begin(), offsets.end());
+    EXPECT_EQ(expected, offsets);
+  }
+
+  std::vector<KeyT> keys;
+  for (size_t i = 0; i < 1000; ++i) {
+    keys.push_back(rand_gen.next<KeyT>() % (m + 10));
+  }
+  std::vector<std::vector<Uint64>> batch_offsets(keys.size());
+  loaded_index->find_batch(keys.data(), keys.size(), batch_offsets.data());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::vector<Uint64> expected;
+    data_index->find(keys[i], expected);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(batch_offsets[i].begin(), batch_offsets[i].end());
+    EXPECT_EQ(expected, batch_offsets[i]);
+  }
+
+  for (size_t i = 0; i < 100; ++i) {
+    KeyT lhs_key = rand_gen.next<KeyT>() % m;
+    KeyT rhs_key = lhs_key + rand_gen.next<KeyT>() % 100;
+
+    std::vector<Uint64> expected;
+    std::vector<Uint64> offsets;
+    data_index->find_range(lhs_key, rhs_key, expected);
+    loaded_index->find_range(lhs_key, rhs_key, offsets);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(offsets.begin(), offsets.end());
+    EXPECT_EQ(expected, offsets);
+  }
+}
+
+TEST_F(StaticIndexNumericTest, SaveLoadTest) {
+
+  for (size_t layout = 0; layout <= 1; ++layout) {
+    test_static_index_numeric_save_load<uint32_t, uint64_t>(IndexType::S_Interpolation, 10, INVALID_INDEX_PARAM, StorageLayout(layout));
+    test_static_index_numeric_save_load<uint64_t, uint64_t>(IndexType::S_Binary, 7, INVALID_INDEX_PARAM, StorageLayout(layout));
+    test_static_index_numeric_save_load<uint32_t, uint64_t>(IndexType::S_KAry, 3, 5, StorageLayout(layout));
+    test_static_index_numeric_save_load<uint32_t, uint64_t>(IndexType::S_Fast, 8, INVALID_INDEX_PARAM, StorageLayout(layout));
+    test_static_index_numeric_save_load<uint64_t, uint64_t>(IndexType::S_Fast, 8, INVALID_INDEX_PARAM, StorageLayout(layout));
+    test_static_index_numeric_save_load<uint64_t, uint64_t>(IndexType::S_Learned, 0, 64, StorageLayout(layout));
+    test_static_index_numeric_save_load<uint32_t, uint64_t>(IndexType::S_Learned, 1, 16, StorageLayout(layout));
+  }
+}
+
+
+template<typename KeyT, typename ValueT>
+void test_static_index_numeric_result_sink(const IndexType index_type, const size_t index_param_1, const size_t index_param_2) {
+
+  size_t n = 10000;
+  size_t m = 1000;
+
+  FastRandom rand_gen(0);
+
+  std::unique_ptr<DataTable<KeyT, ValueT>> data_table(
+    new DataTable<KeyT, ValueT>());
+  std::unique_ptr<BaseIndex<KeyT, ValueT>> data_index(
+    create_numeric_index<KeyT, ValueT>(index_type, data_table.get(), index_param_1, index_param_2));
+
+  for (size_t i = 0; i < n; ++i) {
+    KeyT key = rand_gen.next<KeyT>() % m;
+    ValueT value = i + 2048;
+    data_table->insert_tuple(key, value);
+  }
+
+  data_index->reorganize();
+
+  // find: the sink receives the same offsets as the vector.
+  for (size_t i = 0; i < m * 2; ++i) {
+    KeyT key = i;
+
+    std::vector<Uint64> offsets;
+    data_index->find(key, offsets);
+
+    InlineResultSink<4> sink;
+    data_index->find(key, sink);
+
+    EXPECT_EQ(sink.size(), offsets.size());
+    for (size_t j = 0; j < offsets.size() && j < sink.size(); ++j) {
+      EXPECT_EQ(sink[j], offsets[j]);
+    }
+  }
+
+  // find range: stream the offsets to a visitor.
+  for (size_t i = 0; i < m; i += 37) {
+    KeyT lhs_key = i;
+    KeyT rhs_key = i + 100;
+
+    std::vector<Uint64> offsets;
+    data_index->find_range(lhs_key, rhs_key, offsets);
+
+    std::vector<Uint64> visited;
+    auto visitor = make_visitor_sink([&visited](const Uint64 &offset) { visited.push_back(offset); });
+    data_index->find_range(lhs_key, rhs_key, visitor);
+
+    EXPECT_EQ(visited, offsets);
+  }
+}
+
+
+TEST_F(StaticIndexNumericTest, ResultSinkTest) {
+  test_static_index_numeric_result_sink<uint32_t, uint64_t>(IndexType::S_Interpolation, 10, INVALID_INDEX_PARAM);
+  test_static_index_numeric_result_sink<uint64_t, uint64_t>(IndexType::S_Binary, 7, INVALID_INDEX_PARAM);
+  test_static_index_numeric_result_sink<uint32_t, uint64_t>(IndexType::S_KAry, 3, 5);
+  test_static_index_numeric_result_sink<uint64_t, uint64_t>(IndexType::S_Fast, 8, INVALID_INDEX_PARAM);
+  test_static_index_numeric_result_sink<uint64_t, uint64_t>(IndexType::S_Learned, 1, 16);
+}
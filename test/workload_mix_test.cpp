@@ -0,0 +1,52 @@
+#include <string>
+
+#include "workload_mix.h"
+
+#include "harness.h"
+
+
+class WorkloadMixTest : public IndexZooTest {};
+
+TEST_F(WorkloadMixTest, ParseTest) {
+  std::string error;
+
+  WorkloadMix ycsb_a;
+  EXPECT_TRUE(ycsb_a.parse("a", error));
+  EXPECT_NEAR(ycsb_a.share(OperationType::LookupOpType), 0.5, 1e-9);
+  EXPECT_NEAR(ycsb_a.share(OperationType::UpdateOpType), 0.5, 1e-9);
+  EXPECT_TRUE(ycsb_a.preset_access_type() == AccessType::ZipfianAccessType);
+
+  WorkloadMix ycsb_d;
+  EXPECT_TRUE(ycsb_d.parse("D", error));
+  EXPECT_TRUE(ycsb_d.preset_access_type() == AccessType::LatestAccessType);
+
+  WorkloadMix custom;
+  EXPECT_TRUE(custom.parse("read=0.6,scan=0.2,delete=0.2", error));
+  EXPECT_NEAR(custom.share(OperationType::LookupOpType), 0.6, 1e-9);
+  EXPECT_NEAR(custom.share(OperationType::ScanOpType), 0.2, 1e-9);
+  EXPECT_NEAR(custom.share(OperationType::DeleteOpType), 0.2, 1e-9);
+  EXPECT_NEAR(custom.share(OperationType::InsertOpType), 0, 1e-9);
+  EXPECT_TRUE(custom.preset_access_type() == AccessType::UniformAccessType);
+
+  WorkloadMix malformed;
+  EXPECT_FALSE(malformed.parse("g", error));
+  EXPECT_FALSE(malformed.parse("lookup=0.5", error));
+  EXPECT_FALSE(malformed.parse("lookup=0.5,write=0.5", error));
+}
+
+TEST_F(WorkloadMixTest, NextTest) {
+  std::string error;
+  WorkloadMix mix;
+  EXPECT_TRUE(mix.parse("insert=0.25,rmw=0.75", error));
+
+  FastRandom rand_gen(0);
+  size_t counts[OPERATION_TYPE_COUNT] = { 0 };
+  const size_t draw_count = 100000;
+  for (size_t i = 0; i < draw_count; ++i) {
+    ++counts[size_t(mix.next(rand_gen))];
+  }
+  EXPECT_EQ(counts[size_t(OperationType::LookupOpType)], 0);
+  EXPECT_EQ(counts[size_t(OperationType::DeleteOpType)], 0);
+  EXPECT_NEAR(counts[size_t(OperationType::InsertOpType)], draw_count * 0.25, draw_count * 0.01);
+  EXPECT_NEAR(counts[size_t(OperationType::ReadModifyWriteOpType)], draw_count * 0.75, draw_count * 0.01);
+}